@@ -329,6 +329,8 @@ set(haspthread ${has${CMAKE_USE_PTHREADS_INIT}})
 set(hasxft ${has${xft}})
 set(hascling ${has${cling}})
 set(haslzmacompression ${has${lzma}})
+set(haslz4 ${has${lz4}})
+set(haszstd ${has${zstd}})
 set(hascocoa ${has${cocoa}})
 set(usec++11 ${has${cxx11}})
 set(uselibc++11 ${has${libcxx11}})
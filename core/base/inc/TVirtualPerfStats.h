@@ -63,6 +63,12 @@ public:
 
    virtual void FileUnzipEvent(TFile *file, Long64_t pos, Double_t start, Int_t complen, Int_t objlen) = 0;
 
+   // Per branch events, sent by the TTree I/O only while gPerfStats is set.
+   // branch is the TBranch reading the data. Ignored by default.
+   virtual void UnzipEvent(TObject * /*branch*/, Long64_t /*pos*/, Double_t /*start*/, Int_t /*complen*/, Int_t /*objlen*/) {}
+   virtual void BasketReadEvent(TObject * /*branch*/, Int_t /*nbytes*/, Bool_t /*incache*/) {}
+   virtual void BranchReadEvent(TObject * /*branch*/, Int_t /*nbytes*/, Double_t /*start*/) {}
+
    virtual void RateEvent(Double_t proctime, Double_t deltatime,
                           Long64_t eventsprocessed, Long64_t bytesRead) = 0;
 
@@ -50,6 +50,7 @@
 #include "TPluginManager.h"
 #include "TUrl.h"
 #include "TVirtualMutex.h"
+#include "TSysEvtHandler.h"
 #include "compiledata.h"
 #include "RConfigure.h"
 
@@ -2292,6 +2293,33 @@ int TSystem::SendRaw(int, const void *, int, int)
    return -1;
 }
 
+//______________________________________________________________________________
+int TSystem::SendRawBuffers(int sock, int nbuf, const char * const *buffers, const int *lengths)
+{
+   // Send exactly the nbuf buffers one after the other, as a single
+   // buffer would be sent by SendRaw. Returns the total number of bytes
+   // sent or the (negative) error code of SendRaw. Systems supporting it
+   // send all the buffers with a single system call.
+   // On a non-blocking socket, -4 is returned if nothing could be sent;
+   // once the first buffer is sent, waits until the socket can take the
+   // next ones.
+
+   int ntot = 0;
+   for (int i = 0; i < nbuf; ++i) {
+      if (lengths[i] <= 0) continue;
+      int n = SendRaw(sock, buffers[i], lengths[i], 0);
+      while (n == -4 && ntot > 0) {
+         TFileHandler h(sock, TFileHandler::kWrite);
+         Int_t rc = Select(&h, -1);
+         if (rc < 0 && rc != -2) return -1;
+         n = SendRaw(sock, buffers[i], lengths[i], 0);
+      }
+      if (n <= 0) return n;
+      ntot += n;
+   }
+   return ntot;
+}
+
 //______________________________________________________________________________
 int TSystem::RecvBuf(int, void *, int)
 {
@@ -42,6 +42,11 @@
 //             unspecified non-zero value otherwise                     //
 //             (usually the new value).                                 //
 //                                                                      //
+//  a += n; a -= n;                                                     //
+//                                                                      //
+//    Effects: Atomically adds n to (subtracts n from) the value of a.  //
+//    Returns: nothing.                                                 //
+//                                                                      //
 //  a.Set(n);                                                           //
 //                                                                      //
 //    Effects: Set a to the value n.                                    //
@@ -79,6 +84,8 @@ public:
    explicit TAtomicCount(Long_t v) : fCnt(v) { }
    void operator++() { ++fCnt; }
    Long_t operator--() { return --fCnt; }
+   void operator+=(Long_t v) { fCnt += v; }
+   void operator-=(Long_t v) { fCnt -= v; }
    operator long() const { return fCnt; }
    void Set(Long_t v) { fCnt = v; }
    Long_t Get() const { return fCnt; }
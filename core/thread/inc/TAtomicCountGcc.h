@@ -54,6 +54,8 @@ public:
    explicit TAtomicCount(Long_t v) : fCnt(v) { }
    void operator++() { __atomic_add(&fCnt, 1); }
    Long_t operator--() { return __exchange_and_add(&fCnt, -1) - 1; }
+   void operator+=(Long_t v) { __atomic_add(&fCnt, v); }
+   void operator-=(Long_t v) { __atomic_add(&fCnt, -v); }
    operator long() const { return __exchange_and_add(&fCnt, 0); }
    void Set(Long_t v) {
       fCnt = v;
@@ -63,6 +63,16 @@ public:
       return --fCnt;
    }
 
+   void operator+=(Long_t v) {
+      LockGuard lock(fMutex);
+      fCnt += v;
+   }
+
+   void operator-=(Long_t v) {
+      LockGuard lock(fMutex);
+      fCnt -= v;
+   }
+
    operator long() const {
       LockGuard lock(fMutex);
       return fCnt;
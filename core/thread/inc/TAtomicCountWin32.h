@@ -39,6 +39,8 @@ public:
    explicit TAtomicCount(Long_t v) : fCnt(v) { }
    void operator++() { InterlockedIncrement(&fCnt); }
    Long_t operator--() { return InterlockedDecrement(&fCnt); }
+   void operator+=(Long_t v) { InterlockedExchangeAdd(&fCnt, v); }
+   void operator-=(Long_t v) { InterlockedExchangeAdd(&fCnt, -v); }
    operator long() const { return static_cast<long const volatile &>(fCnt); }
    void Set(Long_t v) { fCnt = v; }
    Long_t Get() const { return static_cast<long const volatile &>(fCnt); }
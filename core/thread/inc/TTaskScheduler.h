@@ -0,0 +1,225 @@
+// @(#)root/thread:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#ifndef ROOT_TTaskScheduler
+#define ROOT_TTaskScheduler
+
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TTaskScheduler                                                       //
+//                                                                      //
+// A pool of worker threads executing jobs, each worker with its own    //
+// queue of jobs; idle workers steal jobs from the others. Jobs are     //
+// run in a TTaskGroup, which can be waited for. The shared instance    //
+// (TTaskScheduler::Instance()) is meant to be used by all the parts    //
+// of ROOT running work in parallel.                                    //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef ROOT_Rtypes
+#include "Rtypes.h"
+#endif
+#ifndef ROOT_TMutex
+#include "TMutex.h"
+#endif
+#ifndef ROOT_TCondition
+#include "TCondition.h"
+#endif
+#ifndef ROOT_TAtomicCount
+#include "TAtomicCount.h"
+#endif
+
+#include <vector>
+
+class TTaskGroup;
+
+class TTaskScheduler {
+
+friend class TTaskGroup;
+
+public:
+   // A unit of work. Derive from it and implement Execute().
+   class TJob {
+   friend class TTaskGroup;
+   friend class TTaskScheduler;
+   private:
+      TTaskGroup *fGroup;   // Group in which the job is run
+      Bool_t      fOwned;   // True if the job is deleted once executed
+   public:
+      TJob() : fGroup(0), fOwned(kFALSE) { }
+      virtual ~TJob() { }
+      virtual void Execute() = 0;
+   };
+
+private:
+   struct TWorker;
+
+   std::vector<TWorker*> fWorkers;     // Worker threads and their queue of jobs
+   TMutex                fSleepMutex;  // Protects the sleeping of the workers
+   TCondition            fWakeUp;      // Signalled when a job is queued and a worker sleeps
+   TAtomicCount          fNQueued;     // Number of jobs queued and not yet taken
+   TAtomicCount          fNSleeping;   // Number of sleeping workers
+   TAtomicCount          fNExecuted;   // Number of jobs executed
+   TAtomicCount          fNStolen;     // Number of jobs taken from the queue of another worker
+   UInt_t                fNextWorker;  // Worker receiving the next job queued by another thread
+   Bool_t                fPinning;     // True if the workers are bound to a cpu each
+   volatile Bool_t       fStopping;    // Set to terminate the workers
+
+   static TTaskScheduler *fgInstance;  // Shared scheduler
+
+   TTaskScheduler(const TTaskScheduler&);            // not implemented
+   TTaskScheduler &operator=(const TTaskScheduler&); // not implemented
+
+   TJob         *FindJob(Int_t self, TTaskGroup *group = 0);
+   Int_t         GetWorkerIndex() const;
+   void          Push(TJob *job);
+   void          RunJob(TJob *job);
+
+   static void  *WorkerLoop(void *arg);
+
+public:
+   TTaskScheduler(UInt_t nthreads = 0, Bool_t pinning = kFALSE);
+   virtual ~TTaskScheduler();
+
+   Long_t        GetNExecuted() const { return fNExecuted.Get(); }
+   Long_t        GetNStolen() const { return fNStolen.Get(); }
+   UInt_t        GetNThreads() const { return fWorkers.size(); }
+   Bool_t        IsPinned() const { return fPinning; }
+   Bool_t        IsWorker() const { return GetWorkerIndex() >= 0; }
+   void          Print() const;
+   Bool_t        RunOne();
+
+   template <class F>
+   void          ParallelFor(Long64_t begin, Long64_t end, F &func, Long64_t grain = 0);
+   template <class T, class F, class Op>
+   T             ParallelReduce(Long64_t begin, Long64_t end, const T &init, F &func, Op op, Long64_t grain = 0);
+
+   static UInt_t GetDefaultNThreads();
+   static TTaskScheduler *Instance();
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TTaskGroup                                                           //
+//                                                                      //
+// A set of jobs run by a TTaskScheduler, whose completion can be       //
+// waited for. A job may itself run jobs in another group and wait for  //
+// them (nested parallelism): a thread waiting for a group executes     //
+// the pending jobs of that group meanwhile.                            //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+class TTaskGroup {
+
+friend class TTaskScheduler;
+
+private:
+   TTaskScheduler *fScheduler;  // Scheduler executing the jobs
+   TAtomicCount    fNPending;   // Number of jobs run and not yet finished
+   TMutex          fMutex;      // Protects the end of the jobs
+   TCondition      fDone;       // Signalled when the last job is finished
+
+   TTaskGroup(const TTaskGroup&);            // not implemented
+   TTaskGroup &operator=(const TTaskGroup&); // not implemented
+
+   void            JobDone();
+
+public:
+   TTaskGroup(TTaskScheduler *scheduler = 0);
+   ~TTaskGroup();
+
+   Long_t          GetNPending() const { return fNPending.Get(); }
+   TTaskScheduler *GetScheduler() const { return fScheduler; }
+   void            Run(TTaskScheduler::TJob *job, Bool_t adopt = kTRUE);
+   void            Wait(Bool_t help = kTRUE);
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// Jobs of TTaskScheduler::ParallelFor and ParallelReduce.              //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+template <class F>
+class TParallelForJob : public TTaskScheduler::TJob {
+private:
+   F        &fFunc;
+   Long64_t  fBegin;
+   Long64_t  fEnd;
+public:
+   TParallelForJob(F &func, Long64_t begin, Long64_t end) : fFunc(func), fBegin(begin), fEnd(end) { }
+   virtual void Execute() { fFunc(fBegin, fEnd); }
+};
+
+template <class T, class F>
+class TParallelReduceJob : public TTaskScheduler::TJob {
+private:
+   F        &fFunc;
+   Long64_t  fBegin;
+   Long64_t  fEnd;
+   T        &fResult;
+public:
+   TParallelReduceJob(F &func, Long64_t begin, Long64_t end, T &result) :
+      fFunc(func), fBegin(begin), fEnd(end), fResult(result) { }
+   virtual void Execute() { fResult = fFunc(fBegin, fEnd); }
+};
+
+//______________________________________________________________________________
+template <class F>
+void TTaskScheduler::ParallelFor(Long64_t begin, Long64_t end, F &func, Long64_t grain)
+{
+   // Call func(first, last) for consecutive sub-ranges [first,last) of
+   // [begin,end) of at most grain elements, in parallel, and return when
+   // all the calls are done. If grain is 0, the range is split in about
+   // four sub-ranges per thread. func may be called concurrently.
+
+   if (end <= begin) return;
+   if (grain <= 0) grain = (end - begin + 4 * GetNThreads() - 1) / (4 * GetNThreads());
+   if (grain <= 0) grain = 1;
+   TTaskGroup group(this);
+   for (Long64_t first = begin; first < end; first += grain) {
+      Long64_t last = end - first > grain ? first + grain : end;
+      group.Run(new TParallelForJob<F>(func, first, last));
+   }
+   group.Wait();
+}
+
+//______________________________________________________________________________
+template <class T, class F, class Op>
+T TTaskScheduler::ParallelReduce(Long64_t begin, Long64_t end, const T &init, F &func, Op op, Long64_t grain)
+{
+   // Call func(first, last), which returns a T, for sub-ranges of
+   // [begin,end) like ParallelFor and return the combination of init
+   // and of the results with op(T, T), in the order of the sub-ranges:
+   // the result is the same for any number of threads as long as grain
+   // is given.
+
+   if (end <= begin) return init;
+   if (grain <= 0) grain = (end - begin + 4 * GetNThreads() - 1) / (4 * GetNThreads());
+   if (grain <= 0) grain = 1;
+   std::vector<T> results((end - begin + grain - 1) / grain, init);
+   {
+      TTaskGroup group(this);
+      UInt_t i = 0;
+      for (Long64_t first = begin; first < end; first += grain, ++i) {
+         Long64_t last = end - first > grain ? first + grain : end;
+         group.Run(new TParallelReduceJob<T, F>(func, first, last, results[i]));
+      }
+      group.Wait();
+   }
+   T result = init;
+   for (UInt_t i = 0; i < results.size(); ++i) result = op(result, results[i]);
+   return result;
+}
+
+#endif
@@ -26,14 +26,16 @@
 #ifndef ROOT_TMutex
 #include "TMutex.h"
 #endif
-#ifndef ROOT_TCondition
-#include "TCondition.h"
+#ifndef ROOT_TThread
+#include "TThread.h"
+#endif
+#ifndef ROOT_TTaskScheduler
+#include "TTaskScheduler.h"
 #endif
 // STD
-#include <queue>
-#include <vector>
 #include <iostream>
-#include <sstream>
+#include <string>
+#include <vector>
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -108,7 +110,14 @@ private:
 //                                                                      //
 // TThreadPool                                                          //
 // This class implement a simple Thread Pool pattern.                   //
-// So far it supports only one type of queue - FIFO                     //
+// The tasks are executed by a TTaskScheduler owned by the pool, with   //
+// threadsCount threads: each thread has its own queue of tasks and     //
+// idle threads steal tasks from the others. The tasks pushed by one    //
+// thread are dealt out to the threads of the pool in turn.             //
+// AddThread does not wait for the queued tasks: the next tasks go to   //
+// a scheduler with one more thread, while the previous one finishes    //
+// the tasks it has. Stop(false) drops the tasks not yet started, as    //
+// the former implementation did (they are now deleted).                //
 //                                                                      //
 // Please see the tutorial "tutorials/thread/threadPool.C" for          //
 // more details on how to use TThreadPool.                              //
@@ -118,8 +127,27 @@ template <class aTask, class aParam>
 class TThreadPool : public TNonCopyable {
 
    typedef TThreadPoolTask<aTask, aParam> task_t;
-   typedef std::queue<task_t*>            taskqueue_t;
-   typedef std::vector<TThread*>          threads_array_t;
+
+   // A task of the pool, as a job of the scheduler.
+   class TPoolJob : public TTaskScheduler::TJob {
+   public:
+      TPoolJob(TThreadPool *pool, task_t *task): fPool(pool), fTask(task) { }
+      virtual ~TPoolJob() { delete fTask; }
+      virtual void Execute() {
+         // tasks not yet started when the pool is stopped are dropped
+         if (fPool->fStopped)
+            return;
+         --fPool->fIdleThreads;
+         fPool->DbgLog("Run the task");
+         if (fTask->run())
+            ++fPool->fSuccessfulTasks;
+         fPool->DbgLog("Done Running the task");
+         ++fPool->fIdleThreads;
+      }
+   private:
+      TThreadPool *fPool;
+      task_t      *fTask;
+   };
 
 public:
    TThreadPool(size_t threadsCount, bool needDbg = false):
@@ -127,205 +155,129 @@ public:
       fSuccessfulTasks(0),
       fTasksCount(0),
       fIdleThreads(threadsCount),
+      fThreadsCount(threadsCount),
       fSilent(!needDbg) {
-      fThreadNeeded = new TCondition(&fMutex);
-      fThreadAvailable = new TCondition(&fMutex);
-      fAllTasksDone = new TCondition(&fMutexAllTasksDone);
-
-      for (size_t i = 0; i < threadsCount; ++i) {
-         TThread *pThread = new TThread(&TThreadPool::Executor, this);
-         fThreads.push_back(pThread);
-         pThread->Run();
-      }
-
-      fThreadJoinHelper = new TThread(&TThreadPool::JoinHelper, this);
-
-      if (needDbg) {
-         fThreadMonitor = new TThread(&TThreadPool::Monitor, this);
-         fThreadMonitor->Run();
-      }
+      fScheduler = new TTaskScheduler(threadsCount);
+      fGroup = new TTaskGroup(fScheduler);
    }
 
    ~TThreadPool() {
       Stop();
-      // deleting threads
-      threads_array_t::const_iterator iter = fThreads.begin();
-      threads_array_t::const_iterator iter_end = fThreads.end();
-      for (; iter != iter_end; ++iter)
-         delete(*iter);
-
-      delete fThreadJoinHelper;
-
-      delete fThreadNeeded;
-      delete fThreadAvailable;
-      delete fAllTasksDone;
    }
 
    void AddThread() {
+      // The threads of a scheduler are fixed: the next tasks are run by
+      // a new scheduler with one more thread. The previous one keeps
+      // running the tasks already pushed and is deleted once they are
+      // done, the call does not wait for them.
       TLockGuard lock(&fMutex);
-      TThread *pThread = new TThread(&TThreadPool::Executor, this);
-      fThreads.push_back(pThread);
-      pThread->Run();
+      if (fStopped)
+         return;
+      fRetired.push_back(fGroup);
+      ++fThreadsCount;
       ++fIdleThreads;
+      fScheduler = new TTaskScheduler(fThreadsCount);
+      fGroup = new TTaskGroup(fScheduler);
+      ReleaseRetired();
    }
 
    void PushTask(typename TThreadPoolTask<aTask, aParam>::task_t &task, aParam param) {
-      {
-         DbgLog("Main thread. Try to push a task");
-
-         TLockGuard lock(&fMutex);
-         task_t *t = new task_t(task, param);
-         fTasks.push(t);
-         ++fTasksCount;
-
-         DbgLog("Main thread. the task is pushed");
-      }
       TLockGuard lock(&fMutex);
-      fThreadNeeded->Broadcast();
+      if (fStopped)
+         return;
+      DbgLog("Main thread. Try to push a task");
+      fGroup->Run(new TPoolJob(this, new task_t(task, param)));
+      ++fTasksCount;
+      DbgLog("Main thread. the task is pushed");
    }
 
    void Stop(bool processRemainingJobs = false) {
-      // prevent more jobs from being added to the queue
-      if (fStopped)
+      // Stop the pool. With processRemainingJobs all the tasks pushed are
+      // run first; otherwise, as before, the running tasks are finished
+      // and the tasks not yet started are dropped (and deleted).
+      if (fStopped || !fScheduler)
          return;
 
       if (processRemainingJobs) {
-         TLockGuard lock(&fMutex);
-         // wait for queue to drain
-         while (!fTasks.empty() && !fStopped) {
-            DbgLog("Main thread is waiting");
-            fThreadAvailable->Wait();
-            DbgLog("Main thread is DONE waiting");
-         }
+         DbgLog("Main thread is waiting");
+         Drain();
+         DbgLog("Main thread is DONE waiting");
       }
-      // tell all threads to stop
+      // prevent more jobs from being added to the queue and tell all
+      // threads to stop
       {
          TLockGuard lock(&fMutex);
          fStopped = true;
-         fThreadNeeded->Broadcast();
-         DbgLog("Main threads requests to STOP");
       }
+      DbgLog("Main threads requests to STOP");
 
       // Waiting for all threads to complete
-      fThreadJoinHelper->Run();
-      fThreadJoinHelper->Join();
+      {
+         TLockGuard lock(&fMutex);
+         fRetired.push_back(fGroup);
+         fGroup = 0;
+         fScheduler = 0;
+      }
+      WaitRetired();
    }
 
    void Drain() {
       // This method stops the calling thread until the task queue is empty
-
-      TLockGuard lock(&fMutexAllTasksDone);
-      fAllTasksDone->Wait();
+      WaitRetired();
+      TTaskGroup *group = 0;
+      {
+         TLockGuard lock(&fMutex);
+         group = fGroup;
+      }
+      if (group)
+         group->Wait(kFALSE);
    }
 
    size_t TasksCount() const {
-      return fTasksCount;
+      return fTasksCount.Get();
    }
 
    size_t SuccessfulTasks() const {
-      return fSuccessfulTasks;
+      return fSuccessfulTasks.Get();
    }
 
    size_t IdleThreads() const {
-      return fIdleThreads;
+      return fIdleThreads.Get();
    }
 
 private:
-   static void* Monitor(void *arg) {
-      if (NULL == arg)
-         return NULL;
-
-      TThreadPool *pThis = reinterpret_cast<TThreadPool*>(arg);
-      while (true && !pThis->fStopped) {
-         std::stringstream ss;
-         ss
-               << ">>>> Check for tasks."
-               << " Number of Tasks: " << pThis->fTasks.size()
-               << "; Idle threads: " << pThis->IdleThreads();
-         pThis->DbgLog(ss.str());
-         sleep(1);
-      }
-      return NULL;
+   static void DeleteGroup(TTaskGroup *group) {
+      TTaskScheduler *scheduler = group->GetScheduler();
+      delete group;
+      delete scheduler;
    }
 
-   static void* Executor(void *arg) {
-      TThreadPool *pThis = reinterpret_cast<TThreadPool*>(arg);
-
-      while (!pThis->fStopped) {
-         task_t *task(NULL);
-
-         // There is a task, let's take it
-         {
-            // Find a task to perform
-            TLockGuard lock(&pThis->fMutex);
-            if (pThis->fTasks.empty() && !pThis->fStopped) {
-               pThis->DbgLog("waiting for a task");
-
-               if (pThis->fThreads.size() == pThis->fIdleThreads) {
-                  TLockGuard l(&pThis->fMutexAllTasksDone);
-                  pThis->fAllTasksDone->Broadcast();
-               }
-
-               // No tasks, we wait for a task to come
-               pThis->fThreadNeeded->Wait();
-
-               pThis->DbgLog("done waiting for tasks");
-            }
-         }
-
-         {
-            TLockGuard lock(&pThis->fMutex);
-            if (!pThis->fTasks.empty()) {
-               --pThis->fIdleThreads;
-               task = pThis->fTasks.front();
-               pThis->fTasks.pop();
-
-               pThis->DbgLog("get the task");
-            } else if (pThis->fThreads.size() == pThis->fIdleThreads) {
-               TLockGuard l(&pThis->fMutexAllTasksDone);
-               pThis->fAllTasksDone->Broadcast();
-            }
-            pThis->DbgLog("done Check <<<<");
+   void ReleaseRetired() {
+      // Delete the groups (and schedulers) replaced by AddThread whose
+      // tasks are done. Called with fMutex locked.
+      for (size_t i = 0; i < fRetired.size(); ) {
+         if (fRetired[i]->GetNPending() > 0) {
+            ++i;
+            continue;
          }
-
-         // Execute the task
-         if (task) {
-            pThis->DbgLog("Run the task");
-
-            if (task->run()) {
-               TLockGuard lock(&pThis->fMutex);
-               ++pThis->fSuccessfulTasks;
-            }
-            delete task;
-            task = NULL;
-
-            TLockGuard lock(&pThis->fMutex);
-            ++pThis->fIdleThreads;
-
-            pThis->DbgLog("Done Running the task");
-         }
-         // Task is done, report that the thread is free
-         TLockGuard lock(&pThis->fMutex);
-         pThis->fThreadAvailable->Broadcast();
+         DeleteGroup(fRetired[i]);
+         fRetired.erase(fRetired.begin() + i);
       }
-
-      pThis->DbgLog("**** DONE ***");
-      return NULL;
    }
 
-   static void *JoinHelper(void *arg) {
-      TThreadPool *pThis = reinterpret_cast<TThreadPool*>(arg);
-      threads_array_t::const_iterator iter = pThis->fThreads.begin();
-      threads_array_t::const_iterator iter_end = pThis->fThreads.end();
-      for (; iter != iter_end; ++iter)
-         (*iter)->Join();
-
-      return NULL;
-   }
-
-   static bool IsThreadActive(TThread *pThread) {
-      // so far we consider only kRunningState as activity
-      return (pThread->GetState() == TThread::kRunningState);
+   void WaitRetired() {
+      // Wait for the tasks of the groups replaced by AddThread (or Stop)
+      // and delete them. The lock is not held while waiting, the tasks
+      // may push new tasks.
+      std::vector<TTaskGroup*> retired;
+      {
+         TLockGuard lock(&fMutex);
+         retired.swap(fRetired);
+      }
+      for (size_t i = 0; i < retired.size(); ++i) {
+         retired[i]->Wait(kFALSE);
+         DeleteGroup(retired[i]);
+      }
    }
 
    void DbgLog(const std::string &msg) {
@@ -336,19 +288,15 @@ private:
    }
 
 private:
-   taskqueue_t     fTasks;
+   TTaskScheduler *fScheduler;
+   TTaskGroup     *fGroup;
+   std::vector<TTaskGroup*> fRetired; // groups replaced by AddThread, with tasks still running
    TMutex          fMutex;
-   TCondition     *fThreadNeeded;
-   TCondition     *fThreadAvailable;
-   TMutex         fMutexAllTasksDone;
-   TCondition     *fAllTasksDone;
-   threads_array_t fThreads;
-   TThread        *fThreadJoinHelper;
-   TThread        *fThreadMonitor;
    volatile bool   fStopped;
-   size_t          fSuccessfulTasks;
-   size_t          fTasksCount;
-   size_t          fIdleThreads;
+   TAtomicCount    fSuccessfulTasks;
+   TAtomicCount    fTasksCount;
+   TAtomicCount    fIdleThreads;
+   size_t          fThreadsCount;
    TMutex          fDbgOutputMutex;
    bool            fSilent; // No DBG messages
 };
@@ -0,0 +1,401 @@
+// @(#)root/thread:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TTaskScheduler                                                       //
+//                                                                      //
+// A pool of worker threads executing jobs (TTaskScheduler::TJob).      //
+//                                                                      //
+// Each worker has its own queue of jobs. A job run by a worker is      //
+// queued in the worker's own queue, from which the worker takes the    //
+// most recent job first (the data it uses are likely still in the      //
+// cache); jobs run by other threads are dealt out to the workers in    //
+// turn. A worker whose queue is empty steals the oldest job of another //
+// worker, trying the workers with the nearest index first, and sleeps  //
+// when there is no job at all. Each queue has its own lock, so that    //
+// the workers do not compete for a single lock.                        //
+//                                                                      //
+// Jobs are run in a TTaskGroup:                                        //
+//                                                                      //
+//    class TMyJob : public TTaskScheduler::TJob {                      //
+//       void Execute() { ... }                                         //
+//    };                                                                //
+//    TTaskGroup group;        // run by TTaskScheduler::Instance()     //
+//    for (...) group.Run(new TMyJob(...));                             //
+//    group.Wait();                                                     //
+//                                                                      //
+// The thread waiting for a group executes the pending jobs of that     //
+// group meanwhile, so that a job can itself run jobs and wait for them //
+// without blocking a worker. Jobs of other groups are left alone: the  //
+// waiting thread may be in the middle of work (holding a lock, with    //
+// gDirectory set) that an unrelated job must not run into.             //
+// ParallelFor and ParallelReduce split a range of indices in jobs:     //
+//                                                                      //
+//    struct TSum {                                                     //
+//       const Double_t *fX;                                            //
+//       Double_t operator()(Long64_t first, Long64_t last) {           //
+//          Double_t s = 0;                                             //
+//          for (Long64_t i = first; i < last; ++i) s += fX[i];         //
+//          return s;                                                   //
+//       }                                                              //
+//    } sum = { x };                                                    //
+//    Double_t total = TTaskScheduler::Instance()->ParallelReduce(      //
+//                        0, n, 0., sum, std::plus<Double_t>());        //
+//                                                                      //
+// TTaskScheduler::Instance() is the scheduler shared by ROOT (parallel //
+// tree processing, basket compression and unzipping, file merging).    //
+// Its number of threads and whether the threads are bound to a cpu     //
+// each are set with the resources Thread.Scheduler.NThreads (default:  //
+// one per cpu) and Thread.Scheduler.Pinning (Linux only). When pinned, //
+// worker i runs on cpu i: as the cpus of a NUMA node are usually       //
+// numbered consecutively, stealing from the nearest workers first      //
+// keeps the jobs on the same node as long as possible.                 //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#include "TTaskScheduler.h"
+#include "TEnv.h"
+#include "TError.h"
+#include "TString.h"
+#include "TSystem.h"
+#include "TThread.h"
+#include "TVirtualMutex.h"
+
+#include <deque>
+
+#if defined(R__LINUX)
+#include <sched.h>
+#endif
+
+TTaskScheduler *TTaskScheduler::fgInstance = 0;
+
+// A worker thread and its queue of jobs.
+struct TTaskScheduler::TWorker {
+   TTaskScheduler    *fScheduler;
+   UInt_t             fId;
+   Long_t             fThreadId;  // TThread::SelfId() of the worker
+   TThread           *fThread;
+   TMutex             fMutex;     // Protects fJobs
+   std::deque<TJob*>  fJobs;      // Jobs queued, the most recent at the back
+};
+
+//______________________________________________________________________________
+TTaskScheduler::TTaskScheduler(UInt_t nthreads, Bool_t pinning) :
+   fWakeUp(&fSleepMutex), fNQueued(0), fNSleeping(0), fNExecuted(0), fNStolen(0),
+   fNextWorker(0), fPinning(pinning), fStopping(kFALSE)
+{
+   // Create a scheduler with nthreads worker threads (0: one per cpu).
+   // If pinning is true, worker i is bound to cpu i (modulo the number of
+   // cpus); this is only supported on Linux.
+
+   if (!TThread::IsInitialized()) TThread::Initialize();
+   if (nthreads == 0) nthreads = GetDefaultNThreads();
+
+   // All the workers must exist before any can steal from the others.
+   for (UInt_t i = 0; i < nthreads; ++i) {
+      TWorker *w = new TWorker;
+      w->fScheduler = this;
+      w->fId = i;
+      w->fThreadId = 0;
+      w->fThread = 0;
+      fWorkers.push_back(w);
+   }
+   for (UInt_t i = 0; i < nthreads; ++i) {
+      TWorker *w = fWorkers[i];
+      w->fThread = new TThread(TString::Format("TTaskScheduler_%u", i), &TTaskScheduler::WorkerLoop, w);
+      if (w->fThread->Run() != 0) {
+         ::Error("TTaskScheduler::TTaskScheduler", "unable to start worker thread %u", i);
+         delete w->fThread;
+         w->fThread = 0;
+      }
+   }
+}
+
+//______________________________________________________________________________
+TTaskScheduler::~TTaskScheduler()
+{
+   // Stop the worker threads once they finish their current job. The jobs
+   // still queued are not executed but counted as done in their group.
+
+   {
+      TLockGuard lock(&fSleepMutex);
+      fStopping = kTRUE;
+      fWakeUp.Broadcast();
+   }
+   for (UInt_t i = 0; i < fWorkers.size(); ++i) {
+      if (fWorkers[i]->fThread) {
+         fWorkers[i]->fThread->Join();
+         delete fWorkers[i]->fThread;
+      }
+   }
+   for (UInt_t i = 0; i < fWorkers.size(); ++i) {
+      std::deque<TJob*> &jobs = fWorkers[i]->fJobs;
+      for (UInt_t j = 0; j < jobs.size(); ++j) {
+         TTaskGroup *group = jobs[j]->fGroup;
+         if (jobs[j]->fOwned) delete jobs[j];
+         if (group) group->JobDone();
+      }
+      delete fWorkers[i];
+   }
+   fWorkers.clear();
+   if (fgInstance == this) fgInstance = 0;
+}
+
+//______________________________________________________________________________
+TTaskScheduler::TJob *TTaskScheduler::FindJob(Int_t self, TTaskGroup *group)
+{
+   // Take a job to execute: the most recent job of worker self (-1 if the
+   // calling thread is not a worker) or else the oldest job of another
+   // worker, the nearest ones first. If group is not null, only the jobs
+   // of group are considered. Returns 0 if there is no job.
+
+   if (fNQueued.Get() <= 0) return 0;
+   TJob *job = 0;
+   UInt_t n = fWorkers.size();
+   if (self >= 0) {
+      TWorker *w = fWorkers[self];
+      TLockGuard lock(&w->fMutex);
+      for (std::deque<TJob*>::iterator it = w->fJobs.end(); it != w->fJobs.begin(); ) {
+         --it;
+         if (group && (*it)->fGroup != group) continue;
+         job = *it;
+         w->fJobs.erase(it);
+         break;
+      }
+   }
+   for (UInt_t k = 1; !job && k <= n; ++k) {
+      UInt_t victim = self >= 0 ? (self + k) % n : k - 1;
+      if ((Int_t)victim == self) continue;
+      TWorker *w = fWorkers[victim];
+      TLockGuard lock(&w->fMutex);
+      for (std::deque<TJob*>::iterator it = w->fJobs.begin(); it != w->fJobs.end(); ++it) {
+         if (group && (*it)->fGroup != group) continue;
+         job = *it;
+         w->fJobs.erase(it);
+         if (self >= 0) ++fNStolen;
+         break;
+      }
+   }
+   if (job) --fNQueued;
+   return job;
+}
+
+//______________________________________________________________________________
+UInt_t TTaskScheduler::GetDefaultNThreads()
+{
+   // Return the number of threads of the shared scheduler: the value of
+   // the resource Thread.Scheduler.NThreads or, if it is 0, the number of
+   // cpus of this machine.
+
+   Int_t nthreads = gEnv ? gEnv->GetValue("Thread.Scheduler.NThreads", 0) : 0;
+   if (nthreads > 0) return nthreads;
+   SysInfo_t info;
+   if (gSystem && gSystem->GetSysInfo(&info) == 0 && info.fCpus > 0) return info.fCpus;
+   return 1;
+}
+
+//______________________________________________________________________________
+Int_t TTaskScheduler::GetWorkerIndex() const
+{
+   // Return the index of the worker running the calling thread, -1 if the
+   // calling thread is not a worker of this scheduler.
+
+   Long_t id = TThread::SelfId();
+   for (UInt_t i = 0; i < fWorkers.size(); ++i) {
+      if (fWorkers[i]->fThreadId == id) return i;
+   }
+   return -1;
+}
+
+//______________________________________________________________________________
+TTaskScheduler *TTaskScheduler::Instance()
+{
+   // Return the scheduler shared by ROOT, created on first use (see the
+   // class description for its settings).
+
+   if (!fgInstance) {
+      R__LOCKGUARD2(gGlobalMutex);
+      if (!fgInstance) {
+         Bool_t pinning = gEnv ? gEnv->GetValue("Thread.Scheduler.Pinning", 0) : kFALSE;
+         fgInstance = new TTaskScheduler(GetDefaultNThreads(), pinning);
+      }
+   }
+   return fgInstance;
+}
+
+//______________________________________________________________________________
+void TTaskScheduler::Print() const
+{
+   // Print the number of threads and of jobs executed.
+
+   Printf("TTaskScheduler: %u threads%s, %ld jobs executed, %ld stolen, %ld queued",
+          GetNThreads(), fPinning ? " (pinned)" : "", fNExecuted.Get(), fNStolen.Get(),
+          fNQueued.Get());
+}
+
+//______________________________________________________________________________
+void TTaskScheduler::Push(TJob *job)
+{
+   // Queue a job: in the queue of the calling thread if it is a worker,
+   // otherwise in the queue of the workers in turn. Wake up a sleeping
+   // worker, if any.
+
+   Int_t self = GetWorkerIndex();
+   // fNextWorker is not protected: a race only changes the distribution.
+   TWorker *w = fWorkers[self >= 0 ? (UInt_t)self : fNextWorker++ % fWorkers.size()];
+   {
+      TLockGuard lock(&w->fMutex);
+      w->fJobs.push_back(job);
+   }
+   ++fNQueued;
+   if (fNSleeping.Get() > 0) {
+      TLockGuard lock(&fSleepMutex);
+      fWakeUp.Signal();
+   }
+}
+
+//______________________________________________________________________________
+Bool_t TTaskScheduler::RunOne()
+{
+   // Execute one of the queued jobs, if any, in the calling thread.
+   // Returns false if there was no job to execute.
+
+   TJob *job = FindJob(GetWorkerIndex());
+   if (!job) return kFALSE;
+   RunJob(job);
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+void TTaskScheduler::RunJob(TJob *job)
+{
+   // Execute job and tell its group that it is done.
+
+   TTaskGroup *group = job->fGroup;
+   Bool_t owned = job->fOwned;
+   job->Execute();
+   ++fNExecuted;
+   if (owned) delete job;
+   if (group) group->JobDone();
+}
+
+//______________________________________________________________________________
+void *TTaskScheduler::WorkerLoop(void *arg)
+{
+   // Loop of a worker thread: execute jobs, sleep when there is none.
+
+   TWorker *w = (TWorker*)arg;
+   TTaskScheduler *sched = w->fScheduler;
+   w->fThreadId = TThread::SelfId();
+
+#if defined(R__LINUX) && defined(CPU_SET)
+   if (sched->fPinning) {
+      SysInfo_t info;
+      Int_t ncpus = (gSystem->GetSysInfo(&info) == 0 && info.fCpus > 0) ? info.fCpus : 1;
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      CPU_SET(w->fId % ncpus, &cpus);
+      // On Linux, pid 0 is the calling thread.
+      if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0)
+         ::Warning("TTaskScheduler::WorkerLoop", "cannot bind worker %u to cpu %d", w->fId, w->fId % ncpus);
+   }
+#endif
+
+   while (!sched->fStopping) {
+      TJob *job = sched->FindJob(w->fId);
+      if (job) {
+         sched->RunJob(job);
+         continue;
+      }
+      TLockGuard lock(&sched->fSleepMutex);
+      ++sched->fNSleeping;
+      // Push increments fNQueued before looking at fNSleeping: either it
+      // sees this worker sleeping and signals, or the job is seen here.
+      // The timeout is only a safety net.
+      if (sched->fNQueued.Get() <= 0 && !sched->fStopping)
+         sched->fWakeUp.TimedWaitRelative(100);
+      --sched->fNSleeping;
+   }
+   return 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TTaskGroup                                                           //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+TTaskGroup::TTaskGroup(TTaskScheduler *scheduler) :
+   fScheduler(scheduler ? scheduler : TTaskScheduler::Instance()), fNPending(0), fDone(&fMutex)
+{
+   // Create a group of jobs executed by scheduler (by default the shared
+   // scheduler).
+}
+
+//______________________________________________________________________________
+TTaskGroup::~TTaskGroup()
+{
+   // Destructor. Waits for the jobs of the group.
+
+   Wait();
+}
+
+//______________________________________________________________________________
+void TTaskGroup::JobDone()
+{
+   // Called when a job of the group is finished. The counter is updated
+   // with the lock held so that the group cannot be deleted by a waiting
+   // thread before this function is done with it.
+
+   TLockGuard lock(&fMutex);
+   if (--fNPending == 0) fDone.Broadcast();
+}
+
+//______________________________________________________________________________
+void TTaskGroup::Run(TTaskScheduler::TJob *job, Bool_t adopt)
+{
+   // Queue job to be executed by the scheduler. If adopt is true, the job
+   // is deleted once executed.
+
+   if (!job) return;
+   job->fGroup = this;
+   job->fOwned = adopt;
+   ++fNPending;
+   fScheduler->Push(job);
+}
+
+//______________________________________________________________________________
+void TTaskGroup::Wait(Bool_t help)
+{
+   // Wait until all the jobs run in the group are finished. If help is
+   // true (the default), the calling thread executes the queued jobs of
+   // this group meanwhile; this is what allows a job to wait for the jobs
+   // it runs without tying up a worker. Jobs of other groups are not
+   // executed, they could use the state of the waiting thread (locks
+   // held, gDirectory and gFile).
+
+   TTaskScheduler::TJob *job;
+   while (1) {
+      if (help) {
+         while (fNPending.Get() > 0 &&
+                (job = fScheduler->FindJob(fScheduler->GetWorkerIndex(), this))) {
+            fScheduler->RunJob(job);
+         }
+      }
+      TLockGuard lock(&fMutex);
+      if (fNPending.Get() <= 0) return;
+      // While helping, wake up regularly to look for jobs to execute.
+      fDone.TimedWaitRelative(help ? 1 : 100);
+      if (fNPending.Get() <= 0) return;
+   }
+}
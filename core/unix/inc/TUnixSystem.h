@@ -205,6 +205,7 @@ public:
    void              CloseConnection(int sock, Bool_t force = kFALSE);
    int               RecvRaw(int sock, void *buffer, int length, int flag);
    int               SendRaw(int sock, const void *buffer, int length, int flag);
+   int               SendRawBuffers(int sock, int nbuf, const char * const *buffers, const int *lengths);
    int               RecvBuf(int sock, void *buffer, int length);
    int               SendBuf(int sock, const void *buffer, int length);
    int               SetSockOpt(int sock, int option, int val);
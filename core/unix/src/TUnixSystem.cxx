@@ -98,6 +98,7 @@
 #include <sys/time.h>
 #include <sys/file.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #if defined(R__AIX)
@@ -3247,6 +3248,68 @@ int TUnixSystem::SendRaw(int sock, const void *buf, int length, int opt)
    return n;
 }
 
+//______________________________________________________________________________
+int TUnixSystem::SendRawBuffers(int sock, int nbuf, const char * const *buffers, const int *lengths)
+{
+   // Send exactly the nbuf buffers one after the other with writev, i.e.
+   // without copying them in a single buffer. Returns the total number of
+   // bytes sent or -1 in case of error. Returns -4 in case of kNoBlock and
+   // errno == EWOULDBLOCK before anything is sent; once the beginning is
+   // sent, waits (select) until the socket can take the rest. Returns -5
+   // if pipe broken or reset by peer (EPIPE || ECONNRESET).
+
+   if (sock < 0) return -1;
+
+   // writev accepts at most IOV_MAX buffers, 16 are always supported.
+   const int kMaxIov = 16;
+   struct iovec iov[kMaxIov];
+   int ntot = 0;
+   int ibuf = 0;
+   int offset = 0;   // bytes of buffers[ibuf] already sent
+   while (ibuf < nbuf) {
+      int niov = 0;
+      for (int i = ibuf; i < nbuf && niov < kMaxIov; ++i) {
+         int skip = (i == ibuf) ? offset : 0;
+         if (lengths[i] - skip <= 0) continue;
+         iov[niov].iov_base = (void *)(buffers[i] + skip);
+         iov[niov].iov_len  = lengths[i] - skip;
+         ++niov;
+      }
+      if (niov == 0) break;
+      ssize_t nsent = writev(sock, iov, niov);
+      if (nsent <= 0) {
+         if (nsent < 0 && GetErrno() == EINTR) continue;
+         if (nsent < 0 && GetErrno() == EWOULDBLOCK) {
+            if (ntot == 0) return -4;
+            // The beginning was sent: the rest must follow, wait until
+            // the socket is writable again.
+            TFdSet wr;
+            wr.Set(sock);
+            int rc = UnixSelect(sock+1, 0, &wr, -1);
+            if (rc < 0 && rc != -2) {
+               ::SysError("TUnixSystem::SendRawBuffers", "select");
+               return -1;
+            }
+            continue;
+         }
+         if (nsent == 0) break;
+         ::SysError("TUnixSystem::SendRawBuffers", "writev");
+         if (GetErrno() == EPIPE || GetErrno() == ECONNRESET)
+            return -5;
+         return -1;
+      }
+      ntot += (int)nsent;
+      // Skip the buffers entirely sent.
+      while (ibuf < nbuf && nsent >= lengths[ibuf] - offset) {
+         nsent -= lengths[ibuf] - offset;
+         offset = 0;
+         ++ibuf;
+      }
+      offset += (int)nsent;
+   }
+   return ntot;
+}
+
 //______________________________________________________________________________
 int TUnixSystem::SetSockOpt(int sock, int opt, int val)
 {
@@ -15,6 +15,8 @@
 #include "zlib.h"
 #include "RConfigure.h"
 #include "ZipLZMA.h"
+#include "ZipLZ4.h"
+#include "ZipZSTD.h"
 
 #include <stdio.h>
 
@@ -152,6 +154,10 @@ ulg R__bits_sent;   /* bit length of the compressed data */
    R__ZipMode = 2 : LZMA compression algorithm is used
    R__ZipMode = 0 or 3 : a very old compression algorithm is used
    (the very old algorithm is supported for backward compatibility)
+   R__ZipMode = 4 : LZ4 compression algorithm is used
+   R__ZipMode = 5 : ZSTD compression algorithm is used
+   LZ4 and ZSTD are only available if ROOT was built with the corresponding
+   option, otherwise ZLIB is used instead.
    The LZMA algorithm requires the external XZ package be installed when linking
    is done. LZMA typically has significantly higher compression factors, but takes
    more CPU time and memory resources while compressing.
@@ -421,6 +427,8 @@ void R__zipMultipleAlgorithm(int cxlevel, int *srcsize, char *src, int *tgtsize,
      /*                      1 = zlib */
      /*                      2 = lzma */
      /*                      3 = old */
+     /*                      4 = lz4 */
+     /*                      5 = zstd */
 {
   int err;
   int method   = Z_DEFLATED;
@@ -440,6 +448,20 @@ void R__zipMultipleAlgorithm(int cxlevel, int *srcsize, char *src, int *tgtsize,
     return;
   }
 
+#ifdef R__HAS_LZ4
+  if (compressionAlgorithm == 4) {
+    R__zipLZ4(cxlevel, srcsize, src, tgtsize, tgt, irep);
+    return;
+  }
+#endif
+
+#ifdef R__HAS_ZSTD
+  if (compressionAlgorithm == 5) {
+    R__zipZSTD(cxlevel, srcsize, src, tgtsize, tgt, irep);
+    return;
+  }
+#endif
+
   // The very old algorithm for backward compatibility
   // 0 for selecting with R__ZipMode in a backward compatible way
   // 3 for selecting in other cases
@@ -495,14 +517,21 @@ void R__zipMultipleAlgorithm(int cxlevel, int *srcsize, char *src, int *tgtsize,
   // algorithm setting
   } else {
 
+    /* Only local state is used on this path (no error_flag, in_size or
+       out_size globals) so that several buffers can be compressed
+       concurrently, see TTree::SetParallelCompression. */
     z_stream stream;
+    unsigned zin_size, zout_size;
     *irep = 0;
 
-    error_flag   = 0;
-    if (*tgtsize <= 0) R__error("target buffer too small");
-    if (error_flag != 0) return;
-    if (*srcsize > 0xffffff) R__error("source buffer too big");
-    if (error_flag != 0) return;
+    if (*tgtsize <= 0) {
+       if (verbose) fprintf(stderr,"R__zip: target buffer too small\n");
+       return;
+    }
+    if (*srcsize > 0xffffff) {
+       if (verbose) fprintf(stderr,"R__zip: source buffer too big\n");
+       return;
+    }
 
 
     stream.next_in   = (Bytef*)src;
@@ -538,15 +567,15 @@ void R__zipMultipleAlgorithm(int cxlevel, int *srcsize, char *src, int *tgtsize,
     tgt[1] = 'L';
     tgt[2] = (char) method;
 
-    in_size   = (unsigned) (*srcsize);
-    out_size  = stream.total_out;             /* compressed size */
-    tgt[3] = (char)(out_size & 0xff);
-    tgt[4] = (char)((out_size >> 8) & 0xff);
-    tgt[5] = (char)((out_size >> 16) & 0xff);
+    zin_size  = (unsigned) (*srcsize);
+    zout_size = stream.total_out;             /* compressed size */
+    tgt[3] = (char)(zout_size & 0xff);
+    tgt[4] = (char)((zout_size >> 8) & 0xff);
+    tgt[5] = (char)((zout_size >> 16) & 0xff);
 
-    tgt[6] = (char)(in_size & 0xff);         /* decompressed size */
-    tgt[7] = (char)((in_size >> 8) & 0xff);
-    tgt[8] = (char)((in_size >> 16) & 0xff);
+    tgt[6] = (char)(zin_size & 0xff);         /* decompressed size */
+    tgt[7] = (char)((zin_size >> 8) & 0xff);
+    tgt[8] = (char)((zin_size >> 16) & 0xff);
 
     *irep = stream.total_out + HDRSIZE;
     return;
@@ -25,6 +25,12 @@ namespace ROOT {
    // in greater compression factors, but takes more CPU time
    // and memory when compressing.  LZMA memory usage is particularly
    // high for compression levels 8 and 9.
+   // The LZ4 algorithm compresses less than ZLIB but decompresses
+   // several times faster, which makes it a good choice for data
+   // that is read often. The ZSTD algorithm reaches compression
+   // factors close to LZMA with a decompression speed better than
+   // ZLIB. LZ4 and ZSTD require ROOT to be built with the lz4 and
+   // zstd options; otherwise ZLIB is used when writing.
    //
    // The current algorithms support level 1 to 9. The higher
    // the level the greater the compression and more CPU time
@@ -34,6 +40,8 @@ namespace ROOT {
                                 kZLIB,
                                 kLZMA,
                                 kOldCompressionAlgo,
+                                kLZ4,
+                                kZSTD,
                                 // if adding new algorithm types,
                                 // keep this enum value last
                                 kUndefinedCompressionAlgorithm
@@ -0,0 +1,99 @@
+// @(#)root/zstd:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#include "ZipZSTD.h"
+#include "RConfigure.h"
+#include <stdio.h>
+
+#ifdef R__HAS_ZSTD
+#include "zstd.h"
+
+static const int kHeaderSize = 9;
+
+/* The ROOT levels 1 to 9 are spread over the ZSTD levels 1 to 19. */
+static const int kZSTDLevels[10] = { 1, 1, 2, 3, 5, 7, 9, 12, 16, 19 };
+#endif
+
+void R__zipZSTD(int cxlevel, int *srcsize, char *src, int *tgtsize, char *tgt, int *irep)
+{
+#ifdef R__HAS_ZSTD
+   size_t out_size;               /* compressed size */
+   unsigned in_size = (unsigned) (*srcsize);
+
+   *irep = 0;
+
+   if (*tgtsize <= kHeaderSize) {
+      return;
+   }
+
+   if (*srcsize > 0xffffff || *srcsize < 0) {
+      return;
+   }
+
+   if (cxlevel > 9) cxlevel = 9;
+   if (cxlevel < 1) cxlevel = 1;
+   out_size = ZSTD_compress(&tgt[kHeaderSize], (size_t)(*tgtsize - kHeaderSize),
+                            src, (size_t)(*srcsize), kZSTDLevels[cxlevel]);
+   if (ZSTD_isError(out_size) || out_size > 0xffffff) {
+      /* No need to print an error message: the buffer could not be
+         compressed into the target, it will be stored uncompressed */
+      return;
+   }
+
+   tgt[0] = 'Z';  /* Signature of ZSTD */
+   tgt[1] = 'S';
+   tgt[2] = 1;    /* Version of the envelope */
+
+   tgt[3] = (char)(out_size & 0xff);
+   tgt[4] = (char)((out_size >> 8) & 0xff);
+   tgt[5] = (char)((out_size >> 16) & 0xff);
+
+   tgt[6] = (char)(in_size & 0xff);         /* decompressed size */
+   tgt[7] = (char)((in_size >> 8) & 0xff);
+   tgt[8] = (char)((in_size >> 16) & 0xff);
+
+   *irep = (int)out_size + kHeaderSize;
+#else
+   (void)cxlevel; (void)srcsize; (void)src; (void)tgtsize; (void)tgt;
+   *irep = 0;
+#endif
+}
+
+void R__unzipZSTD(int *srcsize, unsigned char *src, int *tgtsize, unsigned char *tgt, int *irep)
+{
+#ifdef R__HAS_ZSTD
+   size_t out_size;
+   size_t isize = src[6] | (src[7] << 8) | (src[8] << 16); /* decompressed size */
+
+   *irep = 0;
+
+   out_size = ZSTD_decompress(tgt, (size_t)(*tgtsize),
+                              &src[kHeaderSize], (size_t)(*srcsize - kHeaderSize));
+   if (ZSTD_isError(out_size)) {
+      fprintf(stderr,
+              "R__unzipZSTD: error in ZSTD_decompress: %s\n",
+              ZSTD_getErrorName(out_size));
+      return;
+   }
+   if (out_size != isize) {
+      fprintf(stderr,
+              "R__unzipZSTD: discrepancy in decompressed size: %d instead of %d\n",
+              (int)out_size, (int)isize);
+      return;
+   }
+
+   *irep = (int)out_size;
+#else
+   (void)srcsize; (void)src; (void)tgtsize; (void)tgt;
+   *irep = 0;
+   fprintf(stderr,
+           "R__unzipZSTD: buffer compressed with ZSTD but ROOT was built without ZSTD support\n");
+#endif
+}
@@ -98,6 +98,7 @@ public:
    virtual Int_t      FindBin(Double_t x);
    virtual Int_t      FindBin(const char *label);
    virtual Int_t      FindFixBin(Double_t x) const;
+           void       FindFixBins(Int_t n, const Double_t *x, Int_t *bins) const;
    virtual Double_t   GetBinCenter(Int_t bin) const;
    virtual Double_t   GetBinCenterLog(Int_t bin) const;
    const char        *GetBinLabel(Int_t bin) const;
@@ -67,6 +67,7 @@ class TFormula : public TNamed {
 protected:
 
    typedef Double_t (TObject::*TFuncG)(const Double_t*,const Double_t*) const;
+   typedef Double_t (*TJitFunc_t)(const Double_t*,const Double_t*,const Double_t*);
 
    Int_t      fNdim;            //Dimension of function (1=1-Dim, 2=2-Dim,etc)
    Int_t      fNpar;            //Number of parameters
@@ -94,6 +95,7 @@ protected:
    TOperOffset         *fOperOffset;     //![fNOperOptimized]         Offsets of operrands
    TFormulaPrimitive  **fPredefined;      //![fNPar] predefined function  
    TFuncG               fOptimal; //!pointer to optimal function
+   TJitFunc_t           fJitFunc; //!pointer to the function compiled by Jit()
 
    Int_t             PreCompile();
    virtual Bool_t    CheckOperands(Int_t operation, Int_t &err);
@@ -119,11 +121,15 @@ protected:
 
    void            ClearFormula(Option_t *option="");
    virtual Bool_t  IsString(Int_t oper) const;
+   Long_t          JitCompile(const char *declarations, const char *signature, const TString &body) const;
+   TString         MakeJitBody() const;
+   virtual Int_t   MakeJitOperator(Int_t i, TString &statement, Int_t &need, Int_t &delta, Int_t &jump) const;
 
    virtual void    Convert(UInt_t fromVersion); 
    //
    // Functions  - used for formula evaluation
    Double_t        EvalParFast(const Double_t *x, const Double_t *params);
+   Double_t        EvalParJit(const Double_t *x, const Double_t *params);
    Double_t        EvalPrimitive(const Double_t *x, const Double_t *params);
    Double_t        EvalPrimitive0(const Double_t *x, const Double_t *params);
    Double_t        EvalPrimitive1(const Double_t *x, const Double_t *params);
@@ -245,7 +251,9 @@ public:
    virtual const char *GetParName(Int_t ipar) const;
    virtual Int_t       GetParNumber(const char *name) const;
    virtual Bool_t      IsLinear() {return TestBit(kLinear);}
+   virtual Bool_t      IsJitted() const {return fJitFunc != 0;}
    virtual Bool_t      IsNormalized() {return TestBit(kNormalized);}
+   virtual Bool_t      Jit();
    virtual void        Print(Option_t *option="") const; // *MENU*
    virtual void        ProcessLinear(TString &replaceformula);
    virtual void        SetNumber(Int_t number) {fNumber = number;}
@@ -262,6 +270,8 @@ public:
                                    *name8="p8",const char *name9="p9",const char *name10="p10"); // *MENU*
    virtual void        Update() {;}
 
+   static  Bool_t      GetDefaultJit();
+   static  void        SetDefaultJit(Bool_t jit=kTRUE);
    static  void        SetMaxima(Int_t maxop=1000, Int_t maxpar=1000, Int_t maxconst=1000);
    
    ClassDef(TFormula,8)  //The formula base class  f(x,y,z,par)
@@ -301,6 +301,7 @@ public:
    virtual Int_t    GetQuantiles(Int_t nprobSum, Double_t *q, const Double_t *probSum=0);
    virtual Double_t GetRandom() const;
    virtual void     GetStats(Double_t *stats) const;
+   static  Bool_t   GetStatOverflows();
            Double_t GetStdDev(Int_t axis=1) const { return GetRMS(axis); }                  
            Double_t GetStdDevError(Int_t axis=1) const { return GetRMSError(axis); }
    virtual Double_t GetSumOfWeights() const;
@@ -422,6 +423,7 @@ public:
    ClassDef(TH1,7)  //1-Dim histogram base class
 
 protected: 
+   virtual void     AddBinContents(Int_t n, const Int_t *bins, const Double_t *w);
    virtual Double_t RetrieveBinContent(Int_t bin) const;
    virtual void     UpdateBinContent(Int_t bin, Double_t content);
    virtual Double_t GetBinErrorSqUnchecked(Int_t bin) const { return fSumw2.fN ? fSumw2.fArray[bin] : RetrieveBinContent(bin); }
@@ -581,6 +583,9 @@ public:
    friend  TH1F     operator/(const TH1F &h1, const TH1F &h2);
 
 protected:
+   virtual void     AddBinContents(Int_t n, const Int_t *bins, const Double_t *w)
+                        { if (w) for (Int_t i = 0; i < n; ++i) fArray[bins[i]] += Float_t (w[i]);
+                          else   for (Int_t i = 0; i < n; ++i) ++fArray[bins[i]]; }
    virtual Double_t RetrieveBinContent(Int_t bin) const { return Double_t (fArray[bin]); }
    virtual void     UpdateBinContent(Int_t bin, Double_t content) { fArray[bin] = Float_t (content); }
 };
@@ -624,6 +629,9 @@ public:
    friend  TH1D     operator/(const TH1D &h1, const TH1D &h2);
 
 protected:
+   virtual void     AddBinContents(Int_t n, const Int_t *bins, const Double_t *w)
+                        { if (w) for (Int_t i = 0; i < n; ++i) fArray[bins[i]] += Double_t (w[i]);
+                          else   for (Int_t i = 0; i < n; ++i) ++fArray[bins[i]]; }
    virtual Double_t RetrieveBinContent(Int_t bin) const { return fArray[bin]; }
    virtual void     UpdateBinContent(Int_t bin, Double_t content) { fArray[bin] = content; }
 };
@@ -285,6 +285,9 @@ public:
    friend  TH2F     operator/(TH2F &h1, TH2F &h2);
 
 protected:
+   virtual void     AddBinContents(Int_t n, const Int_t *bins, const Double_t *w)
+                        { if (w) for (Int_t i = 0; i < n; ++i) fArray[bins[i]] += Float_t (w[i]);
+                          else   for (Int_t i = 0; i < n; ++i) ++fArray[bins[i]]; }
    virtual Double_t RetrieveBinContent(Int_t bin) const { return Double_t (fArray[bin]); }
    virtual void     UpdateBinContent(Int_t bin, Double_t content) { fArray[bin] = Float_t (content); }
 
@@ -326,6 +329,9 @@ public:
    friend  TH2D     operator/(TH2D &h1, TH2D &h2);
 
 protected:
+   virtual void     AddBinContents(Int_t n, const Int_t *bins, const Double_t *w)
+                        { if (w) for (Int_t i = 0; i < n; ++i) fArray[bins[i]] += Double_t (w[i]);
+                          else   for (Int_t i = 0; i < n; ++i) ++fArray[bins[i]]; }
    virtual Double_t RetrieveBinContent(Int_t bin) const { return fArray[bin]; }
    virtual void     UpdateBinContent(Int_t bin, Double_t content) { fArray[bin] = content; }
 
@@ -65,6 +65,8 @@ protected:
    Int_t    Fill(Double_t,const char*,Double_t) {return Fill(0);} //MayNotUse
    Int_t    Fill(const char*,Double_t,Double_t) {return Fill(0);} //MayNotUse
    Int_t    Fill(const char*,const char*,Double_t) {return Fill(0);} //MayNotUse
+   virtual void     FillN(Int_t, const Double_t *, const Double_t *, Int_t) {;} //MayNotUse
+   virtual void     FillN(Int_t, const Double_t *, const Double_t *, const Double_t *, Int_t) {;} //MayNotUse
 
 private: 
 
@@ -84,6 +86,7 @@ public:
    virtual Int_t    Fill(Double_t x, const char *namey, const char *namez, Double_t w);
    virtual Int_t    Fill(Double_t x, const char *namey, Double_t z, Double_t w);
    virtual Int_t    Fill(Double_t x, Double_t y, const char *namez, Double_t w);
+   virtual void     FillN(Int_t ntimes, const Double_t *x, const Double_t *y, const Double_t *z, const Double_t *w, Int_t stride=1);
 
    virtual void     FillRandom(const char *fname, Int_t ntimes=5000);
    virtual void     FillRandom(TH1 *h, Int_t ntimes=5000);
@@ -286,6 +289,9 @@ public:
    friend  TH3F      operator/(TH3F &h1, TH3F &h2);
 
 protected:
+   virtual void     AddBinContents(Int_t n, const Int_t *bins, const Double_t *w)
+                        { if (w) for (Int_t i = 0; i < n; ++i) fArray[bins[i]] += Float_t (w[i]);
+                          else   for (Int_t i = 0; i < n; ++i) ++fArray[bins[i]]; }
    virtual Double_t RetrieveBinContent(Int_t bin) const { return Double_t (fArray[bin]); }
    virtual void     UpdateBinContent(Int_t bin, Double_t content) { fArray[bin] = Float_t (content); }
 
@@ -323,6 +329,9 @@ public:
    friend  TH3D      operator/(TH3D &h1, TH3D &h2);
 
 protected:
+   virtual void     AddBinContents(Int_t n, const Int_t *bins, const Double_t *w)
+                        { if (w) for (Int_t i = 0; i < n; ++i) fArray[bins[i]] += Double_t (w[i]);
+                          else   for (Int_t i = 0; i < n; ++i) ++fArray[bins[i]]; }
    virtual Double_t RetrieveBinContent(Int_t bin) const { return fArray[bin]; }
    virtual void     UpdateBinContent(Int_t bin, Double_t content) { fArray[bin] = content; }
 
@@ -23,9 +23,6 @@
 #ifndef ROOT_THnBase
 #include "THnBase.h"
 #endif
-#ifndef ROOT_TExMap
-#include "TExMap.h"
-#endif
 #ifndef ROOT_THnSparse_Internal
 #include "THnSparse_Internal.h"
 #endif
@@ -47,6 +44,7 @@
 #include "TArrayC.h"
 #endif
 
+class THnSparseBinIndex;
 class THnSparseCompactBinCoord;
 
 class THnSparse: public THnBase {
@@ -54,8 +52,7 @@ class THnSparse: public THnBase {
    Int_t      fChunkSize;    // number of entries for each chunk
    Long64_t   fFilledBins;   // number of filled bins
    TObjArray  fBinContent;   // array of THnSparseArrayChunk
-   TExMap     fBins;         //! filled bins
-   TExMap     fBinsContinued;//! filled bins for non-unique hashes, containing pairs of (bin index 0, bin index 1)
+   THnSparseBinIndex *fBinIndex; //! index of the filled bins by hash of their compact coordinate
    THnSparseCompactBinCoord *fCompactCoord; //! compact coordinate
 
    THnSparse(const THnSparse&); // Not implemented
@@ -73,8 +70,9 @@ class THnSparse: public THnBase {
 
    THnSparseArrayChunk* AddChunk();
    void Reserve(Long64_t nbins);
-   void FillExMap();
+   void FillBinIndex();
    virtual TArray* GenerateArray() const = 0;
+   Long64_t GetBinIndex(ULong64_t hash, const Char_t* buf, Bool_t allocate);
    Long64_t GetBinIndexForCurrentBin(Bool_t allocate);
    void FillBin(Long64_t bin, Double_t w) {
       // Increment the bin content of "bin" by "w",
@@ -99,6 +97,8 @@ class THnSparse: public THnBase {
                                        chunkSize);
    }
 
+   void FillN(Long64_t n, const Double_t* x, const Double_t* w = 0);
+
    Int_t GetChunkSize() const { return fChunkSize; }
    Int_t GetNChunks() const { return fBinContent.GetEntriesFast(); }
 
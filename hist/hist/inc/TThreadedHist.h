@@ -0,0 +1,458 @@
+// @(#)root/hist:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#ifndef ROOT_TThreadedHist
+#define ROOT_TThreadedHist
+
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TThreadedHist                                                        //
+//                                                                      //
+// Fill a histogram (TH1, TH2, TH3, THnSparse and their derived         //
+// classes) from several threads at the same time, without a global     //
+// lock. The fills of each thread go to one of:                         //
+//                                                                      //
+//  - kPerThread: a clone of the histogram per thread (the default),    //
+//    added to the histogram by Merge();                                //
+//  - kBuffered: a buffer of fills per thread; a full buffer is         //
+//    replayed in the histogram under a lock, the others by Merge();    //
+//  - kAtomic: the bins of the histogram itself, incremented with       //
+//    atomic additions; the statistics (entries, sums of weights and    //
+//    moments) are kept per thread and added by Merge(). Only for the   //
+//    TH1F, TH1D, TH2F, TH2D, TH3F and TH3D with fixed axes; the other  //
+//    histograms use kBuffered. Suited to histograms with many bins     //
+//    and few collisions between the threads.                           //
+//                                                                      //
+// Merge() must be called, e.g. once the threads are joined, before     //
+// using the histogram; it is also called by the destructor. Merge()    //
+// does nothing if no fill is pending, so that the histogram may be     //
+// used and modified after the last Merge(). Otherwise, while the       //
+// histogram is wrapped it must not be modified other than through the  //
+// TThreadedHist.                                                       //
+//                                                                      //
+//    TH1D *h = new TH1D("h", "px", 100, -4, 4);                        //
+//    TThreadedHist<TH1D> th(h);                                        //
+//    ... // in each thread: th.Fill(px);                               //
+//    ... // join the threads                                           //
+//    th.Merge();                                                       //
+//    h->Draw();                                                        //
+//                                                                      //
+// The threads must be known to ROOT (see TThread::Initialize). In      //
+// kPerThread mode, each thread clones the histogram at its first fill  //
+// under gROOTMutex, without adding the clone to a directory.           //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef ROOT_TH1
+#include "TH1.h"
+#endif
+#ifndef ROOT_TArrayD
+#include "TArrayD.h"
+#endif
+#ifndef ROOT_TArrayF
+#include "TArrayF.h"
+#endif
+#ifndef ROOT_TList
+#include "TList.h"
+#endif
+#ifndef ROOT_TMutex
+#include "TMutex.h"
+#endif
+#ifndef ROOT_TROOT
+#include "TROOT.h"
+#endif
+#ifndef ROOT_TThread
+#include "TThread.h"
+#endif
+#ifndef ROOT_TAtomicCount
+#include "TAtomicCount.h"
+#endif
+#ifndef ROOT_TError
+#include "TError.h"
+#endif
+
+#include <string.h>
+#include <vector>
+
+#if defined(__GNUC__) && !defined(__CINT__)
+#define R__THREADEDHIST_CAS
+#endif
+
+
+template <class HIST>
+class TThreadedHist {
+
+public:
+   enum EMode { kPerThread, kBuffered, kAtomic };
+   enum { kMaxThreads = 1024 };
+
+private:
+   typedef void (*FillFunc_t)(HIST *hist, const Double_t *args);
+
+   struct TFill {
+      FillFunc_t fFunc;      // Fill method of HIST to call
+      UInt_t     fArgs;      // Index of its arguments in TSlot::fArgs
+   };
+
+   struct TSlot {
+      // The state of one thread.
+      Long_t                fThreadId;           // Id of the thread
+      HIST                 *fHist;               // Clone of the histogram (kPerThread)
+      std::vector<TFill>    fFills;              // Fills not yet done in the histogram (kBuffered)
+      std::vector<Double_t> fArgs;               // Arguments of these fills (kBuffered)
+      Double_t              fStats[TH1::kNstat]; // Sums of weights and moments (kAtomic)
+      Double_t              fEntries;            // Number of entries (kAtomic)
+
+      TSlot(Long_t id) : fThreadId(id), fHist(0), fEntries(0) { memset(fStats, 0, sizeof(fStats)); }
+      ~TSlot() { delete fHist; }
+   };
+
+   HIST         *fHist;                  // Histogram filled
+   TH1          *fH1;                    // fHist as a TH1, 0 for a THnBase
+   EMode         fMode;                  // How the threads fill the histogram
+   UInt_t        fBufferSize;            // Number of fills buffered per thread (kBuffered)
+   Double_t     *fContentD;              // Bin contents of fHist stored as doubles (kAtomic)
+   Float_t      *fContentF;              // Bin contents of fHist stored as floats (kAtomic)
+   Double_t     *fSumw2;                 // Sums of squares of weights of fHist (kAtomic)
+   Double_t      fStats[TH1::kNstat];    // Statistics of fHist at the last merge (kAtomic)
+   TMutex        fMutex;                 // Protects the creation of the slots and fHist in kBuffered mode
+   TSlot        *fSlots[kMaxThreads];    // State of each thread
+   TAtomicCount  fNSlots;                // Number of slots in use
+
+   TThreadedHist(const TThreadedHist&);            // not implemented
+   TThreadedHist &operator=(const TThreadedHist&); // not implemented
+
+   //______________________________________________________________________________
+   static void FillArgs1(HIST *h, const Double_t *a) { h->Fill(a[0]); }
+   static void FillArgs2(HIST *h, const Double_t *a) { h->Fill(a[0], a[1]); }
+   static void FillArgs3(HIST *h, const Double_t *a) { h->Fill(a[0], a[1], a[2]); }
+   static void FillArgs4(HIST *h, const Double_t *a) { h->Fill(a[0], a[1], a[2], a[3]); }
+   static void FillArray(HIST *h, const Double_t *a) { h->Fill(a, a[h->GetNdimensions()]); }
+
+   //______________________________________________________________________________
+   void AtomicAdd(Double_t *addr, Double_t v)
+   {
+      // Add v to *addr, atomically.
+
+#ifdef R__THREADEDHIST_CAS
+      union { Long64_t fL; Double_t fD; } oldv, newv;
+      do {
+         oldv.fL = *(volatile Long64_t*)addr;
+         newv.fD = oldv.fD + v;
+      } while (!__sync_bool_compare_and_swap((Long64_t*)addr, oldv.fL, newv.fL));
+#else
+      TLockGuard lock(&fMutex);
+      *addr += v;
+#endif
+   }
+
+   //______________________________________________________________________________
+   void AtomicAdd(Float_t *addr, Double_t v)
+   {
+      // Add v to *addr, atomically.
+
+#ifdef R__THREADEDHIST_CAS
+      union { Int_t fI; Float_t fF; } oldv, newv;
+      do {
+         oldv.fI = *(volatile Int_t*)addr;
+         newv.fF = oldv.fF + v;
+      } while (!__sync_bool_compare_and_swap((Int_t*)addr, oldv.fI, newv.fI));
+#else
+      TLockGuard lock(&fMutex);
+      *addr += v;
+#endif
+   }
+
+   //______________________________________________________________________________
+   HIST *CloneEmpty()
+   {
+      // Return an empty clone of fHist attached to no directory. Cloning
+      // streams fHist and may look at gDirectory and the list of classes,
+      // so it is serialised with the other users of the global state.
+
+      R__LOCKGUARD2(gROOTMutex);
+      Bool_t adddir = TH1::AddDirectoryStatus();
+      TH1::AddDirectory(kFALSE);
+      HIST *clone = (HIST*)fHist->Clone();
+      TH1::AddDirectory(adddir);
+      TH1 *h1 = dynamic_cast<TH1*>(clone);
+      if (h1) h1->SetDirectory(0);
+      clone->Reset();
+      return clone;
+   }
+
+   //______________________________________________________________________________
+   Bool_t CanFillAtomically()
+   {
+      // Return kTRUE if the bins of fHist can be filled with atomic additions,
+      // and set fContentD or fContentF.
+
+      if (!fH1 || fH1->GetBuffer()) return kFALSE;
+      if (fH1->GetXaxis()->CanExtend() || fH1->GetYaxis()->CanExtend() || fH1->GetZaxis()->CanExtend()) return kFALSE;
+      static const char *classes[] = { "TH1F", "TH1D", "TH2F", "TH2D", "TH3F", "TH3D" };
+      const char *cl = fH1->ClassName();
+      Bool_t ok = kFALSE;
+      for (UInt_t i = 0; i < sizeof(classes) / sizeof(classes[0]); ++i) {
+         if (!strcmp(cl, classes[i])) ok = kTRUE;
+      }
+      if (!ok) return kFALSE;
+      TArrayD *ad = dynamic_cast<TArrayD*>(fH1);
+      TArrayF *af = dynamic_cast<TArrayF*>(fH1);
+      if (ad) fContentD = ad->GetArray();
+      if (af) fContentF = af->GetArray();
+      return fContentD || fContentF;
+   }
+
+   //______________________________________________________________________________
+   void FillAtomic(const Double_t *a, Int_t nargs)
+   {
+      // Fill fHist with the coordinates in a, followed by the weight if
+      // nargs is larger than the dimension of the histogram.
+
+      Int_t dim = fH1->GetDimension();
+      if (nargs < dim || nargs > dim + 1) {
+         ::Error("TThreadedHist::Fill", "%d arguments for a histogram of dimension %d", nargs, dim);
+         return;
+      }
+      Double_t w = nargs > dim ? a[dim] : 1.;
+      Double_t x = a[0];
+      Double_t y = dim > 1 ? a[1] : 0;
+      Double_t z = dim > 2 ? a[2] : 0;
+      Int_t binx = fH1->GetXaxis()->FindFixBin(x);
+      Int_t biny = dim > 1 ? fH1->GetYaxis()->FindFixBin(y) : 0;
+      Int_t binz = dim > 2 ? fH1->GetZaxis()->FindFixBin(z) : 0;
+      Int_t bin = fH1->GetBin(binx, biny, binz);
+      if (fContentD) AtomicAdd(fContentD + bin, w);
+      else           AtomicAdd(fContentF + bin, w);
+      AtomicAdd(fSumw2 + bin, w * w);
+
+      TSlot *slot = GetSlot();
+      slot->fEntries += 1;
+      if (!TH1::GetStatOverflows()) {
+         if (binx == 0 || binx > fH1->GetXaxis()->GetNbins()) return;
+         if (dim > 1 && (biny == 0 || biny > fH1->GetYaxis()->GetNbins())) return;
+         if (dim > 2 && (binz == 0 || binz > fH1->GetZaxis()->GetNbins())) return;
+      }
+      Double_t *s = slot->fStats;
+      s[0] += w;
+      s[1] += w * w;
+      s[2] += w * x;
+      s[3] += w * x * x;
+      if (dim > 1) {
+         s[4] += w * y;
+         s[5] += w * y * y;
+         s[6] += w * x * y;
+      }
+      if (dim > 2) {
+         s[7] += w * z;
+         s[8] += w * z * z;
+         s[9] += w * x * z;
+         s[10] += w * y * z;
+      }
+   }
+
+   //______________________________________________________________________________
+   void Flush(TSlot *slot)
+   {
+      // Replay the buffered fills of slot in fHist.
+
+      TLockGuard lock(&fMutex);
+      for (UInt_t i = 0; i < slot->fFills.size(); ++i) {
+         slot->fFills[i].fFunc(fHist, &slot->fArgs[slot->fFills[i].fArgs]);
+      }
+      slot->fFills.clear();
+      slot->fArgs.clear();
+   }
+
+   //______________________________________________________________________________
+   TSlot *GetSlot()
+   {
+      // Return the slot of the calling thread, created at its first fill.
+
+      Long_t id = TThread::SelfId();
+      Long_t n = fNSlots.Get();
+      for (Long_t i = 0; i < n; ++i) {
+         if (fSlots[i]->fThreadId == id) return fSlots[i];
+      }
+
+      // Only this thread adds its slot: no need to look again. The clone is
+      // made before taking fMutex, which is never held with gROOTMutex.
+      TSlot *slot = new TSlot(id);
+      if (fMode == kPerThread) {
+         slot->fHist = CloneEmpty();
+      } else if (fMode == kBuffered) {
+         slot->fFills.reserve(fBufferSize);
+      }
+      TLockGuard lock(&fMutex);
+      n = fNSlots.Get();
+      if (n >= kMaxThreads) {
+         ::Fatal("TThreadedHist::Fill", "more than %d threads fill the histogram", (Int_t)kMaxThreads);
+      }
+      fSlots[n] = slot;
+      ++fNSlots;
+      return slot;
+   }
+
+   //______________________________________________________________________________
+   void Push(FillFunc_t func, const Double_t *a, Int_t nargs)
+   {
+      // Buffer a fill of fHist by the calling thread, replay the buffer if full.
+
+      TSlot *slot = GetSlot();
+      TFill fill;
+      fill.fFunc = func;
+      fill.fArgs = slot->fArgs.size();
+      slot->fArgs.insert(slot->fArgs.end(), a, a + nargs);
+      slot->fFills.push_back(fill);
+      if (slot->fFills.size() >= fBufferSize) Flush(slot);
+   }
+
+public:
+   //______________________________________________________________________________
+   TThreadedHist(HIST *hist, EMode mode = kPerThread, UInt_t bufsize = 1000) :
+      fHist(hist), fH1(0), fMode(mode), fBufferSize(bufsize > 0 ? bufsize : 1),
+      fContentD(0), fContentF(0), fSumw2(0), fNSlots(0)
+   {
+      // Fill hist, which is not adopted, from several threads. In kBuffered
+      // mode each thread replays its fills once it has buffered bufsize of
+      // them. kAtomic mode calls hist->Sumw2().
+
+      memset(fStats, 0, sizeof(fStats));
+      fH1 = dynamic_cast<TH1*>(fHist);
+      if (fMode == kAtomic) {
+         if (!CanFillAtomically()) {
+            ::Warning("TThreadedHist::TThreadedHist", "%s cannot be filled atomically, using kBuffered",
+                      fHist->GetName());
+            fMode = kBuffered;
+         } else {
+            if (!fH1->GetSumw2N()) fH1->Sumw2();
+            fSumw2 = fH1->GetSumw2()->GetArray();
+            fH1->GetStats(fStats);
+         }
+      }
+   }
+
+   //______________________________________________________________________________
+   ~TThreadedHist()
+   {
+      // Merge the pending fills in the histogram.
+
+      Merge();
+      Long_t n = fNSlots.Get();
+      for (Long_t i = 0; i < n; ++i) delete fSlots[i];
+   }
+
+   EMode    GetMode() const { return fMode; }
+   HIST    *GetHist() const { return fHist; }
+   Int_t    GetNThreads() const { return fNSlots.Get(); }
+
+   //______________________________________________________________________________
+   void Fill(Double_t a)
+   {
+      // Call HIST::Fill(a).
+
+      Double_t args[1] = { a };
+      if (fMode == kPerThread)   GetSlot()->fHist->Fill(a);
+      else if (fMode == kAtomic) FillAtomic(args, 1);
+      else                       Push(&FillArgs1, args, 1);
+   }
+
+   //______________________________________________________________________________
+   void Fill(Double_t a, Double_t b)
+   {
+      // Call HIST::Fill(a, b).
+
+      Double_t args[2] = { a, b };
+      if (fMode == kPerThread)   GetSlot()->fHist->Fill(a, b);
+      else if (fMode == kAtomic) FillAtomic(args, 2);
+      else                       Push(&FillArgs2, args, 2);
+   }
+
+   //______________________________________________________________________________
+   void Fill(Double_t a, Double_t b, Double_t c)
+   {
+      // Call HIST::Fill(a, b, c).
+
+      Double_t args[3] = { a, b, c };
+      if (fMode == kPerThread)   GetSlot()->fHist->Fill(a, b, c);
+      else if (fMode == kAtomic) FillAtomic(args, 3);
+      else                       Push(&FillArgs3, args, 3);
+   }
+
+   //______________________________________________________________________________
+   void Fill(Double_t a, Double_t b, Double_t c, Double_t d)
+   {
+      // Call HIST::Fill(a, b, c, d).
+
+      Double_t args[4] = { a, b, c, d };
+      if (fMode == kPerThread)   GetSlot()->fHist->Fill(a, b, c, d);
+      else if (fMode == kAtomic) FillAtomic(args, 4);
+      else                       Push(&FillArgs4, args, 4);
+   }
+
+   //______________________________________________________________________________
+   void Fill(const Double_t *x, Double_t w = 1.)
+   {
+      // Call HIST::Fill(x, w), for a THnBase.
+
+      if (fMode == kPerThread) {
+         GetSlot()->fHist->Fill(x, w);
+         return;
+      }
+      Int_t ndim = fHist->GetNdimensions();
+      std::vector<Double_t> args(x, x + ndim);
+      args.push_back(w);
+      Push(&FillArray, &args[0], ndim + 1);
+   }
+
+   //______________________________________________________________________________
+   HIST *Merge()
+   {
+      // Add the fills of all the threads not yet in the histogram to it and
+      // return it. No thread may fill meanwhile. The histogram is not
+      // touched if no fill is pending, e.g. when the destructor merges
+      // again after an explicit Merge().
+
+      Long_t n = fNSlots.Get();
+      if (fMode == kPerThread) {
+         TList list;
+         for (Long_t i = 0; i < n; ++i) {
+            if (fSlots[i]->fHist->GetEntries() != 0) list.Add(fSlots[i]->fHist);
+         }
+         if (list.IsEmpty()) return fHist;
+         fHist->Merge(&list);
+         for (Long_t i = 0; i < n; ++i) fSlots[i]->fHist->Reset();
+      } else if (fMode == kBuffered) {
+         for (Long_t i = 0; i < n; ++i) {
+            if (!fSlots[i]->fFills.empty()) Flush(fSlots[i]);
+         }
+      } else {
+         Bool_t pending = kFALSE;
+         for (Long_t i = 0; i < n; ++i) {
+            if (fSlots[i]->fEntries != 0) pending = kTRUE;
+         }
+         if (!pending) return fHist;
+         Double_t entries = fH1->GetEntries();
+         for (Long_t i = 0; i < n; ++i) {
+            TSlot *slot = fSlots[i];
+            for (Int_t s = 0; s < TH1::kNstat; ++s) fStats[s] += slot->fStats[s];
+            entries += slot->fEntries;
+            memset(slot->fStats, 0, sizeof(slot->fStats));
+            slot->fEntries = 0;
+         }
+         fH1->PutStats(fStats);
+         fH1->SetEntries(entries);
+      }
+      return fHist;
+   }
+};
+
+#endif
@@ -371,6 +371,51 @@ Int_t TAxis::FindFixBin(Double_t x) const
    return bin;
 }
 
+//______________________________________________________________________________
+void TAxis::FindFixBins(Int_t n, const Double_t *x, Int_t *bins) const
+{
+   // Set bins[i] to the bin number corresponding to x[i], for i in [0,n),
+   // as FindFixBin does (the axis is not extended).
+   //
+   // The loops have no branch depending on the values, so that the
+   // compiler can vectorize them: the result is selected rather than
+   // computed in the branch of FindFixBin, and the bins of variable size
+   // are found with a binary search of fixed length.
+
+   const Double_t xmin = fXmin;
+   const Double_t xmax = fXmax;
+   const Int_t nbins = fNbins;
+   if (!fXbins.fN) {                 //*-* fix bins
+      const Double_t width = xmax - xmin;
+      for (Int_t i = 0; i < n; ++i) {
+         Double_t xi = x[i];
+         Bool_t inside = !(xi < xmin) && (xi < xmax);   // false for NaN
+         // Only values inside the axis are converted to int.
+         Double_t xc = inside ? xi : xmin;
+         Int_t bin = 1 + int (nbins*(xc-xmin)/width);
+         bins[i] = inside ? bin : (xi < xmin ? 0 : nbins+1);
+      }
+   } else {                          //*-* variable bin sizes
+      const Double_t *edges = fXbins.fArray;
+      const Int_t nedges = fXbins.fN;
+      for (Int_t i = 0; i < n; ++i) {
+         Double_t xi = x[i];
+         Bool_t inside = !(xi < xmin) && (xi < xmax);
+         Double_t xc = inside ? xi : xmin;
+         // Last edge <= xc, as TMath::BinarySearch.
+         const Double_t *base = edges;
+         Int_t len = nedges;
+         while (len > 1) {
+            Int_t half = len / 2;
+            base = (base[half] <= xc) ? base + half : base;
+            len -= half;
+         }
+         Int_t bin = 1 + Int_t(base - edges);
+         bins[i] = inside ? bin : (xi < xmin ? 0 : nbins+1);
+      }
+   }
+}
+
 //______________________________________________________________________________
 const char *TAxis::GetBinLabel(Int_t bin) const
 {
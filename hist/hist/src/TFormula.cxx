@@ -23,12 +23,18 @@
 #include "TError.h"
 #include "TFormulaPrimitive.h"
 #include "TInterpreter.h"
+#include "TVirtualMutex.h"
+
+#include <map>
+#include <string>
+#include <vector>
 
 #ifdef WIN32
 #pragma optimize("",off)
 #endif
 
 static Int_t gMAXOP=1000,gMAXPAR=1000,gMAXCONST=1000;
+static Bool_t gDefaultJit = kFALSE;
 const Int_t  gMAXSTRINGFOUND = 10;
 const UInt_t kOptimizationError = BIT(19);
 
@@ -107,6 +113,17 @@ ClassImp(TFormula)
 //*-*   For more performant access to the information, see the implementation
 //*-*   TFormula::EvalPar
 //*-*
+//*-*   COMPILING FORMULAS
+//*-*   ==================
+//*-*   TFormula::Jit translates the formula into a C++ function, compiled
+//*-*   to machine code by the interpreter (cling), which EvalPar then calls
+//*-*   instead of interpreting the operators. Formulas with the same
+//*-*   operators share the compiled function. Formulas using strings or
+//*-*   calls to functions are still interpreted. To compile all the
+//*-*   formulas created from then on (e.g. those of the TF1 to fit, or the
+//*-*   TTreeFormula of TTree::Draw), call
+//*-*     TFormula::SetDefaultJit();
+//*-*
 //*-*   CHANGING DEFAULT SETTINGS
 //*-*   =========================
 //*-*   When creating complex formula , it may be necessary to increase
@@ -150,6 +167,7 @@ TFormula::TFormula(): TNamed()
    fOperOffset     = 0;
    fPredefined     = 0;
    fOptimal        = (TFormulaPrimitive::TFuncG)&TFormula::EvalParOld;
+   fJitFunc        = 0;
 }
 
 //______________________________________________________________________________
@@ -179,6 +197,7 @@ TFormula::TFormula(const char *name,const char *expression) :
    fOperOffset     = 0;
    fPredefined     = 0;
    fOptimal        = (TFormulaPrimitive::TFuncG)&TFormula::EvalParOld;
+   fJitFunc        = 0;
 
    if (!expression || !*expression) {
       Error("TFormula", "expression may not be 0 or have 0 length");
@@ -286,6 +305,8 @@ TFormula::TFormula(const TFormula &formula) : TNamed()
    fOperOffset     = 0;
    fExprOptimized  = 0;
    fOperOptimized  = 0;
+   fOptimal        = (TFormulaPrimitive::TFuncG)&TFormula::EvalParOld;
+   fJitFunc        = 0;
 
    ((TFormula&)formula).TFormula::Copy(*this);
 }
@@ -2235,6 +2256,10 @@ void TFormula::ClearFormula(Option_t * /*option*/ )
    if (fOperOffset)    { delete [] fOperOffset;    fOperOffset    = 0;}
    if (fExprOptimized) { delete [] fExprOptimized; fExprOptimized = 0;}
    if (fOperOptimized) { delete [] fOperOptimized; fOperOptimized = 0;}
+   if (fJitFunc) {
+      fJitFunc = 0;
+      fOptimal = (TFormulaPrimitive::TFuncG)&TFormula::EvalParOld;
+   }
    // should we also remove the object from the list?
    // gROOT->GetListOfFunctions()->Remove(this);
    // if we don't, what happens if it fails the new compilation?
@@ -2491,6 +2516,7 @@ void TFormula::Copy(TObject &obj) const
    }
    ((TFormula&)obj).fNOperOptimized = fNOperOptimized;
    ((TFormula&)obj).fOptimal = fOptimal;
+   ((TFormula&)obj).fJitFunc = fJitFunc;
 
 }
 
@@ -4044,6 +4070,264 @@ void TFormula::Optimize()
    delete [] map0;
    delete [] offset;
    delete [] optimized;
+
+   if (gDefaultJit) Jit();
+}
+
+//______________________________________________________________________________
+Double_t TFormula::EvalParJit(const Double_t *x, const Double_t *params)
+{
+   // Evaluate the formula with the function compiled by Jit().
+
+   return fJitFunc(x, params ? params : fParams, fConst);
+}
+
+//______________________________________________________________________________
+static TString JitStatement(const char *statement, Int_t pos)
+{
+   // Return statement for a stack of pos values, with @0 replaced by the
+   // value to push, @1 by the top of the stack and @2 by the value below it.
+
+   TString s(statement);
+   s.ReplaceAll("@0", TString::Format("t%d", pos));
+   s.ReplaceAll("@1", TString::Format("t%d", pos - 1));
+   s.ReplaceAll("@2", TString::Format("t%d", pos - 2));
+   return "   " + s + "\n";
+}
+
+//______________________________________________________________________________
+TString TFormula::MakeJitBody() const
+{
+   // Translate the operators of the formula into the body of a C++ function
+   //    double f(const double *x, const double *p, const double *c)
+   // evaluating the formula like EvalParOld for the variables x, the
+   // parameters p and the constants c: each value of the stack of
+   // EvalParOld becomes a local variable, and the jumps become gotos.
+   // Return an empty string if an operator cannot be translated (strings,
+   // calls to functions, variables defined by a derived class). A derived
+   // class translates its own operators in MakeJitOperator.
+
+   if (fNoper <= 0 || !fOper) return "";
+
+   std::vector<Int_t> height(fNoper + 1, -1); // height of the stack before each operator reached by a jump
+   TString code;
+   Int_t pos = 0;
+   Int_t maxpos = 0;
+   Bool_t reachable = kTRUE;
+   const char *norm = TestBit(kNormalized) ? "kTRUE" : "kFALSE";
+
+   for (Int_t i = 0; i <= fNoper; ++i) {
+      if (height[i] >= 0) {
+         if (reachable && height[i] != pos) return "";
+         pos = height[i];
+         reachable = kTRUE;
+         code += TString::Format("L%d:\n", i);
+      }
+      if (!reachable) return "";
+      if (i == fNoper) break;
+
+      const Int_t oper = fOper[i];
+      const Int_t opcode = oper >> kTFOperShift;
+      const Int_t param = oper & kTFOperMask;
+      TString statement;
+      Int_t need = 0;   // number of values the operator takes from the stack
+      Int_t delta = 0;  // change of the height of the stack
+      Int_t jump = -1;  // next operator if the jump is taken
+
+      const Int_t translated = MakeJitOperator(i, statement, need, delta, jump);
+      if (translated < 0) return "";
+      if (translated == 0) switch (opcode) {
+         case kParameter : statement.Form("@0 = p[%d];", param); delta = 1; break;
+         case kConstant  : statement.Form("@0 = c[%d];", param); delta = 1; break;
+         case kVariable  : statement.Form("@0 = x[%d];", param); delta = 1; break;
+
+         case kAdd       : statement = "@2 += @1;"; need = 2; delta = -1; break;
+         case kSubstract : statement = "@2 -= @1;"; need = 2; delta = -1; break;
+         case kMultiply  : statement = "@2 *= @1;"; need = 2; delta = -1; break;
+         case kDivide    : statement = "if (@1 == 0) @2 = 0; else @2 /= @1;"; need = 2; delta = -1; break;
+         case kModulo    : statement = "@2 = double((Long64_t)@2 % (Long64_t)@1);"; need = 2; delta = -1; break;
+
+         case kcos  : statement = "@1 = TMath::Cos(@1);"; need = 1; break;
+         case ksin  : statement = "@1 = TMath::Sin(@1);"; need = 1; break;
+         case ktan  : statement = "if (TMath::Cos(@1) == 0) @1 = 0; else @1 = TMath::Tan(@1);"; need = 1; break;
+         case kacos : statement = "if (TMath::Abs(@1) > 1) @1 = 0; else @1 = TMath::ACos(@1);"; need = 1; break;
+         case kasin : statement = "if (TMath::Abs(@1) > 1) @1 = 0; else @1 = TMath::ASin(@1);"; need = 1; break;
+         case katan : statement = "@1 = TMath::ATan(@1);"; need = 1; break;
+         case kcosh : statement = "@1 = TMath::CosH(@1);"; need = 1; break;
+         case ksinh : statement = "@1 = TMath::SinH(@1);"; need = 1; break;
+         case ktanh : statement = "if (TMath::CosH(@1) == 0) @1 = 0; else @1 = TMath::TanH(@1);"; need = 1; break;
+         case kacosh: statement = "if (@1 < 1) @1 = 0; else @1 = TMath::ACosH(@1);"; need = 1; break;
+         case kasinh: statement = "@1 = TMath::ASinH(@1);"; need = 1; break;
+         case katanh: statement = "if (TMath::Abs(@1) > 1) @1 = 0; else @1 = TMath::ATanH(@1);"; need = 1; break;
+         case katan2: statement = "@2 = TMath::ATan2(@2, @1);"; need = 2; delta = -1; break;
+
+         case kfmod : statement = "@2 = fmod(@2, @1);"; need = 2; delta = -1; break;
+         case kpow  : statement = "@2 = TMath::Power(@2, @1);"; need = 2; delta = -1; break;
+         case ksq   : statement = "@1 = @1 * @1;"; need = 1; break;
+         case ksqrt : statement = "@1 = TMath::Sqrt(TMath::Abs(@1));"; need = 1; break;
+         case kmin  : statement = "@2 = TMath::Min(@2, @1);"; need = 2; delta = -1; break;
+         case kmax  : statement = "@2 = TMath::Max(@2, @1);"; need = 2; delta = -1; break;
+
+         case klog  : statement = "if (@1 > 0) @1 = TMath::Log(@1); else @1 = 0;"; need = 1; break;
+         case kexp  : statement = "if (@1 < -700) @1 = 0; else if (@1 > 700) @1 = TMath::Exp(700); else @1 = TMath::Exp(@1);";
+                      need = 1; break;
+         case klog10: statement = "if (@1 > 0) @1 = TMath::Log10(@1); else @1 = 0;"; need = 1; break;
+
+         case kpi   : statement = "@0 = TMath::ACos(-1);"; delta = 1; break;
+         case kabs  : statement = "@1 = TMath::Abs(@1);"; need = 1; break;
+         case ksign : statement = "if (@1 < 0) @1 = -1; else @1 = 1;"; need = 1; break;
+         case kint  : statement = "@1 = double(Int_t(@1));"; need = 1; break;
+         case kSignInv: statement = "@1 = -1 * @1;"; need = 1; break;
+         case krndm : statement = "@0 = gRandom->Rndm(1);"; delta = 1; break;
+
+         case kAnd        : statement = "if (@2 != 0 && @1 != 0) @2 = 1; else @2 = 0;"; need = 2; delta = -1; break;
+         case kOr         : statement = "if (@2 != 0 || @1 != 0) @2 = 1; else @2 = 0;"; need = 2; delta = -1; break;
+         case kEqual      : statement = "if (@2 == @1) @2 = 1; else @2 = 0;"; need = 2; delta = -1; break;
+         case kNotEqual   : statement = "if (@2 != @1) @2 = 1; else @2 = 0;"; need = 2; delta = -1; break;
+         case kLess       : statement = "if (@2 < @1) @2 = 1; else @2 = 0;"; need = 2; delta = -1; break;
+         case kGreater    : statement = "if (@2 > @1) @2 = 1; else @2 = 0;"; need = 2; delta = -1; break;
+         case kLessThan   : statement = "if (@2 <= @1) @2 = 1; else @2 = 0;"; need = 2; delta = -1; break;
+         case kGreaterThan: statement = "if (@2 >= @1) @2 = 1; else @2 = 0;"; need = 2; delta = -1; break;
+         case kNot        : statement = "if (@1 != 0) @1 = 0; else @1 = 1;"; need = 1; break;
+
+         case kBitAnd    : statement = "@2 = ((Int_t) @2) & ((Int_t) @1);"; need = 2; delta = -1; break;
+         case kBitOr     : statement = "@2 = ((Int_t) @2) | ((Int_t) @1);"; need = 2; delta = -1; break;
+         case kLeftShift : statement = "@2 = ((Int_t) @2) << ((Int_t) @1);"; need = 2; delta = -1; break;
+         case kRightShift: statement = "@2 = ((Int_t) @2) >> ((Int_t) @1);"; need = 2; delta = -1; break;
+
+         case kJump   : jump = param + 1; statement.Form("goto L%d;", jump); break;
+         case kJumpIf : jump = param + 1; statement.Form("if (!@1) goto L%d;", jump); need = 1; delta = -1; break;
+         case kBoolOptimize: {
+            // && and ||: skip the right part if the left part decides
+            jump = i + param / 10 + 1;
+            if (param % 10 == 1)      statement.Form("if (!@1) { @1 = 0; goto L%d; }", jump);
+            else if (param % 10 == 2) statement.Form("if (@1) { @1 = 1; goto L%d; }", jump);
+            else jump = -1;
+            need = 1;
+            break;
+         }
+
+         case kxexpo: case kyexpo: case kzexpo:
+            statement.Form("@0 = TMath::Exp(p[%d]+p[%d]*x[%d]);", param, param + 1, opcode - kxexpo);
+            delta = 1; break;
+         case kxyexpo:
+            statement.Form("@0 = TMath::Exp(p[%d]+p[%d]*x[0]+p[%d]*x[1]);", param, param + 1, param + 2);
+            delta = 1; break;
+         case kxgaus: case kygaus: case kzgaus:
+            statement.Form("@0 = p[%d]*TMath::Gaus(x[%d],p[%d],p[%d],%s);", param, opcode - kxgaus, param + 1, param + 2, norm);
+            delta = 1; break;
+         case kxygaus:
+            statement.Form("{ double i1 = p[%d] == 0 ? 1e10 : double((x[0]-p[%d])/p[%d]);"
+                           " double i2 = p[%d] == 0 ? 1e10 : double((x[1]-p[%d])/p[%d]);"
+                           " @0 = p[%d]*TMath::Exp(-0.5*(i1*i1+i2*i2)); }",
+                           param + 2, param + 1, param + 2, param + 4, param + 3, param + 4, param);
+            delta = 1; break;
+         case kxlandau: case kylandau: case kzlandau:
+            statement.Form("@0 = p[%d]*TMath::Landau(x[%d],p[%d],p[%d],%s);", param, opcode - kxlandau, param + 1, param + 2, norm);
+            delta = 1; break;
+         case kxylandau:
+            statement.Form("@0 = p[%d]*TMath::Landau(x[0],p[%d],p[%d],%s)*TMath::Landau(x[1],p[%d],p[%d],%s);",
+                           param, param + 1, param + 2, norm, param + 3, param + 4, norm);
+            delta = 1; break;
+         case kxpol: case kypol: case kzpol: {
+            Int_t degree = param / 100;
+            Int_t first = param - degree * 100 - 1;
+            statement = "{ double m = 1; @0 = 0;";
+            for (Int_t j = 0; j <= degree; ++j)
+               statement += TString::Format(" @0 += m*p[%d]; m *= x[%d];", first + j, opcode - kxpol);
+            statement += " }";
+            delta = 1; break;
+         }
+
+         default:
+            // strings, function calls and defined variables are not translated
+            return "";
+      }
+
+      if (pos < need) return "";
+      if (jump >= 0) {
+         if (jump <= i || jump > fNoper) return "";
+         Int_t jumpheight = pos + delta;
+         if (height[jump] >= 0 && height[jump] != jumpheight) return "";
+         height[jump] = jumpheight;
+      }
+      if (!statement.IsNull()) code += JitStatement(statement, pos);
+      pos += delta;
+      if (pos > maxpos) maxpos = pos;
+      if (opcode == kJump) reachable = kFALSE;
+   }
+   if (pos < 1) return "";
+
+   TString decl = "   double t0 = 0";
+   for (Int_t i = 1; i < maxpos; ++i) decl += TString::Format(", t%d = 0", i);
+   return decl + ";\n" + code + "   return t0;\n";
+}
+
+//______________________________________________________________________________
+Int_t TFormula::MakeJitOperator(Int_t, TString &, Int_t &, Int_t &, Int_t &) const
+{
+   // Translate the operator i for MakeJitBody: set the statement (where @0
+   // is the value pushed on the stack, @1 the top of the stack and @2 the
+   // value below it), the number of values it needs on the stack, the
+   // change of the height of the stack and, for a jump, the next operator
+   // if the jump is taken. Return 1 if the operator is translated, 0 to
+   // let MakeJitBody translate it and -1 if it cannot be translated.
+   // The default implementation leaves all the operators to MakeJitBody.
+
+   return 0;
+}
+
+//______________________________________________________________________________
+Long_t TFormula::JitCompile(const char *declarations, const char *signature, const TString &body) const
+{
+   // Compile with the interpreter the function
+   //    double name(signature) { body }
+   // preceded by the declarations and return its address, or 0 if it
+   // cannot be compiled. The functions are cached by their code: the
+   // formulas with the same operators share one function.
+   //
+   // The cache and the interpreter are serialised on gClingMutex: LoadText
+   // does not take it, and Calc takes it, so holding gROOTMutex here
+   // instead would not protect the declaration and would take the two
+   // mutexes in the opposite order of the interpreter.
+
+   if (body.IsNull() || !gInterpreter) return 0;
+
+   TString key = TString(declarations) + "\n" + signature + "\n" + body;
+
+   R__LOCKGUARD2(gClingMutex);
+   static std::map<std::string, Long_t> cache;
+   static Int_t nfunctions = 0;
+   std::map<std::string, Long_t>::iterator it = cache.find(key.Data());
+   if (it != cache.end()) return it->second;
+
+   TString name = TString::Format("TFormula__Jit%d", nfunctions++);
+   TString code = "#include \"TMath.h\"\n#include \"TRandom.h\"\n";
+   code += TString(declarations) + "\ndouble " + name + "(" + signature + ")\n{\n" + body + "}\n";
+   gInterpreter->LoadText(code);
+   TInterpreter::EErrorCode err = TInterpreter::kNoError;
+   Long_t addr = gInterpreter->Calc(TString::Format("(long)&%s", name.Data()), &err);
+   if (err != TInterpreter::kNoError) addr = 0;
+   cache[key.Data()] = addr;
+   if (!addr) Warning("Jit", "cannot compile the formula %s", GetTitle());
+   return addr;
+}
+
+//______________________________________________________________________________
+Bool_t TFormula::Jit()
+{
+   // Translate the formula into C++ (see MakeJitBody), compile it with the
+   // interpreter (see JitCompile) and evaluate the formula with the
+   // compiled function from now on. Return kFALSE if the formula cannot be
+   // translated or compiled; it is then still evaluated by the interpreter
+   // of operators.
+
+   TJitFunc_t func = (TJitFunc_t) JitCompile("", "const double *x, const double *p, const double *c", MakeJitBody());
+   if (!func) return kFALSE;
+
+   fJitFunc = func;
+   fOptimal = (TFormulaPrimitive::TFuncG)&TFormula::EvalParJit;
+   return kTRUE;
 }
 
 //______________________________________________________________________________
@@ -4457,6 +4741,27 @@ Int_t TFormula::PreCompile()
 }
 
 
+//______________________________________________________________________________
+Bool_t TFormula::GetDefaultJit()
+{
+   // static function
+   // return kTRUE if the formulas are compiled when created, see
+   // TFormula::SetDefaultJit.
+
+   return gDefaultJit;
+}
+
+//______________________________________________________________________________
+void TFormula::SetDefaultJit(Bool_t jit)
+{
+   // static function
+   // if jit is kTRUE, the formulas created or read from a file from now on
+   // are compiled by TFormula::Jit (the formulas that cannot be compiled
+   // are interpreted as before). By default formulas are not compiled.
+
+   gDefaultJit = jit;
+}
+
 //______________________________________________________________________________
 void TFormula::SetMaxima(Int_t maxop, Int_t maxpar, Int_t maxconst)
 {
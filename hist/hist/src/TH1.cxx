@@ -1163,6 +1163,21 @@ void TH1::AddBinContent(Int_t, Double_t)
 }
 
 
+//______________________________________________________________________________
+void TH1::AddBinContents(Int_t n, const Int_t *bins, const Double_t *w)
+{
+   // Increment the content of bin bins[i] by w[i] (by 1 if w is null), for
+   // i in [0,n). Used by FillN; the histograms storing their contents in a
+   // TArrayF or a TArrayD override it with a loop on their array.
+
+   if (w) {
+      for (Int_t i = 0; i < n; ++i) AddBinContent(bins[i], w[i]);
+   } else {
+      for (Int_t i = 0; i < n; ++i) AddBinContent(bins[i]);
+   }
+}
+
+
 //______________________________________________________________________________
 void TH1::AddDirectory(Bool_t add)
 {
@@ -3078,37 +3093,88 @@ void TH1::FillN(Int_t ntimes, const Double_t *x, const Double_t *w, Int_t stride
    //    weights is automatically triggered and the sum of the squares of weights is incremented
    //    by w^2 in the bin corresponding to x.
    //    if w is NULL each entry is assumed a weight=1
+   //
+   //    The entries are processed in blocks: the bins of a block are found
+   //    by TAxis::FindFixBins, then the contents, the sums of squares of
+   //    weights and the statistics are updated. The result is the same as
+   //    calling Fill for each entry. If the axis can be extended, the
+   //    entries are filled one by one.
 
    Int_t bin,i;
-   //If a buffer is activated, go via standard Fill (sorry)
-   //if (fBuffer) {
-   //   for (i=0;i<ntimes;i+=stride) {
-   //      if (w) Fill(x[i],w[i]);
-   //      else   Fill(x[i],0);
-   //   }
-   //   return;
-   //}
+   //If a buffer is activated, go via standard Fill
+   if (fBuffer) {
+      for (i=0;i<ntimes;i++) {
+         Fill(x[i*stride], w ? w[i*stride] : 1.);
+      }
+      return;
+   }
 
    fEntries += ntimes;
    Double_t ww = 1;
    Int_t nbins   = fXaxis.GetNbins();
-   ntimes *= stride;
-   for (i=0;i<ntimes;i+=stride) {
-      bin =fXaxis.FindBin(x[i]);
-      if (bin <0) continue;
-      if (w) ww = w[i];
-      if (!fSumw2.fN && ww != 1.0)  Sumw2();
-      if (fSumw2.fN) fSumw2.fArray[bin] += ww*ww;
-      AddBinContent(bin, ww);
-      if (bin == 0 || bin > nbins) {
-         if (!fgStatOverflows) continue;
+   if (fXaxis.CanExtend()) {
+      ntimes *= stride;
+      for (i=0;i<ntimes;i+=stride) {
+         bin =fXaxis.FindBin(x[i]);
+         if (bin <0) continue;
+         if (w) ww = w[i];
+         if (!fSumw2.fN && ww != 1.0)  Sumw2();
+         if (fSumw2.fN) fSumw2.fArray[bin] += ww*ww;
+         AddBinContent(bin, ww);
+         if (bin == 0 || bin > nbins) {
+            if (!fgStatOverflows) continue;
+         }
+         Double_t z= ww;
+         fTsumw   += z;
+         fTsumw2  += z*z;
+         fTsumwx  += z*x[i];
+         fTsumwx2 += z*x[i]*x[i];
       }
-      Double_t z= ww;
-      fTsumw   += z;
-      fTsumw2  += z*z;
-      fTsumwx  += z*x[i];
-      fTsumwx2 += z*x[i]*x[i];
+      return;
    }
+
+   // The entries with a weight of 1 before the first other weight add as
+   // much to the sums of squares as to the contents: Sumw2 can be called
+   // before filling.
+   if (w && !fSumw2.fN) {
+      for (i=0;i<ntimes;i++) {
+         if (w[i*stride] != 1.0) {
+            Sumw2();
+            break;
+         }
+      }
+   }
+
+   const Int_t kBlock = 256;
+   Int_t    bins[kBlock];
+   Double_t xs[kBlock];
+   Double_t ws[kBlock];
+   // Same order of the additions as in Fill.
+   Double_t tsumw = fTsumw, tsumw2 = fTsumw2, tsumwx = fTsumwx, tsumwx2 = fTsumwx2;
+   for (Int_t first=0;first<ntimes;first+=kBlock) {
+      Int_t n = TMath::Min(kBlock, ntimes-first);
+      for (i=0;i<n;i++) {
+         xs[i] = x[(first+i)*stride];
+         ws[i] = w ? w[(first+i)*stride] : 1.;
+      }
+      fXaxis.FindFixBins(n, xs, bins);
+      AddBinContents(n, bins, w ? ws : 0);
+      if (fSumw2.fN) {
+         for (i=0;i<n;i++) fSumw2.fArray[bins[i]] += ws[i]*ws[i];
+      }
+      for (i=0;i<n;i++) {
+         if (!fgStatOverflows && (bins[i] == 0 || bins[i] > nbins)) continue;
+         Double_t z = ws[i];
+         tsumw   += z;
+         tsumw2  += z*z;
+         tsumwx  += z*xs[i];
+         tsumwx2 += z*xs[i]*xs[i];
+      }
+   }
+   fTsumw   = tsumw;
+   fTsumw2  = tsumw2;
+   fTsumwx  = tsumwx;
+   fTsumwx2 = tsumwx2;
 }
 
 
@@ -7083,6 +7149,17 @@ void TH1::ResetStats()
 }
 
 
+//______________________________________________________________________________
+Bool_t TH1::GetStatOverflows()
+{
+   // static function
+   // return kTRUE if the underflows and overflows are used in the computation
+   // of the statistics by the Fill functions, see TH1::StatOverflows.
+
+   return fgStatOverflows;
+}
+
+
 //______________________________________________________________________________
 Double_t TH1::GetSumOfWeights() const
 {
@@ -514,36 +514,102 @@ void TH2::FillN(Int_t ntimes, const Double_t *x, const Double_t *y, const Double
    //   by w[i]^2 in the bin corresponding to x[i],y[i].
    //  If w is NULL each entry is assumed a weight=1
    //
+   // The entries are processed in blocks, as in TH1::FillN, unless an axis
+   // can be extended.
+   //
    // NB: function only valid for a TH2x object
 
    Int_t binx, biny, bin, i;
+   //If a buffer is activated, go via standard Fill
+   if (fBuffer) {
+      for (i=0;i<ntimes;i++) {
+         Fill(x[i*stride], y[i*stride], w ? w[i*stride] : 1.);
+      }
+      return;
+   }
+
    fEntries += ntimes;
    Double_t ww = 1;
-   ntimes *= stride;
-   for (i=0;i<ntimes;i+=stride) {
-      binx = fXaxis.FindBin(x[i]);
-      biny = fYaxis.FindBin(y[i]);
-      if (binx <0 || biny <0) continue;
-      bin  = biny*(fXaxis.GetNbins()+2) + binx;
-      if (w) ww = w[i];
-      if (!fSumw2.fN && ww != 1.0)  Sumw2();
-      if (fSumw2.fN) fSumw2.fArray[bin] += ww*ww;
-      AddBinContent(bin,ww);
-      if (binx == 0 || binx > fXaxis.GetNbins()) {
-         if (!fgStatOverflows) continue;
+   if (fXaxis.CanExtend() || fYaxis.CanExtend()) {
+      ntimes *= stride;
+      for (i=0;i<ntimes;i+=stride) {
+         binx = fXaxis.FindBin(x[i]);
+         biny = fYaxis.FindBin(y[i]);
+         if (binx <0 || biny <0) continue;
+         bin  = biny*(fXaxis.GetNbins()+2) + binx;
+         if (w) ww = w[i];
+         if (!fSumw2.fN && ww != 1.0)  Sumw2();
+         if (fSumw2.fN) fSumw2.fArray[bin] += ww*ww;
+         AddBinContent(bin,ww);
+         if (binx == 0 || binx > fXaxis.GetNbins()) {
+            if (!fgStatOverflows) continue;
+         }
+         if (biny == 0 || biny > fYaxis.GetNbins()) {
+            if (!fgStatOverflows) continue;
+         }
+         Double_t z= ww; //(ww > 0 ? ww : -ww);
+         fTsumw   += z;
+         fTsumw2  += z*z;
+         fTsumwx  += z*x[i];
+         fTsumwx2 += z*x[i]*x[i];
+         fTsumwy  += z*y[i];
+         fTsumwy2 += z*y[i]*y[i];
+         fTsumwxy += z*x[i]*y[i];
+      }
+      return;
+   }
+
+   // See TH1::FillN.
+   if (w && !fSumw2.fN) {
+      for (i=0;i<ntimes;i++) {
+         if (w[i*stride] != 1.0) {
+            Sumw2();
+            break;
+         }
+      }
+   }
+
+   const Int_t kBlock = 256;
+   Int_t    binsx[kBlock], binsy[kBlock], bins[kBlock];
+   Double_t xs[kBlock], ys[kBlock], ws[kBlock];
+   Int_t nbinsx = fXaxis.GetNbins();
+   Int_t nbinsy = fYaxis.GetNbins();
+   Double_t tsumw = fTsumw, tsumw2 = fTsumw2, tsumwx = fTsumwx, tsumwx2 = fTsumwx2;
+   Double_t tsumwy = fTsumwy, tsumwy2 = fTsumwy2, tsumwxy = fTsumwxy;
+   for (Int_t first=0;first<ntimes;first+=kBlock) {
+      Int_t n = TMath::Min(kBlock, ntimes-first);
+      for (i=0;i<n;i++) {
+         xs[i] = x[(first+i)*stride];
+         ys[i] = y[(first+i)*stride];
+         ws[i] = w ? w[(first+i)*stride] : 1.;
+      }
+      fXaxis.FindFixBins(n, xs, binsx);
+      fYaxis.FindFixBins(n, ys, binsy);
+      for (i=0;i<n;i++) bins[i] = binsy[i]*(nbinsx+2) + binsx[i];
+      AddBinContents(n, bins, w ? ws : 0);
+      if (fSumw2.fN) {
+         for (i=0;i<n;i++) fSumw2.fArray[bins[i]] += ws[i]*ws[i];
       }
-      if (biny == 0 || biny > fYaxis.GetNbins()) {
-         if (!fgStatOverflows) continue;
+      for (i=0;i<n;i++) {
+         if (!fgStatOverflows && (binsx[i] == 0 || binsx[i] > nbinsx ||
+                                  binsy[i] == 0 || binsy[i] > nbinsy)) continue;
+         Double_t z = ws[i];
+         tsumw   += z;
+         tsumw2  += z*z;
+         tsumwx  += z*xs[i];
+         tsumwx2 += z*xs[i]*xs[i];
+         tsumwy  += z*ys[i];
+         tsumwy2 += z*ys[i]*ys[i];
+         tsumwxy += z*xs[i]*ys[i];
       }
-      Double_t z= ww; //(ww > 0 ? ww : -ww);
-      fTsumw   += z;
-      fTsumw2  += z*z;
-      fTsumwx  += z*x[i];
-      fTsumwx2 += z*x[i]*x[i];
-      fTsumwy  += z*y[i];
-      fTsumwy2 += z*y[i]*y[i];
-      fTsumwxy += z*x[i]*y[i];
    }
+   fTsumw   = tsumw;
+   fTsumw2  = tsumw2;
+   fTsumwx  = tsumwx;
+   fTsumwx2 = tsumwx2;
+   fTsumwy  = tsumwy;
+   fTsumwy2 = tsumwy2;
+   fTsumwxy = tsumwxy;
 }
 
 
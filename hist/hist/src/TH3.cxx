@@ -624,6 +624,100 @@ Int_t TH3::Fill(Double_t x, Double_t y, const char *namez, Double_t w)
 }
 
 
+//______________________________________________________________________________
+void TH3::FillN(Int_t ntimes, const Double_t *x, const Double_t *y, const Double_t *z, const Double_t *w, Int_t stride)
+{
+   // Fill a 3-D histogram with arrays of values and weights.
+   //
+   // ntimes:  number of entries in arrays x, y, z and w (array size must be ntimes*stride)
+   // x, y, z: arrays of values to be histogrammed
+   // w:       array of weights
+   // stride:  step size through arrays x, y, z and w
+   //
+   // If the weight is not equal to 1, the storage of the sum of squares of
+   // weights is automatically triggered and the sum of the squares of weights is incremented
+   // by w[i]^2 in the cell corresponding to x[i],y[i],z[i].
+   // If w is NULL each entry is assumed a weight=1
+   //
+   // The entries are processed in blocks, as in TH1::FillN, unless an axis
+   // can be extended.
+
+   Int_t i;
+   if (fBuffer || fXaxis.CanExtend() || fYaxis.CanExtend() || fZaxis.CanExtend()) {
+      for (i=0;i<ntimes;i++) {
+         Fill(x[i*stride], y[i*stride], z[i*stride], w ? w[i*stride] : 1.);
+      }
+      return;
+   }
+
+   fEntries += ntimes;
+   // See TH1::FillN.
+   if (w && !fSumw2.fN) {
+      for (i=0;i<ntimes;i++) {
+         if (w[i*stride] != 1.0) {
+            Sumw2();
+            break;
+         }
+      }
+   }
+
+   const Int_t kBlock = 256;
+   Int_t    binsx[kBlock], binsy[kBlock], binsz[kBlock], bins[kBlock];
+   Double_t xs[kBlock], ys[kBlock], zs[kBlock], ws[kBlock];
+   Int_t nbinsx = fXaxis.GetNbins();
+   Int_t nbinsy = fYaxis.GetNbins();
+   Int_t nbinsz = fZaxis.GetNbins();
+   Double_t tsumw = fTsumw, tsumw2 = fTsumw2, tsumwx = fTsumwx, tsumwx2 = fTsumwx2;
+   Double_t tsumwy = fTsumwy, tsumwy2 = fTsumwy2, tsumwxy = fTsumwxy;
+   Double_t tsumwz = fTsumwz, tsumwz2 = fTsumwz2, tsumwxz = fTsumwxz, tsumwyz = fTsumwyz;
+   for (Int_t first=0;first<ntimes;first+=kBlock) {
+      Int_t n = TMath::Min(kBlock, ntimes-first);
+      for (i=0;i<n;i++) {
+         xs[i] = x[(first+i)*stride];
+         ys[i] = y[(first+i)*stride];
+         zs[i] = z[(first+i)*stride];
+         ws[i] = w ? w[(first+i)*stride] : 1.;
+      }
+      fXaxis.FindFixBins(n, xs, binsx);
+      fYaxis.FindFixBins(n, ys, binsy);
+      fZaxis.FindFixBins(n, zs, binsz);
+      for (i=0;i<n;i++) bins[i] = binsx[i] + (nbinsx+2)*(binsy[i] + (nbinsy+2)*binsz[i]);
+      AddBinContents(n, bins, w ? ws : 0);
+      if (fSumw2.fN) {
+         for (i=0;i<n;i++) fSumw2.fArray[bins[i]] += ws[i]*ws[i];
+      }
+      for (i=0;i<n;i++) {
+         if (!fgStatOverflows && (binsx[i] == 0 || binsx[i] > nbinsx ||
+                                  binsy[i] == 0 || binsy[i] > nbinsy ||
+                                  binsz[i] == 0 || binsz[i] > nbinsz)) continue;
+         Double_t ww = ws[i];
+         tsumw   += ww;
+         tsumw2  += ww*ww;
+         tsumwx  += ww*xs[i];
+         tsumwx2 += ww*xs[i]*xs[i];
+         tsumwy  += ww*ys[i];
+         tsumwy2 += ww*ys[i]*ys[i];
+         tsumwxy += ww*xs[i]*ys[i];
+         tsumwz  += ww*zs[i];
+         tsumwz2 += ww*zs[i]*zs[i];
+         tsumwxz += ww*xs[i]*zs[i];
+         tsumwyz += ww*ys[i]*zs[i];
+      }
+   }
+   fTsumw   = tsumw;
+   fTsumw2  = tsumw2;
+   fTsumwx  = tsumwx;
+   fTsumwx2 = tsumwx2;
+   fTsumwy  = tsumwy;
+   fTsumwy2 = tsumwy2;
+   fTsumwxy = tsumwxy;
+   fTsumwz  = tsumwz;
+   fTsumwz2 = tsumwz2;
+   fTsumwxz = tsumwxz;
+   fTsumwyz = tsumwyz;
+}
+
+
 //______________________________________________________________________________
 void TH3::FillRandom(const char *fname, Int_t ntimes)
 {
@@ -16,6 +16,9 @@
 #include "TDataMember.h"
 #include "TDataType.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace {
 //______________________________________________________________________________
 //
@@ -316,9 +319,9 @@ ULong64_t THnSparseCoordCompression::GetHashFromBuffer(const Char_t* buf) const
 
    // Bins are addressed in two different modes, depending
    // on whether the compact bin index fits into a Long64_t or not.
-   // If it does, we can use it as a "perfect hash" for the TExMap.
+   // If it does, we can use it as a "perfect hash" for THnSparseBinIndex.
    // If not we build a hash from the compact bin index, and use that
-   // as the TExMap's hash.
+   // as the THnSparseBinIndex's hash.
 
    if (fCoordBufferSize <= 8) {
       // fits into a Long64_t
@@ -408,6 +411,163 @@ THnSparseCompactBinCoord::~THnSparseCompactBinCoord()
    delete [] fCurrentBin;
 }
 
+
+
+//______________________________________________________________________________
+//
+// THnSparseBinIndex is a class used by THnSparse internally. It maps the
+// hash of the compact coordinates of each filled bin to the bin's linear
+// index, in a flat hash table with open addressing: all entries are
+// stored in one array of slots, and an entry whose slot is taken goes to
+// the next free one (linear probing). Insertions follow the "robin hood"
+// rule: a new entry takes the slot of an entry closer to its own first
+// slot, which keeps the runs of slots to probe short up to a load factor
+// of 3/4. A lookup thus reads a few adjacent slots of 16 bytes, where
+// TExMap followed a chain of entries.
+//
+// As the hash of compact coordinates longer than 8 bytes is not unique,
+// several entries can have the same hash; the coordinates of the bins
+// are then compared by Find().
+//______________________________________________________________________________
+
+class THnSparseBinIndex {
+public:
+   THnSparseBinIndex(): fSlots(0), fNbits(0), fSize(0) {}
+   ~THnSparseBinIndex() { delete [] fSlots; }
+
+   Long64_t Find(ULong64_t hash, const Char_t* buf, const TObjArray& chunks, Int_t chunkSize) const;
+   Long64_t GetCapacity() const { return fSlots ? ((Long64_t)1) << fNbits : 0; }
+   Long64_t GetSize() const { return fSize; }
+   void     Insert(ULong64_t hash, Long64_t idx);
+   void     Prefetch(ULong64_t hash) const {
+      // Hint the processor to load the first slot to probe for hash.
+#if defined(__GNUC__)
+      if (fSlots) __builtin_prefetch(fSlots + GetHome(hash));
+#else
+      (void) hash;
+#endif
+   }
+   void     Reserve(Long64_t n);
+
+private:
+   struct TSlot {
+      ULong64_t fHash;  // hash of the compact coordinates of the bin
+      Long64_t  fIndex; // linear index of the bin + 1; 0 for a free slot
+   };
+
+   // intentionally not implemented
+   THnSparseBinIndex(const THnSparseBinIndex&);
+   // intentionally not implemented
+   THnSparseBinIndex& operator=(const THnSparseBinIndex&);
+
+   ULong64_t GetHome(ULong64_t hash) const {
+      // Return the first slot to probe for hash: the upper bits of the
+      // product with 2^64 / golden ratio (Fibonacci hashing), which spreads
+      // the compact coordinates differing only in their lower bits.
+      return (hash * 0x9E3779B97F4A7C15ULL) >> (64 - fNbits);
+   }
+   void      InsertSlot(ULong64_t hash, Long64_t value);
+   void      Rehash(Int_t nbits);
+
+   TSlot   *fSlots;  // [1 << fNbits] slots
+   Int_t    fNbits;  // log2 of the number of slots
+   Long64_t fSize;   // number of entries
+};
+
+
+//______________________________________________________________________________
+//______________________________________________________________________________
+
+
+//______________________________________________________________________________
+Long64_t THnSparseBinIndex::Find(ULong64_t hash, const Char_t* buf,
+                                 const TObjArray& chunks, Int_t chunkSize) const
+{
+   // Return the linear index of the bin with compact coordinates buf and
+   // hash "hash", or -1 if there is none. chunks are the
+   // THnSparseArrayChunk holding the coordinates of the bins, chunkSize
+   // bins each.
+
+   if (!fSize) return -1;
+   const ULong64_t mask = GetCapacity() - 1;
+   ULong64_t pos = GetHome(hash);
+   for (ULong64_t dist = 0; ; ++dist, pos = (pos + 1) & mask) {
+      const TSlot& slot = fSlots[pos];
+      // An entry further from its first slot than the one searched for
+      // would have been displaced by it: the bin is not there.
+      if (!slot.fIndex || ((pos - GetHome(slot.fHash)) & mask) < dist)
+         return -1;
+      if (slot.fHash == hash) {
+         Long64_t idx = slot.fIndex - 1;
+         THnSparseArrayChunk* chunk = (THnSparseArrayChunk*) chunks.UncheckedAt(idx / chunkSize);
+         if (chunk->Matches(idx % chunkSize, buf))
+            return idx;
+      }
+   }
+   return -1;
+}
+
+//______________________________________________________________________________
+void THnSparseBinIndex::Insert(ULong64_t hash, Long64_t idx)
+{
+   // Add the bin with linear index idx, which is not in the table yet.
+
+   if (4 * (fSize + 1) > 3 * GetCapacity())
+      Rehash(fSlots ? fNbits + 1 : 8);
+   InsertSlot(hash, idx + 1);
+   ++fSize;
+}
+
+//______________________________________________________________________________
+void THnSparseBinIndex::InsertSlot(ULong64_t hash, Long64_t value)
+{
+   // Store the slot value for hash, moving the entries closer to their
+   // first slot further down.
+
+   const ULong64_t mask = GetCapacity() - 1;
+   ULong64_t pos = GetHome(hash);
+   for (ULong64_t dist = 0; fSlots[pos].fIndex; ++dist, pos = (pos + 1) & mask) {
+      TSlot& slot = fSlots[pos];
+      ULong64_t slotdist = (pos - GetHome(slot.fHash)) & mask;
+      if (slotdist < dist) {
+         std::swap(hash, slot.fHash);
+         std::swap(value, slot.fIndex);
+         dist = slotdist;
+      }
+   }
+   fSlots[pos].fHash = hash;
+   fSlots[pos].fIndex = value;
+}
+
+//______________________________________________________________________________
+void THnSparseBinIndex::Rehash(Int_t nbits)
+{
+   // Move the entries to a table of 2^nbits slots.
+
+   TSlot* old = fSlots;
+   Long64_t oldcapacity = GetCapacity();
+   fNbits = nbits;
+   fSlots = new TSlot[((Long64_t)1) << nbits];
+   memset(fSlots, 0, sizeof(TSlot) * GetCapacity());
+   for (Long64_t i = 0; i < oldcapacity; ++i) {
+      if (old[i].fIndex)
+         InsertSlot(old[i].fHash, old[i].fIndex);
+   }
+   delete [] old;
+}
+
+//______________________________________________________________________________
+void THnSparseBinIndex::Reserve(Long64_t n)
+{
+   // Make room for n entries without rehashing.
+
+   Int_t nbits = fSlots ? fNbits : 8;
+   while (3 * (((Long64_t)1) << nbits) < 4 * n)
+      ++nbits;
+   if (nbits != fNbits || !fSlots)
+      Rehash(nbits);
+}
+
 //______________________________________________________________________________
 //
 // THnSparseArrayChunk is used internally by THnSparse.
@@ -567,21 +727,25 @@ void THnSparseArrayChunk::Sumw2()
 // the chunks is done by GetBin(). It creates a hash from the compacted bin
 // coordinates (the hash of a bin coordinate is the compacted coordinate itself
 // if it takes less than 8 bytes, the size of a Long64_t.
-// This hash is used to lookup the linear index in the TExMap member fBins;
-// the coordinates of the entry fBins points to is compared to the coordinates
-// passed to GetBin(). If they do not match, these two coordinates have the same
-// hash - which is extremely unlikely but (for the case where the compact bin
-// coordinates are larger than 4 bytes) possible. In this case, fBinsContinued
-// contains a chain of linear indexes with the same hash. Iterating through this
-// chain and comparing each bin coordinates with the one passed to GetBin() will
-// retrieve the matching bin.
+// This hash is used to lookup the linear index in the hash table fBinIndex,
+// a flat array of (hash, linear index) slots with open addressing (see
+// THnSparseBinIndex); it is not stored, but rebuilt from the coordinates in
+// the chunks when a histogram read from a file is first filled. If the
+// compact coordinates are larger than 8 bytes, two bins can have the same
+// hash - which is extremely unlikely but possible; the coordinates of the
+// bins with the hash looked up are then compared to the ones passed to
+// GetBin().
+//
+// FillN() fills many entries at once: it computes the compact coordinates of
+// a block of entries and prefetches their slots in fBinIndex before looking
+// them up, which hides most of the cache misses of large histograms.
 
 
 ClassImp(THnSparse);
 
 //______________________________________________________________________________
 THnSparse::THnSparse():
-   fChunkSize(1024), fFilledBins(0), fCompactCoord(0)
+   fChunkSize(1024), fFilledBins(0), fBinIndex(0), fCompactCoord(0)
 {
    // Construct an empty THnSparse.
    fBinContent.SetOwner();
@@ -592,7 +756,7 @@ THnSparse::THnSparse(const char* name, const char* title, Int_t dim,
                      const Int_t* nbins, const Double_t* xmin, const Double_t* xmax,
                      Int_t chunksize):
    THnBase(name, title, dim, nbins, xmin, xmax),
-   fChunkSize(chunksize), fFilledBins(0), fCompactCoord(0)
+   fChunkSize(chunksize), fFilledBins(0), fBinIndex(0), fCompactCoord(0)
 {
    // Construct a THnSparse with "dim" dimensions,
    // with chunksize as the size of the chunks.
@@ -609,6 +773,7 @@ THnSparse::THnSparse(const char* name, const char* title, Int_t dim,
 THnSparse::~THnSparse() {
    // Destruct a THnSparse
 
+   delete fBinIndex;
    delete fCompactCoord;
 }
 
@@ -643,47 +808,35 @@ void THnSparse::InitStorage(Int_t* nbins, Int_t chunkSize)
 }
 
 //______________________________________________________________________________
-void THnSparse::FillExMap()
+void THnSparse::FillBinIndex()
 {
-   //We have been streamed; set up fBins
+   // Set up fBinIndex from the coordinates of the bins stored in the
+   // chunks, e.g. once we have been streamed.
+
+   delete fBinIndex;
+   fBinIndex = new THnSparseBinIndex();
+   fBinIndex->Reserve(GetNbins());
    TIter iChunk(&fBinContent);
    THnSparseArrayChunk* chunk = 0;
    THnSparseCoordCompression compactCoord(*GetCompactCoord());
    Long64_t idx = 0;
-   if (2 * GetNbins() > fBins.Capacity())
-      fBins.Expand(3 * GetNbins());
    while ((chunk = (THnSparseArrayChunk*) iChunk())) {
       const Int_t chunkSize = chunk->GetEntries();
       Char_t* buf = chunk->fCoordinates;
       const Int_t singleCoordSize = chunk->fSingleCoordinateSize;
       const Char_t* endbuf = buf + singleCoordSize * chunkSize;
-      for (; buf < endbuf; buf += singleCoordSize, ++idx) {
-         Long64_t hash = compactCoord.GetHashFromBuffer(buf);
-         Long64_t linidx = fBins.GetValue(hash);
-         if (linidx) {
-            Long64_t nextidx = linidx;
-            while (nextidx) {
-               // must be a collision, so go to fBinsContinued.
-               linidx = nextidx;
-               nextidx = fBinsContinued.GetValue(linidx);
-            }
-            fBinsContinued.Add(linidx, idx + 1);
-         } else {
-            fBins.Add(hash, idx + 1);
-         }
-      }
+      for (; buf < endbuf; buf += singleCoordSize, ++idx)
+         fBinIndex->Insert(compactCoord.GetHashFromBuffer(buf), idx);
    }
 }
 
 //______________________________________________________________________________
 void THnSparse::Reserve(Long64_t nbins) {
    // Initialize storage for nbins
-   if (!fBins.GetSize() && fBinContent.GetSize()) {
-      FillExMap();
-   }
-   if (2 * nbins > fBins.Capacity()) {
-      fBins.Expand(3 * nbins);
+   if (!fBinIndex) {
+      FillBinIndex();
    }
+   fBinIndex->Reserve(nbins);
 }
 
 //______________________________________________________________________________
@@ -702,6 +855,43 @@ Long64_t THnSparse::GetBin(const Double_t* x, Bool_t allocate /* = kTRUE */)
 }
 
 
+//______________________________________________________________________________
+void THnSparse::FillN(Long64_t n, const Double_t* x, const Double_t* w /* = 0 */)
+{
+   // Fill n entries: the coordinates of entry i are
+   // x[i * GetNdimensions()] ... x[(i + 1) * GetNdimensions() - 1], its
+   // weight w[i], or 1 if w is null. The result is the same as the one of
+   // Fill() called for each entry.
+
+   const Int_t blockSize = 256;
+   THnSparseCompactBinCoord* cc = GetCompactCoord();
+   // SetBufferFromCoord() writes 8 bytes for short coordinates.
+   const Int_t bufSize = cc->GetBufferSize() > 8 ? cc->GetBufferSize() : 8;
+   std::vector<Char_t> bufs(blockSize * bufSize);
+   ULong64_t hashes[blockSize];
+   Int_t* coord = cc->GetCoord();
+   if (!fBinIndex)
+      FillBinIndex();
+
+   for (Long64_t first = 0; first < n; first += blockSize) {
+      const Int_t nblock = n - first < blockSize ? (Int_t)(n - first) : blockSize;
+      const Double_t* xblock = x + first * fNdimensions;
+      for (Int_t i = 0; i < nblock; ++i) {
+         const Double_t* xi = xblock + i * fNdimensions;
+         for (Int_t d = 0; d < fNdimensions; ++d)
+            coord[d] = GetAxis(d)->FindBin(xi[d]);
+         hashes[i] = cc->SetBufferFromCoord(coord, &bufs[i * bufSize]);
+         fBinIndex->Prefetch(hashes[i]);
+      }
+      for (Int_t i = 0; i < nblock; ++i) {
+         const Double_t wi = w ? w[first + i] : 1.;
+         UpdateXStat(xblock + i * fNdimensions, wi);
+         FillBin(GetBinIndex(hashes[i], &bufs[i * bufSize], kTRUE), wi);
+      }
+   }
+}
+
+
 //______________________________________________________________________________
 Long64_t THnSparse::GetBin(const char* name[], Bool_t allocate /* = kTRUE */)
 {
@@ -780,21 +970,20 @@ Long64_t THnSparse::GetBinIndexForCurrentBin(Bool_t allocate)
    // If it doesn't exist then return -1, or allocate a new bin if allocate is set
 
    THnSparseCompactBinCoord* cc = GetCompactCoord();
-   ULong64_t hash = cc->GetHash();
-   if (fBinContent.GetSize() && !fBins.GetSize())
-      FillExMap();
-   Long64_t linidx = (Long64_t) fBins.GetValue(hash);
-   while (linidx) {
-      // fBins stores index + 1!
-      THnSparseArrayChunk* chunk = GetChunk((linidx - 1)/ fChunkSize);
-      if (chunk->Matches((linidx - 1) % fChunkSize, cc->GetBuffer()))
-         return linidx - 1; // we store idx+1, 0 is "TExMap: not found"
-
-      Long64_t nextlinidx = fBinsContinued.GetValue(linidx);
-      if (!nextlinidx) break;
+   return GetBinIndex(cc->GetHash(), cc->GetBuffer(), allocate);
+}
 
-      linidx = nextlinidx;
-   }
+//______________________________________________________________________________
+Long64_t THnSparse::GetBinIndex(ULong64_t hash, const Char_t* buf, Bool_t allocate)
+{
+   // Return the index of the bin with compact coordinates buf and hash
+   // "hash". If it doesn't exist then return -1, or allocate a new bin if
+   // allocate is set.
+
+   if (!fBinIndex)
+      FillBinIndex();
+   Long64_t linidx = fBinIndex->Find(hash, buf, fBinContent, fChunkSize);
+   if (linidx >= 0) return linidx;
    if (!allocate) return -1;
 
    ++fFilledBins;
@@ -806,20 +995,11 @@ Long64_t THnSparse::GetBinIndexForCurrentBin(Bool_t allocate)
       chunk = AddChunk();
       newidx = 0;
    }
-   chunk->AddBin(newidx, cc->GetBuffer());
+   chunk->AddBin(newidx, buf);
 
    // store translation between hash and bin
    newidx += (fBinContent.GetEntriesFast() - 1) * fChunkSize;
-   if (!linidx) {
-      // fBins didn't find it
-      if (2 * GetNbins() > fBins.Capacity())
-         fBins.Expand(3 * GetNbins());
-      fBins.Add(hash, newidx + 1);
-   } else {
-      // fBins contains one, but it's the wrong one;
-      // add entry to fBinsContinued.
-      fBinsContinued.Add(linidx, newidx + 1);
-   }
+   fBinIndex->Insert(hash, newidx);
    return newidx;
 }
 
@@ -871,7 +1051,8 @@ Double_t THnSparse::GetSparseFractionMem() const {
 
    Double_t size = 0.;
    size += fBinContent.GetEntries() * (GetChunkSize() * sizePerChunkElement + sizeof(THnSparseArrayChunk));
-   size += + 3 * sizeof(Long64_t) * fBins.GetSize() /* TExMap */;
+   if (fBinIndex)
+      size += 2 * sizeof(Long64_t) * fBinIndex->GetCapacity() /* THnSparseBinIndex */;
 
    Double_t nbinsTotal = 1.;
    for (Int_t d = 0; d < fNdimensions; ++d)
@@ -951,8 +1132,8 @@ void THnSparse::Reset(Option_t *option /*= ""*/)
 {
    // Clear the histogram
    fFilledBins = 0;
-   fBins.Delete();
-   fBinsContinued.Clear();
+   delete fBinIndex;
+   fBinIndex = 0;
    fBinContent.Delete();
    ResetBase(option);
 }
@@ -38,6 +38,7 @@ private:
    Int_t    *fLen;          // array of lengths of each segment
    Long64_t *fPos;          // array of positions of each segment
    Long64_t *fRelOffset;    // relative offset of piece in the buffer
+   Bool_t    fFailed;       // true if the block could not be read
 
    TFPBlock(const TFPBlock&);            // Not implemented.
    TFPBlock &operator=(const TFPBlock&); // Not implemented.
@@ -57,9 +58,11 @@ public:
    Int_t     GetNoElem() const;
    char     *GetBuffer() const;
    char     *GetPtrToPiece(Int_t index) const;
+   Bool_t    IsFailed() const { return fFailed; }
 
    void SetBuffer(char*);
    void SetPos(Int_t, Long64_t);
+   void SetFailed(Bool_t failed = kTRUE) { fFailed = failed; }
    void ReallocBlock(Long64_t*, Int_t*, Int_t);
 
    ClassDef(TFPBlock, 0);  // File prefetch block
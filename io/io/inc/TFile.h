@@ -40,6 +40,7 @@ class TFileCacheWrite;
 class TProcessID;
 class TStopwatch;
 class TFilePrefetch;
+class TMutex;
 
 class TFile : public TDirectoryFile {
   friend class TDirectoryFile;
@@ -80,6 +81,8 @@ protected:
    TArrayC         *fClassIndex;     //!Index of TStreamerInfo classes written to this file
    TObjArray       *fProcessIDs;     //!Array of pointers to TProcessIDs
    Long64_t         fOffset;         //!Seek offset cache
+   Bool_t           fConcurrentRead; //!True if the reads at a given position are positional and thread-safe
+   TMutex          *fReadMutex;      //!Serializes the reads that use the file offset in concurrent read mode
    TArchiveFile    *fArchive;        //!Archive file from which we read this file
    TFileCacheRead  *fCacheRead;      //!Pointer to the read cache (if any)
    TMap            *fCacheReadMap;   //!Pointer to the read cache (if any)
@@ -114,6 +117,7 @@ protected:
    virtual EAsyncOpenStatus GetAsyncOpenStatus() { return fAsyncOpenStatus; }
    virtual void  Init(Bool_t create);
    Bool_t        FlushWriteCache();
+   Bool_t        ReadBufferAt(char *buf, Long64_t pos, Int_t len);
    Int_t         ReadBufferViaCache(char *buf, Int_t len);
    Int_t         WriteBufferViaCache(const char *buf, Int_t len);
 
@@ -125,6 +129,7 @@ protected:
    virtual Int_t    SysOpen(const char *pathname, Int_t flags, UInt_t mode);
    virtual Int_t    SysClose(Int_t fd);
    virtual Int_t    SysRead(Int_t fd, void *buf, Int_t len);
+   virtual Int_t    SysReadAt(Int_t fd, void *buf, Int_t len, Long64_t offset);
    virtual Int_t    SysWrite(Int_t fd, const void *buf, Int_t len);
    virtual Long64_t SysSeek(Int_t fd, Long64_t offset, Int_t whence);
    virtual Int_t    SysStat(Int_t fd, Long_t *id, Long64_t *size, Long_t *flags, Long_t *modtime);
@@ -203,6 +208,7 @@ public:
    Int_t               GetVersion() const { return fVersion; }
    Int_t               GetRecordHeader(char *buf, Long64_t first, Int_t maxbytes,
                                        Int_t &nbytes, Int_t &objlen, Int_t &keylen);
+   virtual char       *GetMappedBuffer(Long64_t pos, Int_t len) const;
    virtual Int_t       GetNbytesInfo() const {return fNbytesInfo;}
    virtual Int_t       GetNbytesFree() const {return fNbytesFree;}
    Long64_t            GetRelOffset() const { return fOffset - fArchiveOffset; }
@@ -214,6 +220,7 @@ public:
    virtual void        IncrementProcessIDs() { fNProcessIDs++; }
    virtual Bool_t      IsArchive() const { return fIsArchive; }
            Bool_t      IsBinary() const { return TestBit(kBinaryFile); }
+           Bool_t      IsConcurrentRead() const { return fConcurrentRead; }
            Bool_t      IsRaw() const { return !fIsRootFile; }
    virtual Bool_t      IsOpen() const;
    virtual void        ls(Option_t *option="") const;
@@ -240,6 +247,7 @@ public:
    virtual void        SetCompressionAlgorithm(Int_t algorithm=0);
    virtual void        SetCompressionLevel(Int_t level=1);
    virtual void        SetCompressionSettings(Int_t settings=1);
+   virtual Bool_t      SetConcurrentRead(Bool_t on = kTRUE);
    virtual void        SetEND(Long64_t last) { fEND = last; }
    virtual void        SetOffset(Long64_t offset, ERelativeTo pos = kBeg);
    virtual void        SetOption(Option_t *option=">") { fOption = option; }
@@ -24,6 +24,8 @@
 // rfio, dcap, etc.                                                     //
 // The merging interface allows files containing histograms and trees   //
 // to be merged, like the standalone hadd program.                      //
+// With SetNThreads the input files are merged in parallel in groups    //
+// before the partial results are merged into the output file.          //
 //                                                                      //
 //////////////////////////////////////////////////////////////////////////
 
@@ -65,10 +67,14 @@ protected:
    TString        fObjectNames;     // List of object names to be either merged exclusively or skipped
    TList         *fMergeList;       // list of TObjString containing the name of the files need to be merged
    TList         *fExcessFiles;     //! List of TObjString containing the name of the files not yet added to fFileList due to user or system limitiation on the max number of files opened.
+   Int_t          fNThreads;        //! Number of threads merging groups of input files in parallel (default 1)
+   Long64_t       fMaxMemory;       //! Maximum size of the histograms read to be merged in one go (0: no limit, default)
+   Bool_t         fGroupMerger;     //! True for the mergers of the groups of a parallel merge (see ParallelPartialMerge)
 
    Bool_t         OpenExcessFiles();
    virtual Bool_t AddFile(TFile *source, Bool_t own, Bool_t cpProgress);
    virtual Bool_t MergeRecursive(TDirectory *target, TList *sourcelist, Int_t type = kRegular | kAll);
+   virtual Bool_t ParallelPartialMerge(Int_t type, TList *partials);
 
 public:
    enum EPartialMergeType {
@@ -94,6 +100,10 @@ public:
    TFile      *GetOutputFile() const { return fOutputFile; }
    Int_t       GetMaxOpenedFies() const { return fMaxOpenedFiles; }
    void        SetMaxOpenedFiles(Int_t newmax);
+   Int_t       GetNThreads() const { return fNThreads; }
+   void        SetNThreads(Int_t nthreads);
+   Long64_t    GetMaxMemory() const { return fMaxMemory; }
+   void        SetMaxMemory(Long64_t maxmemory) { fMaxMemory = maxmemory; }
    const char *GetMsgPrefix() const { return fMsgPrefix; }
    void        SetMsgPrefix(const char *prefix);
    void        AddObjectNames(const char *name) {fObjectNames += name; fObjectNames += " ";}
@@ -86,6 +86,10 @@ private:
 
    static TThread::VoidRtnFunc_t ThreadProc(void*);  //create a joinable worker thread
 
+   Int_t     GetLocalFd() const;
+   void      AdviseBlock(TFPBlock*);
+   Bool_t    ReadLocalBlock(TFPBlock*);
+
 public:
    TFilePrefetch(TFile*);
    virtual ~TFilePrefetch();
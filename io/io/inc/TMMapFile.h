@@ -0,0 +1,53 @@
+// @(#)root/io:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#ifndef ROOT_TMMapFile
+#define ROOT_TMMapFile
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TMMapFile                                                            //
+//                                                                      //
+// A read-only local ROOT file accessed through a memory mapping.       //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef ROOT_TFile
+#include "TFile.h"
+#endif
+
+class TMMapFile : public TFile {
+
+private:
+   char        *fMapAddr;    //! Start of the mapping of the whole file
+   Long64_t     fMapSize;    //  Size of the mapping
+   Long64_t     fSysOffset;  //  Seek offset in the mapping
+
+   TMMapFile(const TMMapFile&);            // Not implemented
+   TMMapFile &operator=(const TMMapFile&); // Not implemented
+
+   // Overload TFile interfaces.
+   Int_t    SysClose(Int_t fd);
+   Int_t    SysRead(Int_t fd, void *buf, Int_t len);
+   Int_t    SysReadAt(Int_t fd, void *buf, Int_t len, Long64_t offset);
+   Long64_t SysSeek(Int_t fd, Long64_t offset, Int_t whence);
+
+public:
+   TMMapFile(const char *name, Option_t *option="", const char *ftitle="", Int_t compress=1);
+   virtual ~TMMapFile();
+
+   virtual char    *GetMappedBuffer(Long64_t pos, Int_t len) const;
+   Long64_t         GetMapSize() const { return fMapSize; }
+   virtual Bool_t   ReadBuffers(char *buf, Long64_t *pos, Int_t *len, Int_t nbuf);
+
+   ClassDef(TMMapFile, 0) //A read-only ROOT file accessed through mmap
+};
+
+#endif
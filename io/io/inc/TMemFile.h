@@ -27,7 +27,7 @@
 
 class TMemFile : public TFile {
 
-private:
+protected:
    struct TMemBlock {
    private:
       TMemBlock(const TMemBlock&);            // Not implemented
@@ -45,6 +45,8 @@ private:
       Long64_t   fSize;
    };
    TMemBlock    fBlockList;   // Colletion of memory blocks of size fBlockSize
+
+private:
    Long64_t     fSize;        // Total file size (sum of the size of the chunks)
    Long64_t     fSysOffset;   // Seek offset in file
    TMemBlock   *fBlockSeek;   // Pointer to the block we seeked to.
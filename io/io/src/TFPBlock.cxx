@@ -53,6 +53,7 @@ TFPBlock::TFPBlock(Long64_t* offset, Int_t* length, Int_t nb)
    fCapacity = aux;
    fDataSize = aux;
    fBuffer = (char*) calloc(fCapacity, sizeof(char));
+   fFailed = kFALSE;
 }
 
 //__________________________________________________________________
@@ -113,4 +114,5 @@ void TFPBlock::ReallocBlock(Long64_t* offset, Int_t* length, Int_t nb)
    }
 
    fDataSize = newSize;
+   fFailed = kFALSE;
 }
@@ -94,6 +94,7 @@
 #include "TInterpreter.h"
 #include "TKey.h"
 #include "TMakeProject.h"
+#include "TMMapFile.h"
 #include "TPluginManager.h"
 #include "TProcessUUID.h"
 #include "TRegexp.h"
@@ -117,6 +118,7 @@
 #include "TSchemaRule.h"
 #include "TSchemaRuleSet.h"
 #include "TThreadSlots.h"
+#include "TMutex.h"
 
 using std::sqrt;
 
@@ -154,6 +156,8 @@ TFile::TFile() : TDirectoryFile(), fInfoCache(0)
    fProcessIDs      = 0;
    fNProcessIDs     = 0;
    fOffset          = 0;
+   fConcurrentRead  = kFALSE;
+   fReadMutex       = 0;
    fArchive         = 0;
    fCacheRead       = 0;
    fCacheReadMap    = new TMap();
@@ -342,6 +346,8 @@ TFile::TFile(const char *fname1, Option_t *option, const char *ftitle, Int_t com
    fProcessIDs   = 0;
    fNProcessIDs  = 0;
    fOffset       = 0;
+   fConcurrentRead = kFALSE;
+   fReadMutex    = 0;
    fCacheRead    = 0;
    fCacheReadMap = new TMap();
    fCacheWrite   = 0;
@@ -515,6 +521,7 @@ TFile::~TFile()
    SafeDelete(fArchive);
    SafeDelete(fInfoCache);
    SafeDelete(fOpenPhases);
+   SafeDelete(fReadMutex);
 
    R__LOCKGUARD2(gROOTMutex);
    gROOT->GetListOfClosedObjects()->Remove(this);
@@ -1176,7 +1183,6 @@ Int_t TFile::GetRecordHeader(char *buf, Long64_t first, Int_t maxbytes, Int_t &n
    keylen = 0;
    if (first < fBEGIN) return 0;
    if (first > fEND)   return 0;
-   Seek(first);
    Int_t nread = maxbytes;
    if (first+maxbytes > fEND) nread = fEND-maxbytes;
    if (nread < 4) {
@@ -1184,7 +1190,7 @@ Int_t TFile::GetRecordHeader(char *buf, Long64_t first, Int_t maxbytes, Int_t &n
               GetName(), nread);
       return nread;
    }
-   if (ReadBuffer(buf,nread)) {
+   if (ReadBuffer(buf,first,nread)) {
       // ReadBuffer return kTRUE in case of failure.
       Warning("GetRecordHeader","%s: failed to read header data (maxbytes = %d)",
               GetName(), nread);
@@ -1231,6 +1237,16 @@ Long64_t TFile::GetSize() const
    return size;
 }
 
+//______________________________________________________________________________
+char *TFile::GetMappedBuffer(Long64_t, Int_t) const
+{
+   // Return the address in memory of the 'len' bytes at position 'pos' of
+   // the file if the file is memory mapped (see TMMapFile), 0 otherwise.
+   // The returned memory is read-only and owned by the file.
+
+   return 0;
+}
+
 //______________________________________________________________________________
 const TList *TFile::GetStreamerInfoCache()
 {
@@ -1472,9 +1488,15 @@ Bool_t TFile::ReadBuffer(char *buf, Long64_t pos, Int_t len)
    // Compared to ReadBuffer(char*, Int_t), this routine does _not_
    // change the cursor on the physical file representation (fD)
    // if the data is in this TFile's cache.
+   // In concurrent read mode (see SetConcurrentRead) it may be called from
+   // several threads: the data is read at 'pos' with a positional read,
+   // without going through this TFile's cache nor using the file offset.
 
    if (IsOpen()) {
 
+      if (fConcurrentRead)
+         return ReadBufferAt(buf, pos, len);
+
       SetOffset(pos);
 
       Int_t st;
@@ -1525,6 +1547,9 @@ Bool_t TFile::ReadBuffer(char *buf, Int_t len)
 
    if (IsOpen()) {
 
+      // The file offset is shared: serialize in concurrent read mode.
+      R__LOCKGUARD(fReadMutex);
+
       Int_t st;
       if ((st = ReadBufferViaCache(buf, len))) {
          if (st == 2)
@@ -1586,7 +1611,9 @@ Bool_t TFile::ReadBuffers(char *buf, Long64_t *pos, Int_t *len, Int_t nbuf)
    Int_t k = 0;
    Bool_t result = kTRUE;
    TFileCacheRead *old = fCacheRead;
-   fCacheRead = 0;
+   // In concurrent read mode the blocks are read with positional reads,
+   // which do not go through the cache anyway.
+   if (!fConcurrentRead) fCacheRead = 0;
    Long64_t curbegin = pos[0];
    Long64_t cur;
    char *buf2 = 0;
@@ -1599,18 +1626,26 @@ Bool_t TFile::ReadBuffers(char *buf, Long64_t *pos, Int_t *len, Int_t nbuf)
          if (n == 0) {
             //if the block to read is about the same size as the read-ahead buffer
             //we read the block directly
-            Seek(pos[i]);
-            result = ReadBuffer(&buf[k], len[i]);
+            if (fConcurrentRead) {
+               result = ReadBufferAt(&buf[k], pos[i], len[i]);
+            } else {
+               Seek(pos[i]);
+               result = ReadBuffer(&buf[k], len[i]);
+            }
             if (result) break;
             k += len[i];
             i++;
          } else {
             //otherwise we read all blocks that fit in the read-ahead buffer
-            Seek(curbegin);
             if (buf2 == 0) buf2 = new char[fgReadaheadSize];
             //we read ahead
             Long64_t nahead = pos[i-1]+len[i-1]-curbegin;
-            result = ReadBuffer(buf2, nahead);
+            if (fConcurrentRead) {
+               result = ReadBufferAt(buf2, curbegin, nahead);
+            } else {
+               Seek(curbegin);
+               result = ReadBuffer(buf2, nahead);
+            }
             if (result) break;
             //now copy from the read-ahead buffer to the cache
             Int_t kold = k;
@@ -1620,6 +1655,7 @@ Bool_t TFile::ReadBuffers(char *buf, Long64_t *pos, Int_t *len, Int_t nbuf)
             }
             Int_t nok = k-kold;
             Long64_t extra = nahead-nok;
+            R__LOCKGUARD(fReadMutex);
             fBytesReadExtra += extra;
             fBytesRead      -= extra;
             fgBytesRead     -= extra;
@@ -1633,6 +1669,53 @@ Bool_t TFile::ReadBuffers(char *buf, Long64_t *pos, Int_t *len, Int_t nbuf)
    return result;
 }
 
+//______________________________________________________________________________
+Bool_t TFile::ReadBufferAt(char *buf, Long64_t pos, Int_t len)
+{
+   // Read len bytes at the offset 'pos' of the file with positional reads
+   // (see SysReadAt), neither using nor changing the file offset. Used in
+   // concurrent read mode; only the update of the statistics is locked.
+   // Returns kTRUE in case of failure.
+
+   Double_t start = 0;
+   if (gPerfStats != 0) start = TTimeStamp();
+
+   Int_t nread = 0;
+   Int_t siz = 0;
+   while (nread < len) {
+      siz = SysReadAt(fD, buf + nread, len - nread, pos + fArchiveOffset + nread);
+      if (siz < 0 && GetErrno() == EINTR) {
+         ResetErrno();
+         continue;
+      }
+      if (siz <= 0) break;
+      nread += siz;
+   }
+
+   if (siz < 0) {
+      SysError("ReadBuffer", "error reading from file %s", GetName());
+      return kTRUE;
+   }
+   if (nread != len) {
+      Error("ReadBuffer", "error reading all requested bytes from file %s, got %d of %d",
+            GetName(), nread, len);
+      return kTRUE;
+   }
+
+   R__LOCKGUARD(fReadMutex);
+   fBytesRead  += nread;
+   fgBytesRead += nread;
+   fReadCalls++;
+   fgReadCalls++;
+
+   if (gMonitoringWriter)
+      gMonitoringWriter->SendFileReadProgress(this);
+   if (gPerfStats != 0) {
+      gPerfStats->FileReadEvent(this, len, start);
+   }
+   return kFALSE;
+}
+
 //______________________________________________________________________________
 Int_t TFile::ReadBufferViaCache(char *buf, Int_t len)
 {
@@ -2023,7 +2106,13 @@ void TFile::Seek(Long64_t offset, ERelativeTo pos)
 //______________________________________________________________________________
 void TFile::SetCompressionAlgorithm(Int_t algorithm)
 {
-   // See comments for function SetCompressionSettings
+   // Set the compression algorithm, one of ROOT::ECompressionAlgorithm:
+   //   ROOT::kUseGlobalSetting (0), ROOT::kZLIB (1), ROOT::kLZMA (2),
+   //   ROOT::kOldCompressionAlgo (3), ROOT::kLZ4 (4), ROOT::kZSTD (5).
+   // LZ4 favours decompression speed, ZSTD gives LZMA-like compression
+   // factors at ZLIB-like speed. If ROOT was built without the lz4 or
+   // zstd option, ZLIB is used when writing.
+   // See also comments for function SetCompressionSettings
    if (algorithm < 0 || algorithm >= ROOT::kUndefinedCompressionAlgorithm) algorithm = 0;
    if (fCompress < 0) {
       // if the level is not defined yet use 1 as a default
@@ -2078,6 +2167,42 @@ void TFile::SetCompressionSettings(Int_t settings)
    fCompress = settings;
 }
 
+//______________________________________________________________________________
+Bool_t TFile::SetConcurrentRead(Bool_t on)
+{
+   // Enable (or disable) the concurrent read mode, in which several threads
+   // may read different records of this file at the same time, e.g. the
+   // baskets of different trees or branches, or different keys, without
+   // opening the file once per thread.
+   //
+   // In this mode ReadBuffer(buf, pos, len) and ReadBuffers() read with
+   // positional reads (pread), which neither use nor change the file
+   // offset, and do not take any lock; TKey and TBasket read their records
+   // this way. ReadBuffer(buf, len), which reads at the file offset, is
+   // serialized. The reads at a given position bypass the cache of the
+   // file: the TTreeCache of a tree is still used by the baskets of that
+   // tree, so each thread should read its own TTree object with its own
+   // cache, set up before the threads start reading.
+   //
+   // Only local files opened for reading (TFile and TMMapFile) support
+   // this mode. Returns kFALSE if the mode could not be enabled.
+
+   if (!on) {
+      fConcurrentRead = kFALSE;
+      return kTRUE;
+   }
+   if (fConcurrentRead) return kTRUE;
+   if (!IsOpen() || fD < 0 || fWritable ||
+       (IsA() != TFile::Class() && IsA() != TMMapFile::Class())) {
+      Error("SetConcurrentRead", "%s: only local files opened for reading support concurrent reads",
+            GetName());
+      return kFALSE;
+   }
+   if (!fReadMutex) fReadMutex = new TMutex(kTRUE);
+   fConcurrentRead = kTRUE;
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 void TFile::SetCacheRead(TFileCacheRead *cache, TObject* tree, ECacheAction action)
 {
@@ -3735,6 +3860,10 @@ TFile *TFile::Open(const char *url, Option_t *options, const char *ftitle,
    //                   it will be internally checked with granularity of
    //                   one millisec.
    //
+   // For local files there is the option:
+   //  MMAP          opens an existing file for reading and maps it in memory
+   //                (see TMMapFile).
+   //
    // For remote files there is the option:
    //  CACHEREAD     opens an existing file for reading through the file cache.
    //                The file will be downloaded to the cache and opened from there.
@@ -3871,7 +4000,10 @@ TFile *TFile::Open(const char *url, Option_t *options, const char *ftitle,
                urlname.SetProtocol("file");
                lfname = urlname.GetUrl();
             }
-            f = new TFile(lfname.Data(), option, ftitle, compress);
+            if (!strcasecmp(option, "MMAP"))
+               f = new TMMapFile(lfname.Data(), option, ftitle, compress);
+            else
+               f = new TFile(lfname.Data(), option, ftitle, compress);
             
          } else if (type == kNet) {
             
@@ -3894,7 +4026,9 @@ TFile *TFile::Open(const char *url, Option_t *options, const char *ftitle,
          } else if (type == kFile) {
             
             // 'file:' protocol
-            if ((h = gROOT->GetPluginManager()->FindHandler("TFile", name)) &&
+            if (!strcasecmp(option, "MMAP")) {
+               f = new TMMapFile(name.Data(), option, ftitle, compress);
+            } else if ((h = gROOT->GetPluginManager()->FindHandler("TFile", name)) &&
                 h->LoadPlugin() == 0) {
                name.ReplaceAll("file:", "");
                f = (TFile*) h->ExecPlugin(4, name.Data(), option, ftitle, compress);
@@ -4133,6 +4267,26 @@ Int_t TFile::SysRead(Int_t fd, void *buf, Int_t len)
    return ::read(fd, buf, len);
 }
 
+//______________________________________________________________________________
+Int_t TFile::SysReadAt(Int_t fd, void *buf, Int_t len, Long64_t offset)
+{
+   // Interface to system pread: read len bytes at 'offset' without using
+   // nor changing the file offset, so that several threads can read the
+   // same file descriptor. All arguments like in POSIX pread() except that
+   // the offset is able to handle 64 bit file systems.
+
+#if defined(WIN32)
+   // No positional read: serialize the seek and the read.
+   R__LOCKGUARD(fReadMutex);
+   if (SysSeek(fd, offset, SEEK_SET) < 0) return -1;
+   return SysRead(fd, buf, len);
+#elif defined(R__SEEK64)
+   return ::pread64(fd, buf, len, offset);
+#else
+   return ::pread(fd, buf, len, offset);
+#endif
+}
+
 //______________________________________________________________________________
 Int_t TFile::SysWrite(Int_t fd, const void *buf, Int_t len)
 {
@@ -4483,7 +4637,8 @@ TFile::EFileType TFile::GetType(const char *name, Option_t *option, TString *pre
             // If option "READ" test existence and access
             TString opt = option;
             Bool_t read = (opt.IsNull() ||
-                          !opt.CompareTo("READ", TString::kIgnoreCase)) ? kTRUE : kFALSE;
+                          !opt.CompareTo("READ", TString::kIgnoreCase) ||
+                          !opt.CompareTo("MMAP", TString::kIgnoreCase)) ? kTRUE : kFALSE;
             if (read) {
                char *fn;
                if ((fn = gSystem->ExpandPathName(TUrl(lfname).GetFile()))) {
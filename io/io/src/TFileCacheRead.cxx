@@ -135,15 +135,9 @@ TFileCacheRead::TFileCacheRead(TFile *file, Int_t buffersize, TObject *tree)
    fPrefetchedBlocks = 0;
 
    //initialise the prefetch object and set the cache directory
-   // start the thread only if the file is not local  
+   // local files are prefetched with positional reads (see TFilePrefetch)
    fEnablePrefetching = gEnv->GetValue("TFile.AsyncPrefetching", 0);
-   
-   if (fEnablePrefetching && strcmp(file->GetEndpointUrl()->GetProtocol(), "file")){
-      SetEnablePrefetchingImpl(true);
-   }
-   else { //disable the async pref for local files
-      SetEnablePrefetchingImpl(false);
-   }
+   SetEnablePrefetchingImpl(fEnablePrefetching && file);
 
    fIsSorted       = kFALSE;
    fIsTransferred  = kFALSE;
@@ -402,7 +396,9 @@ Int_t TFileCacheRead::ReadBufferExtPrefetch(char *buf, Long64_t pos, Int_t len,
 
    // in case we are writing and reading to/from this file, we must check                                                                                    
    // if this buffer is in the write cache (not yet written to the file)
-   if (TFileCacheWrite *cachew = fFile->GetCacheWrite()) {
+   // A null buf is only a lookup of the read cache (see TTreeCacheUnzip)
+   TFileCacheWrite *cachew = buf ? fFile->GetCacheWrite() : 0;
+   if (cachew) {
       if (cachew->ReadBuffer(buf,pos,len) == 0) {
          fFile->SetOffset(pos+len);
          return 1;
@@ -416,9 +412,11 @@ Int_t TFileCacheRead::ReadBufferExtPrefetch(char *buf, Long64_t pos, Int_t len,
 
    if (loc >= 0 && loc < fNseek && pos == fSeekSort[loc]) {
       if (buf && fPrefetch){
-         // prefetch with the new method                  
-         fPrefetch->ReadBuffer(buf, pos, len);
-         return 1;
+         // prefetch with the new method, if the block could not be
+         // read let the caller read the buffer synchronously
+         if (fPrefetch->ReadBuffer(buf, pos, len))
+            return 1;
+         return 0;
       }
    }
    else if (buf && fPrefetch){
@@ -470,7 +468,9 @@ Int_t TFileCacheRead::ReadBufferExtNormal(char *buf, Long64_t pos, Int_t len, In
 
    // in case we are writing and reading to/from this file, we much check
    // if this buffer is in the write cache (not yet written to the file)
-   if (TFileCacheWrite *cachew = fFile->GetCacheWrite()) {
+   // A null buf is only a lookup of the read cache (see TTreeCacheUnzip)
+   TFileCacheWrite *cachew = buf ? fFile->GetCacheWrite() : 0;
+   if (cachew) {
       if (cachew->ReadBuffer(buf,pos,len) == 0) {
          fFile->SetOffset(pos+len);
          return 1;
@@ -22,6 +22,26 @@
 // The merging interface allows files containing histograms and trees   //
 // to be merged, like the standalone hadd program.                      //
 //                                                                      //
+// When the number of threads is set (SetNThreads, hadd -j) the input   //
+// files are split in consecutive groups, one per thread. Each group    //
+// is opened, read and merged into a temporary file (trees are fast     //
+// cloned when the compression allows it) by a job of the shared        //
+// TTaskScheduler, and the partial results are then merged into the     //
+// output file by the calling thread. The order of the tree entries is  //
+// the same as for the serial merge.                                    //
+// The threads read, write and delete the objects under gROOTMutex;    //
+// the histograms are added and the baskets of the trees copied         //
+// concurrently. The baskets are written twice, and the temporary       //
+// directory must have room for about the size of the output file:      //
+// the merge is serial (the default, SetNThreads(1)) if it does not,    //
+// and when the inputs have no tree.                                    //
+//                                                                      //
+// The merge goes through the output one directory at a time: once a    //
+// directory is merged, it is written and deleted from memory, together //
+// with the corresponding directories (and their keys) of the inputs.   //
+// When the histograms are merged in one go, SetMaxMemory bounds the    //
+// size of the copies read from the inputs before they are added.       //
+//                                                                      //
 //////////////////////////////////////////////////////////////////////////
 
 #include "TFileMerger.h"
@@ -39,7 +59,12 @@
 #include "TFileMergeInfo.h"
 #include "TClassRef.h"
 #include "TROOT.h"
+#include "TVirtualMutex.h"
 #include "TMemFile.h"
+#include "TTaskScheduler.h"
+#include "TMath.h"
+
+#include <vector>
 
 #ifdef WIN32
 // For _getmaxstdio
@@ -57,6 +82,112 @@ TClassRef R__TTree_Class("TTree");
 
 static const Int_t kCpProgress = BIT(14);
 static const Int_t kCintFileNumber = 100;
+
+// Input of a thread of the parallel merge (see TFileMerger::ParallelPartialMerge).
+struct TFileMergerWorker {
+   TFileMerger *fMerger;   // Merger of the group, owns the temporary output file
+   TList        fUrls;     // Names of the input files of the group
+   Int_t        fType;     // Type of the merge (EPartialMergeType)
+   Bool_t       fStatus;   // Result of the merge of the group
+};
+
+// Lock held by the mergers of the groups of a parallel merge while they
+// use global state (gROOT lists of files and cleanups, TH1::AddDirectory,
+// the interpreter), released while histograms read from the inputs are
+// added and while the baskets of a tree are copied.
+class TFileMergerLock {
+private:
+   TVirtualMutex *fMutex;
+   Bool_t         fLocked;
+   TFileMergerLock(const TFileMergerLock&);            // Not implemented.
+   TFileMergerLock &operator=(const TFileMergerLock&); // Not implemented.
+public:
+   TFileMergerLock(TVirtualMutex *mutex) : fMutex(mutex), fLocked(kFALSE) { Acquire(); }
+   ~TFileMergerLock() { Release(); }
+   void Acquire() { if (fMutex && !fLocked) { fMutex->Lock(); fLocked = kTRUE; } }
+   void Release() { if (fMutex && fLocked) { fMutex->UnLock(); fLocked = kFALSE; } }
+};
+
+//______________________________________________________________________________
+static Bool_t R__HasTrees(TDirectory *dir)
+{
+   // Return kTRUE if dir or one of its subdirectories has a key of a tree.
+
+   TIter next(dir->GetListOfKeys());
+   TKey *key;
+   while ((key = (TKey*)next())) {
+      TClass *cl = TClass::GetClass(key->GetClassName());
+      if (!cl) continue;
+      if (cl->InheritsFrom(R__TTree_Class)) return kTRUE;
+      if (cl->InheritsFrom(TDirectory::Class())) {
+         TDirectory *subdir = dir->GetDirectory(key->GetName());
+         if (subdir && R__HasTrees(subdir)) return kTRUE;
+      }
+   }
+   return kFALSE;
+}
+
+//______________________________________________________________________________
+static void *R__MergeGroup(void *arg)
+{
+   // Open and merge a group of input files, in its own thread.
+
+   TFileMergerWorker *worker = (TFileMergerWorker*)arg;
+
+   // Objects read from the inputs must not be attached to a directory
+   // shared with other threads.
+   TDirectory::TContext ctxt(0);
+
+   worker->fStatus = kTRUE;
+   {
+      TFileMergerLock lock(gROOTMutex);
+      TIter next(&worker->fUrls);
+      TObjString *url;
+      while ((url = (TObjString*)next())) {
+         if (!worker->fMerger->AddFile(url->GetName(), kFALSE)) {
+            worker->fStatus = kFALSE;
+            return 0;
+         }
+      }
+   }
+   worker->fStatus = worker->fMerger->PartialMerge(worker->fType);
+   return 0;
+}
+
+// The merge of a group, as a job of the task scheduler.
+class TFileMergerJob : public TTaskScheduler::TJob {
+private:
+   TFileMergerWorker *fWorker;
+public:
+   TFileMergerJob(TFileMergerWorker *worker) : fWorker(worker) { }
+   virtual void Execute() { R__MergeGroup(fWorker); }
+};
+
+//______________________________________________________________________________
+static void R__ReleaseDirectories(TList *sourcelist, const char *path, const char *name, TObject *keep)
+{
+   // Delete the sub-directory 'name' of the directory 'path' of each input
+   // file, with its keys, if it is in memory (except 'keep').
+
+   TObjArray *tokens = TString(path).Tokenize("/");
+   TIter next(sourcelist);
+   TFile *file;
+   while ((file = (TFile*)next())) {
+      // Only look at the directories already read.
+      TDirectory *dir = file;
+      for (Int_t i = 0; dir && i < tokens->GetEntriesFast(); ++i) {
+         TObject *sub = dir->GetList()->FindObject(tokens->UncheckedAt(i)->GetName());
+         dir = (sub && sub->InheritsFrom(TDirectory::Class())) ? (TDirectory*)sub : 0;
+      }
+      if (!dir) continue;
+      TObject *sub = dir->GetList()->FindObject(name);
+      if (sub && sub != keep && sub->InheritsFrom(TDirectory::Class())) {
+         delete sub;
+      }
+   }
+   delete tokens;
+}
+
 //______________________________________________________________________________
 static Int_t R__GetSystemMaxOpenedFiles()
 {
@@ -87,7 +218,7 @@ static Int_t R__GetSystemMaxOpenedFiles()
 TFileMerger::TFileMerger(Bool_t isLocal, Bool_t histoOneGo)
             : fOutputFile(0), fFastMethod(kTRUE), fNoTrees(kFALSE), fExplicitCompLevel(kFALSE), fCompressionChange(kFALSE),
               fPrintLevel(0), fMsgPrefix("TFileMerger"), fMaxOpenedFiles( R__GetSystemMaxOpenedFiles() ),
-              fLocal(isLocal), fHistoOneGo(histoOneGo), fObjectNames()
+              fLocal(isLocal), fHistoOneGo(histoOneGo), fObjectNames(), fNThreads(1), fMaxMemory(0), fGroupMerger(kFALSE)
 {
    // Create file merger object.
 
@@ -171,7 +302,7 @@ Bool_t TFileMerger::AddFile(const char *url, Bool_t cpProgress)
          Error("AddFile", "cannot open file %s", url);
       return kFALSE;
    } else {
-      if (fOutputFile && fOutputFile->GetCompressionLevel() != newfile->GetCompressionLevel()) fCompressionChange = kTRUE;
+      if (fOutputFile && fOutputFile->GetCompressionSettings() != newfile->GetCompressionSettings()) fCompressionChange = kTRUE;
       
       newfile->SetBit(kCanDelete);
       fFileList->Add(newfile);
@@ -246,7 +377,7 @@ Bool_t TFileMerger::AddFile(TFile *source, Bool_t own, Bool_t cpProgress)
          Error("AddFile", "cannot open file %s", source->GetName());
       return kFALSE;
    } else {
-      if (fOutputFile && fOutputFile->GetCompressionLevel() != newfile->GetCompressionLevel()) fCompressionChange = kTRUE;
+      if (fOutputFile && fOutputFile->GetCompressionSettings() != newfile->GetCompressionSettings()) fCompressionChange = kTRUE;
       
       if (own || newfile != source) {
          newfile->SetBit(kCanDelete);
@@ -380,8 +511,11 @@ Bool_t TFileMerger::MergeRecursive(TDirectory *target, TList *sourcelist, Int_t
    
    TFileMergeInfo info(target);
 
-   if ((fFastMethod && !fCompressionChange)) {
+   if (fFastMethod) {
+      // When the compression changes, the baskets are recompressed (but
+      // not unstreamed) by the fast cloning.
       info.fOptions.Append(" fast");
+      if (fCompressionChange) info.fOptions.Append(" recompress");
    }
 
    TFile      *current_file;
@@ -405,6 +539,10 @@ Bool_t TFileMerger::MergeRecursive(TDirectory *target, TList *sourcelist, Int_t
          
          while ( (key = (TKey*)nextkey())) {
 
+            // In a group of a parallel merge the objects are read, merged,
+            // written and deleted under gROOTMutex (see ParallelPartialMerge).
+            TFileMergerLock lock(fGroupMerger ? gROOTMutex : 0);
+
             // Keep only the highest cycle number for each key for mergeable objects. They are stored
             // in the (hash) list onsecutively and in decreasing order of cycles, so we can continue
             // until the name changes. We flag the case here and we act consequently later.
@@ -507,16 +645,27 @@ Bool_t TFileMerger::MergeRecursive(TDirectory *target, TList *sourcelist, Int_t
 
                // If this folder is a onlyListed object, merge everything inside.
                if (onlyListed) type &= ~kOnlyListed;
+               lock.Release(); // taken again for each key of the directory
                status = MergeRecursive(newdir, sourcelist, type);
+               lock.Acquire();
                if (onlyListed) type |= kOnlyListed;
                if (!status) return status;
+
+               // The directory is complete: release it and the inputs'.
+               R__ReleaseDirectories(sourcelist, path, obj->GetName(), obj);
+               if (!(type & kIncremental) && newdir != obj) {
+                  delete newdir;
+               }
             } else if (obj->IsA()->GetMerge()) {
                
                // Check if already treated
                if (alreadyseen) continue;
                
                TList inputs;
-               Bool_t oneGo = fHistoOneGo && obj->IsA()->InheritsFrom(R__TH1_Class);
+               Long64_t inputsize = 0;
+               Bool_t isHisto = obj->IsA()->InheritsFrom(R__TH1_Class);
+               Bool_t oneGo = fHistoOneGo && isHisto;
+               Bool_t isTree = obj->IsA()->InheritsFrom(R__TTree_Class);
                
                // Loop over all source files and merge same-name object
                TFile *nextsource = current_file ? (TFile*)sourcelist->After( current_file ) : (TFile*)sourcelist->First();
@@ -546,15 +695,23 @@ Bool_t TFileMerger::MergeRecursive(TDirectory *target, TList *sourcelist, Int_t
                            }
                            hobj->ResetBit(kMustCleanup);
                            inputs.Add(hobj);
-                           if (!oneGo) {
+                           inputsize += key2->GetObjlen();
+                           if (!oneGo || (fMaxMemory > 0 && inputsize >= fMaxMemory)) {
                               ROOT::MergeFunc_t func = obj->IsA()->GetMerge();
+                              // TH1::Merge only uses the histograms, already
+                              // read and detached; once the output tree is
+                              // created, merging a tree copies its baskets:
+                              // let the other groups run meanwhile.
+                              if (isHisto || (isTree && !info.fIsFirst)) lock.Release();
                               Long64_t result = func(obj, &inputs, &info);
+                              lock.Acquire();
                               info.fIsFirst = kFALSE;
                               if (result < 0) {
                                  Error("MergeRecursive", "calling Merge() on '%s' with the corresponding object in '%s'",
                                        obj->GetName(), nextsource->GetName());
                               }
                               inputs.Delete();
+                              inputsize = 0;
                            }
                         }
                      }
@@ -563,7 +720,9 @@ Bool_t TFileMerger::MergeRecursive(TDirectory *target, TList *sourcelist, Int_t
                   // Merge the list, if still to be done
                   if (oneGo || info.fIsFirst) {
                      ROOT::MergeFunc_t func = obj->IsA()->GetMerge();
+                     if (isHisto) lock.Release();
                      func(obj, &inputs, &info);
+                     lock.Acquire();
                      info.fIsFirst = kFALSE;
                      inputs.Delete();
                   }
@@ -810,12 +969,26 @@ Bool_t TFileMerger::PartialMerge(Int_t in_type)
    fOutputFile->SetBit(kMustCleanup);
 
    TDirectory::TContext ctxt(0);
+
+   fWatch.Start(kTRUE);
+   Long64_t bytesread = TFile::GetFileBytesRead();
+   Long64_t byteswritten = TFile::GetFileBytesWritten();
    
    Bool_t result = kTRUE;
    Int_t type = in_type;
+
+   // With several threads, the groups of input files are first merged
+   // in parallel and fFileList is replaced by the partial results.
+   TList partials;
+   partials.SetOwner(kTRUE);
+   if (fNThreads > 1 && !(in_type & kIncremental)) {
+      result = ParallelPartialMerge(type, &partials);
+   }
+
    while (result && fFileList->GetEntries()>0) {
       result = MergeRecursive(fOutputFile, fFileList, type);
       
+      TFileMergerLock lock(fGroupMerger ? gROOTMutex : 0);
       // Remove local copies if there are any
       TIter next(fFileList);
       TFile *file;
@@ -840,6 +1013,13 @@ Bool_t TFileMerger::PartialMerge(Int_t in_type)
          OpenExcessFiles();         
       }
    }
+   // Remove the partial results of the parallel merge
+   TIter nextpartial(&partials);
+   TObjString *partial;
+   while ((partial = (TObjString*) nextpartial())) {
+      gSystem->Unlink(partial->GetName());
+   }
+   TFileMergerLock lock(fGroupMerger ? gROOTMutex : 0);
    if (!result) {
       Error("Merge", "error during merge of your ROOT files");
    } else {
@@ -850,6 +1030,15 @@ Bool_t TFileMerger::PartialMerge(Int_t in_type)
          fOutputFile->Close();
       }
    }
+   fWatch.Stop();
+   if (result && fPrintLevel > 0) {
+      Double_t mbread = (TFile::GetFileBytesRead() - bytesread) / 1048576.;
+      Double_t mbwritten = (TFile::GetFileBytesWritten() - byteswritten) / 1048576.;
+      Double_t rtime = fWatch.RealTime();
+      Printf("%s Merged %d files in %.1f s: %.1f MB read (%.1f MB/s), %.1f MB written (%.1f MB/s)",
+             fMsgPrefix.Data(), fMergeList->GetEntries(), rtime,
+             mbread, rtime > 0 ? mbread / rtime : 0., mbwritten, rtime > 0 ? mbwritten / rtime : 0.);
+   }
    
    // Cleanup
    if (in_type & kIncremental) {
@@ -861,6 +1050,151 @@ Bool_t TFileMerger::PartialMerge(Int_t in_type)
    return result;
 }
 
+//______________________________________________________________________________
+Bool_t TFileMerger::ParallelPartialMerge(Int_t type, TList *partials)
+{
+   // Merge the input files in groups of consecutive files, one group per
+   // thread, each into a temporary file with the compression settings of
+   // the output file. On return fFileList contains the temporary files,
+   // in order, and their local names are added to partials so that the
+   // caller removes them once merged.
+   // The inputs already opened by AddFile are closed and reopened by the
+   // threads; if one of them cannot be reopened by name (TMemFile or
+   // TFile not owned by the merger), or with local copies, nothing is done
+   // and the merge is serial.
+   //
+   // The groups are merged by the threads with the same MergeRecursive as
+   // the serial merge, except that each key is processed under gROOTMutex:
+   // reading, writing and deleting objects, and the Merge functions called
+   // through the interpreter, touch global state. The lock is released
+   // while TH1::Merge adds the histograms read from the inputs and while
+   // the baskets of a tree are copied into the partial result.
+   // The baskets of the trees are written twice, once in the partial
+   // results and once in the output file, and the partial results need
+   // about the size of the inputs in gSystem->TempDirectory(). If there is
+   // not that much free space the merge is serial. It is serial as well
+   // when the first input has no tree: reading the histograms, which is
+   // serialized, dominates and writing them twice would only add to it.
+   // Returns kFALSE in case of error.
+
+   if (fLocal) return kTRUE;
+   Long64_t insize = 0;
+   TIter nextfile(fFileList);
+   TFile *file;
+   while ((file = (TFile*) nextfile())) {
+      if (!file->TestBit(kCanDelete) || file->InheritsFrom(TMemFile::Class())) {
+         if (fPrintLevel > 0) {
+            Printf("%s Input file %s cannot be reopened, merging serially", fMsgPrefix.Data(), file->GetName());
+         }
+         return kTRUE;
+      }
+      insize += file->GetSize();
+   }
+   file = (TFile*) fFileList->First();
+   if (fNoTrees || (file && !R__HasTrees(file))) {
+      if (fPrintLevel > 0) {
+         Printf("%s No tree to merge, merging serially", fMsgPrefix.Data());
+      }
+      return kTRUE;
+   }
+
+   // At least two files per group, and the partial results must all be
+   // opened at once for the final merge.
+   Int_t ninputs = fMergeList->GetEntries();
+   Int_t ngroups = TMath::Min(fNThreads, ninputs / 2);
+   ngroups = TMath::Min(ngroups, fMaxOpenedFiles - 1);
+   if (ngroups < 2) return kTRUE;
+
+   // The files not opened yet (fExcessFiles) are assumed to be of the
+   // average size of the opened ones.
+   if (fFileList->GetEntries() > 0) insize = insize / fFileList->GetEntries() * ninputs;
+   Long_t id, bsize, blocks, bfree;
+   if (gSystem->GetFsInfo(gSystem->TempDirectory(), &id, &bsize, &blocks, &bfree) == 0 &&
+       (Long64_t)bsize * bfree < insize) {
+      Warning("ParallelPartialMerge", "not enough space in %s for the partial results (%lld bytes needed), merging serially",
+              gSystem->TempDirectory(), insize);
+      return kTRUE;
+   }
+
+   if (fPrintLevel > 0) {
+      Printf("%s Merging %d files in %d groups in parallel", fMsgPrefix.Data(), ninputs, ngroups);
+   }
+
+   // Close (delete) the inputs: the threads reopen them so that they are
+   // read concurrently.
+   fFileList->Clear();
+   fExcessFiles->Clear();
+
+   std::vector<TFileMergerWorker*> workers;
+   TObjLink *lnk = fMergeList->FirstLink();
+   Bool_t result = kTRUE;
+   for (Int_t g = 0; g < ngroups; ++g) {
+      TFileMergerWorker *worker = new TFileMergerWorker;
+      worker->fMerger = new TFileMerger(kFALSE, fHistoOneGo);
+      worker->fMerger->SetMsgPrefix(TString::Format("%s[%d]", fMsgPrefix.Data(), g));
+      worker->fMerger->SetPrintLevel(fPrintLevel - 1);
+      worker->fMerger->SetMaxOpenedFiles(TMath::Max(2, fMaxOpenedFiles / ngroups));
+      worker->fMerger->SetFastMethod(fFastMethod);
+      worker->fMerger->SetNotrees(fNoTrees);
+      worker->fMerger->SetMaxMemory(fMaxMemory / ngroups);
+      worker->fMerger->fObjectNames = fObjectNames;
+      worker->fMerger->fGroupMerger = kTRUE;
+      worker->fType = type;
+      worker->fStatus = kFALSE;
+      workers.push_back(worker);
+
+      TUUID uuid;
+      TString partial = TString::Format("%s/ROOTMERGE-%s.root", gSystem->TempDirectory(), uuid.AsString());
+      partials->Add(new TObjString(partial));
+      if (!worker->fMerger->OutputFile(partial, "RECREATE", fOutputFile->GetCompressionSettings())) {
+         result = kFALSE;
+         break;
+      }
+      // Groups of consecutive files keep the order of the tree entries.
+      Int_t nfiles = ninputs / ngroups + (g < ninputs % ngroups ? 1 : 0);
+      for (Int_t i = 0; i < nfiles && lnk; ++i, lnk = lnk->Next()) {
+         worker->fUrls.Add(new TObjString(lnk->GetObject()->GetName()));
+      }
+      worker->fUrls.SetOwner(kTRUE);
+   }
+
+   if (result) {
+      TTaskGroup group;
+      for (UInt_t g = 1; g < workers.size(); ++g) {
+         group.Run(new TFileMergerJob(workers[g]));
+      }
+      // The calling thread merges the first group.
+      R__MergeGroup(workers[0]);
+      group.Wait();
+   }
+
+   for (UInt_t g = 0; g < workers.size(); ++g) {
+      if (result && !workers[g]->fStatus) {
+         Error("ParallelPartialMerge", "error during the merge of group %d", g);
+         result = kFALSE;
+      }
+      delete workers[g]->fMerger;
+      delete workers[g];
+   }
+   if (!result) return kFALSE;
+
+   // The partial results have the compression of the output file, the
+   // final merge can copy the baskets as they are.
+   fCompressionChange = kFALSE;
+   TIter nextpartial(partials);
+   TObjString *partial;
+   while ((partial = (TObjString*) nextpartial())) {
+      TFile *newfile = TFile::Open(partial->GetName(), "READ");
+      if (!newfile) {
+         Error("ParallelPartialMerge", "cannot open the partial result %s", partial->GetName());
+         return kFALSE;
+      }
+      newfile->SetBit(kCanDelete);
+      fFileList->Add(newfile);
+   }
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 Bool_t TFileMerger::OpenExcessFiles()
 {
@@ -897,7 +1231,7 @@ Bool_t TFileMerger::OpenExcessFiles()
             Error("OpenExcessFiles", "cannot open file %s", url->GetName());
          return kFALSE;
       } else {
-         if (fOutputFile && fOutputFile->GetCompressionLevel() != newfile->GetCompressionLevel()) fCompressionChange = kTRUE;
+         if (fOutputFile && fOutputFile->GetCompressionSettings() != newfile->GetCompressionSettings()) fCompressionChange = kTRUE;
          
          newfile->SetBit(kCanDelete);
          fFileList->Add(newfile);
@@ -945,3 +1279,19 @@ void TFileMerger::SetMsgPrefix(const char *prefix)
    fMsgPrefix = prefix;
 }
 
+//______________________________________________________________________________
+void TFileMerger::SetNThreads(Int_t nthreads)
+{
+   // Set the number of threads merging the input files in parallel. If
+   // nthreads is 0, use as many as the shared TTaskScheduler has (by
+   // default one per cpu). With one thread (the default) the files are
+   // merged serially.
+   // The parallel merge applies to non-incremental merges of trees without
+   // local copies of the input files. It writes the baskets of the trees twice,
+   // the first time in temporary files of about the size of the output
+   // (see ParallelPartialMerge): keep the serial merge when the temporary
+   // directory is small or when the merge is limited by the writing.
+
+   if (nthreads <= 0) nthreads = TTaskScheduler::GetDefaultNThreads();
+   fNThreads = nthreads;
+}
@@ -20,6 +20,12 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cctype>
+#include <cerrno>
+
+#ifndef WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#endif
 
 static const int kMAX_READ_SIZE    = 2;   //maximum size of the read list of blocks
 
@@ -96,7 +102,9 @@ void TFilePrefetch::WaitFinishPrefetch()
 //____________________________________________________________________________________________
 void TFilePrefetch::ReadAsync(TFPBlock* block, Bool_t &inCache)
 {
-   // Read one block and insert it in prefetchBuffers list.
+   // Read one block and insert it in prefetchBuffers list. If the block
+   // cannot be read it is marked as failed, ReadBuffer then refuses to
+   // serve its pieces and the caller reads them synchronously.
 
    char* path = 0;
 
@@ -104,8 +112,14 @@ void TFilePrefetch::ReadAsync(TFPBlock* block, Bool_t &inCache)
       block->SetBuffer(GetBlockFromCache(path, block->GetDataSize()));
       inCache = kTRUE;
    }
+   else if (GetLocalFd() >= 0) {
+      if (!ReadLocalBlock(block))
+         block->SetFailed();
+      inCache = kFALSE;
+   }
    else{
-      fFile->ReadBuffers(block->GetBuffer(), block->GetPos(), block->GetLen(), block->GetNoElem());
+      if (fFile->ReadBuffers(block->GetBuffer(), block->GetPos(), block->GetLen(), block->GetNoElem()))
+         block->SetFailed();
       if (fFile->GetArchive()) {
          for (Int_t i = 0; i < block->GetNoElem(); i++)
             block->SetPos(i, block->GetPos(i) - fFile->GetArchiveOffset());
@@ -126,7 +140,7 @@ void TFilePrefetch::ReadListOfBlocks()
    while((block = GetPendingBlock())){
       ReadAsync(block, inCache);
       AddReadBlock(block);
-      if (!inCache)
+      if (!inCache && !block->IsFailed())
          SaveBlockInCache(block);
    }
 }
@@ -168,7 +182,8 @@ Long64_t TFilePrefetch::GetWaitTime()
 //____________________________________________________________________________________________
 Bool_t TFilePrefetch::ReadBuffer(char* buf, Long64_t offset, Int_t len)
 {
-   // Return a prefetched element.
+   // Return a prefetched element. Returns false if the block holding the
+   // element could not be read.
 
    Bool_t found = false;
    TFPBlock* blockObj = 0;
@@ -196,7 +211,9 @@ Bool_t TFilePrefetch::ReadBuffer(char* buf, Long64_t offset, Int_t len)
       }
    }
 
-   if (found){
+   if (found && blockObj->IsFailed())
+      found = false;
+   else if (found){
       char *pBuff = blockObj->GetPtrToPiece(index);
       pBuff += (offset - blockObj->GetPos(index));
       memcpy(buf, pBuff, len);
@@ -211,9 +228,114 @@ void TFilePrefetch::ReadBlock(Long64_t* offset, Int_t* len, Int_t nblock)
    // Create a TFPBlock object or recycle one and add it to the prefetchBlocks list.
 
    TFPBlock* block = CreateBlockObj(offset, len, nblock);
+   AdviseBlock(block);
    AddPendingBlock(block);
 }
 
+//____________________________________________________________________________________________
+Int_t TFilePrefetch::GetLocalFd() const
+{
+   // Return the file descriptor of the file if it is a plain local TFile
+   // that can be read with positional reads by the worker thread, -1
+   // otherwise (remote files and TFile specializations go through
+   // TFile::ReadBuffers).
+
+#ifndef WIN32
+   if (fFile && fFile->IsA() == TFile::Class())
+      return fFile->GetFd();
+#endif
+   return -1;
+}
+
+//____________________________________________________________________________________________
+void TFilePrefetch::AdviseBlock(TFPBlock* block)
+{
+   // Tell the kernel that the pieces of a local block will be read soon,
+   // so that it starts fetching them while the worker thread is still
+   // busy with the previous block. Adjacent pieces are advised together.
+
+#if defined(R__LINUX) && defined(POSIX_FADV_WILLNEED)
+   Int_t fd = GetLocalFd();
+   if (fd < 0) return;
+
+   Long64_t archiveOffset = fFile->GetArchiveOffset();
+   Int_t i = 0;
+   while (i < block->GetNoElem()) {
+      Long64_t pos = block->GetPos(i);
+      Long64_t len = block->GetLen(i);
+      while (++i < block->GetNoElem() && block->GetPos(i) == pos + len)
+         len += block->GetLen(i);
+      posix_fadvise(fd, pos + archiveOffset, len, POSIX_FADV_WILLNEED);
+   }
+#else
+   (void) block;
+#endif
+}
+
+//____________________________________________________________________________________________
+Bool_t TFilePrefetch::ReadLocalBlock(TFPBlock* block)
+{
+   // Read all the pieces of a block of a local file with positional reads.
+   // Contrary to TFile::ReadBuffers this neither moves the file offset nor
+   // touches the read cache of the file, so that it can run in the worker
+   // thread concurrently with reads done by the main thread. The pieces are
+   // sorted by position and stored contiguously in the block buffer, runs
+   // of adjacent pieces are therefore read with a single call.
+
+#ifndef WIN32
+   Int_t fd = GetLocalFd();
+   if (fd < 0) return kFALSE;
+
+   Double_t start = 0;
+   if (gPerfStats != 0) start = TTimeStamp();
+
+   Long64_t archiveOffset = fFile->GetArchiveOffset();
+   Long64_t total = 0;
+   Int_t i = 0;
+   while (i < block->GetNoElem()) {
+      char *buf = block->GetPtrToPiece(i);
+      Long64_t pos = block->GetPos(i);
+      Long64_t len = block->GetLen(i);
+      while (++i < block->GetNoElem() && block->GetPos(i) == pos + len)
+         len += block->GetLen(i);
+
+      Long64_t done = 0;
+      while (done < len) {
+         Int_t n = fFile->SysReadAt(fd, buf + done, (Int_t)(len - done), pos + archiveOffset + done);
+         if (n < 0 && errno == EINTR)
+            continue;
+         if (n <= 0) {
+            if (n < 0)
+               SysError("ReadLocalBlock", "error reading %lld bytes at position %lld of file %s",
+                        len - done, pos + done, fFile->GetName());
+            else
+               Error("ReadLocalBlock", "end of file reached reading %lld bytes at position %lld of file %s",
+                     len - done, pos + done, fFile->GetName());
+            return kFALSE;
+         }
+         done += n;
+      }
+      total += len;
+   }
+
+   R__LOCKGUARD(fFile->fReadMutex);
+   fFile->fBytesRead  += total;
+   fFile->fgBytesRead += total;
+   fFile->SetReadCalls(fFile->GetReadCalls() + 1);
+   fFile->fgReadCalls++;
+
+   if (gMonitoringWriter)
+      gMonitoringWriter->SendFileReadProgress(fFile);
+   if (gPerfStats != 0) {
+      gPerfStats->FileReadEvent(fFile, total, start);
+   }
+   return kTRUE;
+#else
+   (void) block;
+   return kFALSE;
+#endif
+}
+
 //____________________________________________________________________________________________
 void TFilePrefetch::AddPendingBlock(TFPBlock* block)
 {
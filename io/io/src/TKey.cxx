@@ -60,6 +60,7 @@
 #include "TError.h"
 #include "TVirtualStreamerInfo.h"
 #include "TSchemaRuleSet.h"
+#include "TVirtualMutex.h"
 
 extern "C" void R__zipMultipleAlgorithm(int cxlevel, int *srcsize, char *src, int *tgtsize, char *tgt, int *irep, int compressionAlgorithm);
 extern "C" void R__unzip(Int_t *nin, UChar_t *bufin, Int_t *lout, char *bufout, Int_t *nout);
@@ -151,8 +152,7 @@ TKey::TKey(TDirectory* motherDir, const TKey &orig, UShort_t pidOffset) : TNamed
    TFile* f = orig.GetFile();
    if (f) {
       Int_t nsize = orig.fNbytes;
-      f->Seek(orig.fSeekKey);
-      if( f->ReadBuffer(fBuffer+bufferIncOffset,nsize) )
+      if( f->ReadBuffer(fBuffer+bufferIncOffset,orig.fSeekKey,nsize) )
       {
          Error("ReadFile", "Failed to read data.");
          return;
@@ -817,6 +817,7 @@ TObject *TKey::ReadObj()
       dir->SetName(GetName());
       dir->SetTitle(GetTitle());
       dir->SetMother(fMotherDir);
+      R__LOCKGUARD2(gROOTMutex);
       fMotherDir->Append(dir);
    }
 
@@ -824,6 +825,7 @@ TObject *TKey::ReadObj()
    { 
       ROOT::DirAutoAdd_t addfunc = cl->GetDirectoryAutoAdd();
       if (addfunc) {
+         R__LOCKGUARD2(gROOTMutex);
          addfunc(pobj, fMotherDir);
       }
    }
@@ -942,6 +944,7 @@ TObject *TKey::ReadObjWithBuffer(char *bufferRead)
       dir->SetName(GetName());
       dir->SetTitle(GetTitle());
       dir->SetMother(fMotherDir);
+      R__LOCKGUARD2(gROOTMutex);
       fMotherDir->Append(dir);
    }
 
@@ -949,6 +952,7 @@ TObject *TKey::ReadObjWithBuffer(char *bufferRead)
    { 
       ROOT::DirAutoAdd_t addfunc = cl->GetDirectoryAutoAdd();
       if (addfunc) {
+         R__LOCKGUARD2(gROOTMutex);
          addfunc(pobj, fMotherDir);
       }
    }
@@ -1097,6 +1101,7 @@ void *TKey::ReadObjectAny(const TClass* expectedClass)
          dir->SetName(GetName());
          dir->SetTitle(GetTitle());
          dir->SetMother(fMotherDir);
+         R__LOCKGUARD2(gROOTMutex);
          fMotherDir->Append(dir);
       }
    }
@@ -1105,6 +1110,7 @@ void *TKey::ReadObjectAny(const TClass* expectedClass)
       // Append the object to the directory if requested:
       ROOT::DirAutoAdd_t addfunc = cl->GetDirectoryAutoAdd();
       if (addfunc) {
+         R__LOCKGUARD2(gROOTMutex);
          addfunc(pobj, fMotherDir);
       }
    }
@@ -1168,6 +1174,7 @@ Int_t TKey::Read(TObject *obj)
    { 
       ROOT::DirAutoAdd_t addfunc = obj->IsA()->GetDirectoryAutoAdd();
       if (addfunc) {
+         R__LOCKGUARD2(gROOTMutex);
          addfunc(obj, fMotherDir);
       }
    }
@@ -1243,15 +1250,17 @@ Bool_t TKey::ReadFile()
    if (f==0) return kFALSE;
 
    Int_t nsize = fNbytes;
-   f->Seek(fSeekKey);
+   // Read at the position of the key rather than at the file offset, so
+   // that keys can be read concurrently (see TFile::SetConcurrentRead).
 #if 0
+   f->Seek(fSeekKey);
    for (Int_t i = 0; i < nsize; i += kMAXFILEBUFFER) {
       int nb = kMAXFILEBUFFER;
       if (i+nb > nsize) nb = nsize - i;
       f->ReadBuffer(fBuffer+i,nb);
    }
 #else
-   if( f->ReadBuffer(fBuffer,nsize) )
+   if( f->ReadBuffer(fBuffer,fSeekKey,nsize) )
    {
       Error("ReadFile", "Failed to read data.");
       return kFALSE;
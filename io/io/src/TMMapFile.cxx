@@ -0,0 +1,260 @@
+// @(#)root/io:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TMMapFile                                                            //
+//                                                                      //
+// A TMMapFile is a local ROOT file opened read-only and mapped in      //
+// memory with mmap. The reads are served by copying from the mapping   //
+// instead of going through read system calls, and the baskets of       //
+// uncompressed branches (compression level 0) point directly into the  //
+// mapping (see TFile::GetMappedBuffer): reading them is zero-copy.     //
+//                                                                      //
+// It is typically used for files that are opened many times per job,  //
+// e.g. calibration trees, and is created with                          //
+//                                                                      //
+//    TFile *f = TFile::Open("calib.root", "MMAP");                     //
+//                                                                      //
+// or directly with new TMMapFile("calib.root").                        //
+//                                                                      //
+// Since the baskets may reference the mapping, trees read from a       //
+// TMMapFile must not outlive the file (do not detach them with         //
+// TTree::SetDirectory(0)). Memory mapping is not available on Windows. //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#include "TMMapFile.h"
+#include "TError.h"
+#include "TSystem.h"
+#include "TROOT.h"
+#include "TTimeStamp.h"
+#include "TVirtualPerfStats.h"
+#include "TVirtualMonitoring.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
+
+ClassImp(TMMapFile)
+
+//______________________________________________________________________________
+TMMapFile::TMMapFile(const char *path, Option_t *option,
+                     const char *ftitle, Int_t compress) :
+   TFile(path, "WEB", ftitle, compress),
+   fMapAddr(0), fMapSize(0), fSysOffset(0)
+{
+   // Open the existing local file 'path' for reading and map it in memory.
+   // The only accepted options are "READ" (the default) and "MMAP".
+   // See the TFile constructor for the other arguments.
+
+   TString opt = option;
+   opt.ToUpper();
+   const char *fname = 0;
+   Long64_t size = 0;
+   Long_t id, flags, modtime;
+
+   if (!opt.IsNull() && opt != "READ" && opt != "MMAP") {
+      Error("TMMapFile", "a memory mapped file can only be opened for reading (option %s)", option);
+      goto zombie;
+   }
+
+#ifdef WIN32
+   Error("TMMapFile", "memory mapped files are not supported on this platform");
+   goto zombie;
+#else
+   if ((fname = gSystem->ExpandPathName(fUrl.GetFile()))) {
+      SetName(fname);
+      delete [] fname;
+      fRealName = GetName();
+      fname = fRealName.Data();
+   } else {
+      Error("TMMapFile", "error expanding path %s", fUrl.GetFile());
+      goto zombie;
+   }
+
+   fD = SysOpen(fname, O_RDONLY, 0644);
+   if (fD == -1) {
+      SysError("TMMapFile", "file %s can not be opened for reading", fname);
+      goto zombie;
+   }
+   fWritable = kFALSE;
+
+   if (TFile::SysStat(fD, &id, &size, &flags, &modtime) || size <= 0) {
+      Error("TMMapFile", "cannot get the size of file %s", fname);
+      goto zombie;
+   }
+
+   fMapAddr = (char *) mmap(0, (size_t) size, PROT_READ, MAP_PRIVATE, fD, 0);
+   if (fMapAddr == (char *) MAP_FAILED) {
+      fMapAddr = 0;
+      SysError("TMMapFile", "file %s can not be mapped in memory", fname);
+      goto zombie;
+   }
+   fMapSize = size;
+
+   Init(kFALSE);
+   return;
+#endif
+
+zombie:
+   // Error in opening file; make this a zombie
+   if (fD >= 0) {
+      TFile::SysClose(fD);
+      fD = -1;
+   }
+   MakeZombie();
+   gDirectory = gROOT;
+}
+
+//______________________________________________________________________________
+TMMapFile::~TMMapFile()
+{
+   // Close and unmap the file.
+
+   // Need to call close now, as it needs our virtual table to unmap the file.
+   Close();
+}
+
+//______________________________________________________________________________
+char *TMMapFile::GetMappedBuffer(Long64_t pos, Int_t len) const
+{
+   // Return the address of the 'len' bytes at position 'pos' of the file
+   // in the mapping, or 0 if they are not all mapped. The memory is
+   // read-only and stays valid until the file is closed.
+
+   Long64_t off = pos + fArchiveOffset;
+   if (!fMapAddr || off < 0 || len < 0 || off + len > fMapSize)
+      return 0;
+   return fMapAddr + off;
+}
+
+//______________________________________________________________________________
+Bool_t TMMapFile::ReadBuffers(char *buf, Long64_t *pos, Int_t *len, Int_t nbuf)
+{
+   // Copy the nbuf blocks described in arrays pos and len from the mapping.
+   // Contrary to TFile::ReadBuffers this does not move the file offset and
+   // does not need a read-ahead buffer. Returns kTRUE in case of failure.
+
+   if (!buf)
+      return TFile::ReadBuffers(buf, pos, len, nbuf);
+
+   Double_t start = 0;
+   if (gPerfStats != 0) start = TTimeStamp();
+
+   Long64_t k = 0;
+   for (Int_t i = 0; i < nbuf; i++) {
+      const char *src = GetMappedBuffer(pos[i], len[i]);
+      if (!src) {
+         Error("ReadBuffers", "cannot read %d bytes at position %lld of file %s",
+               len[i], pos[i], GetName());
+         return kTRUE;
+      }
+      memcpy(&buf[k], src, len[i]);
+      k += len[i];
+   }
+
+   fBytesRead  += k;
+   fgBytesRead += k;
+   fReadCalls++;
+   fgReadCalls++;
+
+   if (gMonitoringWriter)
+      gMonitoringWriter->SendFileReadProgress(this);
+   if (gPerfStats != 0) {
+      gPerfStats->FileReadEvent(this, k, start);
+   }
+   return kFALSE;
+}
+
+//______________________________________________________________________________
+Int_t TMMapFile::SysClose(Int_t fd)
+{
+   // Unmap and close the file.
+
+#ifndef WIN32
+   if (fMapAddr) {
+      munmap(fMapAddr, (size_t) fMapSize);
+      fMapAddr = 0;
+      fMapSize = 0;
+   }
+#endif
+   return TFile::SysClose(fd);
+}
+
+//______________________________________________________________________________
+Int_t TMMapFile::SysRead(Int_t, void *buf, Int_t len)
+{
+   // Copy len bytes from the current offset in the mapping into buf.
+   // See documentation for TFile::SysRead().
+
+   if (!fMapAddr) {
+      errno = EBADF;
+      gSystem->SetErrorStr("The memory mapped file is not open.");
+      return -1;
+   }
+   if (fSysOffset >= fMapSize)
+      return 0;
+   if (fSysOffset + len > fMapSize)
+      len = (Int_t) (fMapSize - fSysOffset);
+   memcpy(buf, fMapAddr + fSysOffset, len);
+   fSysOffset += len;
+   return len;
+}
+
+//______________________________________________________________________________
+Int_t TMMapFile::SysReadAt(Int_t, void *buf, Int_t len, Long64_t offset)
+{
+   // Copy len bytes at 'offset' in the mapping into buf, without using the
+   // current offset. See documentation for TFile::SysReadAt().
+
+   if (!fMapAddr) {
+      errno = EBADF;
+      gSystem->SetErrorStr("The memory mapped file is not open.");
+      return -1;
+   }
+   if (offset < 0) {
+      errno = EINVAL;
+      return -1;
+   }
+   if (offset >= fMapSize)
+      return 0;
+   if (offset + len > fMapSize)
+      len = (Int_t) (fMapSize - offset);
+   memcpy(buf, fMapAddr + offset, len);
+   return len;
+}
+
+//______________________________________________________________________________
+Long64_t TMMapFile::SysSeek(Int_t, Long64_t offset, Int_t whence)
+{
+   // Seek to a specified position in the mapping. See TFile::SysSeek().
+
+   Long64_t newoffset;
+   if (whence == SEEK_SET)
+      newoffset = offset;
+   else if (whence == SEEK_CUR)
+      newoffset = fSysOffset + offset;
+   else if (whence == SEEK_END)
+      newoffset = fMapSize + offset;
+   else
+      newoffset = -1;
+
+   if (newoffset < 0) {
+      errno = EINVAL;
+      return -1;
+   }
+   fSysOffset = newoffset;
+   return fSysOffset;
+}
@@ -24,6 +24,8 @@
 #include "TVirtualCollectionIterators.h"
 #include "TProcessID.h"
 
+#include <string.h>
+
 static const Int_t kRegrouped = TStreamerInfo::kOffsetL;
 
 // More possible optimizations:
@@ -960,6 +962,71 @@ namespace TStreamerInfoActions
       return 0;
    }
 
+   // Bulk reading of one data member for all the elements of a collection.
+   // When streamed member-wise, the values of a member for all the elements
+   // are contiguous (and big endian) in a TBufferFile.  Instead of calling
+   // the virtual TBuffer::ReadXXX once per element, the loopers check once
+   // that the whole run is in the buffer, byte swap it with a loop on a
+   // compile time size (that the compiler unrolls and turns into bswap or
+   // shuffle instructions) directly into the elements and skip it.
+
+   template <typename T>
+   struct BulkReadable {
+      // Types whose in-memory size is the on-file size.
+      enum { kValue = 1 };
+   };
+   template <> struct BulkReadable<Long_t>  { enum { kValue = 0 }; };
+   template <> struct BulkReadable<ULong_t> { enum { kValue = 0 }; };
+
+   template <Int_t N>
+   inline void BulkSwapOne(char *dest, const char *src)
+   {
+#ifdef R__BYTESWAP
+      for (Int_t b = 0; b < N; ++b) {
+         dest[b] = src[N - 1 - b];
+      }
+#else
+      memcpy(dest, src, N);
+#endif
+   }
+
+   template <typename T>
+   inline Bool_t CanReadBulk(TBuffer &buf, Long64_t nvalues)
+   {
+      // Return true if the next nvalues values of type T can be read by
+      // BulkReadStrided or BulkReadIndirect.  This excludes the text based
+      // and the SQL buffers which override the TBuffer::ReadXXX functions.
+
+      if (!BulkReadable<T>::kValue || nvalues <= 0) return kFALSE;
+      if (buf.IsA() != TBufferFile::Class()) return kFALSE;
+      return buf.Length() + nvalues*(Long64_t)sizeof(T) <= buf.BufferSize();
+   }
+
+   template <typename T>
+   inline void BulkReadStrided(TBuffer &buf, char *dest, Int_t nvalues, Int_t stride)
+   {
+      // Read nvalues values of type T, storing them 'stride' bytes apart.
+
+      const char *src = buf.Buffer() + buf.Length();
+      for (Int_t i = 0; i < nvalues; ++i, dest += stride, src += sizeof(T)) {
+         BulkSwapOne<sizeof(T)>(dest, src);
+      }
+      buf.SetBufferOffset(buf.Length() + nvalues*sizeof(T));
+   }
+
+   template <typename T>
+   inline void BulkReadIndirect(TBuffer &buf, void **objs, Int_t nvalues, Int_t offset)
+   {
+      // Read nvalues values of type T, storing them at 'offset' bytes
+      // from each of the nvalues addresses in objs.
+
+      const char *src = buf.Buffer() + buf.Length();
+      for (Int_t i = 0; i < nvalues; ++i, src += sizeof(T)) {
+         BulkSwapOne<sizeof(T)>((char*)objs[i] + offset, src);
+      }
+      buf.SetBufferOffset(buf.Length() + nvalues*sizeof(T));
+   }
+
    enum ESelectLooper { kVectorLooper, kVectorPtrLooper, kAssociativeLooper, kGenericLooper };
 
    ESelectLooper SelectLooper(TVirtualCollectionProxy &proxy)
@@ -983,6 +1050,11 @@ namespace TStreamerInfoActions
          const Int_t incr = ((TVectorLoopConfig*)loopconfig)->fIncrement;
          iter = (char*)iter + config->fOffset;
          end = (char*)end + config->fOffset;
+         const Int_t n = (Int_t)(((char*)end - (char*)iter) / incr);
+         if (CanReadBulk<T>(buf, n)) {
+            BulkReadStrided<T>(buf, (char*)iter, n, incr);
+            return 0;
+         }
          for(; iter != end; iter = (char*)iter + incr ) {
             T *x = (T*) ((char*) iter);
             buf >> *x;
@@ -999,6 +1071,16 @@ namespace TStreamerInfoActions
             const Int_t incr = ((TVectorLoopConfig*)loopconfig)->fIncrement;
             iter = (char*)iter + config->fOffset;
             end = (char*)end + config->fOffset;
+            const Int_t n = (Int_t)(((char*)end - (char*)iter) / incr);
+            if (CanReadBulk<From>(buf, n)) {
+               const char *src = buf.Buffer() + buf.Length();
+               for(; iter != end; iter = (char*)iter + incr, src += sizeof(From) ) {
+                  BulkSwapOne<sizeof(From)>((char*)&temp, src);
+                  *(To*)( ((char*)iter) ) = (To)temp;
+               }
+               buf.SetBufferOffset(buf.Length() + n*sizeof(From));
+               return 0;
+            }
             for(; iter != end; iter = (char*)iter + incr ) {
                buf >> temp;
                *(To*)( ((char*)iter) ) = (To)temp;
@@ -1353,7 +1435,12 @@ namespace TStreamerInfoActions
       static INLINE_TEMPLATE_ARGS Int_t ReadBasicType(TBuffer &buf, void *iter, const void *end, const TConfiguration *config)
       {
          const Int_t offset = config->fOffset;
-         
+         const Int_t n = (Int_t)(((char*)end - (char*)iter) / sizeof(void*));
+         if (CanReadBulk<T>(buf, n)) {
+            BulkReadIndirect<T>(buf, (void**)iter, n, offset);
+            return 0;
+         }
+
          for(; iter != end; iter = (char*)iter + sizeof(void*) ) {
             T *x = (T*)( ((char*) (*(void**)iter) ) + offset );
             buf >> *x;
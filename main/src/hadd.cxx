@@ -32,6 +32,23 @@
   the Trees with
        hadd -T targetfile source1 source2 ...
 
+  With many input files, the merge can be done in parallel with
+       hadd -j 8 targetfile source1 source2 ...
+  the sources are split in 8 groups of consecutive files, merged
+  concurrently into temporary files which are then merged into the
+  target (see TFileMerger::SetNThreads). "-j 0" uses one thread per cpu.
+  The baskets of the Trees are then written twice, the temporary
+  directory needs room for about the size of the target.
+  Files without Trees are merged serially.
+
+  The histograms are added to the first one read as they are read from
+  the next files. With
+       hadd -m 500 targetfile source1 source2 ...
+  they are instead added several at a time, reading at most 500 MB of
+  them before adding them (see TFileMerger::SetMaxMemory).
+  The directories are merged and written one after the other, so that
+  only the keys of the directory being merged are kept in memory.
+
   Wildcarding and indirect files are also supported
     hadd result.root  myfil*.root
    will merge all files in myfil*.root
@@ -77,7 +94,7 @@ int main( int argc, char **argv )
 {
 
    if ( argc < 3 || "-h" == std::string(argv[1]) || "--help" == std::string(argv[1]) ) {
-      std::cout << "Usage: " << argv[0] << " [-f[0-9]] [-k] [-T] [-O] [-n maxopenedfiles] [-v verbosity] targetfile source1 [source2 source3 ...]" << std::endl;
+      std::cout << "Usage: " << argv[0] << " [-f[0-9]] [-k] [-T] [-O] [-n maxopenedfiles] [-j nthreads] [-m maxmemory] [-v verbosity] targetfile source1 [source2 source3 ...]" << std::endl;
       std::cout << "This program will add histograms from a list of root files and write them" << std::endl;
       std::cout << "to a target root file. The target file is newly created and must not " << std::endl;
       std::cout << "exist, or if -f (\"force\") is given, must not be one of the source files." << std::endl;
@@ -87,6 +104,8 @@ int main( int argc, char **argv )
       std::cout << "If the option -O is used, when merging TTree, the basket size is re-optimized" <<std::endl;
       std::cout << "If the option -v is used, explicitly set the verbosity level; 0 request no output, 99 is the default" <<std::endl;
       std::cout << "If the option -n is used, hadd will open at most 'maxopenedfiles' at once, use 0 to request to use the system maximum." << std::endl;
+      std::cout << "If the option -j is used, the source files are merged in parallel by 'nthreads' threads, use 0 to request one thread per cpu; the partial results are written in the temporary directory." << std::endl;
+      std::cout << "If the option -m is used, histograms are added several at a time, reading at most 'maxmemory' MB of them at once." << std::endl;
       std::cout << "When -the -f option is specified, one can also specify the compression" <<std::endl;
       std::cout << "level of the target file. By default the compression level is 1, but" <<std::endl;
       std::cout << "if \"-f0\" is specified, the target file will not be compressed." <<std::endl;
@@ -101,6 +120,8 @@ int main( int argc, char **argv )
    Bool_t reoptimize = kFALSE;
    Bool_t noTrees = kFALSE;
    Int_t maxopenedfiles = 0;
+   Int_t nthreads = 1;
+   Long64_t maxmemory = 0;
    Int_t verbosity = 99;
 
    int outputPlace = 0;
@@ -133,6 +154,34 @@ int main( int argc, char **argv )
             }
          }
          ++ffirst;
+      } else if ( strcmp(argv[a],"-j") == 0 ) {
+         if (a+1 >= argc) {
+            std::cerr << "Error: no number of threads was provided after -j.\n";
+         } else {
+            Long_t request = strtol(argv[a+1], 0, 10);
+            if (request < kMaxLong && request >= 0) {
+               nthreads = (Int_t)request;
+               ++a;
+               ++ffirst;
+            } else {
+               std::cerr << "Error: could not parse the number of threads passed after -j: " << argv[a+1] << ". We will merge serially.\n";
+            }
+         }
+         ++ffirst;
+      } else if ( strcmp(argv[a],"-m") == 0 ) {
+         if (a+1 >= argc) {
+            std::cerr << "Error: no maximum memory was provided after -m.\n";
+         } else {
+            Long_t request = strtol(argv[a+1], 0, 10);
+            if (request < kMaxLong && request >= 0) {
+               maxmemory = (Long64_t)request * 1024 * 1024;
+               ++a;
+               ++ffirst;
+            } else {
+               std::cerr << "Error: could not parse the maximum memory passed after -m: " << argv[a+1] << ". Histograms will be added one at a time.\n";
+            }
+         }
+         ++ffirst;
       } else if ( strcmp(argv[a],"-v") == 0 ) {
          if (a+1 >= argc) {
             std::cerr << "Error: no verbosity level was provided after -v.\n";
@@ -181,12 +230,16 @@ int main( int argc, char **argv )
       std::cout << "hadd Target file: " << targetname << std::endl;
    }
 
-   TFileMerger merger(kFALSE,kFALSE);
+   TFileMerger merger(kFALSE, maxmemory > 0);
    merger.SetMsgPrefix("hadd");
+   merger.SetMaxMemory(maxmemory);
    merger.SetPrintLevel(verbosity - 1);
    if (maxopenedfiles > 0) {
       merger.SetMaxOpenedFiles(maxopenedfiles);
    }
+   if (nthreads != 1) {
+      merger.SetNThreads(nthreads);
+   }
    if (!merger.OutputFile(targetname,force,newcomp) ) {
       std::cerr << "hadd error opening target file (does " << argv[ffirst-1] << " exist?)." << std::endl;
       std::cerr << "Pass \"-f\" argument to force re-creation of output file." << std::endl;
@@ -53,6 +53,8 @@ private:
    char    *fBufCompCur;  //Current position in compressed buffer
    char    *fCompPos;     //Position of fBufCur when message was compressed
    Bool_t   fEvolution;   //True if support for schema evolution required
+   Int_t    fBufAlloc;    //Allocated size of the buffer of a received message
+   Int_t    fBufCompAlloc;//Allocated size of the compressed buffer of a received message
 
    static Bool_t fgEvolution;  //True if global support for schema evolution required
 
@@ -62,6 +64,8 @@ private:
 
    // used by friend TSocket
    Bool_t TestBitNumber(UInt_t bitnumber) const { return fBitsPIDs.TestBitNumber(bitnumber); }
+   char  *GetRecvBuffer(Int_t bufsize);
+   void   InitRead(Int_t bufsize);
 
 protected:
    TMessage(void *buf, Int_t bufsize);   // only called by T(P)Socket::Recv()
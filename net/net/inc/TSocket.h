@@ -122,6 +122,8 @@ protected:
    Bool_t       RecvStreamerInfos(TMessage *mess);
    void         SendProcessIDs(const TMessage &mess);
    Bool_t       RecvProcessIDs(TMessage *mess);
+   Int_t        RecvAck(const char *where);
+   Int_t        SendAck();
 
 private:
    TSocket&      operator=(const TSocket &);  // not implemented
@@ -165,9 +167,12 @@ public:
    virtual Int_t         Recv(char *mess, Int_t max);
    virtual Int_t         Recv(char *mess, Int_t max, Int_t &kind);
    virtual Int_t         RecvRaw(void *buffer, Int_t length, ESendRecvOptions opt = kDefault);
+   Int_t                 RecvReuse(TMessage *&mess);
    virtual Int_t         Reconnect() { return -1; }
    virtual Int_t         Select(Int_t interest = kRead, Long_t timeout = -1);
    virtual Int_t         Send(const TMessage &mess);
+   Int_t                 SendBuffers(const TMessage &mess, Int_t nbuf, const char **buffers,
+                                     const Int_t *lengths);
    virtual Int_t         Send(Int_t kind);
    virtual Int_t         Send(Int_t status, Int_t kind);
    virtual Int_t         Send(const char *mess, Int_t kind = kMESS_STRING);
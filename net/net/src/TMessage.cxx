@@ -64,6 +64,8 @@ TMessage::TMessage(UInt_t what, Int_t bufsiz) :
    fCompPos    = 0;
    fInfos      = 0;
    fEvolution  = kFALSE;
+   fBufAlloc   = 0;
+   fBufCompAlloc = 0;
 
    SetBit(kCannotHandleMemberWiseStreaming);
 }
@@ -74,34 +76,16 @@ TMessage::TMessage(void *buf, Int_t bufsize) : TBufferFile(TBuffer::kRead, bufsi
    // Create a TMessage object for reading objects. The objects will be
    // read from buf. Use the What() method to get the message type.
 
-   // skip space at the beginning of the message reserved for the message length
-   fBufCur += sizeof(UInt_t);
-
-   *this >> fWhat;
-
    fCompress   = 0;
    fBufComp    = 0;
    fBufCompCur = 0;
    fCompPos    = 0;
    fInfos      = 0;
    fEvolution  = kFALSE;
+   fBufAlloc   = bufsize;
+   fBufCompAlloc = 0;
 
-   if (fWhat & kMESS_ZIP) {
-      // if buffer has kMESS_ZIP set, move it to fBufComp and uncompress
-      fBufComp    = fBuffer;
-      fBufCompCur = fBuffer + bufsize;
-      fBuffer     = 0;
-      Uncompress();
-   }
-
-   if (fWhat == kMESS_OBJECT) {
-      InitMap();
-      fClass = ReadClass();     // get first the class stored in message
-      SetBufferOffset(sizeof(UInt_t) + sizeof(fWhat));
-      ResetMap();
-   } else {
-      fClass = 0;
-   }
+   InitRead(bufsize);
 }
 
 //______________________________________________________________________________
@@ -169,6 +153,71 @@ void TMessage::TagStreamerInfo(TVirtualStreamerInfo *info)
    }
 }
 
+//______________________________________________________________________________
+char *TMessage::GetRecvBuffer(Int_t bufsize)
+{
+   // Return a buffer of at least bufsize bytes in which TSocket::RecvReuse()
+   // receives the next message, reusing the buffer of this message if it
+   // is large enough. The message must then be set with InitRead().
+
+   if (!IsReading() || !fBuffer || fBufAlloc < bufsize) {
+      if (!IsReading()) SetReadMode();
+      delete [] fBuffer;
+      fBuffer   = new char[bufsize];
+      fBufAlloc = bufsize;
+      SetBit(kIsOwner);
+   }
+   return fBuffer;
+}
+
+//______________________________________________________________________________
+void TMessage::InitRead(Int_t bufsize)
+{
+   // Prepare the message for reading the bufsize bytes received in its
+   // buffer: get the message type, uncompress the message and get the
+   // class of the object it contains. Called by the constructor and by
+   // TSocket::RecvReuse().
+
+   fBufSize = bufsize;
+   fBufMax  = fBuffer + fBufSize;
+   // skip space at the beginning of the message reserved for the message length
+   fBufCur  = fBuffer + sizeof(UInt_t);
+
+   *this >> fWhat;
+
+   fClass   = 0;
+   fCompPos = 0;
+   fBitsPIDs.ResetAllBits();
+
+   if (fWhat & kMESS_ZIP) {
+      // if buffer has kMESS_ZIP set, move it to fBufComp and uncompress,
+      // in the former compressed buffer if it is large enough.
+      char *comp    = fBuffer;
+      Int_t compsiz = fBufAlloc;
+      fBuffer       = fBufComp;
+      fBufAlloc     = fBufComp ? fBufCompAlloc : 0;
+      fBufComp      = comp;
+      fBufCompAlloc = compsiz;
+      fBufCompCur   = comp + bufsize;
+      Uncompress();
+   } else if (fBufComp) {
+      // A previous message received in this one was compressed.
+      delete [] fBufComp;
+      fBufComp      = 0;
+      fBufCompCur   = 0;
+      fBufCompAlloc = 0;
+   }
+
+   if (fWhat == kMESS_OBJECT) {
+      InitMap();
+      fClass = ReadClass();     // get first the class stored in message
+      SetBufferOffset(sizeof(UInt_t) + sizeof(fWhat));
+      ResetMap();
+   } else if (fMap) {
+      ResetMap();
+   }
+}
+
 //______________________________________________________________________________
 void TMessage::Reset()
 {
@@ -323,6 +372,7 @@ Int_t TMessage::Compress()
    Int_t chdrlen  = 3*sizeof(UInt_t);   // compressed buffer header length
    Int_t buflen   = TMath::Max(512, chdrlen + messlen + 9*nbuffers);
    fBufComp       = new char[buflen];
+   fBufCompAlloc  = buflen;
    char *messbuf  = Buffer() + hdrlen;
    char *bufcur   = fBufComp + chdrlen;
    Int_t noutot   = 0;
@@ -381,7 +431,11 @@ Int_t TMessage::Uncompress()
       return -1;
    }
 
-   fBuffer  = new char[buflen];
+   if (!fBuffer || fBufAlloc < buflen) {
+      delete [] fBuffer;
+      fBuffer   = new char[buflen];
+      fBufAlloc = buflen;
+   }
    fBufSize = buflen;
    fBufCur  = fBuffer + sizeof(UInt_t) + sizeof(fWhat);
    fBufMax  = fBuffer + fBufSize;
@@ -27,6 +27,8 @@
 #include "TSocket.h"
 #include "TArrayC.h"
 
+#include <vector>
+
 //______________________________________________________________________________
 TParallelMergingFile::TParallelMergingFile(const char *filename, Option_t *option /* = "" */,
                                            const char *ftitle /* = "" */, Int_t compress /* = 1 */) : 
@@ -117,9 +119,18 @@ Bool_t TParallelMergingFile::UploadAndReset()
    fMessage.WriteInt(fServerIdx);
    fMessage.WriteTString(GetName());
    fMessage.WriteLong64(GetEND());
-   CopyTo(fMessage);
+
+   // Send the blocks of the file directly from memory, rather than first
+   // copying them in the message (see TMemFile::CopyTo(TBuffer&)).
+   std::vector<const char*> blocks;
+   std::vector<Int_t> sizes;
+   for (const TMemBlock *current = &fBlockList; current; current = current->fNext) {
+      blocks.push_back((const char*)current->fBuffer);
+      sizes.push_back((Int_t)current->fSize);
+   }
    
-   if (int error = fSocket->Send(fMessage) <= 0) {
+   Int_t error = fSocket->SendBuffers(fMessage, (Int_t)blocks.size(), &blocks[0], &sizes[0]);
+   if (error <= 0) {
       Error("UploadAndReset","Upload to the merging server failed with %d\n",error);
       delete fSocket;
       fSocket = 0;
@@ -36,6 +36,8 @@
 #include "TStreamerInfo.h"
 #include "TProcessID.h"
 
+#include <vector>
+
 ULong64_t TSocket::fgBytesSent = 0;
 ULong64_t TSocket::fgBytesRecv = 0;
 
@@ -565,25 +567,88 @@ Int_t TSocket::Send(const TMessage &mess)
 
    // If acknowledgement is desired, wait for it
    if (mess.What() & kMESS_ACK) {
-      TSystem::ResetErrno();
-      ResetBit(TSocket::kBrokenConn);
-      char buf[2];
-      Int_t n = 0;
-      if ((n = gSystem->RecvRaw(fSocket, buf, sizeof(buf), 0)) < 0) {
-         if (n == -5) {
-            // Connection reset by peer or broken
-            SetBit(TSocket::kBrokenConn);
-            Close();
-         } else
-            n = -1;
-         return n;
-      }
-      if (strncmp(buf, "ok", 2)) {
-         Error("Send", "bad acknowledgement");
-         return -1;
+      Int_t n = RecvAck("Send");
+      if (n < 0) return n;
+   }
+
+   Touch();  // update usage timestamp
+
+   return nsent - sizeof(UInt_t);  //length - length header
+}
+
+//______________________________________________________________________________
+Int_t TSocket::SendBuffers(const TMessage &mess, Int_t nbuf, const char **buffers,
+                           const Int_t *lengths)
+{
+   // Send a TMessage object followed by nbuf buffers of the given lengths,
+   // as a single message: the receiver gets a TMessage whose content is
+   // the one of mess followed by the bytes of the buffers. The buffers are
+   // sent directly from where they are, without first being copied in the
+   // message (using scatter-gather I/O, see TSystem::SendRawBuffers).
+   // If the message is compressed or for sockets of derived classes the
+   // buffers are copied in a single message sent with Send().
+   // Returns the number of bytes sent and -1 in case of error, like Send().
+
+   TSystem::ResetErrno();
+
+   if (fSocket == -1) return -1;
+
+   if (mess.IsReading()) {
+      Error("SendBuffers", "cannot send a message used for reading");
+      return -1;
+   }
+
+   Int_t hdrlen = sizeof(UInt_t) + sizeof(UInt_t);   // length and what
+   if (IsA() != TSocket::Class() || GetCompressionLevel() > 0 ||
+       mess.GetCompressionLevel() > 0) {
+      TMessage all(mess.What(), mess.Length());
+      all.SetCompressionSettings(mess.GetCompressionSettings());
+      all.WriteFastArray(mess.Buffer() + hdrlen, mess.Length() - hdrlen);
+      for (Int_t i = 0; i < nbuf; i++)
+         all.WriteFastArray(buffers[i], lengths[i]);
+      // the streamer infos and the process ids used by the objects in mess
+      SendStreamerInfos(mess);
+      SendProcessIDs(mess);
+      return Send(all);
+   }
+
+   // send streamer infos in case schema evolution is enabled in the TMessage
+   SendStreamerInfos(mess);
+
+   // send the process id's so TRefs work
+   SendProcessIDs(mess);
+
+   std::vector<const char*> bufs(nbuf + 1);
+   std::vector<Int_t>       lens(nbuf + 1);
+   bufs[0] = mess.Buffer();
+   lens[0] = mess.Length();
+   UInt_t mlen = mess.Length();
+   for (Int_t i = 0; i < nbuf; i++) {
+      bufs[i+1] = buffers[i];
+      lens[i+1] = lengths[i];
+      mlen     += lengths[i];
+   }
+   char *mbuf = mess.Buffer();
+   tobuf(mbuf, (UInt_t)(mlen - sizeof(UInt_t)));   //length in first word of buffer
+
+   ResetBit(TSocket::kBrokenConn);
+   Int_t nsent;
+   if ((nsent = gSystem->SendRawBuffers(fSocket, nbuf + 1, &bufs[0], &lens[0])) <= 0) {
+      if (nsent == -5) {
+         // Connection reset by peer or broken
+         SetBit(TSocket::kBrokenConn);
+         Close();
       }
-      fBytesRecv  += 2;
-      fgBytesRecv += 2;
+      return nsent;
+   }
+
+   fBytesSent  += nsent;
+   fgBytesSent += nsent;
+
+   // If acknowledgement is desired, wait for it
+   if (mess.What() & kMESS_ACK) {
+      Int_t n = RecvAck("SendBuffers");
+      if (n < 0) return n;
    }
 
    Touch();  // update usage timestamp
@@ -866,23 +931,116 @@ oncemore:
       goto oncemore;
 
    if (mess->What() & kMESS_ACK) {
-      ResetBit(TSocket::kBrokenConn);
-      char ok[2] = { 'o', 'k' };
-      Int_t n2 = 0;
-      if ((n2 = gSystem->SendRaw(fSocket, ok, sizeof(ok), 0)) < 0) {
-         if (n2 == -5) {
-            // Connection reset or broken
-            SetBit(TSocket::kBrokenConn);
-            Close();
-         }
+      Int_t n2 = SendAck();
+      if (n2 < 0) {
          delete mess;
          mess = 0;
          return n2;
       }
       mess->SetWhat(mess->What() & ~kMESS_ACK);
+   }
+
+   Touch();  // update usage timestamp
+
+   return n;
+}
+
+//______________________________________________________________________________
+Int_t TSocket::RecvReuse(TMessage *&mess)
+{
+   // Receive a TMessage object like Recv(), but reusing the buffers of mess,
+   // if not 0, instead of allocating new ones for each message. This avoids
+   // an allocation and a copy per message when receiving many messages:
+   //
+   //    TMessage *mess = 0;
+   //    while (sock->RecvReuse(mess) > 0) {
+   //       ... use mess ...
+   //    }
+   //    delete mess;
+   //
+   // The objects read from the previous message must not refer to its
+   // buffer anymore. mess is set to 0 (and the TMessage deleted) in case
+   // of error. The return values are those of Recv(). For sockets of
+   // derived classes this calls Recv().
 
-      fBytesSent  += 2;
-      fgBytesSent += 2;
+   if (IsA() != TSocket::Class()) {
+      delete mess;
+      return Recv(mess);
+   }
+
+   TSystem::ResetErrno();
+
+   if (fSocket == -1) {
+      delete mess;
+      mess = 0;
+      return -1;
+   }
+
+oncemore:
+   ResetBit(TSocket::kBrokenConn);
+   Int_t  n;
+   UInt_t len;
+   if ((n = gSystem->RecvRaw(fSocket, &len, sizeof(UInt_t), 0)) <= 0) {
+      if (n == 0 || n == -5) {
+         // Connection closed, reset or broken
+         SetBit(TSocket::kBrokenConn);
+         Close();
+      }
+      delete mess;
+      mess = 0;
+      return n;
+   }
+   len = net2host(len);  //from network to host byte order
+
+   Int_t bufsize = len + sizeof(UInt_t);
+   char *buf;
+   if (mess) {
+      buf = mess->GetRecvBuffer(bufsize);
+   } else {
+      buf = new char[bufsize];
+   }
+   ResetBit(TSocket::kBrokenConn);
+   if ((n = gSystem->RecvRaw(fSocket, buf+sizeof(UInt_t), len, 0)) <= 0) {
+      if (n == 0 || n == -5) {
+         // Connection closed, reset or broken
+         SetBit(TSocket::kBrokenConn);
+         Close();
+      }
+      if (mess) delete mess;
+      else      delete [] buf;
+      mess = 0;
+      return n;
+   }
+
+   fBytesRecv  += n + sizeof(UInt_t);
+   fgBytesRecv += n + sizeof(UInt_t);
+
+   if (mess) {
+      mess->InitRead(bufsize);
+   } else {
+      mess = new TMessage(buf, bufsize);
+   }
+
+   // receive any streamer infos (the message is then deleted)
+   if (RecvStreamerInfos(mess)) {
+      mess = 0;
+      goto oncemore;
+   }
+
+   // receive any process ids (the message is then deleted)
+   if (RecvProcessIDs(mess)) {
+      mess = 0;
+      goto oncemore;
+   }
+
+   if (mess->What() & kMESS_ACK) {
+      Int_t n2 = SendAck();
+      if (n2 < 0) {
+         delete mess;
+         mess = 0;
+         return n2;
+      }
+      mess->SetWhat(mess->What() & ~kMESS_ACK);
    }
 
    Touch();  // update usage timestamp
@@ -890,6 +1048,60 @@ oncemore:
    return n;
 }
 
+//______________________________________________________________________________
+Int_t TSocket::RecvAck(const char *where)
+{
+   // Wait for the acknowledgement of a message sent with kMESS_ACK.
+   // Returns 2 or -1 in case of error or -5 if pipe broken or reset by peer.
+
+   TSystem::ResetErrno();
+   ResetBit(TSocket::kBrokenConn);
+   char buf[2];
+   Int_t n = 0;
+   if ((n = gSystem->RecvRaw(fSocket, buf, sizeof(buf), 0)) < 0) {
+      if (n == -5) {
+         // Connection reset by peer or broken
+         SetBit(TSocket::kBrokenConn);
+         Close();
+      } else
+         n = -1;
+      return n;
+   }
+   if (strncmp(buf, "ok", 2)) {
+      Error(where, "bad acknowledgement");
+      return -1;
+   }
+   fBytesRecv  += 2;
+   fgBytesRecv += 2;
+
+   return n;
+}
+
+//______________________________________________________________________________
+Int_t TSocket::SendAck()
+{
+   // Acknowledge a message received with kMESS_ACK.
+   // Returns 2 or a negative value in case of error (-5 if pipe broken or
+   // reset by peer).
+
+   ResetBit(TSocket::kBrokenConn);
+   char ok[2] = { 'o', 'k' };
+   Int_t n = 0;
+   if ((n = gSystem->SendRaw(fSocket, ok, sizeof(ok), 0)) < 0) {
+      if (n == -5) {
+         // Connection reset or broken
+         SetBit(TSocket::kBrokenConn);
+         Close();
+      }
+      return n;
+   }
+
+   fBytesSent  += 2;
+   fgBytesSent += 2;
+
+   return n;
+}
+
 //______________________________________________________________________________
 Int_t TSocket::RecvRaw(void *buffer, Int_t length, ESendRecvOptions opt)
 {
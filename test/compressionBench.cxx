@@ -0,0 +1,182 @@
+// This program compares the I/O performance of the compression
+// algorithms supported by ROOT (see core/zip/inc/Compression.h).
+// For each algorithm a tree with a mix of smooth and noisy data is
+// written with the same compression level and read back entirely.
+// The test prints a summary table with the write and read throughput
+// (uncompressed MB per second of real time), the file size and the
+// compression factor.
+//
+//  run with
+//     compressionBench [nevents] [level]
+//  e.g.
+//     compressionBench 200000 5
+//
+// Algorithms that were not enabled when building ROOT (lz4, zstd) fall
+// back to ZLIB when writing, their lines are flagged in the table.
+
+#include "TROOT.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TRandom3.h"
+#include "TStopwatch.h"
+#include "TSystem.h"
+#include "RConfigure.h"
+#include "Compression.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+const Int_t kNhits = 50;
+
+struct TCompressionBenchData {
+   const char *fName;
+   Double_t    fWriteRT;
+   Double_t    fReadRT;
+   Long64_t    fTotBytes;
+   Long64_t    fZipBytes;
+   Bool_t      fFallback;
+};
+
+//______________________________________________________________________________
+static Long64_t WriteTree(const char *filename, Int_t algorithm, Int_t level, Int_t nevents)
+{
+   // Write nevents entries to filename and return the uncompressed size.
+
+   TFile f(filename, "RECREATE");
+   f.SetCompressionAlgorithm(algorithm);
+   f.SetCompressionLevel(level);
+
+   Int_t   run, nhits;
+   Float_t energy[kNhits];
+   Float_t x[kNhits];
+   Short_t adc[kNhits];
+   Double_t time;
+
+   TTree *tree = new TTree("T", "compression benchmark");
+   tree->Branch("run", &run, "run/I");
+   tree->Branch("time", &time, "time/D");
+   tree->Branch("nhits", &nhits, "nhits/I");
+   tree->Branch("energy", energy, "energy[nhits]/F");
+   tree->Branch("x", x, "x[nhits]/F");
+   tree->Branch("adc", adc, "adc[nhits]/S");
+
+   TRandom3 rng(4357);
+   for (Int_t ev = 0; ev < nevents; ++ev) {
+      run   = 1000 + ev / 10000;
+      time  = 1.e-3 * ev;
+      nhits = 1 + (Int_t)rng.Uniform(kNhits - 1);
+      for (Int_t i = 0; i < nhits; ++i) {
+         energy[i] = rng.Exp(10.);
+         x[i]      = 0.1f * i + (Float_t)rng.Gaus(0., 0.01);
+         adc[i]    = (Short_t)rng.Poisson(20.);
+      }
+      tree->Fill();
+   }
+   Long64_t totbytes = tree->GetTotBytes();
+   f.Write();
+   f.Close();
+   return totbytes;
+}
+
+//______________________________________________________________________________
+static Long64_t ReadTree(const char *filename)
+{
+   // Read all the entries and return the number of bytes unzipped.
+
+   TFile f(filename);
+   TTree *tree = (TTree*)f.Get("T");
+   if (!tree) return 0;
+   Long64_t nbytes = 0;
+   Long64_t nentries = tree->GetEntries();
+   for (Long64_t ev = 0; ev < nentries; ++ev) {
+      nbytes += tree->GetEntry(ev);
+   }
+   return nbytes;
+}
+
+//______________________________________________________________________________
+static TCompressionBenchData RunTest(const char *name, Int_t algorithm, Int_t level, Int_t nevents)
+{
+   TStopwatch timer;
+   TCompressionBenchData data;
+   data.fName = name;
+   data.fFallback = kFALSE;
+#ifndef R__HAS_LZ4
+   if (algorithm == ROOT::kLZ4) data.fFallback = kTRUE;
+#endif
+#ifndef R__HAS_ZSTD
+   if (algorithm == ROOT::kZSTD) data.fFallback = kTRUE;
+#endif
+
+   TString filename = TString::Format("compressionBench_%s.root", name);
+
+   timer.Start();
+   data.fTotBytes = WriteTree(filename, algorithm, level, nevents);
+   timer.Stop();
+   data.fWriteRT = timer.RealTime();
+
+   Long64_t filesize = 0;
+   Long_t id, flags, modtime;
+   gSystem->GetPathInfo(filename, &id, &filesize, &flags, &modtime);
+   data.fZipBytes = filesize;
+
+   // Read twice, the first pass only warms up the file system cache.
+   ReadTree(filename);
+   timer.Start(kTRUE);
+   ReadTree(filename);
+   timer.Stop();
+   data.fReadRT = timer.RealTime();
+
+   gSystem->Unlink(filename);
+   return data;
+}
+
+//______________________________________________________________________________
+int main(int argc, char **argv)
+{
+   Int_t nevents = 100000;
+   Int_t level   = 5;
+   if (argc > 1) nevents = atoi(argv[1]);
+   if (argc > 2) level   = atoi(argv[2]);
+
+   struct {
+      const char *fName;
+      Int_t       fAlgorithm;
+   } algos[] = {
+      { "zlib", ROOT::kZLIB },
+      { "lzma", ROOT::kLZMA },
+      { "lz4",  ROOT::kLZ4  },
+      { "zstd", ROOT::kZSTD }
+   };
+   const Int_t nalgos = sizeof(algos) / sizeof(algos[0]);
+
+   TCompressionBenchData results[nalgos];
+   for (Int_t i = 0; i < nalgos; ++i) {
+      results[i] = RunTest(algos[i].fName, algos[i].fAlgorithm, level, nevents);
+   }
+
+   printf("\n");
+   printf("*******************************************************************************\n");
+   printf("* compressionBench: %8d events, compression level %d                       *\n", nevents, level);
+   printf("*******************************************************************************\n");
+   printf("* algorithm *  write MB/s  *  read MB/s  *   file size (bytes) *  comp. factor  *\n");
+   printf("*******************************************************************************\n");
+   for (Int_t i = 0; i < nalgos; ++i) {
+      const TCompressionBenchData &d = results[i];
+      Double_t mb = d.fTotBytes / 1.e6;
+      printf("* %-5s%-4s * %11.2f  * %10.2f  * %19lld * %13.2f  *\n",
+             d.fName, d.fFallback ? "(*)" : "",
+             d.fWriteRT > 0 ? mb / d.fWriteRT : 0.,
+             d.fReadRT  > 0 ? mb / d.fReadRT  : 0.,
+             d.fZipBytes,
+             d.fZipBytes > 0 ? (Double_t)d.fTotBytes / d.fZipBytes : 0.);
+   }
+   printf("*******************************************************************************\n");
+   for (Int_t i = 0; i < nalgos; ++i) {
+      if (results[i].fFallback) {
+         printf("(*) ROOT built without %s support, ZLIB was used instead\n", results[i].fName);
+      }
+   }
+   return 0;
+}
@@ -12,6 +12,9 @@
 //               and using ">>+elist" in TTree::Draw
 //   - Test3() - transforming TEventList objects into TEntryList objects for a TChain
 //   - Test4() - same as Test3() but for a TTree 
+//   - Test5() - full and empty entry lists
+//   - Test6() - TEntryListBlock as bits, lists and runs: streaming and
+//               merging or subtracting blocks with different representations
 //
 //   To run in batch mode, do
 //     stressEntryList
@@ -31,13 +34,17 @@
 // Test2: Adding and subtracting entry lists-------------------------- OK
 // Test3: TEntryList and TEventList for TChain------------------------ OK
 // Test4: TEntryList and TEventList for TTree------------------------- OK
+// Test5: Full and Empty TEntryList----------------------------------- OK
+// Test6: TEntryListBlock representations and streaming--------------- OK
 // **********************************************************************
 // *******************Deleting the data files****************************
 // **********************************************************************
 
 #include <stdlib.h>
 #include "TApplication.h"
+#include "TBufferFile.h"
 #include "TEntryList.h"
+#include "TEntryListBlock.h"
 #include "TEventList.h"
 #include "TTree.h"
 #include "TChain.h"
@@ -47,6 +54,8 @@
 #include "TFile.h"
 #include "TSystem.h"
 
+#include <vector>
+
 Int_t stressEntryList(Int_t nentries = 10000, Int_t nfiles = 10);
 void MakeTrees(Int_t nentries, Int_t nfiles);
 
@@ -511,6 +520,155 @@ Bool_t Test5()
       return kTRUE;
 }
 
+//Number of entries in a TEntryListBlock
+const Int_t kBlockEntries = TEntryListBlock::kBlockSize*16;
+
+Bool_t SameBlock(TEntryListBlock *block, const std::vector<Bool_t> &ref)
+{
+//Compares the block with the reference through Contains(), GetNPassed(),
+//Next() and GetEntry()
+
+   Int_t i, n = 0;
+   for (i=0; i<kBlockEntries; i++){
+      if (ref[i]) n++;
+      if ((block->Contains(i)!=0) != ref[i]) return kFALSE;
+   }
+   if (block->GetNPassed() != n) return kFALSE;
+   block->ResetIndices();
+   for (i=0; i<kBlockEntries; i++){
+      if (ref[i] && block->Next() != i) return kFALSE;
+   }
+   //not in sequence, every 7th passing entry
+   block->ResetIndices();
+   n = 0;
+   for (i=0; i<kBlockEntries; i++){
+      if (!ref[i]) continue;
+      if (n%7==0 && block->GetEntry(n) != i) return kFALSE;
+      n++;
+   }
+   block->ResetIndices();
+   return kTRUE;
+}
+
+Bool_t Test6()
+{
+//Test the bits, list and runs representations of TEntryListBlock:
+//- OptimizeStorage() picks the expected one
+//- the blocks read back from a file have the same entries, and the
+//  runs are written as bits or lists, as older versions expect
+//- Merge() and Subtract() between blocks with different representations
+
+   const Int_t npatterns = 6;
+   //expected type after OptimizeStorage(): 0 - bits, 1 - list, 2 - runs
+   const Int_t types[npatterns] = {1, 0, 2, 2, 1, 2};
+   std::vector<Bool_t> ref[npatterns];
+   TEntryListBlock blocks[npatterns];
+   TRandom rand(4357);
+   Int_t i, j, k;
+   for (i=0; i<npatterns; i++)
+      ref[i].assign(kBlockEntries, kFALSE);
+   for (j=0; j<kBlockEntries; j++){
+      //a few scattered entries: list of passing entries
+      if (rand.Rndm() < 0.02) ref[0][j] = kTRUE;
+      //half of the entries: bits
+      if (rand.Rndm() < 0.5) ref[1][j] = kTRUE;
+      //long ranges: runs, written as bits
+      if ((j>=100 && j<=5000) || (j>=20000 && j<=20100) || j>=63000) ref[2][j] = kTRUE;
+      //short ranges: runs, written as a list
+      if ((j>=10 && j<=1000) || (j>=40000 && j<=40500)) ref[3][j] = kTRUE;
+      //almost all entries: list of the entries that don't pass
+      ref[4][j] = kTRUE;
+      //many ranges, overlapping the others: runs, written as bits
+      if (j>=3000 && j<=45000 && j%1000!=7) ref[5][j] = kTRUE;
+   }
+   for (j=0; j<100; j++)
+      ref[4][(Int_t)(rand.Rndm()*kBlockEntries)] = kFALSE;
+
+   Int_t wrongblocks = 0;
+   for (i=0; i<npatterns; i++){
+      for (j=0; j<kBlockEntries; j++)
+         if (ref[i][j]) blocks[i].Enter(j);
+      blocks[i].OptimizeStorage();
+      if (blocks[i].GetType() != types[i]){
+         printf("\npattern %d: type %d instead of %d\n", i, blocks[i].GetType(), types[i]);
+         wrongblocks++;
+      }
+      if (!SameBlock(&blocks[i], ref[i])){
+         printf("\npattern %d: wrong entries\n", i);
+         wrongblocks++;
+      }
+   }
+
+   //what an older version reads: the class buffer without the conversions
+   //of TEntryListBlock::Streamer()
+   Int_t wrongwritten = 0;
+   for (i=0; i<npatterns; i++){
+      TBufferFile wbuf(TBuffer::kWrite);
+      blocks[i].Streamer(wbuf);
+      TBufferFile rbuf(TBuffer::kRead, wbuf.Length(), wbuf.Buffer(), kFALSE);
+      TEntryListBlock raw;
+      TEntryListBlock::Class()->ReadBuffer(rbuf, &raw);
+      if (raw.GetType()!=0 && raw.GetType()!=1){
+         printf("\npattern %d: written with type %d\n", i, raw.GetType());
+         wrongwritten++;
+      }
+      if (!SameBlock(&raw, ref[i])) wrongwritten++;
+      if (blocks[i].GetType()==2 && !SameBlock(&blocks[i], ref[i])) wrongwritten++;
+   }
+
+   //round trip through a file
+   Int_t wrongread = 0;
+   TFile *f = new TFile("stressEntryListBlocks.root", "RECREATE");
+   char name[20];
+   for (i=0; i<npatterns; i++){
+      snprintf(name, 20, "block%d", i);
+      blocks[i].Write(name);
+   }
+   delete f;
+   f = new TFile("stressEntryListBlocks.root");
+   for (i=0; i<npatterns; i++){
+      snprintf(name, 20, "block%d", i);
+      TEntryListBlock *block = (TEntryListBlock*)f->Get(name);
+      if (!block || block->GetType() != types[i] || !SameBlock(block, ref[i])){
+         printf("\npattern %d: wrong block read back\n", i);
+         wrongread++;
+      }
+      delete block;
+   }
+   delete f;
+   gSystem->Unlink("stressEntryListBlocks.root");
+
+   //Merge() and Subtract() for all the pairs of representations
+   Int_t wrongmerge = 0;
+   Int_t wrongsubtract = 0;
+   std::vector<Bool_t> result(kBlockEntries);
+   for (i=0; i<npatterns; i++){
+      for (k=0; k<npatterns; k++){
+         TEntryListBlock merged(blocks[i]);
+         TEntryListBlock other(blocks[k]);
+         merged.Merge(&other);
+         for (j=0; j<kBlockEntries; j++)
+            result[j] = ref[i][j] || ref[k][j];
+         if (!SameBlock(&merged, result) || !SameBlock(&other, ref[k])){
+            printf("\nmerging pattern %d with %d: wrong entries\n", i, k);
+            wrongmerge++;
+         }
+         TEntryListBlock subtracted(blocks[i]);
+         subtracted.Subtract(&other);
+         for (j=0; j<kBlockEntries; j++)
+            result[j] = ref[i][j] && !ref[k][j];
+         if (!SameBlock(&subtracted, result)){
+            printf("\nsubtracting pattern %d from %d: wrong entries\n", k, i);
+            wrongsubtract++;
+         }
+      }
+   }
+
+   if (wrongblocks>0 || wrongwritten>0 || wrongread>0 || wrongmerge>0 || wrongsubtract>0)
+      return kFALSE;
+   else
+      return kTRUE;
+}
 
 void MakeTrees(Int_t nentries, Int_t nfiles)
 {
@@ -578,6 +736,7 @@ Int_t stressEntryList(Int_t nentries, Int_t nfiles)
    Bool_t ok3=kTRUE;
    Bool_t ok4=kTRUE;
    Bool_t ok5=kTRUE;
+   Bool_t ok6=kTRUE;
 
    ok1 = Test1();
    if (ok1)
@@ -613,6 +772,12 @@ Int_t stressEntryList(Int_t nentries, Int_t nfiles)
    else
       printf("Test5: Full and Empty TEntryList----------------------------------- FAILED\n");
 
+   ok6 = Test6();
+   if (ok6)
+      printf("Test6: TEntryListBlock representations and streaming--------------- OK\n");
+   else
+      printf("Test6: TEntryListBlock representations and streaming--------------- FAILED\n");
+
    printf("**********************************************************************\n");
    printf("*******************Deleting the data files****************************\n");
    printf("**********************************************************************\n");
@@ -47,7 +47,11 @@
 // Test 14: Integral tests for Histograms....................................OK  //
 // Test 15: TH1-THn[Sparse] Conversion tests.................................OK  //
 // Test 16: Filldata tests for Histograms and THn[Sparse]....................OK  //
-// Test 17: Reference File Read for Histograms and Profiles..................OK  //
+// Test 17: FillN tests for 1D, 2D and 3D Histograms.........................OK  //
+// Test 18: TThreadedHist tests for 1D, 2D and 3D Histograms.................OK  //
+// Test 19: THnSparse bin index tests........................................OK  //
+// Test 20: TFormula compilation tests.......................................OK  //
+// Test 21: Reference File Read for Histograms and Profiles..................OK  //
 // ****************************************************************************  //
 // stressHistogram: Real Time =  64.01 seconds Cpu Time =  63.89 seconds         //
 //  ROOTMARKS = 430.74 ROOT version: 5.25/01 branches/dev/mathDev@29787       //
@@ -68,10 +72,13 @@
 #include "TProfile.h"
 #include "TProfile2D.h"
 #include "TProfile3D.h"
+#include "TThreadedHist.h"
 
 #include "TF1.h"
 #include "TF2.h"
 #include "TF3.h"
+#include "TFormula.h"
+#include "TInterpreter.h"
 
 #include "Fit/SparseData.h"
 #include "HFitInterface.h"
@@ -85,9 +92,12 @@
 #include "TRandom2.h"
 #include "TFile.h"
 #include "TClass.h"
+#include "TSystem.h"
 
 #include "TROOT.h"
 #include <algorithm>
+#include <map>
+#include <vector>
 #include <cassert>
 
 using namespace std;
@@ -7126,6 +7136,492 @@ bool testBinDataData3DInt()
    return status;
 }
 
+int sameFill(const char* msg, TH1* h1, TH1* h2)
+{
+   // Compare exactly the contents, the errors, the number of entries and
+   // the statistics of two histograms: FillN gives the same result as
+   // calling Fill for each entry. The second histogram is deleted.
+
+   int differents = ( h1 == h2 ) || ( h1->GetNcells() != h2->GetNcells() );
+   for ( Int_t bin = 0; !differents && bin < h1->GetNcells(); ++bin ) {
+      if ( h1->GetBinContent(bin) != h2->GetBinContent(bin) ||
+           h1->GetBinError(bin)   != h2->GetBinError(bin) )
+         ++differents;
+   }
+   if ( h1->GetEntries() != h2->GetEntries() ) ++differents;
+   Double_t stats1[TH1::kNstat] = { 0 };
+   Double_t stats2[TH1::kNstat] = { 0 };
+   h1->GetStats(stats1);
+   h2->GetStats(stats2);
+   for ( Int_t i = 0; i < TH1::kNstat; ++i )
+      if ( stats1[i] != stats2[i] ) ++differents;
+
+   if ( defaultEqualOptions & cmpOptPrint ) std::cout << msg << ": \t" << (differents?"FAILED":"OK") << std::endl;
+
+   delete h2;
+
+   return differents;
+}
+
+void FillNData(Int_t n, Double_t* x, Double_t* w)
+{
+   // Values around [minRange, maxRange], with underflows, overflows, the
+   // limits of the axis and NaN, and weights around 1.
+
+   for ( Int_t i = 0; i < n; ++i ) {
+      x[i] = r.Uniform(minRange - 1, maxRange + 1);
+      w[i] = r.Uniform(0.5, 2);
+   }
+   x[0] = minRange;
+   x[n/3] = maxRange;
+   x[n/2] = TMath::QuietNaN();
+   x[n-1] = TMath::QuietNaN();
+}
+
+// Not a multiple of the 256 entries of a block of FillN
+const Int_t nFillN = 3 * 256 + 37;
+
+bool testFillN1D()
+{
+   // FillN with and without weights, with a stride, on fixed and variable
+   // bins, and on float bins.
+
+   Double_t x[2 * nFillN], w[2 * nFillN];
+   FillNData(2 * nFillN, x, w);
+   Double_t v[numberOfBins+1];
+   FillVariableRange(v);
+
+   int status = 0;
+   for ( int k = 0; k < 4; ++k ) {
+      bool var = k & 1;
+      Double_t* ww = (k & 2) ? w : 0;
+      TH1D* h1 = var ? new TH1D("fn1D-h1", "h1-Title", numberOfBins, v)
+                     : new TH1D("fn1D-h1", "h1-Title", numberOfBins, minRange, maxRange);
+      TH1D* h2 = var ? new TH1D("fn1D-h2", "h2-Title", numberOfBins, v)
+                     : new TH1D("fn1D-h2", "h2-Title", numberOfBins, minRange, maxRange);
+      h1->FillN(nFillN, x, ww, 2);
+      for ( Int_t i = 0; i < nFillN; ++i ) {
+         if ( ww ) h2->Fill(x[2*i], ww[2*i]);
+         else      h2->Fill(x[2*i]);
+      }
+      status += sameFill(TString::Format("FillN1D-%d", k), h1, h2);
+      delete h1;
+   }
+
+   TH1F* h1 = new TH1F("fn1DF-h1", "h1-Title", numberOfBins, minRange, maxRange);
+   TH1F* h2 = new TH1F("fn1DF-h2", "h2-Title", numberOfBins, minRange, maxRange);
+   h1->FillN(2 * nFillN, x, w);
+   for ( Int_t i = 0; i < 2 * nFillN; ++i )
+      h2->Fill(x[i], w[i]);
+   status += sameFill("FillN1DF", h1, h2);
+   delete h1;
+
+   if ( defaultEqualOptions & cmpOptPrint ) std::cout << "testFillN1D: \t" << (status?"FAILED":"OK") << std::endl;
+   return status;
+}
+
+bool testFillN2D()
+{
+   // FillN with and without weights, with a stride, on fixed and variable
+   // bins.
+
+   Double_t x[2 * nFillN], y[2 * nFillN], w[2 * nFillN];
+   FillNData(2 * nFillN, x, w);
+   FillNData(2 * nFillN, y, w);
+   Double_t v[numberOfBins+1];
+   FillVariableRange(v);
+
+   int status = 0;
+   for ( int k = 0; k < 4; ++k ) {
+      bool var = k & 1;
+      Double_t* ww = (k & 2) ? w : 0;
+      TH2D* h1 = var ? new TH2D("fn2D-h1", "h1-Title", numberOfBins, v, numberOfBins + 2, v[0], v[numberOfBins])
+                     : new TH2D("fn2D-h1", "h1-Title", numberOfBins, minRange, maxRange,
+                                numberOfBins + 2, minRange, maxRange);
+      TH2D* h2 = var ? new TH2D("fn2D-h2", "h2-Title", numberOfBins, v, numberOfBins + 2, v[0], v[numberOfBins])
+                     : new TH2D("fn2D-h2", "h2-Title", numberOfBins, minRange, maxRange,
+                                numberOfBins + 2, minRange, maxRange);
+      h1->FillN(nFillN, x, y, ww, 2);
+      for ( Int_t i = 0; i < nFillN; ++i ) {
+         if ( ww ) h2->Fill(x[2*i], y[2*i], ww[2*i]);
+         else      h2->Fill(x[2*i], y[2*i]);
+      }
+      status += sameFill(TString::Format("FillN2D-%d", k), h1, h2);
+      delete h1;
+   }
+
+   if ( defaultEqualOptions & cmpOptPrint ) std::cout << "testFillN2D: \t" << (status?"FAILED":"OK") << std::endl;
+   return status;
+}
+
+bool testFillN3D()
+{
+   // FillN with and without weights, with a stride, on fixed and variable
+   // bins.
+
+   Double_t x[2 * nFillN], y[2 * nFillN], z[2 * nFillN], w[2 * nFillN];
+   FillNData(2 * nFillN, x, w);
+   FillNData(2 * nFillN, y, w);
+   FillNData(2 * nFillN, z, w);
+   Double_t v[numberOfBins+1];
+   FillVariableRange(v);
+
+   int status = 0;
+   for ( int k = 0; k < 4; ++k ) {
+      bool var = k & 1;
+      Double_t* ww = (k & 2) ? w : 0;
+      TH3D* h1 = var ? new TH3D("fn3D-h1", "h1-Title", numberOfBins, v, numberOfBins, v, numberOfBins, v)
+                     : new TH3D("fn3D-h1", "h1-Title", numberOfBins, minRange, maxRange,
+                                numberOfBins + 1, minRange, maxRange, numberOfBins + 2, minRange, maxRange);
+      TH3D* h2 = var ? new TH3D("fn3D-h2", "h2-Title", numberOfBins, v, numberOfBins, v, numberOfBins, v)
+                     : new TH3D("fn3D-h2", "h2-Title", numberOfBins, minRange, maxRange,
+                                numberOfBins + 1, minRange, maxRange, numberOfBins + 2, minRange, maxRange);
+      h1->FillN(nFillN, x, y, z, ww, 2);
+      for ( Int_t i = 0; i < nFillN; ++i ) {
+         if ( ww ) h2->Fill(x[2*i], y[2*i], z[2*i], ww[2*i]);
+         else      h2->Fill(x[2*i], y[2*i], z[2*i]);
+      }
+      status += sameFill(TString::Format("FillN3D-%d", k), h1, h2);
+      delete h1;
+   }
+
+   if ( defaultEqualOptions & cmpOptPrint ) std::cout << "testFillN3D: \t" << (status?"FAILED":"OK") << std::endl;
+   return status;
+}
+
+// Values filled by the threads of the TThreadedHist tests
+const Int_t nFillThreads = 4;
+const Int_t nThreadedFills = 2000;
+Double_t thX[nFillThreads * nThreadedFills];
+Double_t thY[nFillThreads * nThreadedFills];
+Double_t thZ[nFillThreads * nThreadedFills];
+Double_t thW[nFillThreads * nThreadedFills];
+
+void FillValue(TH1D* h, Int_t i) { h->Fill(thX[i], thW[i]); }
+void FillValue(TH2D* h, Int_t i) { h->Fill(thX[i], thY[i], thW[i]); }
+void FillValue(TH3D* h, Int_t i) { h->Fill(thX[i], thY[i], thZ[i], thW[i]); }
+void FillValue(TThreadedHist<TH1D>* h, Int_t i) { h->Fill(thX[i], thW[i]); }
+void FillValue(TThreadedHist<TH2D>* h, Int_t i) { h->Fill(thX[i], thY[i], thW[i]); }
+void FillValue(TThreadedHist<TH3D>* h, Int_t i) { h->Fill(thX[i], thY[i], thZ[i], thW[i]); }
+
+template <class HIST>
+struct ThreadedFillJob {
+   // The fills of one thread.
+   TThreadedHist<HIST> *fHist;
+   Int_t                fFirst;
+
+   static void *Run(void *arg)
+   {
+      ThreadedFillJob *job = (ThreadedFillJob*) arg;
+      for ( Int_t i = job->fFirst; i < job->fFirst + nThreadedFills; ++i )
+         FillValue(job->fHist, i);
+      return 0;
+   }
+};
+
+template <class HIST>
+int testThreadedFill(const char* msg, HIST* h, HIST* href, typename TThreadedHist<HIST>::EMode mode)
+{
+   // Fill h from nFillThreads threads and href serially with the same
+   // values, merge twice (the second merge must not change h) and compare.
+   // The weights are multiples of 1/2: the contents do not depend on the
+   // order of the fills, the statistics only up to rounding.
+
+   int differents = 0;
+   {
+      TThreadedHist<HIST> th(h, mode);
+      ThreadedFillJob<HIST> jobs[nFillThreads];
+      TThread* threads[nFillThreads];
+      for ( Int_t t = 0; t < nFillThreads; ++t ) {
+         jobs[t].fHist = &th;
+         jobs[t].fFirst = t * nThreadedFills;
+         threads[t] = new TThread(&ThreadedFillJob<HIST>::Run, &jobs[t]);
+         threads[t]->Run();
+      }
+      for ( Int_t t = 0; t < nFillThreads; ++t ) {
+         threads[t]->Join();
+         delete threads[t];
+      }
+      th.Merge();
+      Double_t stats1[TH1::kNstat] = { 0 };
+      Double_t stats2[TH1::kNstat] = { 0 };
+      Double_t entries = h->GetEntries();
+      h->GetStats(stats1);
+      th.Merge();
+      h->GetStats(stats2);
+      if ( h->GetEntries() != entries ) ++differents;
+      for ( Int_t i = 0; i < TH1::kNstat; ++i )
+         if ( stats1[i] != stats2[i] ) ++differents;
+   }
+
+   for ( Int_t i = 0; i < nFillThreads * nThreadedFills; ++i )
+      FillValue(href, i);
+   if ( h->GetEntries() != href->GetEntries() ) ++differents;
+   for ( Int_t bin = 0; bin < h->GetNcells(); ++bin ) {
+      if ( h->GetBinContent(bin) != href->GetBinContent(bin) ||
+           h->GetBinError(bin)   != href->GetBinError(bin) )
+         ++differents;
+   }
+   differents += equals(msg, h, href, cmpOptStats, 1E-12);
+   return differents;
+}
+
+bool testThreadedHist()
+{
+   // TThreadedHist in the three modes for TH1D, TH2D and TH3D, compared
+   // with serial fills.
+
+   TThread::Initialize();
+   for ( Int_t i = 0; i < nFillThreads * nThreadedFills; ++i ) {
+      thX[i] = r.Uniform(minRange - 1, maxRange + 1);
+      thY[i] = r.Uniform(minRange - 1, maxRange + 1);
+      thZ[i] = r.Uniform(minRange - 1, maxRange + 1);
+      thW[i] = 0.5 * r.Integer(4) + 0.5;
+   }
+
+   const char* modes[3] = { "PerThread", "Buffered", "Atomic" };
+   int status = 0;
+   for ( int m = 0; m < 3; ++m ) {
+      TH1D* h1 = new TH1D("th1D-h", "h-Title", numberOfBins, minRange, maxRange);
+      TH1D* h1r = new TH1D("th1D-r", "r-Title", numberOfBins, minRange, maxRange);
+      status += testThreadedFill(TString::Format("Threaded1D-%s", modes[m]), h1, h1r,
+                                 (TThreadedHist<TH1D>::EMode) m);
+      delete h1;
+
+      TH2D* h2 = new TH2D("th2D-h", "h-Title", numberOfBins, minRange, maxRange,
+                          numberOfBins + 1, minRange, maxRange);
+      TH2D* h2r = new TH2D("th2D-r", "r-Title", numberOfBins, minRange, maxRange,
+                           numberOfBins + 1, minRange, maxRange);
+      status += testThreadedFill(TString::Format("Threaded2D-%s", modes[m]), h2, h2r,
+                                 (TThreadedHist<TH2D>::EMode) m);
+      delete h2;
+
+      TH3D* h3 = new TH3D("th3D-h", "h-Title", numberOfBins, minRange, maxRange,
+                          numberOfBins + 1, minRange, maxRange, numberOfBins + 2, minRange, maxRange);
+      TH3D* h3r = new TH3D("th3D-r", "r-Title", numberOfBins, minRange, maxRange,
+                           numberOfBins + 1, minRange, maxRange, numberOfBins + 2, minRange, maxRange);
+      status += testThreadedFill(TString::Format("Threaded3D-%s", modes[m]), h3, h3r,
+                                 (TThreadedHist<TH3D>::EMode) m);
+      delete h3;
+   }
+
+   if ( defaultEqualOptions & cmpOptPrint ) std::cout << "testThreadedHist: \t" << (status?"FAILED":"OK") << std::endl;
+   return status;
+}
+
+int checkSparseBins(THnSparse* s, const std::map<std::vector<Int_t>, Double_t>& ref)
+{
+   // Compare the filled bins of s with ref, both ways: each coordinate of
+   // ref is found with its content, and each bin of s is in ref.
+
+   int differents = ( s->GetNbins() != (Long64_t) ref.size() );
+   std::vector<Int_t> coord(s->GetNdimensions());
+   for ( std::map<std::vector<Int_t>, Double_t>::const_iterator it = ref.begin(); it != ref.end(); ++it ) {
+      Long64_t bin = s->GetBin(&it->first[0], kFALSE);
+      if ( bin < 0 || s->GetBinContent(bin) != it->second ) ++differents;
+   }
+   for ( Long64_t bin = 0; bin < s->GetNbins(); ++bin ) {
+      Double_t content = s->GetBinContent(bin, &coord[0]);
+      std::map<std::vector<Int_t>, Double_t>::const_iterator it = ref.find(coord);
+      if ( it == ref.end() || it->second != content ) ++differents;
+   }
+   return differents;
+}
+
+int testSparseIndexDim(const char* msg, Int_t ndim, Int_t nbins, Int_t nfills)
+{
+   // Fill a THnSparse with small chunks (so that the bin index is rehashed
+   // many times while growing) and compare its bins with a map of the
+   // coordinates filled. Look up coordinates not filled, and write and
+   // read back the histogram: the index is rebuilt from the chunks.
+
+   std::vector<Int_t> bins(ndim, nbins);
+   std::vector<Double_t> xmin(ndim, minRange);
+   std::vector<Double_t> xmax(ndim, maxRange);
+   THnSparseD* s = new THnSparseD(TString::Format("%s-s", msg), "s-Title", ndim, &bins[0], &xmin[0], &xmax[0], 64);
+   std::map<std::vector<Int_t>, Double_t> ref;
+   std::vector<Int_t> coord(ndim);
+   for ( Int_t e = 0; e < nfills; ++e ) {
+      // Revisit some bins: a few coordinates take only a few values.
+      for ( Int_t d = 0; d < ndim; ++d )
+         coord[d] = ( d % 2 ) ? r.Integer(3) + 1 : r.Integer(nbins + 2);
+      Double_t w = r.Integer(4) + 1;
+      s->AddBinContent(&coord[0], w);
+      ref[coord] += w;
+   }
+   int differents = checkSparseBins(s, ref);
+
+   // Misses do not allocate bins.
+   Long64_t nfilled = s->GetNbins();
+   for ( Int_t e = 0; e < nfills; ++e ) {
+      for ( Int_t d = 0; d < ndim; ++d )
+         coord[d] = r.Integer(nbins + 2);
+      Long64_t bin = ((const THnSparse*) s)->GetBin(&coord[0]);
+      if ( ( bin >= 0 ) != ( ref.find(coord) != ref.end() ) ) ++differents;
+   }
+   if ( s->GetNbins() != nfilled ) ++differents;
+
+   TFile* file = TFile::Open("stressHistogram_sparse.root", "RECREATE");
+   s->Write();
+   delete file;
+   file = TFile::Open("stressHistogram_sparse.root");
+   THnSparseD* sr = 0;
+   if ( file ) file->GetObject(TString::Format("%s-s", msg), sr);
+   if ( !sr ) ++differents;
+   else {
+      differents += checkSparseBins(sr, ref);
+      // Fill the bins read back and new ones.
+      for ( Int_t e = 0; e < nfills / 10; ++e ) {
+         for ( Int_t d = 0; d < ndim; ++d )
+            coord[d] = r.Integer(nbins + 2);
+         sr->AddBinContent(&coord[0], 1.);
+         ref[coord] += 1.;
+      }
+      differents += checkSparseBins(sr, ref);
+      delete sr;
+   }
+   delete file;
+   gSystem->Unlink("stressHistogram_sparse.root");
+
+   // Reset empties the index.
+   s->Reset();
+   if ( s->GetNbins() != 0 || ((const THnSparse*) s)->GetBin(&ref.begin()->first[0]) >= 0 ) ++differents;
+   delete s;
+
+   if ( defaultEqualOptions & cmpOptPrint ) std::cout << msg << ": \t" << (differents?"FAILED":"OK") << std::endl;
+   return differents;
+}
+
+bool testSparseIndex()
+{
+   // Compact coordinates of up to 8 bytes are their own hash; longer ones
+   // share hashes, told apart by their coordinates in the chunks.
+
+   int status = 0;
+   status += testSparseIndexDim("SparseIndexShort", 4, 100, 20000);
+   status += testSparseIndexDim("SparseIndexLong", 12, 1000, 20000);
+
+   if ( defaultEqualOptions & cmpOptPrint ) std::cout << "testSparseIndex: \t" << (status?"FAILED":"OK") << std::endl;
+   return status;
+}
+
+bool testSparseFillN()
+{
+   // THnSparse::FillN gives the same bins as Fill called for each entry.
+
+   const Int_t ndim = 3;
+   const Int_t n = 3 * 256 + 37;
+   Int_t bins[ndim] = { numberOfBins, numberOfBins + 1, numberOfBins + 2 };
+   Double_t xmin[ndim] = { minRange, minRange, minRange };
+   Double_t xmax[ndim] = { maxRange, maxRange, maxRange };
+   THnSparseD* s1 = new THnSparseD("fnS-s1", "s1-Title", ndim, bins, xmin, xmax);
+   THnSparseD* s2 = new THnSparseD("fnS-s2", "s2-Title", ndim, bins, xmin, xmax);
+   s1->Sumw2();
+   s2->Sumw2();
+   Double_t x[n * ndim], w[n];
+   for ( Int_t i = 0; i < n; ++i ) {
+      for ( Int_t d = 0; d < ndim; ++d )
+         x[i * ndim + d] = r.Uniform(minRange - 1, maxRange + 1);
+      w[i] = r.Uniform(0.5, 2);
+   }
+   s1->FillN(n, x, w);
+   for ( Int_t i = 0; i < n; ++i )
+      s2->Fill(x + i * ndim, w[i]);
+
+   int status = equals("SparseFillN", s1, s2, cmpOptNone, 0);
+   if ( s1->GetEntries() != n ) ++status;
+   delete s1;
+
+   if ( defaultEqualOptions & cmpOptPrint ) std::cout << "testSparseFillN: \t" << (status?"FAILED":"OK") << std::endl;
+   return status;
+}
+
+bool testRefReadSparseIndex()
+{
+   // The bins of a THnSparse read from the reference file, written by an
+   // old version of ROOT, are found by their coordinates and can be
+   // filled again.
+
+   if ( refFileOption == refFileWrite ) return 0;
+   THnSparseD* s = static_cast<THnSparseD*> ( refFile->Get("rr-s1") );
+   if ( !s ) return 1;
+   int differents = 0;
+   Long64_t nbins = s->GetNbins();
+   std::vector<Int_t> coord(s->GetNdimensions());
+   for ( Long64_t bin = 0; bin < nbins; ++bin ) {
+      Double_t content = s->GetBinContent(bin, &coord[0]);
+      if ( s->GetBin(&coord[0], kFALSE) != bin ) ++differents;
+      s->AddBinContent(&coord[0], 1.);
+      if ( s->GetBinContent(bin) != content + 1. ) ++differents;
+   }
+   if ( s->GetNbins() != nbins ) ++differents;
+   delete s;
+
+   if ( defaultEqualOptions & cmpOptPrint ) std::cout << "Ref Read Sparse Index: \t" << (differents?"FAILED":"OK") << std::endl;
+   return differents;
+}
+
+bool testFormulaJit()
+{
+   // A formula compiled by TFormula::Jit evaluates (through EvalPar) as
+   // the interpreter of operators EvalParOld, for formulas with
+   // parameters, predefined functions, ternaries and logical operators.
+
+   if ( !gInterpreter ) return 0;
+   const char* expressions[] = {
+      "x*x+2*x-1",
+      "[0]*exp(-0.5*((x-[1])/[2])**2)",
+      "gaus(0)+[3]",
+      "pol3(0)",
+      "expo(0)*landau(2)",
+      "sin(x)*cos(y)+tan(z/10)",
+      "sqrt(x*x+y*y+z*z)/(1+abs(x))",
+      "x>0?log(1+x):-x",
+      "x>0&&y<1||z==0",
+      "!(x>y)+(x!=z)*2",
+      "min(x,y)+max(y,z)",
+      "atan2(y,x)+fmod(z,3)+int(x)",
+      "pow(x,2)-[0]*x**3+[1]",
+      "pi*x+exp([0])"
+   };
+   const Int_t nexpr = sizeof(expressions) / sizeof(expressions[0]);
+   const Double_t params[5] = { 1.5, -0.5, 2., 0.25, 0.75 };
+
+   Bool_t jit = TFormula::GetDefaultJit();
+   TFormula::SetDefaultJit(kFALSE);
+   int status = 0;
+   for ( Int_t i = 0; i < nexpr; ++i ) {
+      TFormula f(TString::Format("fjit%d", i), expressions[i]);
+      Double_t x[3];
+      std::vector<Double_t> ref;
+      for ( Int_t e = 0; e < 100; ++e ) {
+         x[0] = r.Uniform(-5, 5);
+         x[1] = r.Uniform(-5, 5);
+         x[2] = ( e % 10 == 0 ) ? 0 : r.Uniform(-5, 5);
+         ref.push_back(x[0]);
+         ref.push_back(x[1]);
+         ref.push_back(x[2]);
+         ref.push_back(f.EvalParOld(x, params));
+      }
+      if ( !f.Jit() || !f.IsJitted() ) {
+         if ( defaultEqualOptions & cmpOptPrint ) std::cout << "FormulaJit " << expressions[i] << ": \tnot compiled" << std::endl;
+         ++status;
+         continue;
+      }
+      int differents = 0;
+      for ( UInt_t e = 0; e < ref.size(); e += 4 ) {
+         differents += equals(ref[e + 3], f.EvalPar(&ref[e], params), 1E-13);
+         differents += equals(ref[e + 3], f.EvalParOld(&ref[e], params), 0);
+      }
+      if ( defaultEqualOptions & cmpOptPrint ) std::cout << "FormulaJit " << expressions[i] << ": \t" << (differents?"FAILED":"OK") << std::endl;
+      status += differents;
+   }
+   TFormula::SetDefaultJit(jit);
+
+   if ( defaultEqualOptions & cmpOptPrint ) std::cout << "testFormulaJit: \t" << (status?"FAILED":"OK") << std::endl;
+   return status;
+}
+
 bool testRefRead1D()
 {
    // Tests consistency with a reference file for 1D Histogram
@@ -9431,9 +9927,46 @@ int stressHistogram()
                                            "FillData tests for Histograms and Sparses........................",
                                            fillDataTestPointer };
 
+   // Test 17
+   // FillN Tests
+   const unsigned int numberOfFillN = 3;
+   pointer2Test fillNTestPointer[numberOfFillN] = { testFillN1D,
+                                                    testFillN2D,
+                                                    testFillN3D
+   };
+   struct TTestSuite fillNTestSuite = { numberOfFillN, 
+                                        "FillN tests for 1D, 2D and 3D Histograms.........................",
+                                        fillNTestPointer };
+
+   // Test 18
+   // TThreadedHist Tests
+   const unsigned int numberOfThreaded = 1;
+   pointer2Test threadedTestPointer[numberOfThreaded] = { testThreadedHist };
+   struct TTestSuite threadedTestSuite = { numberOfThreaded, 
+                                           "TThreadedHist tests for 1D, 2D and 3D Histograms.................",
+                                           threadedTestPointer };
+
+   // Test 19
+   // THnSparse Bin Index Tests
+   const unsigned int numberOfSparseIndex = 2;
+   pointer2Test sparseIndexTestPointer[numberOfSparseIndex] = { testSparseIndex,
+                                                                testSparseFillN
+   };
+   struct TTestSuite sparseIndexTestSuite = { numberOfSparseIndex, 
+                                              "THnSparse bin index tests........................................",
+                                              sparseIndexTestPointer };
+
+   // Test 20
+   // TFormula Jit Tests
+   const unsigned int numberOfFormulaJit = 1;
+   pointer2Test formulaJitTestPointer[numberOfFormulaJit] = { testFormulaJit };
+   struct TTestSuite formulaJitTestSuite = { numberOfFormulaJit, 
+                                             "TFormula compilation tests.......................................",
+                                             formulaJitTestPointer };
+
 
    // Combination of tests
-   const unsigned int numberOfSuits = 14;
+   const unsigned int numberOfSuits = 18;
    struct TTestSuite* testSuite[numberOfSuits];
    testSuite[ 0] = &rangeTestSuite;
    testSuite[ 1] = &rebinTestSuite;
@@ -9449,6 +9982,10 @@ int stressHistogram()
    testSuite[11] = &integralTestSuite;
    testSuite[12] = &conversionsTestSuite;
    testSuite[13] = &fillDataTestSuite;
+   testSuite[14] = &fillNTestSuite;
+   testSuite[15] = &threadedTestSuite;
+   testSuite[16] = &sparseIndexTestSuite;
+   testSuite[17] = &formulaJitTestSuite;
 
    status = 0;
    for ( unsigned int i = 0; i < numberOfSuits; ++i ) {
@@ -9463,13 +10000,14 @@ int stressHistogram()
    }
    GlobalStatus += status;
 
-   // Test 17
+   // Test 21
    // Reference Tests
-   const unsigned int numberOfRefRead = 7;
+   const unsigned int numberOfRefRead = 8;
    pointer2Test refReadTestPointer[numberOfRefRead] = { testRefRead1D,  testRefReadProf1D,
                                                         testRefRead2D,  testRefReadProf2D,
                                                         testRefRead3D,  testRefReadProf3D,
-                                                        testRefReadSparse
+                                                        testRefReadSparse,
+                                                        testRefReadSparseIndex
    };
    struct TTestSuite refReadTestSuite = { numberOfRefRead, 
                                           "Reference File Read for Histograms and Profiles..................",
@@ -0,0 +1,1943 @@
+// @(#)root/test:$Id$
+
+/////////////////////////////////////////////////////////////////
+//
+//___A stress test for the multi-threaded and bulk tree I/O___
+//
+//   Each test writes small trees and checks that the new ways of
+//   reading, writing and merging them give the same entries as the
+//   classic serial ones. The last test checks, on localhost, the
+//   scatter-gather socket functions used to upload the files of a
+//   parallel merge.
+//
+//   To run in batch mode, do
+//     stressTreeIO
+//     stressTreeIO 1000
+//   Here the parameter is the number of entries in each TTree.
+//   Default value is 10000.
+//
+//   An example of output when all tests pass:
+// **********************************************************************
+// ******************Starting tree I/O stress test***********************
+// **********************************************************************
+// TTreeProcessor: entries processed and missing file ---------------- OK
+// ...
+// **********************************************************************
+// *******************Deleting the data files****************************
+// **********************************************************************
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "TApplication.h"
+#include "Compression.h"
+#include "TBasket.h"
+#include "TBufferFile.h"
+#include "TChain.h"
+#include "TClonesArray.h"
+#include "TError.h"
+#include "TFile.h"
+#include "TFileMerger.h"
+#include "TFormula.h"
+#include "TH1.h"
+#include "TKey.h"
+#include "TLeaf.h"
+#include "TInterpreter.h"
+#include "TMath.h"
+#include "TMessage.h"
+#include "TMMapFile.h"
+#include "TRandom3.h"
+#include "TROOT.h"
+#include "TSelector.h"
+#include "TServerSocket.h"
+#include "TSocket.h"
+#include "TSystem.h"
+#include "TTaskScheduler.h"
+#include "TThread.h"
+#include "TThreadPool.h"
+#include "TTree.h"
+#include "TTreeBlockIndex.h"
+#include "TTreeCacheUnzip.h"
+#include "TTreeFormula.h"
+#include "TTreePerfStats.h"
+#include "TTreeProcessor.h"
+#include "TTreeReader.h"
+#include "TTreeReaderValue.h"
+#include "TTreeStatsFilter.h"
+#include "TTreeTuningProfile.h"
+#include "TVirtualStreamerInfo.h"
+
+#include "stressTreeIO.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> gFiles; // files to delete at the end
+
+//______________________________________________________________________________
+void Report(const char *title, Bool_t ok)
+{
+   // Print the result of a test on one line.
+
+   TString line = title;
+   line += " ";
+   while (line.Length() < 67) line += "-";
+   printf("%s %s\n", line.Data(), ok ? "OK" : "FAILED");
+}
+
+//______________________________________________________________________________
+void MakeTree(const char *filename, Int_t nentries, UInt_t seed,
+              const TTreeTuningProfile *profile = 0, UInt_t ncompress = 0)
+{
+   // Write the tree "T" with nentries entries in filename: an integer
+   // counter, two doubles and a variable size array, and the histogram
+   // "h" of x. The layout of the tree is tuned with profile if not null,
+   // and its baskets are compressed by ncompress threads if not 0.
+
+   TFile f(filename, "RECREATE");
+   TTree *t = new TTree("T", "stressTreeIO");
+   TRandom3 rnd(seed);
+   Int_t i, n;
+   Double_t x, y;
+   Float_t a[10];
+   TH1D *h = new TH1D("h", "x", 100, -50, 50);
+   t->Branch("i", &i, "i/I");
+   t->Branch("x", &x, "x/D");
+   t->Branch("y", &y, "y/D");
+   t->Branch("n", &n, "n/I");
+   t->Branch("a", a, "a[n]/F");
+   t->SetAutoFlush(nentries / 7 + 1);
+   if (profile) t->SetTuningProfile(profile);
+   if (ncompress) t->SetParallelCompression(kTRUE, ncompress);
+   for (i = 0; i < nentries; ++i) {
+      x = rnd.Gaus(0, 10);
+      y = rnd.Uniform(-5, 5);
+      n = rnd.Integer(10);
+      for (Int_t j = 0; j < n; ++j) a[j] = rnd.Uniform(0, 100);
+      t->Fill();
+      h->Fill(x);
+   }
+   f.Write();
+   f.Close();
+   gFiles.push_back(filename);
+}
+
+//______________________________________________________________________________
+Bool_t SameOutput(TSelector *sel, TSelector *ref, Long64_t nentries, Double_t sum)
+{
+   // Compare the histograms "hx" and "hn" filled by two TCountSelector,
+   // and check that nentries entries, whose i add up to sum, were seen.
+
+   TH1 *hx = (TH1*) sel->GetOutputList()->FindObject("hx");
+   TH1 *hn = (TH1*) sel->GetOutputList()->FindObject("hn");
+   TH1 *hxr = (TH1*) ref->GetOutputList()->FindObject("hx");
+   TH1 *hnr = (TH1*) ref->GetOutputList()->FindObject("hn");
+   if (!hx || !hn || !hxr || !hnr) return kFALSE;
+   if (hn->GetEntries() != nentries || hn->GetBinContent(1) != sum) return kFALSE;
+   if (hnr->GetEntries() != nentries || hnr->GetBinContent(1) != sum) return kFALSE;
+   if (hx->GetEntries() != hxr->GetEntries()) return kFALSE;
+   for (Int_t bin = 0; bin <= hx->GetNbinsX() + 1; ++bin) {
+      if (hx->GetBinContent(bin) != hxr->GetBinContent(bin)) return kFALSE;
+   }
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+Bool_t TestProcessor(Int_t nentries)
+{
+   // Process a chain with TTreeProcessor with one, two and four threads:
+   // the merged outputs of the selectors are the ones of TChain::Process.
+   // A chain with a missing file is reported as an error, and so is a
+   // file removed once the entries are split among the threads: its
+   // entries are counted as failed, the others are processed.
+
+   MakeTree("stressTreeIO_p0.root", nentries, 1);
+   MakeTree("stressTreeIO_p1.root", nentries, 2);
+   MakeTree("stressTreeIO_p2.root", nentries, 3);
+   TChain chain("T");
+   chain.Add("stressTreeIO_p0.root");
+   chain.Add("stressTreeIO_p1.root");
+   Double_t sum = 2 * (Double_t(nentries) * (nentries - 1) / 2);
+
+   TCountSelector ref;
+   chain.Process(&ref);
+   Bool_t ok = kTRUE;
+   UInt_t nthreads[3] = { 1, 2, 4 };
+   for (Int_t k = 0; k < 3; ++k) {
+      TCountSelector sel;
+      TTreeProcessor proc(&chain, nthreads[k]);
+      if (proc.Process(&sel) < 0 || proc.GetNFailed() != 0 ||
+          !SameOutput(&sel, &ref, 2 * nentries, sum)) ok = kFALSE;
+   }
+
+   Int_t level = gErrorIgnoreLevel;
+   gErrorIgnoreLevel = kFatal;
+   TChain missing("T");
+   missing.Add("stressTreeIO_p0.root");
+   missing.Add("stressTreeIO_missing.root");
+   TCountSelector sel2;
+   TTreeProcessor proc2(&missing, 2);
+   if (proc2.Process(&sel2) >= 0) ok = kFALSE;
+
+   chain.Add("stressTreeIO_p2.root");
+   TUnlinkSelector sel3;
+   TTreeProcessor proc3(&chain, 2);
+   if (proc3.Process(&sel3, "stressTreeIO_p2.root") >= 0 || proc3.GetNFailed() != nentries ||
+       !SameOutput(&sel3, &ref, 2 * nentries, sum)) ok = kFALSE;
+   gErrorIgnoreLevel = level;
+   return ok;
+}
+
+//______________________________________________________________________________
+Bool_t SameMerge(const char *filename, const char *reference)
+{
+   // Compare the tree "T" (entry by entry, including the variable size
+   // array) and the histogram "h" (bin by bin) of two merged files.
+
+   TFile f(filename);
+   TFile r(reference);
+   TTree *t = (TTree*) f.Get("T");
+   TTree *tr = (TTree*) r.Get("T");
+   TH1 *h = (TH1*) f.Get("h");
+   TH1 *hr = (TH1*) r.Get("h");
+   if (!t || !tr || !h || !hr) return kFALSE;
+   if (t->GetEntries() != tr->GetEntries() || h->GetEntries() != hr->GetEntries()) return kFALSE;
+   for (Int_t bin = 0; bin <= h->GetNbinsX() + 1; ++bin) {
+      if (h->GetBinContent(bin) != hr->GetBinContent(bin)) return kFALSE;
+   }
+   Int_t i, ir, n, nr;
+   Double_t x, xr, y, yr;
+   Float_t a[10], ar[10];
+   t->SetBranchAddress("i", &i);
+   t->SetBranchAddress("x", &x);
+   t->SetBranchAddress("y", &y);
+   t->SetBranchAddress("n", &n);
+   t->SetBranchAddress("a", a);
+   tr->SetBranchAddress("i", &ir);
+   tr->SetBranchAddress("x", &xr);
+   tr->SetBranchAddress("y", &yr);
+   tr->SetBranchAddress("n", &nr);
+   tr->SetBranchAddress("a", ar);
+   for (Long64_t entry = 0; entry < t->GetEntries(); ++entry) {
+      if (t->GetEntry(entry) <= 0 || tr->GetEntry(entry) <= 0) return kFALSE;
+      if (i != ir || x != xr || y != yr || n != nr) return kFALSE;
+      for (Int_t j = 0; j < n; ++j) {
+         if (a[j] != ar[j]) return kFALSE;
+      }
+   }
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+Bool_t Merge(const char *output, Int_t ninputs, Int_t nthreads, Long64_t maxmemory,
+             Int_t settings = -1, const char *input = "stressTreeIO_m%d.root",
+             Bool_t histoOneGo = kFALSE)
+{
+   // Merge the first ninputs files named by the format input into output,
+   // with the compression settings of the inputs if settings is -1.
+
+   TFileMerger merger(kFALSE, histoOneGo);
+   merger.SetPrintLevel(0);
+   merger.SetNThreads(nthreads);
+   merger.SetMaxMemory(maxmemory);
+   if (settings < 0) {
+      if (!merger.OutputFile(output, "RECREATE")) return kFALSE;
+   } else {
+      if (!merger.OutputFile(output, "RECREATE", settings)) return kFALSE;
+   }
+   for (Int_t i = 0; i < ninputs; ++i) {
+      if (!merger.AddFile(TString::Format(input, i))) return kFALSE;
+   }
+   gFiles.push_back(output);
+   return merger.Merge();
+}
+
+//______________________________________________________________________________
+void MakeDirs(const char *filename, Int_t nentries, UInt_t seed, Bool_t withtree)
+{
+   // Write the directories d0 and d1, each with four histograms and the
+   // subdirectory s holding four more histograms, and with withtree the
+   // tree "T" of x in d1/s.
+
+   TFile f(filename, "RECREATE");
+   TRandom3 rnd(seed);
+   for (Int_t d = 0; d < 2; ++d) {
+      TDirectory *dir = f.mkdir(TString::Format("d%d", d));
+      TDirectory *sub = dir->mkdir("s");
+      for (Int_t k = 0; k < 8; ++k) {
+         (k < 4 ? dir : sub)->cd();
+         TH1D *h = new TH1D(TString::Format("h%d", k % 4), "x", 50, -25, 25);
+         for (Int_t i = 0; i < nentries; ++i) h->Fill(rnd.Gaus(k, 10));
+      }
+      if (withtree && d == 1) {
+         sub->cd();
+         Double_t x;
+         TTree *t = new TTree("T", "stressTreeIO");
+         t->Branch("x", &x, "x/D");
+         for (Int_t i = 0; i < nentries; ++i) {
+            x = rnd.Gaus(0, 10);
+            t->Fill();
+         }
+      }
+   }
+   f.Write();
+   f.Close();
+   gFiles.push_back(filename);
+}
+
+//______________________________________________________________________________
+Bool_t SameDirs(TDirectory *dir, TDirectory *ref)
+{
+   // Compare the histograms (bin by bin) and the trees "T" of x (entry by
+   // entry) of two merged directories, recursively.
+
+   TIter next(ref->GetListOfKeys());
+   TKey *key;
+   while ((key = (TKey*) next())) {
+      TObject *objr = key->ReadObj();
+      TObject *obj = dir->Get(key->GetName());
+      if (!obj || obj->IsA() != objr->IsA()) return kFALSE;
+      if (objr->InheritsFrom(TDirectory::Class())) {
+         if (!SameDirs((TDirectory*) obj, (TDirectory*) objr)) return kFALSE;
+      } else if (objr->InheritsFrom(TH1::Class())) {
+         TH1 *h = (TH1*) obj;
+         TH1 *hr = (TH1*) objr;
+         if (h->GetEntries() != hr->GetEntries()) return kFALSE;
+         for (Int_t bin = 0; bin <= hr->GetNbinsX() + 1; ++bin) {
+            if (h->GetBinContent(bin) != hr->GetBinContent(bin)) return kFALSE;
+         }
+      } else if (objr->InheritsFrom(TTree::Class())) {
+         TTree *t = (TTree*) obj;
+         TTree *tr = (TTree*) objr;
+         if (t->GetEntries() != tr->GetEntries()) return kFALSE;
+         Double_t x, xr;
+         t->SetBranchAddress("x", &x);
+         tr->SetBranchAddress("x", &xr);
+         for (Long64_t entry = 0; entry < t->GetEntries(); ++entry) {
+            if (t->GetEntry(entry) <= 0 || tr->GetEntry(entry) <= 0 || x != xr) return kFALSE;
+         }
+      }
+   }
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+Bool_t SameDirs(const char *filename, const char *reference)
+{
+   // Compare two merged files of directories written by MakeDirs.
+
+   TFile f(filename);
+   TFile r(reference);
+   if (f.IsZombie() || r.IsZombie() || r.GetListOfKeys()->GetSize() != 2) return kFALSE;
+   return SameDirs(&f, &r);
+}
+
+//______________________________________________________________________________
+Bool_t TestMergerOptions(Int_t nentries)
+{
+   // Merge files with several threads and, the histograms being merged in
+   // one go, with a memory limit: the result is the same as for the serial
+   // merge. Files with nested directories of histograms, with and without
+   // a tree, go through the release of the merged directories.
+
+   for (Int_t i = 0; i < 4; ++i)
+      MakeTree(TString::Format("stressTreeIO_m%d.root", i), nentries / 4, 10 + i);
+
+   Bool_t ok = Merge("stressTreeIO_serial.root", 4, 1, 0);
+   ok = ok && Merge("stressTreeIO_threads.root", 4, 2, 0);
+   ok = ok && SameMerge("stressTreeIO_threads.root", "stressTreeIO_serial.root");
+   ok = ok && Merge("stressTreeIO_maxmem.root", 4, 1, 1, -1, "stressTreeIO_m%d.root", kTRUE);
+   ok = ok && SameMerge("stressTreeIO_maxmem.root", "stressTreeIO_serial.root");
+
+   for (Int_t i = 0; i < 4; ++i) {
+      MakeDirs(TString::Format("stressTreeIO_h%d.root", i), nentries / 40, 30 + i, kFALSE);
+      MakeDirs(TString::Format("stressTreeIO_d%d.root", i), nentries / 40, 40 + i, kTRUE);
+   }
+   const char *inputs[2] = { "stressTreeIO_h%d.root", "stressTreeIO_d%d.root" };
+   for (Int_t k = 0; k < 2; ++k) {
+      TString serial = TString::Format("stressTreeIO_serial_%c.root", inputs[k][13]);
+      TString onego = TString::Format("stressTreeIO_onego_%c.root", inputs[k][13]);
+      TString maxmem = TString::Format("stressTreeIO_maxmem_%c.root", inputs[k][13]);
+      TString threads = TString::Format("stressTreeIO_threads_%c.root", inputs[k][13]);
+      ok = ok && Merge(serial, 4, 1, 0, -1, inputs[k]);
+      ok = ok && Merge(onego, 4, 1, 0, -1, inputs[k], kTRUE);
+      ok = ok && SameDirs(onego, serial);
+      ok = ok && Merge(maxmem, 4, 1, 1, -1, inputs[k], kTRUE);
+      ok = ok && SameDirs(maxmem, serial);
+      ok = ok && Merge(threads, 4, 2, 1, -1, inputs[k], kTRUE);
+      ok = ok && SameDirs(threads, serial);
+   }
+
+   TFileMerger merger(kFALSE);
+   merger.SetNThreads(0);
+   if (merger.GetNThreads() < 1) ok = kFALSE;
+   return ok;
+}
+
+//______________________________________________________________________________
+Bool_t TestParallelMerge(Int_t nentries)
+{
+   // Merge seven files serially and in groups of uneven sizes by three
+   // threads, and with one thread per cpu: the trees and histograms are
+   // the same.
+
+   for (Int_t i = 0; i < 7; ++i)
+      MakeTree(TString::Format("stressTreeIO_m%d.root", i), nentries / 7 + i, 20 + i);
+
+   Bool_t ok = Merge("stressTreeIO_serial7.root", 7, 1, 0);
+   ok = ok && Merge("stressTreeIO_threads3.root", 7, 3, 0);
+   ok = ok && SameMerge("stressTreeIO_threads3.root", "stressTreeIO_serial7.root");
+   ok = ok && Merge("stressTreeIO_threads0.root", 7, 0, 0);
+   ok = ok && SameMerge("stressTreeIO_threads0.root", "stressTreeIO_serial7.root");
+   return ok;
+}
+
+//______________________________________________________________________________
+Bool_t CheckCompression(const char *filename, Int_t settings)
+{
+   // Check that the file and all the branches of its tree "T" were
+   // written with the given compression settings. When the algorithm
+   // is available, also check the signature of the compressed baskets.
+
+   TFile f(filename);
+   TTree *t = (TTree*) f.Get("T");
+   if (!t || f.GetCompressionSettings() != settings) return kFALSE;
+   char tag[2] = {0, 0};
+#ifdef R__HAS_LZ4
+   if (settings / 100 == ROOT::kLZ4) { tag[0] = 'L'; tag[1] = '4'; }
+#endif
+#ifdef R__HAS_ZSTD
+   if (settings / 100 == ROOT::kZSTD) { tag[0] = 'Z'; tag[1] = 'S'; }
+#endif
+   std::vector<char> buf;
+   TIter next(t->GetListOfBranches());
+   TBranch *branch;
+   while ((branch = (TBranch*) next())) {
+      if (branch->GetCompressionSettings() != settings) return kFALSE;
+      if (!tag[0]) continue;
+      for (Int_t i = 0; i < branch->GetWriteBasket(); ++i) {
+         Int_t nbytes = branch->GetBasketBytes()[i];
+         if (nbytes < 18) return kFALSE;
+         buf.resize(nbytes);
+         if (f.ReadBuffer(&buf[0], branch->GetBasketSeek(i), nbytes)) return kFALSE;
+         // The object length is in the bytes 6 to 9 of the key header and
+         // the key length in the bytes 14 and 15; a basket which does not
+         // shrink is written uncompressed, without a signature.
+         const UChar_t *b = (const UChar_t*) &buf[0];
+         Int_t objlen = (b[6] << 24) | (b[7] << 16) | (b[8] << 8) | b[9];
+         Int_t keylen = (b[14] << 8) | b[15];
+         if (nbytes == keylen + objlen) continue;
+         if (nbytes < keylen + 2) return kFALSE;
+         if (buf[keylen] != tag[0] || buf[keylen + 1] != tag[1]) return kFALSE;
+      }
+   }
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+Bool_t TestRecompress(Int_t nentries)
+{
+   // Fast merge files into outputs with other compression algorithms and
+   // levels, so that the baskets are recompressed instead of copied, and
+   // merge each output back with the default settings: all the entries
+   // read back are the same as for a merge without recompression.
+
+   for (Int_t i = 0; i < 3; ++i)
+      MakeTree(TString::Format("stressTreeIO_m%d.root", i), nentries / 3 + i, 30 + i);
+
+   const Int_t nsettings = 5;
+   Int_t settings[nsettings] = {
+      ROOT::CompressionSettings(ROOT::kZLIB, 6),
+      ROOT::CompressionSettings(ROOT::kLZMA, 2),
+      ROOT::CompressionSettings(ROOT::kLZ4, 4),
+      ROOT::CompressionSettings(ROOT::kZSTD, 5),
+      0
+   };
+   Bool_t ok = Merge("stressTreeIO_recomp.root", 3, 1, 0);
+   for (Int_t k = 0; ok && k < nsettings; ++k) {
+      TString output = TString::Format("stressTreeIO_recomp%d.root", k);
+      TString back = TString::Format("stressTreeIO_recomp%d_back.root", k);
+      ok = Merge(output, 3, 1, 0, settings[k])
+           && CheckCompression(output, settings[k])
+           && SameMerge(output, "stressTreeIO_recomp.root")
+           && Merge(back, 1, 1, 0, 1, output)
+           && CheckCompression(back, 1)
+           && SameMerge(back, "stressTreeIO_recomp.root");
+   }
+   return ok;
+}
+
+//______________________________________________________________________________
+Bool_t CheckColumns(TTree *t, Bool_t keepbaskets)
+{
+   // Load the columns of t and compare the entries read from the columns
+   // and, after DropColumns, from the baskets with a first serial read.
+   // The baskets of x must be kept in memory if keepbaskets is true, and
+   // dropped (except a basket not yet written) otherwise.
+
+   Long64_t nentries = t->GetEntries();
+   Int_t i;
+   Double_t x;
+   t->SetBranchAddress("i", &i);
+   t->SetBranchAddress("x", &x);
+   std::vector<Double_t> ref(nentries);
+   for (Long64_t entry = 0; entry < nentries; ++entry) {
+      t->GetEntry(entry);
+      ref[entry] = x;
+   }
+
+   TBranch *b = t->GetBranch("x");
+   Int_t nbaskets = b->GetListOfBaskets()->GetEntries();
+   if (t->LoadColumns("*") < 2) return kFALSE;
+   Int_t nloaded = b->GetListOfBaskets()->GetEntries();
+   if (keepbaskets ? nloaded != nbaskets : nloaded > 1) return kFALSE;
+
+   for (Int_t pass = 0; pass < 2; ++pass) {
+      for (Long64_t entry = 0; entry < nentries; ++entry) {
+         t->GetEntry(entry);
+         if (i != entry || x != ref[entry]) return kFALSE;
+      }
+      t->DropColumns();
+   }
+   t->ResetBranchAddresses();
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+Bool_t TestColumns(Int_t nentries)
+{
+   // LoadColumns keeps the baskets of an in-memory tree and drops the ones
+   // of a tree read from a file.
+
+   Bool_t ok = kTRUE;
+   {
+      TDirectory::TContext ctxt(gROOT);
+      TTree t("M", "in-memory tree");
+      Int_t i;
+      Double_t x;
+      t.Branch("i", &i, "i/I");
+      t.Branch("x", &x, "x/D");
+      t.SetAutoFlush(nentries / 7 + 1);
+      TRandom3 rnd(3);
+      for (i = 0; i < nentries; ++i) {
+         x = rnd.Gaus(0, 10);
+         t.Fill();
+      }
+      t.ResetBranchAddresses();
+      ok = CheckColumns(&t, kTRUE);
+   }
+
+   MakeTree("stressTreeIO_c.root", nentries, 4);
+   TFile f("stressTreeIO_c.root");
+   TTree *t = (TTree*) f.Get("T");
+   ok = ok && t && CheckColumns(t, kFALSE);
+   return ok;
+}
+
+//______________________________________________________________________________
+void MakeBulkTree(const char *filename, Int_t nentries)
+{
+   // Write the tree "B" of fixed size branches of several types, in small
+   // baskets, for the bulk reads.
+
+   TFile f(filename, "RECREATE");
+   TTree *t = new TTree("B", "stressTreeIO");
+   TRandom3 rnd(90);
+   Double_t x;
+   Short_t s;
+   Float_t v[3];
+   Char_t c;
+   t->Branch("x", &x, "x/D", 1000);
+   t->Branch("s", &s, "s/S", 1000);
+   t->Branch("v", v, "v[3]/F", 1000);
+   t->Branch("c", &c, "c/B", 1000);
+   for (Int_t i = 0; i < nentries; ++i) {
+      x = rnd.Gaus(0, 10);
+      s = i % 100 - 50;
+      for (Int_t j = 0; j < 3; ++j) v[j] = rnd.Uniform(0, 100) + j;
+      c = i % 7;
+      t->Fill();
+   }
+   f.Write();
+   f.Close();
+   gFiles.push_back(filename);
+}
+
+//______________________________________________________________________________
+Double_t BulkValue(TBuffer &buf, Int_t i, TLeaf *leaf, Bool_t serialized)
+{
+   // Return the i-th value of the type of leaf in buf, which is in host
+   // order or, if serialized, as stored in the file.
+
+   TString type = leaf->GetTypeName();
+   if (serialized) {
+      TBufferFile b(TBuffer::kRead, buf.BufferSize(), buf.Buffer(), kFALSE);
+      b.SetBufferOffset(i * leaf->GetLenType());
+      if (type == "Double_t") { Double_t d; b >> d; return d; }
+      if (type == "Float_t")  { Float_t f;  b >> f; return f; }
+      if (type == "Short_t")  { Short_t s;  b >> s; return s; }
+      if (type == "Char_t")   { Char_t c;   b >> c; return c; }
+      return -1;
+   }
+   const char *p = buf.Buffer() + i * leaf->GetLenType();
+   if (type == "Double_t") { Double_t d; memcpy(&d, p, sizeof(d)); return d; }
+   if (type == "Float_t")  { Float_t f;  memcpy(&f, p, sizeof(f)); return f; }
+   if (type == "Short_t")  { Short_t s;  memcpy(&s, p, sizeof(s)); return s; }
+   if (type == "Char_t")   { return *p; }
+   return -1;
+}
+
+//______________________________________________________________________________
+Bool_t CheckBulk(TBranch *branch, Long64_t first)
+{
+   // Read the entries of branch from first to the end with GetBulkEntries
+   // and GetEntriesSerialized, one basket at a time, and compare them with
+   // the ones read by GetEntry.
+
+   TLeaf *leaf = (TLeaf*) branch->GetListOfLeaves()->At(0);
+   Int_t len = leaf->GetLenStatic();
+   Long64_t nentries = branch->GetEntries();
+   std::vector<Double_t> ref;
+   char address[64];
+   branch->SetAddress(address);
+   for (Long64_t entry = first; entry < nentries; ++entry) {
+      if (branch->GetEntry(entry) <= 0) break;
+      for (Int_t k = 0; k < len; ++k) ref.push_back(leaf->GetValue(k));
+   }
+   branch->ResetAddress();
+   if ((Long64_t) ref.size() != (nentries - first) * len) return kFALSE;
+
+   TBufferFile bulk(TBuffer::kRead, 100);
+   TBufferFile serialized(TBuffer::kRead, 100);
+   Long64_t *basketentry = branch->GetBasketEntry();
+   for (Long64_t entry = first; entry < nentries; ) {
+      Int_t n = branch->GetBulkEntries(entry, bulk);
+      if (n <= 0 || branch->GetEntriesSerialized(entry, serialized) != n) return kFALSE;
+      // The entries read stop at the end of a basket.
+      Bool_t boundary = (entry + n == nentries);
+      for (Int_t j = 0; j <= branch->GetWriteBasket(); ++j) {
+         if (basketentry[j] == entry + n) boundary = kTRUE;
+      }
+      if (!boundary) return kFALSE;
+      for (Int_t i = 0; i < n * len; ++i) {
+         Double_t value = ref[(entry - first) * len + i];
+         if (BulkValue(bulk, i, leaf, kFALSE) != value) return kFALSE;
+         if (BulkValue(serialized, i, leaf, kTRUE) != value) return kFALSE;
+      }
+      entry += n;
+   }
+   return branch->GetBulkEntries(nentries, bulk) == 0;
+}
+
+//______________________________________________________________________________
+Bool_t TestBulkRead(Int_t nentries)
+{
+   // Read branches of several types, byte swapped or not, with
+   // GetBulkEntries and GetEntriesSerialized from the first entry and from
+   // the middle of a basket: the values are the ones of GetEntry. A basket
+   // whose buffer was dropped is read again, and a basket that can no
+   // longer be read gives an error instead of stale values.
+
+   nentries = TMath::Max(nentries, 2000);
+   MakeBulkTree("stressTreeIO_bulk.root", nentries);
+   {
+      TFile f("stressTreeIO_bulk.root");
+      TTree *t = (TTree*) f.Get("B");
+      if (!t) return kFALSE;
+      t->SetCacheSize(0);
+      const char *names[4] = {"x", "s", "v", "c"};
+      for (Int_t k = 0; k < 4; ++k) {
+         TBranch *branch = t->GetBranch(names[k]);
+         if (!branch || !CheckBulk(branch, 0) || !CheckBulk(branch, 5)) {
+            printf("TBranch::GetBulkEntries: branch %s differs\n", names[k]);
+            return kFALSE;
+         }
+      }
+   }
+
+   TFile f("stressTreeIO_bulk.root");
+   TTree *t = (TTree*) f.Get("B");
+   if (!t) return kFALSE;
+   t->SetCacheSize(0);
+   TBranch *branch = t->GetBranch("s");
+   TBufferFile buf(TBuffer::kRead, 100);
+   Int_t n0 = branch->GetBulkEntries(0, buf);
+   Int_t n1 = n0 > 0 ? branch->GetBulkEntries(n0, buf) : 0;
+   TBasket *basket = (TBasket*) branch->GetListOfBaskets()->At(1);
+   if (n1 <= 0 || !basket) return kFALSE;
+   std::vector<char> values(buf.Buffer(), buf.Buffer() + n1 * sizeof(Short_t));
+   basket->DropBuffers();
+   if (branch->GetBulkEntries(n0, buf) != n1) return kFALSE;
+   if (memcmp(&values[0], buf.Buffer(), values.size())) return kFALSE;
+
+   // Overwrite the compressed content of the basket in the file.
+   basket->DropBuffers();
+   Int_t keylen = basket->GetKeylen();
+   Int_t nbytes = branch->GetBasketBytes()[1];
+   if (nbytes >= keylen + basket->GetObjlen()) return kFALSE;
+   FILE *fp = fopen("stressTreeIO_bulk.root", "r+b");
+   if (!fp) return kFALSE;
+   std::vector<char> zeros(nbytes - keylen, 0);
+   fseek(fp, (long) branch->GetBasketSeek(1) + keylen, SEEK_SET);
+   fwrite(&zeros[0], 1, zeros.size(), fp);
+   fclose(fp);
+   Int_t level = gErrorIgnoreLevel;
+   gErrorIgnoreLevel = kFatal;
+   Bool_t ok = branch->GetBulkEntries(n0, buf) == -1
+               && branch->GetEntriesSerialized(n0, buf) == -1
+               && branch->GetBulkEntries(0, buf) == n0;
+   gErrorIgnoreLevel = level;
+   return ok;
+}
+
+//______________________________________________________________________________
+template <class T>
+void SetBulkElem(T &e, Int_t i, Int_t j)
+{
+   // Set the data members of the j-th element of the collections of the
+   // entry i; all the values are exact in the smallest types used.
+
+   e.fI = 100 * i + j;
+   e.fX = 0.5 * (i + j);
+   e.fF = 0.25 * j;
+   e.fS = (i + j) % 300 - 150;
+   e.fC = (i + j) % 100;
+}
+
+//______________________________________________________________________________
+template <class T>
+Bool_t SameBulkElem(const T &e, Int_t i, Int_t j)
+{
+   // Check the data members of the j-th element of the entry i.
+
+   T ref;
+   SetBulkElem(ref, i, j);
+   return e.fI == ref.fI && e.fX == ref.fX && e.fF == ref.fF && e.fS == ref.fS && e.fC == ref.fC;
+}
+
+//______________________________________________________________________________
+void MakeBulkCollections(const char *filename, Int_t nentries)
+{
+   // Write the tree "W" of collections of up to 12 elements: vectors of
+   // TBulkElem and of its former layout TBulkElemOld, split and not
+   // split, and a split TClonesArray. The collections not split are
+   // streamed member-wise or not depending on
+   // TVirtualStreamerInfo::GetStreamMemberWise.
+
+   TFile f(filename, "RECREATE");
+   TTree *t = new TTree("W", "stressTreeIO");
+   std::vector<TBulkElem> *v = new std::vector<TBulkElem>;
+   std::vector<TBulkElemOld> *vold = new std::vector<TBulkElemOld>;
+   TClonesArray *ca = new TClonesArray("TBulkObj");
+   t->Branch("v99", &v, 32000, 99);
+   t->Branch("v0", &v, 32000, 0);
+   t->Branch("vold99", &vold, 32000, 99);
+   t->Branch("vold0", &vold, 32000, 0);
+   t->Branch("ca", &ca, 32000, 99);
+   for (Int_t i = 0; i < nentries; ++i) {
+      Int_t n = i % 13;
+      v->resize(n);
+      vold->resize(n);
+      ca->Clear();
+      for (Int_t j = 0; j < n; ++j) {
+         SetBulkElem((*v)[j], i, j);
+         SetBulkElem((*vold)[j], i, j);
+         TBulkObj *obj = new ((*ca)[j]) TBulkObj;
+         SetBulkElem(*obj, i, j);
+      }
+      t->Fill();
+   }
+   f.Write();
+   f.Close();
+   delete v;
+   delete vold;
+   delete ca;
+   gFiles.push_back(filename);
+}
+
+//______________________________________________________________________________
+Bool_t CheckBulkCollections(const char *filename)
+{
+   // Read the tree written by MakeBulkCollections, with the vectors of
+   // TBulkElemOld read as vectors of TBulkElem, and check every element.
+
+   TFile f(filename);
+   TTree *t = (TTree*) f.Get("W");
+   if (!t) return kFALSE;
+   const Int_t nv = 4;
+   const char *names[nv] = {"v99", "v0", "vold99", "vold0"};
+   std::vector<TBulkElem> *v[nv] = {0, 0, 0, 0};
+   TClonesArray *ca = 0;
+   Bool_t ok = kTRUE;
+   for (Int_t k = 0; k < nv; ++k) {
+      if (t->SetBranchAddress(names[k], &v[k]) < 0) ok = kFALSE;
+   }
+   if (t->SetBranchAddress("ca", &ca) < 0) ok = kFALSE;
+   for (Long64_t i = 0; ok && i < t->GetEntries(); ++i) {
+      if (t->GetEntry(i) <= 0) ok = kFALSE;
+      Int_t n = i % 13;
+      for (Int_t k = 0; ok && k < nv; ++k) {
+         if (!v[k] || (Int_t) v[k]->size() != n) ok = kFALSE;
+         for (Int_t j = 0; ok && j < n; ++j) ok = SameBulkElem((*v[k])[j], i, j);
+         if (!ok) printf("member-wise read: %s differs at entry %lld\n", names[k], i);
+      }
+      if (ok && (!ca || ca->GetEntriesFast() != n)) ok = kFALSE;
+      for (Int_t j = 0; ok && j < n; ++j) ok = SameBulkElem(*(TBulkObj*) ca->UncheckedAt(j), i, j);
+   }
+   t->ResetBranchAddresses();
+   for (Int_t k = 0; k < nv; ++k) delete v[k];
+   delete ca;
+   return ok;
+}
+
+//______________________________________________________________________________
+Bool_t TestMemberWise(Int_t nentries)
+{
+   // Read vectors and a TClonesArray of elements with data members of
+   // basic types, split and not split, with type conversions of the
+   // former layout of the elements. The vectors not split are written
+   // member-wise, read in bulk, and object-wise, read element by element.
+
+   nentries = nentries / 4 + 13;
+   Bool_t memberwise = TVirtualStreamerInfo::SetStreamMemberWise(kTRUE);
+   MakeBulkCollections("stressTreeIO_mw.root", nentries);
+   TVirtualStreamerInfo::SetStreamMemberWise(kFALSE);
+   MakeBulkCollections("stressTreeIO_ow.root", nentries);
+   TVirtualStreamerInfo::SetStreamMemberWise(memberwise);
+   return CheckBulkCollections("stressTreeIO_mw.root")
+          && CheckBulkCollections("stressTreeIO_ow.root");
+}
+
+//______________________________________________________________________________
+Bool_t CheckBlockIndex(TTree *t)
+{
+   // Every (run, evt) pair of t is found at its entry with the index.
+
+   if (!t || !t->GetTreeIndex()) return kFALSE;
+   for (Long64_t entry = 0; entry < t->GetEntries(); entry += 3) {
+      if (t->GetEntryNumberWithIndex(entry / 100, (entry % 100) * 7) != entry) return kFALSE;
+   }
+   return t->GetEntryNumberWithIndex(-1, 0) < 0;
+}
+
+//______________________________________________________________________________
+Bool_t TestBlockIndex(Int_t nentries)
+{
+   // Write a tree with a TTreeBlockIndex, build the index again with other
+   // blocks and write the tree again: both cycles of the tree can use their
+   // index when read back.
+
+   {
+      TFile f("stressTreeIO_b.root", "RECREATE");
+      gFiles.push_back("stressTreeIO_b.root");
+      TTree *t = new TTree("T", "block index");
+      Int_t run, evt;
+      t->Branch("run", &run, "run/I");
+      t->Branch("evt", &evt, "evt/I");
+      for (Long64_t entry = 0; entry < nentries; ++entry) {
+         run = entry / 100;
+         evt = (entry % 100) * 7;
+         t->Fill();
+      }
+      TTreeBlockIndex *index = new TTreeBlockIndex(t, "run", "evt", 100);
+      t->SetTreeIndex(index);
+      t->Write();
+      t->SetTreeIndex(new TTreeBlockIndex(t, "run", "evt", 37));
+      delete index;
+      t->Write();
+      f.Close();
+   }
+   TFile f("stressTreeIO_b.root");
+   return CheckBlockIndex((TTree*) f.Get("T;1")) && CheckBlockIndex((TTree*) f.Get("T;2"));
+}
+
+//______________________________________________________________________________
+Bool_t SameProfile(const TTreeTuningProfile *p, const TTreeTuningProfile *pr)
+{
+   // Compare the settings and the branch profiles of two tuning profiles.
+
+   if (!p || !pr) return kFALSE;
+   if (p->GetCacheSize() != pr->GetCacheSize() || p->GetMaxMemory() != pr->GetMaxMemory()
+       || p->GetClusterSize() != pr->GetClusterSize() || p->GetNBranches() != pr->GetNBranches()
+       || strcmp(p->GetTreeName(), pr->GetTreeName())) return kFALSE;
+   for (Int_t i = 0; i < p->GetNBranches(); ++i) {
+      const TTreeTuningProfile::TBranchProfile *b = p->GetBranchProfile(i);
+      const TTreeTuningProfile::TBranchProfile *br = pr->GetBranchProfile(i);
+      if (b->fName != br->fName || b->fEntriesRead != br->fEntriesRead
+          || b->fBytesPerEntry != br->fBytesPerEntry || b->fZipBytesPerEntry != br->fZipBytesPerEntry
+          || p->IsHot(b->fName) != pr->IsHot(br->fName)) return kFALSE;
+   }
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+Bool_t TestTuningProfile(Int_t nentries)
+{
+   // Record the profile of an analysis reading x and y through a
+   // TTreeCache, save it and read it back, and write the tree again with
+   // it: the tree has the cluster size and the basket sizes of the
+   // profile, the baskets of x and y come first in each cluster, and the
+   // entries are the same as without the profile.
+
+   MakeTree("stressTreeIO_t.root", nentries, 50);
+   TTreeTuningProfile *profile = 0;
+   {
+      TFile f("stressTreeIO_t.root");
+      TTree *t = (TTree*) f.Get("T");
+      if (!t) return kFALSE;
+      t->SetCacheSize(10000000);
+      t->AddBranchToCache("x");
+      t->AddBranchToCache("y");
+      t->StopCacheLearningPhase();
+      for (Long64_t entry = 0; entry < nentries; ++entry) {
+         t->GetBranch("x")->GetEntry(entry);
+         t->GetBranch("y")->GetEntry(entry);
+      }
+      profile = new TTreeTuningProfile("T_profile", t);
+      if (profile->AddCachedBranches() != 2 || profile->GetNBranches() != 5
+          || !profile->IsHot("x") || !profile->IsHot("y") || profile->IsHot("a")) {
+         delete profile;
+         return kFALSE;
+      }
+      // About five clusters for the hot branches.
+      Double_t hotzip = 0;
+      for (Int_t i = 0; i < profile->GetNBranches(); ++i) {
+         const TTreeTuningProfile::TBranchProfile *b = profile->GetBranchProfile(i);
+         if (profile->IsHot(b->fName)) hotzip += b->fZipBytesPerEntry;
+      }
+      profile->SetCacheSize((Long64_t)(hotzip * nentries / 5));
+      profile->SetMaxMemory(100000000);
+   }
+   {
+      TFile f("stressTreeIO_tp.root", "RECREATE");
+      gFiles.push_back("stressTreeIO_tp.root");
+      profile->Write();
+   }
+
+   TFile pf("stressTreeIO_tp.root");
+   TTreeTuningProfile *read = 0;
+   pf.GetObject("T_profile", read);
+   Bool_t ok = SameProfile(read, profile);
+   delete profile;
+   if (!ok) return kFALSE;
+   Long64_t cluster = read->GetClusterSize();
+   if (cluster <= 0 || cluster >= nentries) return kFALSE;
+
+   MakeTree("stressTreeIO_t2.root", nentries, 50, read);
+   ok = SameMerge("stressTreeIO_t2.root", "stressTreeIO_t.root");
+   TFile f("stressTreeIO_t2.root");
+   TTree *t = (TTree*) f.Get("T");
+   if (!ok || !t || t->GetAutoFlush() != cluster) return kFALSE;
+   Long64_t hotseek = 0;
+   Long64_t coldseek = -1;
+   TIter next(t->GetListOfBranches());
+   TBranch *branch;
+   while ((branch = (TBranch*) next())) {
+      if (branch->GetBasketSize() != read->GetBasketSize(branch)) return kFALSE;
+      Long64_t seek = branch->GetBasketSeek(0);
+      if (read->IsHot(branch->GetName())) {
+         if (seek > hotseek) hotseek = seek;
+      } else if (coldseek < 0 || seek < coldseek) {
+         coldseek = seek;
+      }
+   }
+   return hotseek > 0 && hotseek < coldseek;
+}
+
+//______________________________________________________________________________
+Bool_t TestFormulaJit(Int_t nentries)
+{
+   // Compile tree formulas with TTreeFormula::Jit and compare, for every
+   // entry and instance, EvalInstance with the one of the same formulas
+   // interpreted: arrays and out of range indices, Alt$, Sum$, Length$,
+   // MinIf$ and MaxIf$, and the boolean optimisation of && and ||.
+
+   if (!gInterpreter) return kTRUE;
+   MakeTree("stressTreeIO_f.root", nentries, 60);
+   TFile f("stressTreeIO_f.root");
+   TTree *t = (TTree*) f.Get("T");
+   if (!t) return kFALSE;
+
+   const char *expressions[] = {
+      "x*2+y",
+      "a*2-x",
+      "a[2]*1",
+      "a[i%12]+1",
+      "Alt$(a[3],-1)+1",
+      "Sum$(a)/(1+Length$(a))",
+      "MinIf$(a,a>50)*2",
+      "MaxIf$(a,a<50&&x>0)+y",
+      "x>0&&a[0]>50",
+      "x>0||a[1]<50",
+      "!(y>0)&&(n>3||a[4]>90)",
+      "i%3==0?x:y",
+      "(i&6)+(n|1)"
+   };
+   const Int_t nexpr = sizeof(expressions) / sizeof(expressions[0]);
+   Bool_t jit = TFormula::GetDefaultJit();
+   TFormula::SetDefaultJit(kFALSE);
+   Bool_t ok = kTRUE;
+   for (Int_t k = 0; ok && k < nexpr; ++k) {
+      TTreeFormula ref("ref", expressions[k], t);
+      TTreeFormula compiled("compiled", expressions[k], t);
+      if (ref.GetNdim() == 0 || !compiled.Jit()) ok = kFALSE;
+      for (Long64_t entry = 0; ok && entry < nentries; ++entry) {
+         t->LoadTree(entry);
+         Int_t ndata = ref.GetNdata();
+         if (compiled.GetNdata() != ndata) ok = kFALSE;
+         for (Int_t inst = 0; ok && inst < ndata; ++inst) {
+            Double_t v = ref.EvalInstance(inst);
+            Double_t vc = compiled.EvalInstance(inst);
+            if (TMath::Abs(v - vc) > 1e-13 * TMath::Abs(v)) ok = kFALSE;
+         }
+      }
+      if (!ok) printf("TTreeFormula::Jit: %s differs\n", expressions[k]);
+   }
+   TFormula::SetDefaultJit(jit);
+   return ok;
+}
+
+//______________________________________________________________________________
+Double_t ReadTree(TFile &f, Bool_t prefetch)
+{
+   // Read all the branches of the tree "T" of f through a cache, with
+   // prefetching if prefetch, and return a checksum of the entries.
+   // Returns -1 if an entry cannot be read.
+
+   TTree *t = (TTree*) f.Get("T");
+   if (!t) return -1;
+   Int_t i, n;
+   Double_t x, y;
+   Float_t a[10];
+   t->SetBranchAddress("i", &i);
+   t->SetBranchAddress("x", &x);
+   t->SetBranchAddress("y", &y);
+   t->SetBranchAddress("n", &n);
+   t->SetBranchAddress("a", a);
+   t->SetCacheSize(1000000);
+   TTreeCache *cache = (TTreeCache*) f.GetCacheRead(t);
+   if (!cache) return -1;
+   if (prefetch) cache->SetEnablePrefetching(kTRUE);
+   t->AddBranchToCache("*", kTRUE);
+   t->StopCacheLearningPhase();
+   Double_t sum = 0;
+   for (Long64_t entry = 0; entry < t->GetEntries(); ++entry) {
+      if (t->GetEntry(entry) <= 0) return -1;
+      sum += i + 3 * x + 7 * y + n;
+      for (Int_t j = 0; j < n; ++j) sum += (j + 1) * a[j];
+   }
+   return sum;
+}
+
+//______________________________________________________________________________
+Double_t ReadTree(const char *filename, Bool_t prefetch)
+{
+   // Same as above for the tree "T" of filename.
+
+   TFile f(filename);
+   return ReadTree(f, prefetch);
+}
+
+//______________________________________________________________________________
+Bool_t TestParallelUnzip(Int_t nentries)
+{
+   // Read a tree with the baskets unzipped by two threads, without and
+   // with prefetching: the entries are the same as for the serial read.
+
+   MakeTree("stressTreeIO_unzip.root", nentries, 60);
+   Double_t serial = ReadTree("stressTreeIO_unzip.root", kFALSE);
+   Double_t serialpf = ReadTree("stressTreeIO_unzip.root", kTRUE);
+
+   TTreeCacheUnzip::EParUnzipMode mode = TTreeCacheUnzip::GetParallelUnzip();
+   TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::kEnable);
+   TTreeCacheUnzip::SetUnzipThreads(2);
+   Double_t parallel = ReadTree("stressTreeIO_unzip.root", kFALSE);
+   Double_t parallelpf = ReadTree("stressTreeIO_unzip.root", kTRUE);
+   TTreeCacheUnzip::SetUnzipThreads(0);
+   TTreeCacheUnzip::SetParallelUnzip(mode);
+
+   return serial >= 0 && serialpf == serial && parallel == serial && parallelpf == serial;
+}
+
+//______________________________________________________________________________
+Bool_t SameBaskets(const char *filename, const char *reference)
+{
+   // Check that the baskets of the tree "T" of two files are at the same
+   // places and have the same bytes, apart from the date of their keys.
+
+   TFile f(filename);
+   TFile fr(reference);
+   TTree *t = (TTree*) f.Get("T");
+   TTree *tr = (TTree*) fr.Get("T");
+   if (!t || !tr || t->GetEntries() != tr->GetEntries()) return kFALSE;
+   Int_t nbranches = t->GetListOfBranches()->GetEntriesFast();
+   if (nbranches != tr->GetListOfBranches()->GetEntriesFast()) return kFALSE;
+   std::vector<char> buf, bufr;
+   for (Int_t j = 0; j < nbranches; ++j) {
+      TBranch *b = (TBranch*) t->GetListOfBranches()->UncheckedAt(j);
+      TBranch *br = (TBranch*) tr->GetListOfBranches()->UncheckedAt(j);
+      if (b->GetWriteBasket() != br->GetWriteBasket()) return kFALSE;
+      for (Int_t i = 0; i < b->GetWriteBasket(); ++i) {
+         Int_t nbytes = b->GetBasketBytes()[i];
+         if (nbytes != br->GetBasketBytes()[i] || nbytes < 18) return kFALSE;
+         if (b->GetBasketSeek(i) != br->GetBasketSeek(i)) return kFALSE;
+         buf.resize(nbytes);
+         bufr.resize(nbytes);
+         if (f.ReadBuffer(&buf[0], b->GetBasketSeek(i), nbytes)) return kFALSE;
+         if (fr.ReadBuffer(&bufr[0], br->GetBasketSeek(i), nbytes)) return kFALSE;
+         // The date is in the bytes 10 to 13 of the key header.
+         for (Int_t k = 0; k < nbytes; ++k) {
+            if ((k < 10 || k > 13) && buf[k] != bufr[k]) return kFALSE;
+         }
+      }
+   }
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+Bool_t TestParallelCompression(Int_t nentries)
+{
+   // Write the same tree with its baskets compressed serially, and by two
+   // and four threads at each AutoFlush: the baskets are the same and so
+   // are the entries read back.
+
+   MakeTree("stressTreeIO_pzip0.root", nentries, 80);
+   MakeTree("stressTreeIO_pzip2.root", nentries, 80, 0, 2);
+   MakeTree("stressTreeIO_pzip4.root", nentries, 80, 0, 4);
+   Double_t serial = ReadTree("stressTreeIO_pzip0.root", kFALSE);
+   return serial >= 0
+          && SameBaskets("stressTreeIO_pzip2.root", "stressTreeIO_pzip0.root")
+          && SameBaskets("stressTreeIO_pzip4.root", "stressTreeIO_pzip0.root")
+          && ReadTree("stressTreeIO_pzip2.root", kFALSE) == serial
+          && ReadTree("stressTreeIO_pzip4.root", kFALSE) == serial;
+}
+
+class TPrefetchFile : public TFile {
+   // Local file counting the positional reads, done by the prefetching
+   // thread (TFilePrefetch::ReadLocalBlock), and making them fail if fFail.
+public:
+   Bool_t fFail;
+   Int_t  fNReads;
+   TPrefetchFile(const char *name, Bool_t fail) : TFile(name), fFail(fail), fNReads(0) { }
+   Int_t SysReadAt(Int_t fd, void *buf, Int_t len, Long64_t offset) {
+      ++fNReads;
+      if (fFail) {
+         errno = EIO;
+         return -1;
+      }
+      return TFile::SysReadAt(fd, buf, len, offset);
+   }
+};
+
+//______________________________________________________________________________
+Bool_t TestPrefetch(Int_t nentries)
+{
+   // Read a local tree with prefetching: the blocks are read by the
+   // prefetching thread with positional reads and, when these fail, the
+   // baskets are read synchronously. In both cases the entries are the
+   // ones of a read without prefetching.
+
+   MakeTree("stressTreeIO_pf.root", nentries, 110);
+   Double_t plain = ReadTree("stressTreeIO_pf.root", kFALSE);
+   Double_t sums[2];
+   Int_t nreads[2];
+   Int_t level = gErrorIgnoreLevel;
+   for (Int_t fail = 0; fail < 2; ++fail) {
+      if (fail) gErrorIgnoreLevel = kFatal;
+      TPrefetchFile *f = new TPrefetchFile("stressTreeIO_pf.root", fail);
+      sums[fail] = ReadTree(*f, kTRUE);
+      // Closing the file stops the prefetching thread.
+      f->Close();
+      nreads[fail] = f->fNReads;
+      delete f;
+   }
+   gErrorIgnoreLevel = level;
+   return plain >= 0 && sums[0] == plain && sums[1] == plain
+          && nreads[0] > 0 && nreads[1] > 0;
+}
+
+//______________________________________________________________________________
+void MakeTrees(const char *filename, Int_t ntrees, Int_t nentries)
+{
+   // Write ntrees trees "T0", "T1"... of nentries entries in filename,
+   // with an integer, a double and a variable size array.
+
+   TFile f(filename, "RECREATE");
+   TRandom3 rnd(70);
+   Int_t i, n;
+   Double_t x;
+   Float_t a[10];
+   for (Int_t k = 0; k < ntrees; ++k) {
+      TTree *t = new TTree(TString::Format("T%d", k), "stressTreeIO");
+      t->Branch("i", &i, "i/I");
+      t->Branch("x", &x, "x/D");
+      t->Branch("n", &n, "n/I");
+      t->Branch("a", a, "a[n]/F");
+      t->SetAutoFlush(nentries / 7 + 1);
+      for (i = 0; i < nentries; ++i) {
+         x = rnd.Gaus(k, 10);
+         n = rnd.Integer(10);
+         for (Int_t j = 0; j < n; ++j) a[j] = rnd.Uniform(0, 100);
+         t->Fill();
+      }
+   }
+   f.Write();
+   f.Close();
+   gFiles.push_back(filename);
+}
+
+//______________________________________________________________________________
+Double_t Checksum(TTree *t)
+{
+   // Read all the entries of a tree written by MakeTrees and return a
+   // checksum of them, -1 if an entry cannot be read.
+
+   Int_t i, n;
+   Double_t x;
+   Float_t a[10];
+   t->SetBranchAddress("i", &i);
+   t->SetBranchAddress("x", &x);
+   t->SetBranchAddress("n", &n);
+   t->SetBranchAddress("a", a);
+   Double_t sum = 0;
+   for (Long64_t entry = 0; entry < t->GetEntries(); ++entry) {
+      if (t->GetEntry(entry) <= 0) return -1;
+      sum += i + 3 * x + n;
+      for (Int_t j = 0; j < n; ++j) sum += (j + 1) * a[j];
+   }
+   return sum;
+}
+
+// Tree read by a thread of TestConcurrentRead, and its checksum.
+struct TReaderArgs {
+   TTree   *fTree;
+   Double_t fSum;
+};
+
+//______________________________________________________________________________
+void *ReaderThread(void *arg)
+{
+   // Compute the checksum of the tree of a TReaderArgs.
+
+   TReaderArgs *args = (TReaderArgs*) arg;
+   args->fSum = Checksum(args->fTree);
+   return 0;
+}
+
+//______________________________________________________________________________
+Bool_t TestConcurrentRead(Int_t nentries)
+{
+   // Read four trees of a file, each by its own thread, through one TFile
+   // and through one TMMapFile in concurrent read mode: each thread gets
+   // the entries of the serial read.
+
+   const Int_t ntrees = 4;
+   MakeTrees("stressTreeIO_concurrent.root", ntrees, nentries);
+   Double_t serial[ntrees];
+   {
+      TFile f("stressTreeIO_concurrent.root");
+      for (Int_t k = 0; k < ntrees; ++k) {
+         TTree *t = (TTree*) f.Get(TString::Format("T%d", k));
+         serial[k] = t ? Checksum(t) : -1;
+      }
+   }
+   Bool_t ok = kTRUE;
+   for (Int_t mmap = 0; mmap < 2; ++mmap) {
+      TFile *f = TFile::Open("stressTreeIO_concurrent.root", mmap ? "MMAP" : "READ");
+      if (!f || (mmap && !f->InheritsFrom(TMMapFile::Class())) || !f->SetConcurrentRead()) {
+         delete f;
+         return kFALSE;
+      }
+      TReaderArgs args[ntrees];
+      std::vector<TThread*> threads;
+      for (Int_t k = 0; k < ntrees; ++k) {
+         args[k].fTree = (TTree*) f->Get(TString::Format("T%d", k));
+         args[k].fSum = -1;
+         if (!args[k].fTree) ok = kFALSE;
+      }
+      for (Int_t k = 0; ok && k < ntrees; ++k) {
+         threads.push_back(new TThread(TString::Format("reader%d", k), ReaderThread, &args[k]));
+         threads.back()->Run();
+      }
+      for (UInt_t k = 0; k < threads.size(); ++k) {
+         threads[k]->Join();
+         delete threads[k];
+      }
+      for (Int_t k = 0; k < ntrees; ++k) {
+         if (serial[k] < 0 || args[k].fSum != serial[k]) ok = kFALSE;
+      }
+      delete f;
+   }
+   return ok;
+}
+
+//______________________________________________________________________________
+void MakeMixedTree(const char *filename, Int_t nentries, Int_t compress)
+{
+   // Write the tree "U" in a file with the compression level compress. If
+   // compress is not 0, the branches u and a[n] are not compressed.
+
+   TFile f(filename, "RECREATE", "", compress);
+   TTree *t = new TTree("U", "stressTreeIO");
+   TRandom3 rnd(100);
+   Int_t i, n;
+   Double_t x, u;
+   Float_t a[10];
+   t->Branch("i", &i, "i/I");
+   t->Branch("x", &x, "x/D");
+   t->Branch("u", &u, "u/D");
+   t->Branch("n", &n, "n/I");
+   t->Branch("a", a, "a[n]/F");
+   if (compress) {
+      t->GetBranch("u")->SetCompressionLevel(0);
+      t->GetBranch("a")->SetCompressionLevel(0);
+   }
+   t->SetAutoFlush(nentries / 7 + 1);
+   for (i = 0; i < nentries; ++i) {
+      x = rnd.Gaus(0, 10);
+      u = rnd.Uniform(-5, 5);
+      n = rnd.Integer(10);
+      for (Int_t j = 0; j < n; ++j) a[j] = rnd.Uniform(0, 100);
+      t->Fill();
+   }
+   f.Write();
+   f.Close();
+   gFiles.push_back(filename);
+}
+
+//______________________________________________________________________________
+Double_t ReadMixed(TTree *t, Bool_t backward)
+{
+   // Read all the entries of a tree written by MakeMixedTree, from the
+   // last one if backward, and return a checksum of them, -1 if an entry
+   // cannot be read.
+
+   Int_t i, n;
+   Double_t x, u;
+   Float_t a[10];
+   t->SetBranchAddress("i", &i);
+   t->SetBranchAddress("x", &x);
+   t->SetBranchAddress("u", &u);
+   t->SetBranchAddress("n", &n);
+   t->SetBranchAddress("a", a);
+   Long64_t nentries = t->GetEntries();
+   Double_t sum = 0;
+   for (Long64_t k = 0; k < nentries; ++k) {
+      if (t->GetEntry(backward ? nentries - 1 - k : k) <= 0) {
+         sum = -1;
+         break;
+      }
+      sum += i + 3 * x + 7 * u + n;
+      for (Int_t j = 0; j < n; ++j) sum += (j + 1) * a[j];
+   }
+   t->ResetBranchAddresses();
+   return sum;
+}
+
+//______________________________________________________________________________
+Bool_t TestMMap(Int_t nentries)
+{
+   // Read a tree with compressed and uncompressed branches, and a tree of
+   // a file without compression, through TFile::Open(..., "MMAP") and a
+   // plain TFile: forward, backward, with the compression levels of the
+   // branches swapped (so that the baskets pointing to the mapping are
+   // reused for copied and compressed buffers and vice versa), and through
+   // a TTreeCache. The entries are the same.
+
+   Bool_t ok = kTRUE;
+   for (Int_t compress = 0; ok && compress < 2; ++compress) {
+      TString filename = TString::Format("stressTreeIO_mmap%d.root", compress);
+      MakeMixedTree(filename, nentries, compress);
+      Double_t sums[2][4];
+      for (Int_t mmap = 0; mmap < 2; ++mmap) {
+         TFile *f = TFile::Open(filename, mmap ? "MMAP" : "READ");
+         TTree *t = f ? (TTree*) f->Get("U") : 0;
+         if (!t || (mmap && !f->InheritsFrom(TMMapFile::Class()))) {
+            delete f;
+            return kFALSE;
+         }
+         sums[mmap][0] = ReadMixed(t, kFALSE);
+         sums[mmap][1] = ReadMixed(t, kTRUE);
+         TIter next(t->GetListOfBranches());
+         TBranch *branch;
+         while ((branch = (TBranch*) next())) {
+            branch->SetCompressionLevel(branch->GetCompressionLevel() ? 0 : 1);
+         }
+         sums[mmap][2] = ReadMixed(t, kFALSE);
+         t->SetCacheSize(1000000);
+         t->AddBranchToCache("*", kTRUE);
+         sums[mmap][3] = ReadMixed(t, kFALSE);
+         delete f;
+      }
+      for (Int_t k = 0; k < 4; ++k) {
+         if (sums[0][k] < 0 || sums[1][k] != sums[0][k]) ok = kFALSE;
+      }
+      if (sums[0][2] != sums[0][0] || sums[0][3] != sums[0][0]) ok = kFALSE;
+   }
+   return ok;
+}
+
+//______________________________________________________________________________
+void MakeStatsTree(const char *filename, UInt_t seed, Bool_t stats)
+{
+   // Write the tree "S" of pt, growing with the entry number, and of the
+   // array a[n], empty in the first half of the entries, in small
+   // baskets, with their ranges of values if stats.
+
+   Int_t nentries = 8000;
+   TFile f(filename, "RECREATE");
+   TTree *t = new TTree("S", "stressTreeIO");
+   TRandom3 rnd(seed);
+   Int_t n;
+   Double_t pt;
+   Float_t a[5];
+   t->Branch("pt", &pt, "pt/D");
+   t->Branch("n", &n, "n/I");
+   t->Branch("a", a, "a[n]/F");
+   t->SetBasketSize("*", 2000);
+   if (stats) t->SetBasketStats("*");
+   for (Int_t i = 0; i < nentries; ++i) {
+      pt = 100. * i / nentries + rnd.Uniform(0, 5);
+      n = i < nentries / 2 ? 0 : rnd.Integer(5);
+      for (Int_t j = 0; j < n; ++j) a[j] = rnd.Uniform(0, 100);
+      t->Fill();
+   }
+   f.Write();
+   f.Close();
+   gFiles.push_back(filename);
+}
+
+//______________________________________________________________________________
+Bool_t SameDraw(TTree *t, TTree *tr, const char *varexp, const char *selection)
+{
+   // Draw varexp with selection from the tree with basket statistics t and
+   // from tr: the same values are selected.
+
+   Long64_t n = t->Draw(varexp, selection, "goff");
+   Double_t sum = 0;
+   for (Long64_t i = 0; i < n; ++i) sum += t->GetV1()[i];
+   Long64_t nr = tr->Draw(varexp, selection, "goff");
+   Double_t sumr = 0;
+   for (Long64_t i = 0; i < nr; ++i) sumr += tr->GetV1()[i];
+   return n >= 0 && n == nr && sum == sumr;
+}
+
+//______________________________________________________________________________
+Long64_t CountReader(TTree *t, const char *filter, Double_t cut, Double_t &sum)
+{
+   // Count, and sum in sum, the values of pt above cut read by a
+   // TTreeReader, skipping the entries according to filter if not null.
+
+   TTreeReader reader(t);
+   TTreeReaderValue<Double_t> pt(reader, "pt");
+   if (filter && !reader.SetStatsFilter(filter)) return -1;
+   Long64_t n = 0;
+   sum = 0;
+   while (reader.Next()) {
+      if (*pt > cut) {
+         ++n;
+         sum += *pt;
+      }
+   }
+   return n;
+}
+
+//______________________________________________________________________________
+Bool_t SameStats(TTree *t, TTree *tr)
+{
+   // Compare the selections of t, with basket statistics, and of tr,
+   // without, through TTree::Draw and through TTreeReader.
+
+   const char *selections[] = { "pt>50", "50<pt", "pt>30 && pt<=60", "(75.5>=pt)&&n==3",
+                                "a>90", "a>90 && pt>70", "pt>200", "" };
+   Bool_t ok = kTRUE;
+   for (Int_t k = 0; selections[k][0]; ++k) {
+      ok = ok && SameDraw(t, tr, "pt", selections[k]);
+      ok = ok && SameDraw(t, tr, "a", selections[k]);
+   }
+   Double_t sum, sumr;
+   Long64_t n = CountReader(t, "50<pt", 50, sum);
+   Long64_t nr = CountReader(tr, 0, 50, sumr);
+   ok = ok && n > 0 && n == nr && sum == sumr;
+   n = CountReader(t, "pt>80", 80, sum);
+   nr = CountReader(tr, 0, 80, sumr);
+   ok = ok && n > 0 && n == nr && sum == sumr;
+   return ok;
+}
+
+//______________________________________________________________________________
+Bool_t TestBasketStats()
+{
+   // Select entries of trees with basket statistics, of a chain of them
+   // and of a fast merge of them (whose baskets have no known range), and
+   // compare with the same trees written without statistics. A filter on
+   // the statistics skips the first baskets of pt, and those of the
+   // array a with no value at all.
+
+   MakeStatsTree("stressTreeIO_s0.root", 80, kTRUE);
+   MakeStatsTree("stressTreeIO_s1.root", 81, kTRUE);
+   MakeStatsTree("stressTreeIO_r0.root", 80, kFALSE);
+   MakeStatsTree("stressTreeIO_r1.root", 81, kFALSE);
+
+   Bool_t ok = kTRUE;
+   {
+      TFile f("stressTreeIO_s0.root");
+      TFile r("stressTreeIO_r0.root");
+      TTree *t = (TTree*) f.Get("S");
+      TTree *tr = (TTree*) r.Get("S");
+      if (!t || !tr) return kFALSE;
+      ok = ok && SameStats(t, tr);
+      TTreeStatsFilter filter(t, "50<pt");
+      ok = ok && filter.IsActive() && filter.NextEntry(0) > 0 && filter.GetNSkipped() > 0;
+      TTreeStatsFilter empty(t, "a>=0");
+      ok = ok && empty.IsActive() && empty.NextEntry(0) > 0;
+   }
+
+   TChain chain("S");
+   chain.Add("stressTreeIO_s0.root");
+   chain.Add("stressTreeIO_s1.root");
+   TChain chainr("S");
+   chainr.Add("stressTreeIO_r0.root");
+   chainr.Add("stressTreeIO_r1.root");
+   ok = ok && SameStats(&chain, &chainr);
+   // The filter goes on with the next tree of the chain when the remaining
+   // baskets of a tree fail the selection.
+   Long64_t ntree = chain.GetEntries() / 2;
+   TTreeStatsFilter high(&chain, "pt>99");
+   Long64_t next = high.NextEntry(0);
+   ok = ok && next > 0 && next < ntree && high.NextEntry(ntree) > ntree;
+   TTreeStatsFilter low(&chain, "pt<5");
+   ok = ok && low.NextEntry(0) == 0 && low.NextEntry(ntree / 2) == ntree;
+
+   ok = ok && Merge("stressTreeIO_smerged.root", 2, 1, 0, -1, "stressTreeIO_s%d.root");
+   {
+      TFile f("stressTreeIO_smerged.root");
+      TTree *t = (TTree*) f.Get("S");
+      if (!t) return kFALSE;
+      ok = ok && SameStats(t, &chainr);
+   }
+   return ok;
+}
+
+//______________________________________________________________________________
+std::string ReadText(const char *filename)
+{
+   // Return the content of a text file, empty if it cannot be read.
+
+   std::string text;
+   FILE *fp = fopen(filename, "r");
+   if (!fp) return text;
+   char buf[1024];
+   size_t n;
+   while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) text.append(buf, n);
+   fclose(fp);
+   return text;
+}
+
+//______________________________________________________________________________
+Bool_t CheckBranchStats(const TTreePerfStats *ps, TTree *t, const char *name,
+                        Int_t size, Bool_t cached)
+{
+   // Check the counters of the branch name of t, whose entries of size
+   // bytes were all read: every basket was read once, from the TTreeCache
+   // if cached, and every entry was deserialized.
+
+   const TTreePerfStats::TBranchStats *stats = ps->GetBranchStats(name);
+   TBranch *branch = t->GetBranch(name);
+   if (!stats || !branch) return kFALSE;
+   Long64_t nbytes = 0;
+   for (Int_t i = 0; i < branch->GetWriteBasket(); ++i) nbytes += branch->GetBasketBytes()[i];
+   if (stats->fEntries != t->GetEntries()) return kFALSE;
+   if (stats->fBytesStreamed != size * t->GetEntries()) return kFALSE;
+   if (stats->fBasketsRead != branch->GetWriteBasket() || stats->fBytesRead != nbytes) return kFALSE;
+   if (stats->fCacheHits + stats->fCacheMisses != stats->fBasketsRead) return kFALSE;
+   if (cached ? stats->fCacheHits == 0 : stats->fCacheHits != 0) return kFALSE;
+   return stats->fBasketsUnzipped <= stats->fBasketsRead;
+}
+
+//______________________________________________________________________________
+Bool_t CheckExport(const TTreePerfStats *ps)
+{
+   // Export ps as JSON and as CSV and check that the files have the
+   // expected layout and hold the counters of each branch.
+
+   ps->Export("stressTreeIO_ps.json");
+   ps->Export("stressTreeIO_ps.csv");
+   std::string json = ReadText("stressTreeIO_ps.json");
+   std::string csv = ReadText("stressTreeIO_ps.csv");
+
+   // CSV: a header line, then one line per branch.
+   std::string header = "branch,entries,basketsread,bytesread,cachehits,cachemisses,"
+                        "basketsunzipped,bytesunzipped,unziptime,bytesstreamed,streamertime\n";
+   if (csv.compare(0, header.size(), header) != 0) return kFALSE;
+   Int_t nlines = 0;
+   for (UInt_t k = 0; k < csv.size(); ++k) {
+      if (csv[k] == '\n') ++nlines;
+   }
+   if (nlines != ps->GetNBranchStats() + 1) return kFALSE;
+
+   // JSON: one object, with balanced braces and brackets outside the
+   // strings, and the array of the branches.
+   if (json.size() < 2 || json[0] != '{' || json.compare(json.size() - 2, 2, "}\n") != 0) return kFALSE;
+   Int_t depth = 0;
+   Bool_t instring = kFALSE;
+   for (UInt_t k = 0; k < json.size(); ++k) {
+      char c = json[k];
+      if (instring) {
+         if (c == '\\') ++k;
+         else if (c == '"') instring = kFALSE;
+      } else if (c == '"') {
+         instring = kTRUE;
+      } else if (c == '{' || c == '[') {
+         ++depth;
+      } else if (c == '}' || c == ']') {
+         if (--depth < 0) return kFALSE;
+      }
+   }
+   if (depth != 0 || instring || json.find("\"branches\": [") == std::string::npos) return kFALSE;
+
+   for (Int_t i = 0; i < ps->GetNBranchStats(); ++i) {
+      const TTreePerfStats::TBranchStats *b = ps->GetBranchStats(i);
+      TString line = TString::Format("\n%s,%lld,%d,%lld,%d,%d,%d,%lld,", b->fName.Data(),
+                                     b->fEntries, b->fBasketsRead, b->fBytesRead, b->fCacheHits,
+                                     b->fCacheMisses, b->fBasketsUnzipped, b->fBytesUnzipped);
+      TString object = TString::Format("{\"name\": \"%s\", \"entries\": %lld, \"basketsread\": %d, "
+                                       "\"bytesread\": %lld, \"cachehits\": %d, \"cachemisses\": %d, "
+                                       "\"basketsunzipped\": %d, \"bytesunzipped\": %lld, ",
+                                       b->fName.Data(), b->fEntries, b->fBasketsRead, b->fBytesRead,
+                                       b->fCacheHits, b->fCacheMisses, b->fBasketsUnzipped,
+                                       b->fBytesUnzipped);
+      if (csv.find(line.Data()) == std::string::npos) return kFALSE;
+      if (json.find(object.Data()) == std::string::npos) return kFALSE;
+   }
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+Bool_t TestPerfStats(Int_t nentries)
+{
+   // Read two branches of a tree under a TTreePerfStats, without and with
+   // a TTreeCache: the counters of each branch match its baskets and
+   // entries, the branches not read have no counters, and the JSON and
+   // CSV exports hold the same counters.
+
+   MakeTree("stressTreeIO_ps.root", nentries, 120);
+   gFiles.push_back("stressTreeIO_ps.json");
+   gFiles.push_back("stressTreeIO_ps.csv");
+   Bool_t ok = kTRUE;
+   for (Int_t cached = 0; ok && cached < 2; ++cached) {
+      TFile f("stressTreeIO_ps.root");
+      TTree *t = (TTree*) f.Get("T");
+      if (!t) return kFALSE;
+      Int_t i;
+      Double_t x;
+      t->SetBranchStatus("*", 0);
+      t->SetBranchStatus("i", 1);
+      t->SetBranchStatus("x", 1);
+      t->SetBranchAddress("i", &i);
+      t->SetBranchAddress("x", &x);
+      t->SetCacheSize(cached ? 1000000 : 0);
+      if (cached) {
+         t->AddBranchToCache("i");
+         t->AddBranchToCache("x");
+         t->StopCacheLearningPhase();
+      }
+      TTreePerfStats *ps = new TTreePerfStats("ioperf", t);
+      for (Long64_t entry = 0; entry < t->GetEntries(); ++entry) {
+         if (t->GetEntry(entry) <= 0) ok = kFALSE;
+      }
+      ok = ok && ps->GetNBranchStats() == 2 && !ps->GetBranchStats("y")
+           && CheckBranchStats(ps, t, "i", sizeof(Int_t), cached)
+           && CheckBranchStats(ps, t, "x", sizeof(Double_t), cached)
+           && ps->GetBranchStats("i")->fBasketsUnzipped > 0
+           && CheckExport(ps);
+      delete ps;
+   }
+   return ok;
+}
+
+//______________________________________________________________________________
+char NetByte(Int_t k, Int_t b, Int_t i)
+{
+   // Byte i of the buffer b of the message k sent by NetSender.
+
+   return (char) (i * 7 + k * 13 + b);
+}
+
+// Sizes of the buffers sent by NetSender, going up and down.
+static const Int_t gNetSizes[] = {0, 17, 100000, 1000, 3000000, 5};
+static const Int_t gNetNSizes = sizeof(gNetSizes) / sizeof(Int_t);
+static const Int_t gNetNMessages = 4 * gNetNSizes;
+static const Int_t gNetRawSizes[] = {10, 200000, 1};
+
+// Connected socket used by NetSender, and whether all was sent.
+struct TNetArgs {
+   TSocket *fSocket;
+   Bool_t   fOk;
+};
+
+//______________________________________________________________________________
+void *NetSender(void *arg)
+{
+   // Send gNetNMessages messages with TSocket::SendBuffers: an integer in
+   // the message followed by two buffers, compressed or not and with or
+   // without acknowledgement. Then send three raw buffers in one call of
+   // TSystem::SendRawBuffers.
+
+   TNetArgs *args = (TNetArgs*) arg;
+   for (Int_t k = 0; k < gNetNMessages; ++k) {
+      Int_t mode = k / gNetNSizes;
+      Int_t lengths[2] = {gNetSizes[k % gNetNSizes], gNetSizes[k % gNetNSizes] / 3 + 1};
+      std::vector<char> data[2];
+      const char *buffers[2];
+      for (Int_t b = 0; b < 2; ++b) {
+         data[b].resize(lengths[b] + 1);
+         for (Int_t i = 0; i < lengths[b]; ++i) data[b][i] = NetByte(k, b, i);
+         buffers[b] = &data[b][0];
+      }
+      TMessage mess((mode & 2) ? kMESS_ANY | kMESS_ACK : kMESS_ANY);
+      mess.SetCompressionLevel(mode & 1);
+      mess << k;
+      if (args->fSocket->SendBuffers(mess, 2, buffers, lengths) <= 0) {
+         args->fOk = kFALSE;
+         return 0;
+      }
+   }
+   std::vector<char> data[3];
+   const char *buffers[3];
+   Int_t total = 0;
+   for (Int_t b = 0; b < 3; ++b) {
+      data[b].resize(gNetRawSizes[b]);
+      for (Int_t i = 0; i < gNetRawSizes[b]; ++i) data[b][i] = NetByte(gNetNMessages, b, i);
+      buffers[b] = &data[b][0];
+      total += gNetRawSizes[b];
+   }
+   if (gSystem->SendRawBuffers(args->fSocket->GetDescriptor(), 3, buffers, gNetRawSizes) != total)
+      args->fOk = kFALSE;
+   return 0;
+}
+
+//______________________________________________________________________________
+Bool_t TestSocketBuffers()
+{
+   // Receive on localhost the messages and raw buffers of NetSender:
+   // the messages with TSocket::RecvReuse reusing one TMessage, whose
+   // size goes up and down, and the raw buffers with RecvRaw. All the
+   // bytes are the ones sent.
+
+   TServerSocket ss(0, kTRUE);
+   if (!ss.IsValid()) return kFALSE;
+   // The connection is established before Accept, which does not block.
+   TSocket client("localhost", ss.GetLocalPort());
+   if (!client.IsValid()) return kFALSE;
+   TSocket *sock = ss.Accept();
+   if (!sock || sock == (TSocket*) -1) return kFALSE;
+
+   TNetArgs args;
+   args.fSocket = &client;
+   args.fOk = kTRUE;
+   TThread sender("netsender", NetSender, &args);
+   sender.Run();
+
+   Bool_t ok = kTRUE;
+   TMessage *mess = 0;
+   std::vector<char> buf;
+   for (Int_t k = 0; ok && k < gNetNMessages; ++k) {
+      if (sock->RecvReuse(mess) <= 0 || !mess || mess->What() != kMESS_ANY) {
+         ok = kFALSE;
+         break;
+      }
+      Int_t kk = -1;
+      *mess >> kk;
+      ok = (kk == k);
+      Int_t lengths[2] = {gNetSizes[k % gNetNSizes], gNetSizes[k % gNetNSizes] / 3 + 1};
+      for (Int_t b = 0; ok && b < 2; ++b) {
+         buf.resize(lengths[b] + 1);
+         mess->ReadFastArray(&buf[0], lengths[b]);
+         for (Int_t i = 0; ok && i < lengths[b]; ++i) ok = (buf[i] == NetByte(k, b, i));
+      }
+      // Nothing after the buffers.
+      if (ok && mess->Length() != mess->BufferSize()) ok = kFALSE;
+      if (!ok) printf("TSocket::RecvReuse: message %d differs\n", k);
+   }
+   for (Int_t b = 0; ok && b < 3; ++b) {
+      buf.resize(gNetRawSizes[b]);
+      if (sock->RecvRaw(&buf[0], gNetRawSizes[b]) != gNetRawSizes[b]) ok = kFALSE;
+      for (Int_t i = 0; ok && i < gNetRawSizes[b]; ++i) ok = (buf[i] == NetByte(gNetNMessages, b, i));
+   }
+   sender.Join();
+   delete mess;
+   sock->Close();
+   delete sock;
+   client.Close();
+   return ok && args.fOk;
+}
+
+// Functors and jobs of TestScheduler.
+struct TSquares {
+   std::vector<Long64_t> *fX;
+   void operator()(Long64_t first, Long64_t last) {
+      for (Long64_t i = first; i < last; ++i) (*fX)[i] = i * i;
+   }
+};
+
+struct TSumRange {
+   Long64_t operator()(Long64_t first, Long64_t last) {
+      Long64_t s = 0;
+      for (Long64_t i = first; i < last; ++i) s += i;
+      return s;
+   }
+};
+
+struct TAdd {
+   Long64_t operator()(Long64_t a, Long64_t b) const { return a + b; }
+};
+
+static TMutex gInsideMutex;
+static std::map<Long_t, Int_t> gInside; // thread -> outer job waiting for its inner jobs
+static Int_t gNestingErrors = 0;
+
+class TInnerJob : public TTaskScheduler::TJob {
+   // Check that the thread running the job is not waiting for the inner
+   // jobs of another outer job.
+   Int_t  fOuter;
+   Int_t *fCount;
+public:
+   TInnerJob(Int_t outer, Int_t *count) : fOuter(outer), fCount(count) { }
+   virtual void Execute() {
+      gSystem->Sleep(1);
+      TLockGuard lock(&gInsideMutex);
+      std::map<Long_t, Int_t>::iterator it = gInside.find(TThread::SelfId());
+      if (it != gInside.end() && it->second != fOuter) ++gNestingErrors;
+      ++(*fCount);
+   }
+};
+
+class TOuterJob : public TTaskScheduler::TJob {
+   // Run inner jobs in a group of its own and wait for them.
+   TTaskScheduler *fScheduler;
+   Int_t           fOuter;
+public:
+   TOuterJob(TTaskScheduler *scheduler, Int_t outer) : fScheduler(scheduler), fOuter(outer) { }
+   virtual void Execute() {
+      Long_t self = TThread::SelfId();
+      {
+         TLockGuard lock(&gInsideMutex);
+         if (gInside.count(self)) ++gNestingErrors;
+         gInside[self] = fOuter;
+      }
+      Int_t count = 0;
+      TTaskGroup group(fScheduler);
+      for (Int_t j = 0; j < 20; ++j) group.Run(new TInnerJob(fOuter, &count));
+      group.Wait();
+      TLockGuard lock(&gInsideMutex);
+      gInside.erase(self);
+      if (count != 20) ++gNestingErrors;
+   }
+};
+
+class TSquareTask : public TThreadPoolTaskImp<TSquareTask, Int_t> {
+   // Task of TThreadPool adding the square of its argument to fSum.
+public:
+   TMutex   fMutex;
+   Long64_t fSum;
+   TSquareTask() : fSum(0) { }
+   bool runTask(Int_t &i) {
+      TLockGuard lock(&fMutex);
+      fSum += i * i;
+      return true;
+   }
+};
+
+//______________________________________________________________________________
+Bool_t TestScheduler()
+{
+   // Run ParallelFor and ParallelReduce on a scheduler of four threads,
+   // jobs waiting for inner groups of jobs (a waiting thread only runs
+   // the jobs of the group it waits for), and tasks of a TThreadPool
+   // growing while the tasks run.
+
+   const Long64_t n = 100000;
+   TTaskScheduler sched(4);
+   std::vector<Long64_t> x(n, -1);
+   TSquares squares;
+   squares.fX = &x;
+   sched.ParallelFor(0, n, squares);
+   Bool_t ok = kTRUE;
+   for (Long64_t i = 0; i < n; ++i) {
+      if (x[i] != i * i) ok = kFALSE;
+   }
+   TSumRange sum;
+   ok = ok && sched.ParallelReduce(0, n, (Long64_t)0, sum, TAdd()) == n * (n - 1) / 2;
+   ok = ok && sched.ParallelReduce(0, n, (Long64_t)5, sum, TAdd(), 7) == n * (n - 1) / 2 + 5;
+   ok = ok && sched.ParallelReduce(3, 3, (Long64_t)5, sum, TAdd()) == 5;
+
+   {
+      TTaskGroup group(&sched);
+      for (Int_t k = 0; k < 16; ++k) group.Run(new TOuterJob(&sched, k));
+      group.Wait();
+      ok = ok && gNestingErrors == 0 && group.GetNPending() == 0;
+   }
+
+   TSquareTask task;
+   Long64_t expected = 0;
+   TThreadPool<TSquareTask, Int_t> pool(2);
+   for (Int_t i = 0; i < 200; ++i) {
+      if (i == 100) pool.AddThread();
+      pool.PushTask(task, i);
+      expected += i * i;
+   }
+   pool.Stop(true);
+   ok = ok && pool.TasksCount() == 200 && pool.SuccessfulTasks() == 200 && task.fSum == expected;
+   return ok;
+}
+
+//______________________________________________________________________________
+Int_t stressTreeIO(Int_t nentries)
+{
+   printf("**********************************************************************\n");
+   printf("******************Starting tree I/O stress test***********************\n");
+   printf("**********************************************************************\n");
+
+   Report("TTreeProcessor: entries processed and missing file", TestProcessor(nentries));
+   Report("TFileMerger: threads and memory limit", TestMergerOptions(nentries));
+   Report("TFileMerger: serial and parallel merge of seven files", TestParallelMerge(nentries));
+   Report("TFileMerger: fast merge with recompression", TestRecompress(nentries));
+   Report("TTree::LoadColumns: in-memory and file trees", TestColumns(nentries));
+   Report("TBranch::GetBulkEntries: bulk and serialized reads", TestBulkRead(nentries));
+   Report("Member-wise collections: bulk reads and conversions", TestMemberWise(nentries));
+   Report("TTreeBlockIndex: index written twice and read back", TestBlockIndex(nentries));
+   Report("TTreeTuningProfile: profile saved and applied to a tree", TestTuningProfile(nentries));
+   Report("TTreeFormula::Jit: compiled and interpreted formulas", TestFormulaJit(nentries));
+   Report("TTreeCacheUnzip: parallel unzipping, with and without prefetching", TestParallelUnzip(nentries));
+   Report("TTree::SetParallelCompression: same baskets as serial", TestParallelCompression(nentries));
+   Report("TFilePrefetch: local prefetching and failed blocks", TestPrefetch(nentries));
+   Report("TTaskScheduler: parallel loops, nested groups and TThreadPool", TestScheduler());
+   Report("TFile::SetConcurrentRead: threads reading TFile and TMMapFile", TestConcurrentRead(nentries));
+   Report("TMMapFile: mapped and copied baskets, reused", TestMMap(nentries));
+   Report("TTreeStatsFilter: Draw and TTreeReader with basket statistics", TestBasketStats());
+   Report("TTreePerfStats: branch counters, JSON and CSV export", TestPerfStats(nentries));
+   Report("TSocket: SendBuffers, RecvReuse and TSystem::SendRawBuffers", TestSocketBuffers());
+
+   printf("**********************************************************************\n");
+   printf("*******************Deleting the data files****************************\n");
+   printf("**********************************************************************\n");
+   for (UInt_t i = 0; i < gFiles.size(); ++i) gSystem->Unlink(gFiles[i].c_str());
+   return 0;
+}
+
+//_____________________________batch only_____________________
+#ifndef __CINT__
+
+int main(int argc, char *argv[])
+{
+   TApplication theApp("App", &argc, argv);
+   Int_t nentries = 10000;
+   if (argc > 1) nentries = atoi(argv[1]);
+   stressTreeIO(nentries);
+   return 0;
+}
+
+#endif
@@ -0,0 +1,103 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// Classes of stressTreeIO needing a dictionary: the selectors run by
+// TTreeProcessor, which creates one instance per thread via TClass::New,
+// and the elements of the collections streamed member-wise.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef STRESSTREEIO_H
+#define STRESSTREEIO_H
+
+#include "TH1.h"
+#include "TObject.h"
+#include "TSelector.h"
+#include "TSystem.h"
+#include "TTree.h"
+
+class TCountSelector : public TSelector {
+   // Fill the histogram "hx" of x and, weighted by i, the one bin
+   // histogram "hn": its entries count the entries processed and its
+   // sum of weights is the sum of i.
+public:
+   TTree   *fTree;
+   Int_t    fI;
+   Double_t fX;
+   TCountSelector() : fTree(0), fI(0), fX(0) { }
+   virtual Int_t  Version() const { return 2; }
+   virtual void   Init(TTree *tree) {
+      fTree = tree;
+      tree->SetBranchAddress("i", &fI);
+      tree->SetBranchAddress("x", &fX);
+   }
+   virtual void   SlaveBegin(TTree *) {
+      TH1 *hx = new TH1D("hx", "x", 100, -50, 50);
+      TH1 *hn = new TH1D("hn", "i", 1, 0, 1);
+      hx->SetDirectory(0);
+      hn->SetDirectory(0);
+      fOutput->Add(hx);
+      fOutput->Add(hn);
+   }
+   virtual Bool_t Process(Long64_t entry) {
+      fTree->GetEntry(entry);
+      ((TH1*)fOutput->FindObject("hx"))->Fill(fX);
+      ((TH1*)fOutput->FindObject("hn"))->Fill(0.5, fI);
+      return kTRUE;
+   }
+
+   ClassDef(TCountSelector,0) // Selector of the TTreeProcessor test
+};
+
+class TUnlinkSelector : public TCountSelector {
+   // Remove the file named by the option in Begin, once TTreeProcessor
+   // has split the entries but before the threads open the files.
+public:
+   virtual void   Begin(TTree *) { gSystem->Unlink(GetOption()); }
+
+   ClassDef(TUnlinkSelector,0) // Selector removing a file of the chain being processed
+};
+
+class TBulkElem {
+   // Element of the collections streamed member-wise: data members of
+   // basic types of all sizes.
+public:
+   Int_t    fI;
+   Double_t fX;
+   Float_t  fF;
+   Int_t    fS;
+   Char_t   fC;
+   TBulkElem() : fI(0), fX(0), fF(0), fS(0), fC(0) { }
+   virtual ~TBulkElem() { }
+
+   ClassDef(TBulkElem,1) // Element of the member-wise streamed vectors
+};
+
+class TBulkElemOld {
+   // Former layout of TBulkElem (see the read rule in the LinkDef): fX
+   // and fS are converted from Float_t and Short_t when read.
+public:
+   Int_t    fI;
+   Float_t  fX;
+   Float_t  fF;
+   Short_t  fS;
+   Char_t   fC;
+   TBulkElemOld() : fI(0), fX(0), fF(0), fS(0), fC(0) { }
+   virtual ~TBulkElemOld() { }
+
+   ClassDef(TBulkElemOld,1) // Former layout of TBulkElem
+};
+
+class TBulkObj : public TObject {
+   // Element of the split TClonesArray, with the data members of TBulkElem.
+public:
+   Int_t    fI;
+   Double_t fX;
+   Float_t  fF;
+   Int_t    fS;
+   Char_t   fC;
+   TBulkObj() : fI(0), fX(0), fF(0), fS(0), fC(0) { }
+
+   ClassDef(TBulkObj,1) // Element of the member-wise streamed TClonesArray
+};
+
+#endif
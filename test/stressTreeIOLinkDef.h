@@ -0,0 +1,17 @@
+#ifdef __CINT__
+
+#pragma link off all globals;
+#pragma link off all classes;
+#pragma link off all functions;
+
+#pragma link C++ class TCountSelector+;
+#pragma link C++ class TUnlinkSelector+;
+#pragma link C++ class TBulkElem+;
+#pragma link C++ class TBulkElemOld+;
+#pragma link C++ class TBulkObj+;
+#pragma link C++ class std::vector<TBulkElem>+;
+#pragma link C++ class std::vector<TBulkElemOld>+;
+
+#pragma read sourceClass="TBulkElemOld" targetClass="TBulkElem";
+
+#endif
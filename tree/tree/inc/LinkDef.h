@@ -29,7 +29,7 @@
 #pragma link C++ class TEntryList-;
 #pragma link C++ class TEntryListArray+;
 #pragma link C++ class TEntryListFromFile+;
-#pragma link C++ class TEntryListBlock+;
+#pragma link C++ class TEntryListBlock-;
 #pragma link C++ class TEventList-;
 #pragma link C++ class TFriendElement+;
 #pragma link C++ class TTreeFriendLeafIter;
@@ -53,6 +53,8 @@
 #pragma link C++ class TTreeCloner+;
 #pragma link C++ class TTreeCache+;
 #pragma link C++ class TTreeCacheUnzip+;
+#pragma link C++ class TTreeTuningProfile+;
+#pragma link C++ class TTreeTuningProfile::TBranchProfile+;
 #pragma link C++ class TVirtualTreePlayer;
 #pragma link C++ class TVirtualIndex+;
 #pragma link C++ class TTreeResult+;
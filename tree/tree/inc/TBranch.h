@@ -91,6 +91,8 @@ protected:
    Int_t      *fBasketBytes;     //[fMaxBaskets] Length of baskets on file
    Long64_t   *fBasketEntry;     //[fMaxBaskets] Table of first entry in each basket
    Long64_t   *fBasketSeek;      //[fMaxBaskets] Addresses of baskets on file
+   Double_t   *fBasketMin;       //[fMaxBaskets] Smallest value of the leaf in each basket (0 if not recorded, see SetBasketStats)
+   Double_t   *fBasketMax;       //[fMaxBaskets] Largest value of the leaf in each basket (0 if not recorded)
    TTree      *fTree;            //! Pointer to Tree header
    TBranch    *fMother;          //! Pointer to top-level parent branch in the tree.
    TBranch    *fParent;          //! Pointer to parent branch.
@@ -99,6 +101,8 @@ protected:
    TString     fFileName;        //  Name of file where buffers are stored ("" if in same file as Tree header)
    TBuffer    *fEntryBuffer;     //! Buffer used to directly pass the content without streaming
    TList      *fBrowsables;      //! List of TVirtualBranchBrowsables used for Browse()
+   char      **fColumns;         //! In-memory column (native values of all entries) of each leaf, see LoadColumns
+   Int_t      *fColumnLen;       //! Number of bytes per entry in each column
 
    Bool_t      fSkipZip;         //! After being read, the buffer will not be unziped.
 
@@ -116,9 +120,13 @@ protected:
    void     Init(const char *name, const char *leaflist, Int_t compress);
 
    TBasket *GetFreshBasket();
+   TBasket *GetBasketForEntry(Long64_t entry);
+   Int_t    ReadBulkEntries(Long64_t entry, TBuffer &user_buf, Bool_t hostorder);
    Int_t    WriteBasket(TBasket* basket, Int_t where);
    
    TString  GetRealFileName() const;
+   void     ResetBasketStats(Int_t first);
+   void     UpdateBasketStats(TBasket *basket);
 
 private:
    Int_t FillEntryBuffer(TBasket* basket,TBuffer* buf, Int_t& lnew);
@@ -136,6 +144,7 @@ public:
    virtual void      Browse(TBrowser *b);
    virtual void      DeleteBaskets(Option_t* option="");
    virtual void      DropBaskets(Option_t *option = "");
+           void      DropColumns();
            void      ExpandBasketArrays();
    virtual Int_t     Fill();
    virtual TBranch  *FindBranch(const char *name);
@@ -147,6 +156,9 @@ public:
            TBasket  *GetBasket(Int_t basket);
            Int_t    *GetBasketBytes() const {return fBasketBytes;}
            Long64_t *GetBasketEntry() const {return fBasketEntry;}
+           Double_t *GetBasketMax() const {return fBasketMax;}
+           Double_t *GetBasketMin() const {return fBasketMin;}
+           Bool_t    GetBasketRange(Int_t basket, Double_t &min, Double_t &max) const;
    virtual Long64_t  GetBasketSeek(Int_t basket) const;
    virtual Int_t     GetBasketSize() const {return fBasketSize;}
    virtual TList    *GetBrowsables();
@@ -155,6 +167,8 @@ public:
            Int_t     GetCompressionLevel() const;
            Int_t     GetCompressionSettings() const;
    TDirectory       *GetDirectory() const {return fDirectory;}
+   virtual Int_t     GetBulkEntries(Long64_t entry, TBuffer &user_buf);
+   virtual Int_t     GetEntriesSerialized(Long64_t entry, TBuffer &user_buf);
    virtual Int_t     GetEntry(Long64_t entry=0, Int_t getall = 0);
    virtual Int_t     GetEntryExport(Long64_t entry, Int_t getall, TClonesArray *list, Int_t n);
            Int_t     GetEntryOffsetLen() const { return fEntryOffsetLen; }
@@ -185,10 +199,15 @@ public:
    virtual Bool_t    GetMakeClass() const;
    TBranch          *GetMother() const;
    TBranch          *GetSubBranch(const TBranch *br) const;
+   Bool_t            HasBasketStats() const { return fBasketMin != 0; }
+   Bool_t            HasColumns() const { return fColumns != 0; }
    Bool_t            IsAutoDelete() const;
+   virtual Bool_t    IsBulkReadable() const;
+   virtual Bool_t    IsColumnReadable() const;
    Bool_t            IsFolder() const;
    virtual void      KeepCircular(Long64_t maxEntries);
    virtual Int_t     LoadBaskets();
+   virtual Bool_t    LoadColumns();
    virtual void      Print(Option_t *option="") const;
    virtual void      ReadBasket(TBuffer &b);
    virtual void      Refresh(TBranch *b);
@@ -200,6 +219,7 @@ public:
    virtual void      SetObject(void *objadd);
    virtual void      SetAutoDelete(Bool_t autodel=kTRUE);
    virtual void      SetBasketSize(Int_t buffsize);
+   virtual Bool_t    SetBasketStats(Bool_t on = kTRUE);
    virtual void      SetBufferAddress(TBuffer *entryBuffer);
    void              SetCompressionAlgorithm(Int_t algorithm=0);
    void              SetCompressionLevel(Int_t level=1);
@@ -219,7 +239,7 @@ public:
 
    static  void      ResetCount();
 
-   ClassDef(TBranch,12);  //Branch descriptor
+   ClassDef(TBranch,13);  //Branch descriptor
 };
 
 //______________________________________________________________________________
@@ -14,11 +14,13 @@
 //
 // Used internally in TEntryList to store the entry numbers. 
 //
-// There are 2 ways to represent entry numbers in a TEntryListBlock:
+// There are 3 ways to represent entry numbers in a TEntryListBlock:
 // 1) as bits, where passing entry numbers are assigned 1, not passing - 0
 // 2) as a simple array of entry numbers
-// In both cases, a UShort_t* is used. The second option is better in case
-// less than 1/16 of entries passes the selection, and the representation can be
+// 3) as runs of consecutive entry numbers (first and last of each run)
+// In all cases, a UShort_t* is used. The second option is better in case
+// less than 1/16 of entries passes the selection, the third one when the
+// passing entries are grouped, and the representation can be
 // changed by calling OptimizeStorage() function. 
 // When the block is being filled, it's always stored as bits, and the OptimizeStorage()
 // function is called by TEntryList when it starts filling the next block. If
@@ -29,6 +31,7 @@
 // - Merge() - adds all entries from one block to the other. If the first block 
 //             uses array representation, it's changed to bits representation only
 //             if the total number of passing entries is still less than kBlockSize
+// - Subtract() - removes from one block the entries of the other.
 // - GetEntry(n) - returns n-th non-zero entry.
 // - Next()      - return next non-zero entry. In case of representation 1), Next()
 //                 is faster than GetEntry()
@@ -49,14 +52,20 @@ class TEntryListBlock:public TObject
                          //not in the entry list
    Int_t    fN;          //size of fIndices for I/O  =fNPassed for list, fBlockSize for bits
    UShort_t *fIndices;   //[fN]
-   Int_t    fType;       //0 - bits, 1 - list
+   Int_t    fType;       //0 - bits, 1 - list, 2 - runs (in memory only)
    Bool_t   fPassing;    //1 - stores entries that belong to the list
                          //0 - stores entries that don't belong to the list
-   UShort_t fCurrent;    //! to fasten  Contains() in list mode
+   UShort_t fCurrent;    //! to fasten  Contains() in list mode and Next() in runs mode
    Int_t    fLastIndexQueried; //! to optimize GetEntry() in a loop
    Int_t    fLastIndexReturned; //! to optimize GetEntry() in a loop
 
    void Transform(Bool_t dir, UShort_t *indexnew);
+   void TransformToRuns();
+   void FillBits(UShort_t *bits) const;
+   void Optimize(Bool_t runs);
+
+   static Int_t CountBits(const UShort_t *bits);
+   static Int_t CountRuns(const UShort_t *bits);
 
  public:
 
@@ -71,6 +80,7 @@ class TEntryListBlock:public TObject
    Int_t   Contains(Int_t entry);
    void    OptimizeStorage();
    Int_t   Merge(TEntryListBlock *block);
+   Int_t   Subtract(TEntryListBlock *block);
    Int_t   Next();
    Int_t   GetEntry(Int_t entry);
    void    ResetIndices() {fLastIndexQueried = -1, fLastIndexReturned = -1;}
@@ -29,14 +29,16 @@
 #include "TTreeCache.h"
 #endif
 
-#include <queue>
+#include <vector>
 
 class TTree;
 class TBranch;
-class TThread;
 class TCondition;
+class TTaskGroup;
 class TBasket;
 class TMutex;
+class TAtomicCount;
+class TTreeCacheUnzipBlock;
 
 class TTreeCacheUnzip : public TTreeCache {
 public:
@@ -47,26 +49,31 @@ public:
 protected:
 
    // Members for paral. managing
-   TThread    *fUnzipThread[10];
+   TTaskGroup *fUnzipGroup;            //! Jobs of the task scheduler unzipping the blocks
+   Int_t       fNThreads;              //! Maximum number of jobs unzipping at once
+   Int_t       fNJobs;                 //! Number of unzipping jobs queued or running
    Bool_t      fActiveThread;          // Used to terminate gracefully the unzippers
-   TCondition *fUnzipStartCondition;   // Used to signal the threads to start.
-   TCondition *fUnzipDoneCondition;    // Used to wait for an unzip tour to finish. Gives the Async feel.
+   TCondition *fUnzipDoneCondition;    // Used to signal that the threads unzipped a block.
    Bool_t      fParallel;              // Indicate if we want to activate the parallelism (for this instance)
    Bool_t      fAsyncReading;
-   TMutex     *fMutexList;             // Mutex to protect the various lists. Used by the condvars.
+   TMutex     *fMutexList;             // Protects the task counters below. Used by the condvars.
    TMutex     *fIOMutex;
 
    Int_t       fCycle;
    static TTreeCacheUnzip::EParUnzipMode fgParallel;  // Indicate if we want to activate the parallelism
+   static Int_t fgNThreads;            // Number of unzipping threads (0: one per core)
 
-   Int_t       fLastReadPos;
-   Int_t       fBlocksToGo;
+   // Task counters, protected by fMutexList
+   Int_t       fNTasks;           //! Number of blocks the threads may unzip in this cycle
+   Int_t       fNextTask;         //! Index of the next block to be taken by a thread
+   Int_t       fNRunning;         //! Number of blocks being unzipped by the threads
 
-   // Unzipping related members
+   // Unzipping related members, indexed like fSeekSort
+   TTreeCacheUnzipBlock *fUnzipBlocks; //! [fNseek] Ownership and status of each block
    Int_t      *fUnzipLen;         //! [fNseek] Length of the unzipped buffers
    char      **fUnzipChunks;      //! [fNseek] Individual unzipped chunks. Their summed size is kept under control.
-   Byte_t     *fUnzipStatus;      //! [fNSeek] For each blk, tells us if it's unzipped or pending
-   Long64_t    fTotalUnzipBytes;  //! The total sum of the currently unzipped blks
+   TAtomicCount *fUnzipBytes;     //! The total sum of the currently unzipped blks
+   TAtomicCount *fNWaiting;       //! Number of jobs stopped until the unzipped blks are consumed
 
    Int_t       fNseekMax;         //!  fNseek can change so we need to know its max size
    Long64_t    fUnzipBufferSize;  //!  Max Size for the ready unzipped blocks (default is 2*fBufferSize)
@@ -79,8 +86,6 @@ protected:
    Int_t       fNStalls;          //! number of hits which caused a stall
    Int_t       fNMissed;          //! number of blocks that were not found in the cache and were unzipped
 
-   std::queue<Int_t>       fActiveBlks; // The blocks which are active now
-
 private:
    TTreeCacheUnzip(const TTreeCacheUnzip &);            //this class cannot be copied
    TTreeCacheUnzip& operator=(const TTreeCacheUnzip &);
@@ -92,6 +97,10 @@ private:
    void  Init();
    Int_t StartThreadUnzip(Int_t nthreads);
    Int_t StopThreadUnzip();
+   void  ScheduleUnzip();
+   void  StartUnzipJobs(Int_t njobs);
+   void  WaitUnzipIdle();
+   Int_t TakeUnzipped(Int_t loc, char **buf, Bool_t *free);
 
 public:
    TTreeCacheUnzip();
@@ -102,18 +111,20 @@ public:
    Bool_t              FillBuffer();
    virtual Int_t       ReadBufferExt(char *buf, Long64_t pos, Int_t len, Int_t &loc);
    void                SetEntryRange(Long64_t emin,   Long64_t emax);
+   virtual void        SetFile(TFile *file, TFile::ECacheAction action=TFile::kDisconnect);
    virtual void        StopLearningPhase();
    void                UpdateBranches(TTree *tree);
 
    // Methods related to the thread
    static EParUnzipMode GetParallelUnzip();
+   static Int_t         GetUnzipThreads();
    static Bool_t        IsParallelUnzip();
    static Int_t         SetParallelUnzip(TTreeCacheUnzip::EParUnzipMode option = TTreeCacheUnzip::kEnable);
+   static void          SetUnzipThreads(Int_t nthreads);
 
    Bool_t               IsActiveThread();
    Bool_t               IsQueueEmpty();
 
-   void                 WaitUnzipStartSignal();
    void                 SendUnzipStartSignal(Bool_t broadcast);
 
    // Unzipping related methods
@@ -123,12 +134,13 @@ public:
    void           SetUnzipBufferSize(Long64_t bufferSize);
    static void    SetUnzipRelBufferSize(Float_t relbufferSize);
    Int_t          UnzipBuffer(char **dest, char *src);
-   Int_t          UnzipCache(Int_t &startindex, Int_t &locbuffsz, char *&locbuff);
+   Int_t          UnzipCache(Int_t loc);
 
    // Methods to get stats
    Int_t  GetNUnzip() { return fNUnzip; }
    Int_t  GetNFound() { return fNFound; }
    Int_t  GetNMissed(){ return fNMissed; }
+   Int_t  GetNStalls(){ return fNStalls; }
 
    void Print(Option_t* option = "") const;
 
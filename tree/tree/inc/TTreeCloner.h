@@ -60,6 +60,7 @@ class TTreeCloner {
 
    UInt_t     fCloneMethod;      //Indicates which cloning method was selected.
    Long64_t   fToStartEntries;   //Number of entries in the target tree before any addition.
+   Bool_t     fRecompress;       //True if the baskets are recompressed with the settings of the output branches.
 
    enum ECloneMethod {
       kDefault             = 0,
@@ -86,6 +87,7 @@ class TTreeCloner {
    friend class CompareEntry;
    
    void ImportClusterRanges();
+   void WriteBasketsRecompressed();
 
 private:
    TTreeCloner(const TTreeCloner&);            // Not implemented.
@@ -111,6 +113,7 @@ public:
    void   CopyProcessIds();
    const char *GetWarning() const { return fWarningMsg; }
    Bool_t Exec();
+   Bool_t IsRecompressing() const { return fRecompress; }
    Bool_t IsValid() { return fIsValid; }
    Bool_t NeedConversion() { return fNeedConversion; }
    void   SortBaskets();
@@ -0,0 +1,84 @@
+// @(#)root/tree:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#ifndef ROOT_TTreeTuningProfile
+#define ROOT_TTreeTuningProfile
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TTreeTuningProfile                                                   //
+//                                                                      //
+// Which branches of a tree were read by an analysis, and how large     //
+// their entries are; used by TTree::SetTuningProfile to choose the     //
+// cluster size, the basket sizes and the order of the baskets on disk  //
+// when writing the next version of the tree.                           //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef ROOT_TNamed
+#include "TNamed.h"
+#endif
+
+#include <vector>
+
+class TBranch;
+class TCollection;
+class TTree;
+
+class TTreeTuningProfile : public TNamed {
+
+public:
+   class TBranchProfile {
+      // Read pattern and size of one branch.
+   public:
+      TBranchProfile() : fEntriesRead(0), fBytesPerEntry(0), fZipBytesPerEntry(0) {}
+
+      TString  fName;             // Name of the branch
+      Long64_t fEntriesRead;      // Number of entries read
+      Double_t fBytesPerEntry;    // Average size of an entry (uncompressed)
+      Double_t fZipBytesPerEntry; // Average size of an entry on file
+   };
+
+protected:
+   TString                     fTreeName;    // Name of the tree profiled
+   Long64_t                    fCacheSize;   // Size on file of the hot branches in a cluster
+   Long64_t                    fMaxMemory;   // Maximum size in memory of all the baskets of a cluster
+   std::vector<TBranchProfile> fBranches;    // Profile of each branch
+   TTree                      *fTree;        //! Tree being profiled
+
+   TBranchProfile       *FindBranch(const char *name);
+   const TBranchProfile *FindBranch(const char *name) const;
+   Long64_t              GetMaxEntriesRead() const;
+
+public:
+   TTreeTuningProfile();
+   TTreeTuningProfile(const char *name, TTree *tree);
+   virtual ~TTreeTuningProfile();
+
+   Int_t             AddCachedBranches();
+   void              AddRead(const char *branchname, Long64_t nentries);
+   Int_t             GetBasketSize(const TBranch *branch) const;
+   Long64_t          GetCacheSize() const { return fCacheSize; }
+   Long64_t          GetClusterSize() const;
+   Long64_t          GetMaxMemory() const { return fMaxMemory; }
+   Int_t             GetNBranches() const { return (Int_t)fBranches.size(); }
+   const TBranchProfile *GetBranchProfile(Int_t i) const { return (i >= 0 && i < GetNBranches()) ? &fBranches[i] : 0; }
+   TTree            *GetTree() const { return fTree; }
+   const char       *GetTreeName() const { return fTreeName.Data(); }
+   Bool_t            IsHot(const char *branchname) const;
+   virtual Long64_t  Merge(TCollection *list);
+   virtual void      Print(Option_t *option="") const;
+   void              SetCacheSize(Long64_t size) { fCacheSize = size; }
+   void              SetMaxMemory(Long64_t size) { fMaxMemory = size; }
+
+   ClassDef(TTreeTuningProfile,1); //Read pattern of a tree, used to tune the layout of the next version of the tree
+};
+
+#endif
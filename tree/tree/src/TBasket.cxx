@@ -49,7 +49,7 @@ ClassImp(TBasket)
 //
 
 //_______________________________________________________________________
-TBasket::TBasket() : fCompressedBufferRef(0), fOwnsCompressedBuffer(kFALSE), fLastWriteBufferSize(0)
+TBasket::TBasket() : fCompressedBufferRef(0), fOwnsCompressedBuffer(kFALSE), fLastWriteBufferSize(0), fCompressedLen(-1)
 {
    // Default contructor.
 
@@ -66,7 +66,7 @@ TBasket::TBasket() : fCompressedBufferRef(0), fOwnsCompressedBuffer(kFALSE), fLa
 }
 
 //_______________________________________________________________________
-TBasket::TBasket(TDirectory *motherDir) : TKey(motherDir),fCompressedBufferRef(0), fOwnsCompressedBuffer(kFALSE), fLastWriteBufferSize(0)
+TBasket::TBasket(TDirectory *motherDir) : TKey(motherDir),fCompressedBufferRef(0), fOwnsCompressedBuffer(kFALSE), fLastWriteBufferSize(0), fCompressedLen(-1)
 {
    // Constructor used during reading.
    fDisplacement  = 0;
@@ -83,7 +83,7 @@ TBasket::TBasket(TDirectory *motherDir) : TKey(motherDir),fCompressedBufferRef(0
 
 //_______________________________________________________________________
 TBasket::TBasket(const char *name, const char *title, TBranch *branch) : 
-   TKey(branch->GetDirectory()),fCompressedBufferRef(0), fOwnsCompressedBuffer(kFALSE), fLastWriteBufferSize(0)
+   TKey(branch->GetDirectory()),fCompressedBufferRef(0), fOwnsCompressedBuffer(kFALSE), fLastWriteBufferSize(0), fCompressedLen(-1)
 {
    // Basket normal constructor, used during writing.
 
@@ -220,6 +220,26 @@ Int_t TBasket::GetEntryPointer(Int_t entry)
    return offset;
 }
 
+//_______________________________________________________________________
+static Int_t R__ReadDirectly(TFile *file, char *buffer, Long64_t pos, Int_t len)
+{
+   // Read len bytes at pos from the file itself rather than from its cache.
+   // Returns kTRUE in case of failure, like TFile::ReadBuffer.
+
+   if (file->IsConcurrentRead()) {
+      // The reads at a position never go through the cache of the file;
+      // do not touch the cache, which may be used by another thread.
+      return file->ReadBuffer(buffer,pos,len);
+   }
+   // If we are using a TTreeCache, disable reading from the default cache
+   // temporarily, to force reading directly from file
+   TTreeCache *fc = dynamic_cast<TTreeCache*>(file->GetCacheRead());
+   if (fc) fc->Disable();
+   Int_t ret = file->ReadBuffer(buffer,pos,len);
+   if (fc) fc->Enable();
+   return ret;
+}
+
 //_______________________________________________________________________
 Int_t TBasket::LoadBasketBuffers(Long64_t pos, Int_t len, TFile *file, TTree *tree)
 { 
@@ -243,31 +263,21 @@ Int_t TBasket::LoadBasketBuffers(Long64_t pos, Int_t len, TFile *file, TTree *tr
    }
    fBufferRef->SetParent(file);
    char *buffer = fBufferRef->Buffer();
-   file->Seek(pos);
    TFileCacheRead *pf = file->GetCacheRead(tree);
    if (pf) {
       Int_t st = pf->ReadBuffer(buffer,pos,len);
       if (st < 0) {
          return 1;
       } else if (st == 0) {
-         // fOffset might have been changed via TFileCacheRead::ReadBuffer(), reset it
-         file->Seek(pos);
-         // If we are using a TTreeCache, disable reading from the default cache
-         // temporarily, to force reading directly from file
-         TTreeCache *fc = dynamic_cast<TTreeCache*>(file->GetCacheRead());
-         if (fc) fc->Disable();
-         Int_t ret = file->ReadBuffer(buffer,len);
-         if (fc) fc->Enable();
+         Int_t ret = R__ReadDirectly(file, buffer, pos, len);
          pf->AddNoCacheBytesRead(len);
          pf->AddNoCacheReadCalls(1);
          if (ret) {
             return 1;
          }
       }
-      // fOffset might have been changed via TFileCacheRead::ReadBuffer(), reset it
-      file->SetOffset(pos + len);
    } else {
-      if (file->ReadBuffer(buffer,len)) {
+      if (file->ReadBuffer(buffer,pos,len)) {
          return 1; //error while reading
       }
    }
@@ -386,7 +396,11 @@ static inline TBuffer* R__InitializeReadBasketBuffer(TBuffer* bufferRef, Int_t l
    if (R__likely(bufferRef)) {
       bufferRef->SetReadMode();
       Int_t curBufferSize = bufferRef->BufferSize();
-      if (curBufferSize < len) {
+      if (R__unlikely(!bufferRef->TestBit(TBuffer::kIsOwner))) {
+         // The buffer is not ours (e.g. it points into a memory mapped
+         // file), do not overwrite it.
+         bufferRef->SetBuffer(new char[len], len, kTRUE);
+      } else if (curBufferSize < len) {
          // Experience shows that giving 5% "wiggle-room" decreases churn.
          bufferRef->Expand(Int_t(len*1.05));
       }
@@ -435,15 +449,18 @@ Int_t TBasket::ReadBasketBuffers(Long64_t pos, Int_t len, TFile *file)
    Bool_t oldCase;
    char *rawUncompressedBuffer, *rawCompressedBuffer;
    Int_t uncompressedBufferLen;
+   const Int_t nbytesRead = len;
+   Bool_t inCache = kFALSE;
 
    // See if the cache has already unzipped the buffer for us.
    TFileCacheRead *pf = file->GetCacheRead(fBranch->GetTree());
    if (pf) {
       Int_t res = -1;
       Bool_t free = kTRUE;
-      char *buffer;
+      char *buffer = 0;
       res = pf->GetUnzipBuffer(&buffer, pos, len, &free);
       if (R__unlikely(res >= 0)) {
+         inCache = kTRUE;
          len = ReadBasketBuffersUnzip(buffer, res, free, file);
          // Note that in the kNotDecompressed case, the above function will return 0;
          // In such a case, we should stop processing
@@ -452,6 +469,34 @@ Int_t TBasket::ReadBasketBuffers(Long64_t pos, Int_t len, TFile *file)
       }
    }
 
+   // If the file is memory mapped and the basket is not compressed, use
+   // the basket directly from the mapping.
+   if (R__unlikely(fBranch->GetCompressionLevel()==0)) {
+      char *mapped = file->GetMappedBuffer(pos, len);
+      if (mapped) {
+         fBranch->GetTree()->IncrementTotalBuffers(-fBufferSize);
+         if (fBufferRef) {
+            fBufferRef->SetBuffer(mapped, len, kFALSE);
+            fBufferRef->SetReadMode();
+            fBufferRef->Reset();
+         } else {
+            fBufferRef = new TBufferFile(TBuffer::kRead, len, mapped, kFALSE);
+         }
+         fBufferRef->SetParent(file);
+         Streamer(*fBufferRef);
+         if (IsZombie()) {
+            return 1;
+         }
+         if (R__likely(fObjlen+fKeylen == fNbytes)) {
+            fBuffer = fBufferRef->Buffer();
+            goto AfterBuffer;
+         }
+         // The basket was compressed anyway, read it the usual way.
+         fBufferRef->SetBuffer(new char[len], len, kTRUE);
+         fBranch->GetTree()->IncrementTotalBuffers(fBufferSize);
+      }
+   }
+
    // Determine which buffer to use, so that we can avoid a memcpy in case of 
    // the basket was not compressed.
    TBuffer* readBufferRef;
@@ -476,14 +521,11 @@ Int_t TBasket::ReadBasketBuffers(Long64_t pos, Int_t len, TFile *file)
       Int_t st = pf->ReadBuffer(readBufferRef->Buffer(),pos,len);
       if (st < 0) {
          return 1;
-      } else if (st == 0) {
+      } else if (st > 0) {
+         inCache = kTRUE;
+      } else {
          // Read directly from file, not from the cache
-         // If we are using a TTreeCache, disable reading from the default cache
-         // temporarily, to force reading directly from file
-         TTreeCache *fc = dynamic_cast<TTreeCache*>(file->GetCacheRead());
-         if (fc) fc->Disable();
-         Int_t ret = file->ReadBuffer(readBufferRef->Buffer(),pos,len);
-         if (fc) fc->Enable();
+         Int_t ret = R__ReadDirectly(file, readBufferRef->Buffer(), pos, len);
          pf->AddNoCacheBytesRead(len);
          pf->AddNoCacheReadCalls(1);
          if (ret) {
@@ -582,6 +624,7 @@ Int_t TBasket::ReadBasketBuffers(Long64_t pos, Int_t len, TFile *file)
       len = fObjlen+fKeylen;
       if (R__unlikely(gPerfStats)) {
          gPerfStats->FileUnzipEvent(file,pos,start,nintot,fObjlen);
+         gPerfStats->UnzipEvent(fBranch,pos,start,nintot,fObjlen);
       }
    } else {
       // Nothing is compressed - copy over wholesale.
@@ -592,6 +635,10 @@ AfterBuffer:
 
    fBranch->GetTree()->IncrementTotalBuffers(fBufferSize);
 
+   if (R__unlikely(gPerfStats)) {
+      gPerfStats->BasketReadEvent(fBranch, nbytesRead, inCache);
+   }
+
    // Read offsets table if needed.
    if (!fBranch->GetEntryOffsetLen()) {
       return 0;
@@ -683,6 +730,7 @@ void TBasket::Reset()
    }
    
    TKey::Reset();
+   fCompressedLen = -1;
 
    Int_t newNevBufSize = fBranch->GetEntryOffsetLen();
    if (newNevBufSize==0) {
@@ -893,6 +941,186 @@ void TBasket::Update(Int_t offset, Int_t skipped)
    fNevBuf++;
 }
 
+//_______________________________________________________________________
+Int_t TBasket::CompressBuffer(TFile *file, Bool_t privatebuffer)
+{
+   // Transfer the entry offsets at the end of the buffer and compress the
+   // object into fCompressedBufferRef, without writing anything to file.
+   //
+   // Return the size of the compressed object, 0 if the object is not to be
+   // compressed (compression level 0 or data not compressible) and -1 in case
+   // of error.
+   //
+   // This only modifies the buffers of this basket; it is called by
+   // WriteBuffer and, ahead of it, concurrently for several baskets by
+   // TTree::FlushBaskets (see TTree::SetParallelCompression). The result is
+   // then picked up by the next call to WriteBuffer.
+   // If privatebuffer is true, the basket compresses into its own buffer
+   // rather than into the transient buffer shared by the baskets of the tree.
+
+   fCompressedLen = -1;
+
+   // Transfer fEntryOffset table at the end of fBuffer.
+   fLast = fBufferRef->Length();
+   if (fEntryOffset) {
+      // Note: We might want to investigate the compression gain if we 
+      // transform the Offsets to fBuffer in entry length to optimize 
+      // compression algorithm.  The aggregate gain on a (random) CMS files
+      // is around 5.5%. So the code could something like:
+      //      for(Int_t z = fNevBuf; z > 0; --z) {
+      //         if (fEntryOffset[z]) fEntryOffset[z] = fEntryOffset[z] - fEntryOffset[z-1];
+      //      }
+      fBufferRef->WriteArray(fEntryOffset,fNevBuf+1);
+      if (fDisplacement) {
+         fBufferRef->WriteArray(fDisplacement,fNevBuf+1);
+         delete [] fDisplacement; fDisplacement = 0;
+      }
+   }
+
+   Int_t lbuf, nout, noutot, bufmax, nzip;
+   lbuf       = fBufferRef->Length();
+   fObjlen    = lbuf - fKeylen;
+
+   Int_t cxlevel = fBranch->GetCompressionLevel();
+   Int_t cxAlgorithm = fBranch->GetCompressionAlgorithm();
+   if (cxlevel <= 0) {
+      fCompressedLen = 0;
+      return 0;
+   }
+
+   Int_t nbuffers = 1 + (fObjlen - 1) / kMAXBUF;
+   Int_t buflen = fKeylen + fObjlen + 9 * nbuffers + 28; //add 28 bytes in case object is placed in a deleted gap
+   if (privatebuffer && !fOwnsCompressedBuffer) fCompressedBufferRef = 0;
+   InitializeCompressedBuffer(buflen, file);
+   if (!fCompressedBufferRef) {
+      Warning("CompressBuffer", "Unable to allocate the compressed buffer");
+      return -1;
+   }
+   fCompressedBufferRef->SetWriteMode();
+   char *objbuf = fBufferRef->Buffer() + fKeylen;
+   char *bufcur = fCompressedBufferRef->Buffer() + fKeylen;
+   noutot = 0;
+   nzip   = 0;
+   for (Int_t i = 0; i < nbuffers; ++i) {
+      if (i == nbuffers - 1) bufmax = fObjlen - nzip;
+      else bufmax = kMAXBUF;
+      //compress the buffer
+      R__zipMultipleAlgorithm(cxlevel, &bufmax, objbuf, &bufmax, bufcur, &nout, cxAlgorithm);
+
+      // test if buffer has really been compressed. In case of small buffers 
+      // when the buffer contains random data, it may happen that the compressed
+      // buffer is larger than the input. In this case, we write the original uncompressed buffer
+      if (nout == 0 || nout >= fObjlen) {
+         // We used to delete fBuffer here, we no longer want to since
+         // the buffer (held by fCompressedBufferRef) might be re-used later.
+         if ((fObjlen+fKeylen)>buflen) {
+            Warning("CompressBuffer","Possible memory corruption due to compression algorithm, wrote %d bytes past the end of a block of %d bytes. fNbytes=%d, fObjLen=%d, fKeylen=%d",
+               (fObjlen+fKeylen-buflen),buflen,fNbytes,fObjlen,fKeylen);
+         }
+         fCompressedLen = 0;
+         return 0;
+      }
+      bufcur += nout;
+      noutot += nout;
+      objbuf += kMAXBUF;
+      nzip   += kMAXBUF;
+   }
+   fCompressedLen = noutot;
+   return noutot;
+}
+
+//_______________________________________________________________________
+Int_t TBasket::Recompress(Int_t settings)
+{
+   // Recompress the object of the basket loaded by LoadBasketBuffers with
+   // the compression settings 'settings' (100 * algorithm + level), without
+   // unstreaming it: the object is unzipped and zipped again into a new
+   // buffer, ready to be written by CopyTo. The entry offsets stored with
+   // the object are kept as they are.
+   //
+   // Return the new size of the object on file, or -1 in case of error, in
+   // which case the basket is left unchanged.
+   //
+   // This only modifies the buffers of this basket; it is called
+   // concurrently for several baskets by TTreeCloner (option "recompress").
+
+   if (!fBufferRef || fKeylen <= 0 || fObjlen <= 0) return -1;
+
+   char *src = fBufferRef->Buffer();
+   Int_t nin = fNbytes - fKeylen;
+
+   // Unzip the object, unless it was stored uncompressed.
+   char *objbuf = src + fKeylen;
+   Bool_t ownobj = kFALSE;
+   if (fObjlen > nin) {
+      objbuf = new char[fObjlen];
+      ownobj = kTRUE;
+      UChar_t *bufcur = (UChar_t *)src + fKeylen;
+      Int_t noutot = 0;
+      while (noutot < fObjlen) {
+         Int_t nzip, nbuf, nout = 0;
+         if (R__unzip_header(&nzip, bufcur, &nbuf) != 0) break;
+         if (nbuf > fObjlen - noutot) break;
+         R__unzip(&nzip, bufcur, &nbuf, objbuf + noutot, &nout);
+         if (!nout) break;
+         noutot += nout;
+         bufcur += nzip;
+      }
+      if (noutot != fObjlen) {
+         Error("Recompress", "cannot unzip the basket of branch %s", fBranch ? fBranch->GetName() : GetName());
+         delete [] objbuf;
+         return -1;
+      }
+   }
+
+   Int_t cxlevel = settings % 100;
+   Int_t cxAlgorithm = settings / 100;
+   TBuffer *newbuf = 0;
+   Int_t noutot = 0;
+   if (cxlevel > 0) {
+      Int_t nbuffers = 1 + (fObjlen - 1) / kMAXBUF;
+      Int_t buflen = fKeylen + fObjlen + 9 * nbuffers + 28;
+      newbuf = new TBufferFile(TBuffer::kWrite, buflen);
+      char *bufcur = newbuf->Buffer() + fKeylen;
+      Int_t nzip = 0;
+      for (Int_t i = 0; i < nbuffers; ++i) {
+         Int_t bufmax, nout;
+         if (i == nbuffers - 1) bufmax = fObjlen - nzip;
+         else bufmax = kMAXBUF;
+         R__zipMultipleAlgorithm(cxlevel, &bufmax, objbuf + nzip, &bufmax, bufcur, &nout, cxAlgorithm);
+         if (nout == 0 || nout >= fObjlen) {
+            // Not compressible: store the object uncompressed.
+            noutot = 0;
+            break;
+         }
+         bufcur += nout;
+         noutot += nout;
+         nzip   += kMAXBUF;
+      }
+   }
+   if (noutot == 0) {
+      if (!ownobj) {
+         // Already stored uncompressed.
+         delete newbuf;
+         return fObjlen;
+      }
+      delete newbuf;
+      newbuf = new TBufferFile(TBuffer::kWrite, fKeylen + fObjlen);
+      memcpy(newbuf->Buffer() + fKeylen, objbuf, fObjlen);
+      noutot = fObjlen;
+   }
+   memcpy(newbuf->Buffer(), src, fKeylen);
+   if (ownobj) delete [] objbuf;
+
+   newbuf->SetParent(fBufferRef->GetParent());
+   newbuf->SetReadMode();
+   delete fBufferRef;
+   fBufferRef = newbuf;
+   fBuffer = fBufferRef->Buffer();
+   fNbytes = fKeylen + noutot;
+   return noutot;
+}
+
 //_______________________________________________________________________
 Int_t TBasket::WriteBuffer()
 {
@@ -934,90 +1162,33 @@ Int_t TBasket::WriteBuffer()
       return nBytes>0 ? fKeylen+nout : -1;
    }
 
-   // Transfer fEntryOffset table at the end of fBuffer.
-   fLast = fBufferRef->Length();
-   if (fEntryOffset) {
-      // Note: We might want to investigate the compression gain if we 
-      // transform the Offsets to fBuffer in entry length to optimize 
-      // compression algorithm.  The aggregate gain on a (random) CMS files
-      // is around 5.5%. So the code could something like:
-      //      for(Int_t z = fNevBuf; z > 0; --z) {
-      //         if (fEntryOffset[z]) fEntryOffset[z] = fEntryOffset[z] - fEntryOffset[z-1];
-      //      }
-      fBufferRef->WriteArray(fEntryOffset,fNevBuf+1);
-      if (fDisplacement) {
-         fBufferRef->WriteArray(fDisplacement,fNevBuf+1);
-         delete [] fDisplacement; fDisplacement = 0;
-      }
+   Int_t nout = fCompressedLen;
+   fCompressedLen = -1;
+   if (nout < 0) {
+      nout = CompressBuffer(file);
+      if (nout < 0) return -1;
    }
 
-   Int_t lbuf, nout, noutot, bufmax, nzip;
-   lbuf       = fBufferRef->Length();
-   fObjlen    = lbuf - fKeylen;
-
    fHeaderOnly = kTRUE;
    fCycle = fBranch->GetWriteBasket();
-   Int_t cxlevel = fBranch->GetCompressionLevel();
-   Int_t cxAlgorithm = fBranch->GetCompressionAlgorithm();
-   if (cxlevel > 0) {
-      Int_t nbuffers = 1 + (fObjlen - 1) / kMAXBUF;
-      Int_t buflen = fKeylen + fObjlen + 9 * nbuffers + 28; //add 28 bytes in case object is placed in a deleted gap
-      InitializeCompressedBuffer(buflen, file);
-      if (!fCompressedBufferRef) {
-         Warning("WriteBuffer", "Unable to allocate the compressed buffer");
-         return -1;
-      }
-      fCompressedBufferRef->SetWriteMode();
+   if (nout > 0) {
       fBuffer = fCompressedBufferRef->Buffer();
-      char *objbuf = fBufferRef->Buffer() + fKeylen;
-      char *bufcur = &fBuffer[fKeylen];
-      noutot = 0;
-      nzip   = 0;
-      for (Int_t i = 0; i < nbuffers; ++i) {
-         if (i == nbuffers - 1) bufmax = fObjlen - nzip;
-         else bufmax = kMAXBUF;
-         //compress the buffer
-         R__zipMultipleAlgorithm(cxlevel, &bufmax, objbuf, &bufmax, bufcur, &nout, cxAlgorithm);
-
-         // test if buffer has really been compressed. In case of small buffers 
-         // when the buffer contains random data, it may happen that the compressed
-         // buffer is larger than the input. In this case, we write the original uncompressed buffer
-         if (nout == 0 || nout >= fObjlen) {
-            nout = fObjlen;
-            // We used to delete fBuffer here, we no longer want to since
-            // the buffer (held by fCompressedBufferRef) might be re-used later.
-            fBuffer = fBufferRef->Buffer();
-            Create(fObjlen,file);
-            fBufferRef->SetBufferOffset(0);
-
-            Streamer(*fBufferRef);         //write key itself again
-            if ((nout+fKeylen)>buflen) {
-               Warning("WriteBuffer","Possible memory corruption due to compression algorithm, wrote %d bytes past the end of a block of %d bytes. fNbytes=%d, fObjLen=%d, fKeylen=%d",
-                  (nout+fKeylen-buflen),buflen,fNbytes,fObjlen,fKeylen);
-            }
-            goto WriteFile;
-         }
-         bufcur += nout;
-         noutot += nout;
-         objbuf += kMAXBUF;
-         nzip   += kMAXBUF;
-      }
-      nout = noutot;
-      Create(noutot,file);
+      Create(nout,file);
       fBufferRef->SetBufferOffset(0);
 
       Streamer(*fBufferRef);         //write key itself again
       memcpy(fBuffer,fBufferRef->Buffer(),fKeylen);
    } else {
+      // Compression is disabled or did not reduce the size: write the
+      // original uncompressed buffer.
+      nout = fObjlen;
       fBuffer = fBufferRef->Buffer();
       Create(fObjlen,file);
       fBufferRef->SetBufferOffset(0);
 
       Streamer(*fBufferRef);         //write key itself again
-      nout = fObjlen;
    }
 
-WriteFile:
    Int_t nBytes = WriteFileKeepBuffer();
    fHeaderOnly = kFALSE;
    return nBytes>0 ? fKeylen+nout : -1;
@@ -37,8 +37,11 @@
 #include "TTreeCache.h"
 #include "TTreeCacheUnzip.h"
 #include "TVirtualPad.h"
+#include "TVirtualPerfStats.h"
+#include "TTimeStamp.h"
 
 #include <cstddef>
+#include <float.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -105,6 +108,8 @@ TBranch::TBranch()
 , fBasketBytes(0)
 , fBasketEntry(0)
 , fBasketSeek(0)
+, fBasketMin(0)
+, fBasketMax(0)
 , fTree(0)
 , fMother(0)
 , fParent(0)
@@ -113,6 +118,8 @@ TBranch::TBranch()
 , fFileName("")
 , fEntryBuffer(0)
 , fBrowsables(0)
+, fColumns(0)
+, fColumnLen(0)
 , fSkipZip(kFALSE)
 , fReadLeaves(&TBranch::ReadLeavesImpl)
 , fFillLeaves(&TBranch::FillLeavesImpl)
@@ -151,6 +158,8 @@ TBranch::TBranch(TTree *tree, const char* name, void* address, const char* leafl
 , fBasketBytes(0)
 , fBasketEntry(0)
 , fBasketSeek(0)
+, fBasketMin(0)
+, fBasketMax(0)
 , fTree(tree)
 , fMother(0)
 , fParent(0)
@@ -159,6 +168,8 @@ TBranch::TBranch(TTree *tree, const char* name, void* address, const char* leafl
 , fFileName("")
 , fEntryBuffer(0)
 , fBrowsables(0)
+, fColumns(0)
+, fColumnLen(0)
 , fSkipZip(kFALSE)
 , fReadLeaves(&TBranch::ReadLeavesImpl)
 , fFillLeaves(&TBranch::FillLeavesImpl)
@@ -253,6 +264,8 @@ TBranch::TBranch(TBranch *parent, const char* name, void* address, const char* l
 , fBasketBytes(0)
 , fBasketEntry(0)
 , fBasketSeek(0)
+, fBasketMin(0)
+, fBasketMax(0)
 , fTree(parent ? parent->GetTree() : 0)
 , fMother(parent ? parent->GetMother() : 0)
 , fParent(parent)
@@ -261,6 +274,8 @@ TBranch::TBranch(TBranch *parent, const char* name, void* address, const char* l
 , fFileName("")
 , fEntryBuffer(0)
 , fBrowsables(0)
+, fColumns(0)
+, fColumnLen(0)
 , fSkipZip(kFALSE)
 , fReadLeaves(&TBranch::ReadLeavesImpl)
 , fFillLeaves(&TBranch::FillLeavesImpl)
@@ -414,12 +429,20 @@ TBranch::~TBranch()
    delete fBrowsables;
    fBrowsables = 0;
 
+   DropColumns();
+
    // Note: We do *not* have ownership of the buffer.
    fEntryBuffer = 0;
 
    delete [] fBasketSeek;
    fBasketSeek  = 0;
 
+   delete [] fBasketMin;
+   fBasketMin   = 0;
+
+   delete [] fBasketMax;
+   fBasketMax   = 0;
+
    delete [] fBasketEntry;
    fBasketEntry = 0;
 
@@ -518,10 +541,19 @@ void TBranch::AddBasket(TBasket& b, Bool_t ondisk, Long64_t startEntry)
             fBasketEntry[j] = fBasketEntry[j-1];
             fBasketBytes[j] = fBasketBytes[j-1];
             fBasketSeek[j]  = fBasketSeek[j-1];
+            if (fBasketMin) {
+               fBasketMin[j] = fBasketMin[j-1];
+               fBasketMax[j] = fBasketMax[j-1];
+            }
          }
       }
    }
    fBasketEntry[where] = startEntry;
+   if (fBasketMin) {
+      // The content of a basket copied as is is not known.
+      fBasketMin[where] = -DBL_MAX;
+      fBasketMax[where] = DBL_MAX;
+   }
 
    if (ondisk) {
       fBasketBytes[where] = basket->GetNbytes();  // not for in mem
@@ -699,6 +731,13 @@ void TBranch::ExpandBasketArrays()
    fBasketSeek   = (Long64_t*)TStorage::ReAlloc(fBasketSeek,
                                                 newsize*sizeof(Long64_t),fMaxBaskets*sizeof(Long64_t));
 
+   if (fBasketMin) {
+      fBasketMin = (Double_t*)TStorage::ReAlloc(fBasketMin,
+                                                newsize*sizeof(Double_t),fMaxBaskets*sizeof(Double_t));
+      fBasketMax = (Double_t*)TStorage::ReAlloc(fBasketMax,
+                                                newsize*sizeof(Double_t),fMaxBaskets*sizeof(Double_t));
+   }
+
    fMaxBaskets   = newsize;
 
    fBaskets.Expand(newsize);
@@ -708,6 +747,7 @@ void TBranch::ExpandBasketArrays()
       fBasketEntry[i] = 0;
       fBasketSeek[i]  = 0;
    }
+   ResetBasketStats(fWriteBasket);
 }
 
 //______________________________________________________________________________
@@ -725,6 +765,11 @@ Int_t TBranch::Fill()
       return 0;
    }
 
+   // The columns would not contain the new entry.
+   if (R__unlikely(fColumns)) {
+      DropColumns();
+   }
+
    TBasket* basket = GetBasket(fWriteBasket);
    if (!basket) {
       basket = fTree->CreateBasket(this); //  create a new basket
@@ -755,6 +800,9 @@ Int_t TBranch::Fill()
       ++fEntries;
       ++fEntryNumber;
       (this->*fFillLeaves)(*buf);
+      if (R__unlikely(fBasketMin)) {
+         UpdateBasketStats(basket);
+      }
       if (buf->GetMapCount()) {
          // The map is used.
          ResetBit(TBranch::kDoNotUseBufferMap);
@@ -1133,6 +1181,80 @@ TBasket* TBranch::GetBasket(Int_t basketnumber)
    return basket;
 }
 
+//______________________________________________________________________________
+TBasket* TBranch::GetBasketForEntry(Long64_t entry)
+{
+   // Make the basket containing entry the current read basket and return it,
+   // with its buffer in memory. Used by the bulk readers (ReadBulkEntries);
+   // GetEntry keeps its own lookup, which also prepares the basket for the
+   // entry and tells a missing entry from an I/O error.
+   //
+   // Return 0 if the entry does not exist or if the basket can not be read.
+
+   if ((entry < fFirstEntry) || (entry >= fEntryNumber)) {
+      return 0;
+   }
+   if (fCurrentBasket && fFirstBasketEntry <= entry && entry < fNextBasketEntry
+       && fCurrentBasket->GetBufferRef()) {
+      return fCurrentBasket;
+   }
+   fReadBasket = TMath::BinarySearch(fWriteBasket + 1, fBasketEntry, entry);
+   if (fReadBasket < 0) {
+      fNextBasketEntry = -1;
+      Error("GetBasketForEntry", "In the branch %s, no basket contains the entry %lld\n", GetName(), entry);
+      return 0;
+   }
+   if (fReadBasket == fWriteBasket) {
+      fNextBasketEntry = fEntryNumber;
+   } else {
+      fNextBasketEntry = fBasketEntry[fReadBasket+1];
+   }
+   fFirstBasketEntry = fBasketEntry[fReadBasket];
+   TBasket *basket = GetBasket(fReadBasket);
+   fCurrentBasket = basket;
+   if (!basket) {
+      fFirstBasketEntry = -1;
+      fNextBasketEntry = -1;
+      return 0;
+   }
+   if (!basket->GetBufferRef()) {
+      TFile* file = GetFile(0);
+      if (!file || basket->ReadBasketBuffers(fBasketSeek[fReadBasket], fBasketBytes[fReadBasket], file)
+          || !basket->GetBufferRef()) {
+         // Do not keep a partially read buffer: the basket is read again
+         // by the next call.
+         basket->DropBuffers();
+         fCurrentBasket = 0;
+         fFirstBasketEntry = -1;
+         fNextBasketEntry = -1;
+         return 0;
+      }
+   }
+   // The basket being filled stays in write mode: its content is read
+   // directly from its buffer, and TBranch::Fill would have to restore it.
+   if (!basket->GetBufferRef()->IsReading() && basket != fBaskets.UncheckedAt(fWriteBasket)) {
+      basket->SetReadMode();
+   }
+   return basket;
+}
+
+//______________________________________________________________________________
+Bool_t TBranch::GetBasketRange(Int_t basketnumber, Double_t &min, Double_t &max) const
+{
+   // Set min and max to the smallest and largest values of the leaf
+   // in the basket (see SetBasketStats). Returns kFALSE if the range
+   // of the basket is not known, in which case min and max are set to
+   // -DBL_MAX and DBL_MAX. A basket without any value has min > max.
+
+   min = -DBL_MAX;
+   max = DBL_MAX;
+   if (!fBasketMin || basketnumber < 0 || basketnumber > fWriteBasket) return kFALSE;
+   if (fBasketMin[basketnumber] == -DBL_MAX && fBasketMax[basketnumber] == DBL_MAX) return kFALSE;
+   min = fBasketMin[basketnumber];
+   max = fBasketMax[basketnumber];
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 Long64_t TBranch::GetBasketSeek(Int_t basketnumber) const
 {
@@ -1152,6 +1274,67 @@ TList* TBranch::GetBrowsables() {
    return fBrowsables;
 }
 
+//______________________________________________________________________________
+namespace {
+   // Copy n values of N bytes from the big endian (network order) src to
+   // dst, reversing the bytes of each value. Written as a plain byte
+   // permutation on purpose: unlike the inline assembly of Byteswap.h the
+   // compiler can turn this loop into vector shuffles.
+   template <Int_t N>
+   void R__SwapCopy(char *dst, const char *src, Int_t n)
+   {
+      for (Int_t i = 0; i < n; ++i) {
+         for (Int_t b = 0; b < N; ++b) {
+            dst[i*N + b] = src[i*N + N - 1 - b];
+         }
+      }
+   }
+
+   void R__BulkByteSwap(char *dst, const char *src, Int_t n, Int_t typesize)
+   {
+#ifdef R__BYTESWAP
+      switch (typesize) {
+         case 2: R__SwapCopy<2>(dst, src, n); return;
+         case 4: R__SwapCopy<4>(dst, src, n); return;
+         case 8: R__SwapCopy<8>(dst, src, n); return;
+         default: break;
+      }
+#endif
+      memcpy(dst, src, (size_t)n*typesize);
+   }
+}
+
+//______________________________________________________________________________
+Int_t TBranch::GetBulkEntries(Long64_t entry, TBuffer &user_buf)
+{
+   // Read in one go the values of all the entries from entry to the end of
+   // the basket containing it, converted to the host byte order.
+   //
+   // On return user_buf holds the values contiguously, starting at
+   // user_buf.Buffer(), and the function returns the number of entries
+   // read. Each entry holds GetLeaf()->GetLenStatic() values of
+   // GetLeaf()->GetLenType() bytes, e.g. for a "x/F" branch:
+   //
+   //     TBufferFile buf(TBuffer::kRead, 10000);
+   //     for (Long64_t entry = 0; entry < nentries; ) {
+   //        Int_t n = branch->GetBulkEntries(entry, buf);
+   //        if (n <= 0) break;
+   //        const Float_t *x = (const Float_t*) buf.Buffer();
+   //        for (Int_t i = 0; i < n; ++i) sum += x[i];
+   //        entry += n;
+   //     }
+   //
+   // The whole range is byte swapped in a single pass instead of going
+   // through TLeaf::ReadBasket entry by entry. The branch address is not
+   // used and not updated.
+   //
+   // The function returns 0 if the entry does not exist, and -1 in case of
+   // an I/O error or if the branch can not be read in bulk
+   // (see IsBulkReadable).
+
+   return ReadBulkEntries(entry, user_buf, kTRUE);
+}
+
 //______________________________________________________________________________
 const char * TBranch::GetClassName() const 
 {
@@ -1173,6 +1356,24 @@ const char* TBranch::GetIconName() const
       return "TBranchElement-leaf";
 }
 
+//______________________________________________________________________________
+Int_t TBranch::GetEntriesSerialized(Long64_t entry, TBuffer &user_buf)
+{
+   // Copy to user_buf the serialized content of all the entries from entry
+   // to the end of the basket containing it and return the number of
+   // entries copied.
+   //
+   // The values are left as they are stored in the file (big endian),
+   // use GetBulkEntries to have them in host order. This is useful to
+   // forward the data without interpreting it, e.g. to a TMessage.
+   //
+   // The function returns 0 if the entry does not exist, and -1 in case of
+   // an I/O error or if the branch can not be read in bulk
+   // (see IsBulkReadable).
+
+   return ReadBulkEntries(entry, user_buf, kFALSE);
+}
+
 //______________________________________________________________________________
 Int_t TBranch::GetEntry(Long64_t entry, Int_t getall)
 {
@@ -1194,6 +1395,20 @@ Int_t TBranch::GetEntry(Long64_t entry, Int_t getall)
    //
 
    Bool_t enabled = !TestBit(kDoNotProcess) || getall;
+   if (R__unlikely(fColumns)) {
+      // The values are already in memory, in native format: copy them.
+      if (!enabled || (entry < fFirstEntry) || (entry >= fEntryNumber)) {
+         return 0;
+      }
+      Int_t nbytes = 0;
+      for (Int_t i = 0; i < fNleaves; ++i) {
+         TLeaf *leaf = (TLeaf*)fLeaves.UncheckedAt(i);
+         memcpy(leaf->GetValuePointer(), fColumns[i] + entry * fColumnLen[i], fColumnLen[i]);
+         nbytes += fColumnLen[i];
+      }
+      fReadEntry = entry;
+      return nbytes;
+   }
    TBasket *basket; // will be initialized in the if/then clauses.
    Long64_t first;
    if (R__likely(enabled && fFirstBasketEntry <= entry && entry < fNextBasketEntry)) {
@@ -1273,6 +1488,12 @@ Int_t TBranch::GetEntry(Long64_t entry, Int_t getall)
    // Int_t bufbegin = buf->Length();
    // Remember which entry we are reading.
    fReadEntry = entry;
+   if (R__unlikely(gPerfStats)) {
+      Double_t start = TTimeStamp();
+      (this->*fReadLeaves)(*buf);
+      gPerfStats->BranchReadEvent(this, buf->Length() - bufbegin, start);
+      return buf->Length() - bufbegin;
+   }
    (this->*fReadLeaves)(*buf);
    return buf->Length() - bufbegin;
 }
@@ -1641,6 +1862,59 @@ Bool_t TBranch::IsAutoDelete() const
    return TestBit(kAutoDelete);
 }
 
+//______________________________________________________________________________
+Bool_t TBranch::IsBulkReadable() const
+{
+   // Return kTRUE if the branch can be read with GetBulkEntries or
+   // GetEntriesSerialized, i.e. if it has a single leaf of a basic type
+   // (not a string) with a fixed number of values per entry.
+
+   if (IsA() != TBranch::Class() || fNleaves != 1) {
+      return kFALSE;
+   }
+   TLeaf *leaf = (TLeaf*)fLeaves.UncheckedAt(0);
+   if (!leaf || leaf->GetLeafCount() || leaf->IsA() == TLeafC::Class()) {
+      return kFALSE;
+   }
+   Int_t typesize = leaf->GetLenType();
+   return typesize == 1 || typesize == 2 || typesize == 4 || typesize == 8;
+}
+
+//______________________________________________________________________________
+void TBranch::DropColumns()
+{
+   // Delete the in-memory columns created by LoadColumns. The entries are
+   // then read from the baskets again.
+
+   if (!fColumns) return;
+   for (Int_t i = 0; i < fNleaves; ++i) {
+      delete [] fColumns[i];
+   }
+   delete [] fColumns;
+   delete [] fColumnLen;
+   fColumns = 0;
+   fColumnLen = 0;
+}
+
+//______________________________________________________________________________
+Bool_t TBranch::IsColumnReadable() const
+{
+   // Return kTRUE if the branch can be stored in memory as columns (see
+   // LoadColumns), i.e. if all its leaves are of a basic type (not a
+   // string) with a fixed number of values per entry.
+
+   if (IsA() != TBranch::Class() || fNleaves <= 0) {
+      return kFALSE;
+   }
+   for (Int_t i = 0; i < fNleaves; ++i) {
+      TLeaf *leaf = (TLeaf*)fLeaves.UncheckedAt(i);
+      if (!leaf || leaf->GetLeafCount() || leaf->IsA() == TLeafC::Class() || leaf->GetLenType() <= 0) {
+         return kFALSE;
+      }
+   }
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 Bool_t TBranch::IsFolder() const
 {
@@ -1706,6 +1980,68 @@ Int_t TBranch::LoadBaskets()
    return nimported;
 }
 
+//______________________________________________________________________________
+Bool_t TBranch::LoadColumns()
+{
+   // Read all the entries of the branch once and keep the values of each
+   // leaf in memory as a contiguous array in the native format of the
+   // machine (a column). From then on GetEntry copies the values from the
+   // columns to the leaves (or to the branch address) without reading the
+   // baskets, unstreaming or byte swapping: re-reading the same entries, for
+   // example in an iterative fit or with TTree::Draw, costs a memcpy.
+   //
+   // Only the branches with leaves of basic types and a fixed number of
+   // values per entry can be loaded (see IsColumnReadable); for the others
+   // the function returns kFALSE and the branch is read as usual.
+   // Once loaded, the baskets of a branch read from a file are dropped from
+   // memory. The columns are dropped by Fill and Reset or with DropColumns.
+   //
+   // See also TTree::LoadColumns.
+
+   if (!IsColumnReadable()) {
+      return kFALSE;
+   }
+   DropColumns();
+
+   Long64_t nentries = fEntryNumber;
+   char **columns = new char*[fNleaves];
+   Int_t *columnlen = new Int_t[fNleaves];
+   for (Int_t i = 0; i < fNleaves; ++i) {
+      TLeaf *leaf = (TLeaf*)fLeaves.UncheckedAt(i);
+      columnlen[i] = leaf->GetLenType() * leaf->GetLenStatic();
+      columns[i] = new char[nentries * columnlen[i] + 1];
+   }
+   Bool_t ok = kTRUE;
+   for (Long64_t entry = fFirstEntry; entry < nentries; ++entry) {
+      if (GetEntry(entry, 1) < 0) {
+         Error("LoadColumns", "cannot read entry %lld of branch %s", entry, GetName());
+         ok = kFALSE;
+         break;
+      }
+      for (Int_t i = 0; i < fNleaves; ++i) {
+         TLeaf *leaf = (TLeaf*)fLeaves.UncheckedAt(i);
+         memcpy(columns[i] + entry * columnlen[i], leaf->GetValuePointer(), columnlen[i]);
+      }
+   }
+   if (!ok) {
+      for (Int_t i = 0; i < fNleaves; ++i) delete [] columns[i];
+      delete [] columns;
+      delete [] columnlen;
+      return kFALSE;
+   }
+   fColumns = columns;
+   fColumnLen = columnlen;
+
+   // Drop the baskets of a branch stored in a file, they are read again
+   // after DropColumns. The baskets of an in-memory tree (created in
+   // gROOT or without directory) are its only copy of the data, they
+   // are kept.
+   if (GetFile()) {
+      DropBaskets("all");
+   }
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 void TBranch::Print(Option_t*) const
 {
@@ -1799,6 +2135,58 @@ void TBranch::Print(Option_t*) const
    fgCount++;
 }
 
+//______________________________________________________________________________
+Int_t TBranch::ReadBulkEntries(Long64_t entry, TBuffer &user_buf, Bool_t hostorder)
+{
+   // Implementation of GetBulkEntries (hostorder = kTRUE) and
+   // GetEntriesSerialized (hostorder = kFALSE).
+
+   if (TestBit(kDoNotProcess)) {
+      return 0;
+   }
+   if (!IsBulkReadable()) {
+      Error(hostorder ? "GetBulkEntries" : "GetEntriesSerialized",
+            "The branch %s can not be read in bulk", GetName());
+      return -1;
+   }
+   if ((entry < fFirstEntry) || (entry >= fEntryNumber)) {
+      return 0;
+   }
+   TBasket *basket = GetBasketForEntry(entry);
+   if (!basket) {
+      return -1;
+   }
+   if (basket->GetEntryOffset()) {
+      // Baskets written with an entry offset table (for example by an old
+      // version of ROOT) do not have a fixed entry size.
+      Error(hostorder ? "GetBulkEntries" : "GetEntriesSerialized",
+            "The baskets of the branch %s do not have a fixed entry size", GetName());
+      return -1;
+   }
+   Int_t entrysize = basket->GetNevBufSize();
+   Int_t nentries  = (Int_t)(fNextBasketEntry - entry);
+   Int_t nbytes    = nentries * entrysize;
+   if (nentries <= 0 || entrysize <= 0) {
+      return 0;
+   }
+
+   const char *src = basket->GetBufferRef()->Buffer() + basket->GetKeylen()
+                     + (entry - fFirstBasketEntry) * entrysize;
+   if (user_buf.BufferSize() < nbytes) {
+      user_buf.Expand(nbytes, kFALSE);
+   }
+   if (hostorder) {
+      TLeaf *leaf = (TLeaf*)fLeaves.UncheckedAt(0);
+      Int_t typesize = leaf->GetLenType();
+      R__BulkByteSwap(user_buf.Buffer(), src, nbytes / typesize, typesize);
+   } else {
+      memcpy(user_buf.Buffer(), src, nbytes);
+   }
+   user_buf.SetBufferOffset(0);
+   fReadEntry = entry;
+   return nentries;
+}
+
 //______________________________________________________________________________
 void TBranch::ReadBasket(TBuffer&)
 {
@@ -1885,6 +2273,16 @@ void TBranch::Refresh(TBranch* b)
       fBasketEntry[i] = b->fBasketEntry[i];
       fBasketSeek[i]  = b->fBasketSeek[i];
    }
+   delete [] fBasketMin;
+   delete [] fBasketMax;
+   fBasketMin = 0;
+   fBasketMax = 0;
+   if (b->fBasketMin) {
+      fBasketMin = new Double_t[fMaxBaskets];
+      fBasketMax = new Double_t[fMaxBaskets];
+      memcpy(fBasketMin, b->fBasketMin, fMaxBaskets*sizeof(Double_t));
+      memcpy(fBasketMax, b->fBasketMax, fMaxBaskets*sizeof(Double_t));
+   }
    fBaskets.Delete();
    Int_t nbaskets = b->fBaskets.GetSize();
    fBaskets.Expand(nbaskets);
@@ -1909,6 +2307,7 @@ void TBranch::Reset(Option_t*)
    // Entries, max and min are reset.
    //
 
+   DropColumns();
    fReadBasket = 0;
    fReadEntry = -1;
    fFirstBasketEntry = -1;
@@ -1938,6 +2337,8 @@ void TBranch::Reset(Option_t*)
       }
    }
 
+   ResetBasketStats(0);
+
    fBaskets.Delete();
    fNBaskets = 0;
 }
@@ -1952,6 +2353,7 @@ void TBranch::ResetAfterMerge(TFileMergeInfo *)
    // Entries, max and min are reset.
    //
 
+   DropColumns();
    fReadBasket       = 0;
    fReadEntry        = -1;
    fFirstBasketEntry = -1;
@@ -1981,6 +2383,8 @@ void TBranch::ResetAfterMerge(TFileMergeInfo *)
       }
    }
 
+   ResetBasketStats(0);
+
    TBasket *reusebasket = (TBasket*)fBaskets[fWriteBasket];
    if (reusebasket) {
       fBaskets[fWriteBasket] = 0;
@@ -2000,6 +2404,18 @@ void TBranch::ResetAfterMerge(TFileMergeInfo *)
    }
 }
 
+//______________________________________________________________________________
+void TBranch::ResetBasketStats(Int_t first)
+{
+   // Mark the range of the baskets from 'first' on as unknown.
+
+   if (!fBasketMin) return;
+   for (Int_t i = first; i < fMaxBaskets; ++i) {
+      fBasketMin[i] = -DBL_MAX;
+      fBasketMax[i] = DBL_MAX;
+   }
+}
+
 //______________________________________________________________________________
 void TBranch::ResetAddress()
 {
@@ -2092,6 +2508,39 @@ void TBranch::SetBasketSize(Int_t buffsize)
    }
 }
 
+//______________________________________________________________________________
+Bool_t TBranch::SetBasketStats(Bool_t on)
+{
+   // Record (or stop recording) the smallest and largest value of the
+   // leaf in each basket filled from now on. The ranges are stored with
+   // the branch and let the event loops skip the baskets in which no
+   // entry can pass a selection like "pt>50" (see TTreeStatsFilter).
+   // The baskets filled before the call have an unknown range.
+   //
+   // Only branches of class TBranch with a single numerical leaf
+   // support this; returns kFALSE for the others.
+
+   if (!on) {
+      delete [] fBasketMin;
+      delete [] fBasketMax;
+      fBasketMin = 0;
+      fBasketMax = 0;
+      return kTRUE;
+   }
+   if (IsA() != TBranch::Class() || fNleaves != 1) return kFALSE;
+   TClass *cl = fLeaves.UncheckedAt(0)->IsA();
+   if (cl != TLeafB::Class() && cl != TLeafS::Class() && cl != TLeafI::Class() &&
+       cl != TLeafL::Class() && cl != TLeafF::Class() && cl != TLeafD::Class() &&
+       cl != TLeafO::Class()) {
+      return kFALSE;
+   }
+   if (fBasketMin) return kTRUE;
+   fBasketMin = new Double_t[fMaxBaskets];
+   fBasketMax = new Double_t[fMaxBaskets];
+   ResetBasketStats(0);
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 void TBranch::SetBufferAddress(TBuffer* buf)
 {
@@ -2610,6 +3059,28 @@ void TBranch::SetupAddresses()
    // Nothing to do for regular branch, the TLeaf already did it.
 }
 
+//______________________________________________________________________________
+void TBranch::UpdateBasketStats(TBasket *basket)
+{
+   // Extend the range of the write basket to the values of the entry
+   // just filled.
+
+   Double_t &bmin = fBasketMin[fWriteBasket];
+   Double_t &bmax = fBasketMax[fWriteBasket];
+   if (basket->GetNevBuf() == 1) {
+      // First entry of the basket.
+      bmin = DBL_MAX;
+      bmax = -DBL_MAX;
+   }
+   TLeaf *leaf = (TLeaf*)fLeaves.UncheckedAt(0);
+   Int_t len = leaf->GetLen();
+   for (Int_t i = 0; i < len; ++i) {
+      Double_t val = leaf->GetValue(i);
+      if (val < bmin) bmin = val;
+      if (val > bmax) bmax = val;
+   }
+}
+
 //______________________________________________________________________________
 void TBranch::UpdateFile()
 {
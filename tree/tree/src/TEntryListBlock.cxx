@@ -12,7 +12,7 @@
 //______________________________________________________________________________
 /* Begin_Html
 <center><h2>TEntryListBlock: Used by TEntryList to store the entry numbers</h2></center>
- There are 2 ways to represent entry numbers in a TEntryListBlock:
+ There are 3 ways to represent entry numbers in a TEntryListBlock:
 <ol>
  <li> as bits, where passing entry numbers are assigned 1, not passing - 0
  <li> as a simple array of entry numbers
@@ -20,10 +20,16 @@
 <li> storing the numbers of entries that pass
 <li> storing the numbers of entries that don't pass
 </ul>
+ <li> as runs: the first and last entry numbers of each range of consecutive
+      passing entries
  </ol>
- In both cases, a UShort_t* is used. The second option is better in case
- less than 1/16 or more than 15/16 of entries pass the selection, and the representation can be
- changed by calling OptimizeStorage() function. 
+ In all cases, a UShort_t* is used. The second option is better in case
+ less than 1/16 or more than 15/16 of entries pass the selection, the third
+ one when the passing entries are grouped in ranges (e.g. selections on run
+ or luminosity block numbers), and the representation can be
+ changed by calling OptimizeStorage() function, which picks the smallest one.
+ The runs representation only exists in memory: the blocks are written as
+ bits or arrays, so that the files can be read by older versions. 
  When the block is being filled, it's always stored as bits, and the OptimizeStorage()
  function is called by TEntryList when it starts filling the next block. If
  Enter() or Remove() is called after OptimizeStorage(), representation is 
@@ -38,7 +44,9 @@ Begin_Html
 <ul>
  <li> <b>Merge</b>() - adds all entries from one block to the other. If the first block 
              uses array representation, it's changed to bits representation only
-             if the total number of passing entries is still less than kBlockSize
+             if the total number of passing entries is still less than kBlockSize.
+             Otherwise the blocks are combined 16 bits at a time as bitmaps.
+ <li> <b>Subtract</b>() - removes from one block the entries of the other.
  <li> <b>GetEntry(n)</b> - returns n-th non-zero entry.
  <li> <b>Next</b>()      - return next non-zero entry. In case of representation 1), Next()
                  is faster than GetEntry()
@@ -47,10 +55,24 @@ End_Html */
 
 
 #include "TEntryListBlock.h"
+#include "TBuffer.h"
 #include "TString.h"
 
+#include <string.h>
+
 ClassImp(TEntryListBlock)
 
+//______________________________________________________________________________
+static inline Int_t R__BitCount(UInt_t w)
+{
+   // Number of bits set in the 16 bit word w.
+
+   w = w - ((w >> 1) & 0x5555);
+   w = (w & 0x3333) + ((w >> 2) & 0x3333);
+   w = (w + (w >> 4)) & 0x0F0F;
+   return (w + (w >> 8)) & 0x1F;
+}
+
 //______________________________________________________________________________
 TEntryListBlock::TEntryListBlock()
 {
@@ -152,12 +174,11 @@ Bool_t TEntryListBlock::Enter(Int_t entry)
          return 0;
       }
    }
-   //list
+   //list or runs
    //change to bits
    UShort_t *bits = new UShort_t[kBlockSize];
    Transform(1, bits);
-   Enter(entry);
-   return 0;
+   return Enter(entry);
 }
 
 //______________________________________________________________________________
@@ -183,7 +204,7 @@ Bool_t TEntryListBlock::Remove(Int_t entry)
          return 0;
       }
    }
-   //list
+   //list or runs
    //change to bits
    UShort_t *bits = new UShort_t[kBlockSize];
    Transform(1, bits);
@@ -208,6 +229,21 @@ Int_t TEntryListBlock::Contains(Int_t entry)
       Bool_t result = (fIndices[i] & (1<<j))!=0;
       return result;
    }
+   if (fType==2){
+      //runs, binary search of the last run starting before entry
+      Int_t lo = 0;
+      Int_t hi = fN/2 - 1;
+      while (lo <= hi) {
+         Int_t mid = (lo + hi)/2;
+         if (fIndices[2*mid] <= entry) {
+            if (entry <= fIndices[2*mid+1]) return kTRUE;
+            lo = mid + 1;
+         } else {
+            hi = mid - 1;
+         }
+      }
+      return kFALSE;
+   }
    //list
    if (entry < fCurrent) fCurrent = 0;
    if (fPassing && fIndices){
@@ -244,14 +280,20 @@ Int_t TEntryListBlock::Merge(TEntryListBlock *block)
    //Merge with the other block
    //Returns the resulting number of entries in the block
 
-   Int_t i, j;
+   Int_t i;
    if (block->GetNPassed() == 0) return GetNPassed();
    if (GetNPassed() == 0){
       //this block is empty
+      if (fIndices)
+         delete [] fIndices;
       fN = block->fN;
-      fIndices = new UShort_t[fN];
-      for (i=0; i<fN; i++)
-         fIndices[i] = block->fIndices[i];
+      if (block->fIndices){
+         fIndices = new UShort_t[fN];
+         for (i=0; i<fN; i++)
+            fIndices[i] = block->fIndices[i];
+      } else {
+         fIndices = 0;
+      }
       fNPassed = block->fNPassed;
       fType = block->fType;
       fPassing = block->fPassing;
@@ -260,105 +302,80 @@ Int_t TEntryListBlock::Merge(TEntryListBlock *block)
       fLastIndexQueried = -1;
       return fNPassed;
    }
-   if (fType==0){
-      //stored as bits
-      if (block->fType == 0){
-         for (i=0; i<kBlockSize*16; i++){
-            if (block->Contains(i))
-               Enter(i);
-         }
-      } else {
-         if (block->fPassing){
-            //the other block stores entries that pass
-            for (i=0; i<block->fNPassed; i++){
-               Enter(block->fIndices[i]);
-            }
-         } else {
-            //the other block stores entries that don't pass
-            if (block->fNPassed==0){
-               for (i=0; i<kBlockSize*16; i++){
-                  Enter(i);
-               }
-            }
-            for (j=0; j<block->fIndices[0]; j++)
-               Enter(j);
-            for (i=0; i<block->fNPassed-1; i++){
-               for (j=block->fIndices[i]+1; j<block->fIndices[i+1]; j++){
-                  Enter(j);
-               }
-            }
-            for (j=block->fIndices[block->fNPassed-1]+1; j<kBlockSize*16; j++)
-               Enter(j);
+   if (fType==1 && fPassing && block->fType==1 && block->fPassing &&
+       GetNPassed() + block->GetNPassed() <= kBlockSize){
+      //both blocks are short lists of passing entries
+      //make a bigger list
+      Int_t en = block->fNPassed;
+      Int_t newsize = fNPassed + en;
+      UShort_t *newlist = new UShort_t[newsize];
+      UShort_t *elst = block->fIndices;
+      Int_t newpos, elpos;
+      newpos = elpos = 0;
+      for (i=0; i<fNPassed; i++) {
+         while (elpos < en && fIndices[i] > elst[elpos]) {
+            newlist[newpos] = elst[elpos];
+            newpos++;
+            elpos++;
          }
+         if (elpos < en && fIndices[i] == elst[elpos]) elpos++;
+         newlist[newpos] = fIndices[i];
+         newpos++;
       }
+      while (elpos < en) {
+         newlist[newpos] = elst[elpos];
+         newpos++;
+         elpos++;
+      }
+      delete [] fIndices;
+      fIndices = newlist;
+      fNPassed = newpos;
+      fN = fNPassed;
    } else {
-      //stored as a list
-      if (GetNPassed() + block->GetNPassed() > kBlockSize){
-         //change to bits
+      //combine the blocks as bitmaps
+      if (fType!=0){
          UShort_t *bits = new UShort_t[kBlockSize];
          Transform(1, bits);
-         Merge(block);
-      } else {
-         //this is only possible if fPassing=1 in both blocks
-         if (block->fType==1){
-            //second block stored as a list
-            //make a bigger list
-            Int_t en = block->fNPassed;
-            Int_t newsize = fNPassed + en;
-            UShort_t *newlist = new UShort_t[newsize];
-            UShort_t *elst = block->fIndices;
-            Int_t newpos, elpos;
-            newpos = elpos = 0;
-            for (i=0; i<fNPassed; i++) {
-               while (elpos < en && fIndices[i] > elst[elpos]) {
-                  newlist[newpos] = elst[elpos];
-                  newpos++;
-                  elpos++;
-               }
-               if (fIndices[i] == elst[elpos]) elpos++;
-               newlist[newpos] = fIndices[i];
-               newpos++;
-            }
-            while (elpos < en) {
-               newlist[newpos] = elst[elpos];
-               newpos++;
-               elpos++;
-            }
-            delete [] fIndices;
-            fIndices = newlist;
-            fNPassed = newpos;
-            fN = fNPassed;
-         } else {
-            //second block is stored as bits
-
-            Int_t en = block->fNPassed;
-            Int_t newsize = fNPassed + en;
-            UShort_t *newlist = new UShort_t[newsize];
-            Int_t newpos, current;
-            newpos = current = 0;
-            for (i=0; i<kBlockSize*16; i++){
-               if (!block->Contains(i)) continue;
-               while(current < fNPassed && fIndices[current]<i){
-                  newlist[newpos] = fIndices[current];
-                  current++;
-                  newpos++;
-               }
-               if (fIndices[current]==i) current++;
-               newlist[newpos] = i;
-               newpos++;
-            }
-            while(current<fNPassed){
-               newlist[newpos] = fIndices[current];
-               newpos++;
-               current++;
-            }
-            delete [] fIndices;
-            fIndices = newlist;
-            fNPassed = newpos;
-            fN = fNPassed;
-         }
       }
+      UShort_t *other = block->fIndices;
+      if (block->fType!=0){
+         other = new UShort_t[kBlockSize];
+         block->FillBits(other);
+      }
+      for (i=0; i<kBlockSize; i++)
+         fIndices[i] |= other[i];
+      if (other != block->fIndices)
+         delete [] other;
+      fNPassed = CountBits(fIndices);
+   }
+   fLastIndexQueried = -1;
+   fLastIndexReturned = -1;
+   OptimizeStorage();
+   return GetNPassed();
+}
+
+//______________________________________________________________________________
+Int_t TEntryListBlock::Subtract(TEntryListBlock *block)
+{
+   //Remove from this block all the entries of the other block
+   //Returns the resulting number of entries in the block
+
+   if (GetNPassed() == 0 || block->GetNPassed() == 0) return GetNPassed();
+   Int_t i;
+   if (fType!=0){
+      UShort_t *bits = new UShort_t[kBlockSize];
+      Transform(1, bits);
    }
+   UShort_t *other = block->fIndices;
+   if (block->fType!=0){
+      other = new UShort_t[kBlockSize];
+      block->FillBits(other);
+   }
+   for (i=0; i<kBlockSize; i++)
+      fIndices[i] &= ~other[i];
+   if (other != block->fIndices)
+      delete [] other;
+   fNPassed = CountBits(fIndices);
    fLastIndexQueried = -1;
    fLastIndexReturned = -1;
    OptimizeStorage();
@@ -389,18 +406,37 @@ Int_t TEntryListBlock::GetEntry(Int_t entry)
    else {
       Int_t i=0; Int_t j=0; Int_t entries_found=0;
       if (fType==0){
-         if ((fIndices[i] & (1<<j))!=0)
-            entries_found++;
-         while (entries_found<entry+1){
-            if (j==15){i++; j=0;}
-            else j++;
-            if ((fIndices[i] & (1<<j))!=0)
+         //skip the words before the one holding the entry
+         Int_t nbits = R__BitCount(fIndices[0]);
+         while (entries_found + nbits < entry+1){
+            entries_found += nbits;
+            i++;
+            if (i>=kBlockSize) return -1;
+            nbits = R__BitCount(fIndices[i]);
+         }
+         for (j=0; j<16; j++){
+            if ((fIndices[i] & (1<<j))!=0){
                entries_found++;
+               if (entries_found==entry+1) break;
+            }
          }
          fLastIndexQueried = entry;
          fLastIndexReturned = i*16+j;
          return fLastIndexReturned;
       }
+      if (fType==2){
+         for (i=0; i<fN; i+=2){
+            Int_t len = fIndices[i+1] - fIndices[i] + 1;
+            if (entries_found + len > entry){
+               fCurrent = i/2;
+               fLastIndexQueried = entry;
+               fLastIndexReturned = fIndices[i] + entry - entries_found;
+               return fLastIndexReturned;
+            }
+            entries_found += len;
+         }
+         return -1;
+      }
       if (fType==1){
          if (fPassing){
             fLastIndexQueried = entry;
@@ -461,17 +497,35 @@ Int_t TEntryListBlock::Next()
       fLastIndexReturned++;
       i = fLastIndexReturned>>4;
       j = fLastIndexReturned & 15;
-      Bool_t result=(fIndices[i] & (1<<j))!=0;
-      while (result==0){
-         if (j==15) {j=0; i++;}
-         else j++;
-         result = (fIndices[i] & (1<<j))!=0;
+      //bits of the current word at or after the last returned entry
+      UInt_t word = (UInt_t)fIndices[i] >> j;
+      while (word==0){
+         //skip the empty words
+         i++;
+         j = 0;
+         word = fIndices[i];
+      }
+      while ((word & 1)==0){
+         word >>= 1;
+         j++;
       }
       fLastIndexReturned = i*16+j;
       fLastIndexQueried++;
       return fLastIndexReturned;
 
    } 
+   if (fType==2) {
+      //runs, fCurrent is the run of the last returned entry
+      Int_t nruns = fN/2;
+      Int_t candidate = fLastIndexReturned+1;
+      if (fCurrent >= nruns || fIndices[2*fCurrent] > candidate) fCurrent = 0;
+      while (fCurrent < nruns && fIndices[2*fCurrent+1] < candidate) fCurrent++;
+      if (fCurrent >= nruns) return -1;
+      if (candidate < fIndices[2*fCurrent]) candidate = fIndices[2*fCurrent];
+      fLastIndexReturned = candidate;
+      fLastIndexQueried++;
+      return fLastIndexReturned;
+   }
    if (fType==1) {
       fLastIndexQueried++;
       if (fPassing){
@@ -506,6 +560,13 @@ void TEntryListBlock::PrintWithShift(Int_t shift) const
    //print the corrent values
 
    Int_t i;
+   if (fType==2){
+      for (i=0; i<fN; i+=2){
+         for (Int_t j=fIndices[i]; j<=fIndices[i+1]; j++)
+            printf("%d\n", j+shift);
+      }
+      return;
+   }
    if (fType==0){
       Int_t ibit, ibite;
       Bool_t result;
@@ -547,8 +608,26 @@ void TEntryListBlock::PrintWithShift(Int_t shift) const
 void TEntryListBlock::OptimizeStorage()
 {
    //if there are < kBlockSize or >kBlockSize*15 entries, change to an array representation
+   //if the entries are grouped in few enough runs, change to the runs representation
+
+   Optimize(kTRUE);
+}
+
+//______________________________________________________________________________
+void TEntryListBlock::Optimize(Bool_t runs)
+{
+   //Change from bits to the smallest representation, considering the runs
+   //representation only if runs is true
 
    if (fType!=0) return;
+   if (runs){
+      Int_t nlist = fNPassed > kBlockSize*15 ? kBlockSize*16-fNPassed : fNPassed;
+      if (nlist >= kBlockSize) nlist = kBlockSize;
+      if (2*CountRuns(fIndices) < nlist){
+         TransformToRuns();
+         return;
+      }
+   }
    if (fNPassed > kBlockSize*15)
       fPassing = 0;
    if (fNPassed<kBlockSize || !fPassing){
@@ -558,6 +637,109 @@ void TEntryListBlock::OptimizeStorage()
    }
 }
 
+//______________________________________________________________________________
+Int_t TEntryListBlock::CountBits(const UShort_t *bits)
+{
+   //Number of entries set in a bit array of kBlockSize words
+
+   Int_t n = 0;
+   for (Int_t i=0; i<kBlockSize; i++)
+      n += R__BitCount(bits[i]);
+   return n;
+}
+
+//______________________________________________________________________________
+Int_t TEntryListBlock::CountRuns(const UShort_t *bits)
+{
+   //Number of runs of consecutive entries in a bit array of kBlockSize words
+
+   Int_t n = 0;
+   UInt_t carry = 0;
+   for (Int_t i=0; i<kBlockSize; i++){
+      UInt_t w = bits[i];
+      //bits set whose previous bit is not set
+      n += R__BitCount(w & ~((w << 1) | carry) & 0xFFFF);
+      carry = w >> 15;
+   }
+   return n;
+}
+
+//______________________________________________________________________________
+void TEntryListBlock::FillBits(UShort_t *bits) const
+{
+   //Fill the kBlockSize words of bits with the bit representation of the block
+
+   Int_t i;
+   if (fType==0 && fIndices){
+      memcpy(bits, fIndices, kBlockSize*sizeof(UShort_t));
+      return;
+   }
+   if (fType==1 && !fPassing){
+      for (i=0; i<kBlockSize; i++)
+         bits[i] = 0xFFFF;
+      for (i=0; i<fNPassed; i++)
+         bits[fIndices[i]>>4] &= ~(1<<(fIndices[i] & 15));
+      return;
+   }
+   for (i=0; i<kBlockSize; i++)
+      bits[i] = 0;
+   if (!fIndices) return;
+   if (fType==1){
+      for (i=0; i<fNPassed; i++)
+         bits[fIndices[i]>>4] |= 1<<(fIndices[i] & 15);
+   } else if (fType==2){
+      for (i=0; i<fN; i+=2){
+         Int_t e = fIndices[i];
+         Int_t last = fIndices[i+1];
+         while (e <= last){
+            if ((e & 15)==0 && e+15 <= last){
+               bits[e>>4] = 0xFFFF;
+               e += 16;
+            } else {
+               bits[e>>4] |= 1<<(e & 15);
+               e++;
+            }
+         }
+      }
+   }
+}
+
+//______________________________________________________________________________
+void TEntryListBlock::TransformToRuns()
+{
+   //Transform the bits representation into runs
+
+   if (fType!=0) return;
+   Int_t nruns = CountRuns(fIndices);
+   UShort_t *runs = new UShort_t[2*nruns > 0 ? 2*nruns : 1];
+   Int_t irun = 0;
+   Bool_t inrun = kFALSE;
+   for (Int_t i=0; i<kBlockSize; i++){
+      UInt_t w = fIndices[i];
+      if ((w==0 && !inrun) || (w==0xFFFF && inrun)) continue;
+      for (Int_t j=0; j<16; j++){
+         Bool_t set = (w & (1<<j))!=0;
+         if (set && !inrun){
+            runs[2*irun] = i*16+j;
+            inrun = kTRUE;
+         } else if (!set && inrun){
+            runs[2*irun+1] = i*16+j-1;
+            irun++;
+            inrun = kFALSE;
+         }
+      }
+   }
+   if (inrun){
+      runs[2*irun+1] = kBlockSize*16-1;
+      irun++;
+   }
+   delete [] fIndices;
+   fIndices = runs;
+   fN = 2*irun;
+   fType = 2;
+   fPassing = 1;
+   fCurrent = 0;
+}
 
 //______________________________________________________________________________
 void TEntryListBlock::Transform(Bool_t dir, UShort_t *indexnew)
@@ -569,6 +751,16 @@ void TEntryListBlock::Transform(Bool_t dir, UShort_t *indexnew)
    Int_t i=0;
    Int_t ilist = 0;
    Int_t ibite, ibit;
+   if (dir && fType==2) {
+      //from runs to bits
+      FillBits(indexnew);
+      if (fIndices)
+         delete [] fIndices;
+      fIndices = indexnew;
+      fType = 0;
+      fN = kBlockSize;
+      return;
+   }
    if (!dir) {
          for (i=0; i<kBlockSize*16; i++){
             ibite = i >> 4;
@@ -622,3 +814,28 @@ void TEntryListBlock::Transform(Bool_t dir, UShort_t *indexnew)
    fPassing = 1;
    return;
 }
+
+//______________________________________________________________________________
+void TEntryListBlock::Streamer(TBuffer &b)
+{
+   //Stream an object of class TEntryListBlock.
+   //The runs representation is not written: such blocks are written as
+   //bits or as a list, so that older versions can read them.
+
+   if (b.IsReading()) {
+      b.ReadClassBuffer(TEntryListBlock::Class(), this);
+      fCurrent = 0;
+      ResetIndices();
+      OptimizeStorage();
+   } else {
+      if (fType==2) {
+         TEntryListBlock block(*this);
+         UShort_t *bits = new UShort_t[kBlockSize];
+         block.Transform(1, bits);
+         block.Optimize(kFALSE);
+         b.WriteClassBuffer(TEntryListBlock::Class(), &block);
+      } else {
+         b.WriteClassBuffer(TEntryListBlock::Class(), this);
+      }
+   }
+}
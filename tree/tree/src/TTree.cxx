@@ -365,6 +365,10 @@
 #include "TBranchSTL.h"
 #include "TSchemaRuleSet.h"
 #include "TFileMergeInfo.h"
+#include "TMutex.h"
+#include "TTaskScheduler.h"
+#include "Compression.h"
+#include "TTreeTuningProfile.h"
 
 #include <cstddef>
 #include <fstream>
@@ -372,6 +376,9 @@
 #include <string>
 #include <stdio.h>
 #include <limits.h>
+#include <vector>
+
+extern "C" int R__ZipMode;  // Global compression algorithm, see R__SetZipMode
 
 Int_t    TTree::fgBranchStyle = 1;  // Use new TBranch style with TBranchElement.
 Long64_t TTree::fgMaxTreeSize = 100000000000LL;
@@ -655,6 +662,8 @@ TTree::TTree()
 , fBranchRef(0)
 , fFriendLockStatus(0)
 , fTransientBuffer(0)
+, fNCompressThreads(0)
+, fHotBranches(0)
 {
    // Default constructor and I/O constructor.
    //
@@ -724,6 +733,8 @@ TTree::TTree(const char* name, const char* title, Int_t splitlevel /* = 99 */)
 , fBranchRef(0)
 , fFriendLockStatus(0)
 , fTransientBuffer(0)
+, fNCompressThreads(0)
+, fHotBranches(0)
 {
    // Normal tree constructor.
    //
@@ -868,6 +879,8 @@ TTree::~TTree()
       delete fTransientBuffer;
       fTransientBuffer = 0;
    }
+   delete fHotBranches;
+   fHotBranches = 0;
 }
 
 //______________________________________________________________________________
@@ -2794,6 +2807,11 @@ TTree* TTree::CloneTree(Long64_t nentries /* = -1 */, Option_t* option /* = "" *
    // cloning will be done without unzipping or unstreaming the baskets
    // (i.e., a direct copy of the raw bytes on disk).
    //
+   // When 'fast' is specified, 'option' can also contain the word
+   // 'recompress': the baskets whose compression settings differ from
+   // the ones of the output branches are then unzipped and zipped again
+   // (in parallel, see TTaskScheduler) without being unstreamed.
+   //
    // When 'fast' is specified, 'option' can also contain a sorting
    // order for the baskets in the output file.
    //
@@ -3180,6 +3198,10 @@ Long64_t TTree::CopyEntries(TTree* tree, Long64_t nentries /* = -1 */, Option_t*
    // done without unzipping or unstreaming the baskets (i.e., a direct copy of the
    // raw bytes on disk).
    //
+   // When 'fast' is specified, 'option' can also contain the word 'recompress' to
+   // recompress the baskets with the compression settings of the branches of this
+   // tree (see TTree::CloneTree).
+   //
    // When 'fast' is specified, 'option' can also contains a sorting order for the
    // baskets in the output file.
    //
@@ -4055,6 +4077,18 @@ void TTree::DropBaskets()
    }
 }
 
+//______________________________________________________________________________
+void TTree::DropColumns()
+{
+   // Delete the in-memory columns created by LoadColumns.
+
+   Int_t nleaves = fLeaves.GetEntriesFast();
+   for (Int_t i = 0; i < nleaves; ++i) {
+      TLeaf *leaf = (TLeaf*) fLeaves.UncheckedAt(i);
+      leaf->GetBranch()->DropColumns();
+   }
+}
+
 //______________________________________________________________________________
 void TTree::DropBuffers(Int_t)
 {
@@ -4187,7 +4221,8 @@ Int_t TTree::Fill()
 
             //First call FlushBasket to make sure that fTotBytes is up to date.
             FlushBaskets();
-            OptimizeBaskets(fTotBytes,1,"");
+            // The basket sizes chosen by a tuning profile are kept.
+            if (!fHotBranches) OptimizeBaskets(fTotBytes,1,"");
             if (gDebug > 0) Info("TTree::Fill","OptimizeBaskets called at entry %lld, fZipBytes=%lld, fFlushedBytes=%lld\n",fEntries,fZipBytes,fFlushedBytes);
             fFlushedBytes = fZipBytes;
             fAutoFlush    = fEntries;  // Use test on entries rather than bytes
@@ -4543,6 +4578,104 @@ Int_t TTree::Fit(const char* funcname, const char* varexp, const char* selection
    return -1;
 }
 
+namespace {
+   // Baskets to be compressed by TTree::CompressBasketsParallel.
+   struct TBasketCompressJob {
+      std::vector<TBasket*> fBaskets; // Baskets to compress
+      std::vector<TFile*>   fFiles;   // File each basket will be written to
+      UInt_t                fNext;    // Index of the next basket to compress
+      TMutex                fMutex;   // Protects fNext
+   };
+
+   void *R__CompressBasketsWorker(void *arg)
+   {
+      // Compress baskets of the job until there is none left.
+
+      TBasketCompressJob *job = (TBasketCompressJob*)arg;
+      while (1) {
+         UInt_t i;
+         {
+            TLockGuard lock(&job->fMutex);
+            if (job->fNext >= job->fBaskets.size()) break;
+            i = job->fNext++;
+         }
+         job->fBaskets[i]->CompressBuffer(job->fFiles[i], kTRUE);
+      }
+      return 0;
+   }
+
+   // A thread compressing baskets, as a job of the task scheduler.
+   class TBasketCompressTask : public TTaskScheduler::TJob {
+   private:
+      TBasketCompressJob *fJob;
+   public:
+      TBasketCompressTask(TBasketCompressJob *job) : fJob(job) { }
+      virtual void Execute() { R__CompressBasketsWorker(fJob); }
+   };
+
+   void R__CollectBasketsToCompress(TBranch *branch, TBasketCompressJob &job)
+   {
+      // Add to the job the baskets of branch (and its sub-branches) that
+      // TBranch::FlushBaskets is about to compress and write.
+
+      TDirectory *dir = branch->GetDirectory();
+      TFile *file = dir ? dir->GetFile() : 0;
+      Int_t algorithm = branch->GetCompressionAlgorithm();
+      if (algorithm == ROOT::kUseGlobalSetting) algorithm = R__ZipMode;
+      // The old compression algorithm uses global state: leave its baskets
+      // to the serial path.
+      if (file && file->IsWritable() && branch->GetCompressionLevel() > 0
+          && algorithm != ROOT::kUseGlobalSetting && algorithm != ROOT::kOldCompressionAlgo) {
+         TObjArray *baskets = branch->GetListOfBaskets();
+         Int_t maxbasket = TMath::Min(branch->GetWriteBasket() + 1, baskets->GetSize());
+         for (Int_t i = 0; i < maxbasket; ++i) {
+            TBasket *basket = (TBasket*)baskets->UncheckedAt(i);
+            if (basket && basket->GetNevBuf() && branch->GetBasketSeek(i) == 0
+                && basket->GetBufferRef() && basket->GetBufferRef()->IsWriting()
+                && !basket->GetBufferRef()->TestBit(TBufferFile::kNotDecompressed)) {
+               job.fBaskets.push_back(basket);
+               job.fFiles.push_back(file);
+            }
+         }
+      }
+      TObjArray *branches = branch->GetListOfBranches();
+      Int_t nb = branches->GetEntriesFast();
+      for (Int_t i = 0; i < nb; ++i) {
+         TBranch *sub = (TBranch*)branches->UncheckedAt(i);
+         if (sub) R__CollectBasketsToCompress(sub, job);
+      }
+   }
+}
+
+//______________________________________________________________________________
+void TTree::CompressBasketsParallel() const
+{
+   // Compress, using up to fNCompressThreads threads of the shared task
+   // scheduler, the baskets about to be written by FlushBaskets. Only the compression is done here: the
+   // baskets are then written by the usual serial code, in the usual order,
+   // so that the output file is identical to the one obtained without
+   // parallel compression.
+
+   TBasketCompressJob job;
+   job.fNext = 0;
+   TObjArray *lb = const_cast<TTree*>(this)->GetListOfBranches();
+   Int_t nb = lb->GetEntriesFast();
+   for (Int_t j = 0; j < nb; j++) {
+      TBranch* branch = (TBranch*) lb->UncheckedAt(j);
+      if (branch) R__CollectBasketsToCompress(branch, job);
+   }
+   if (job.fBaskets.size() < 2) return;
+
+   UInt_t nthreads = TMath::Min((UInt_t)job.fBaskets.size(), fNCompressThreads);
+   TTaskGroup group;
+   for (UInt_t i = 1; i < nthreads; ++i) {
+      group.Run(new TBasketCompressTask(&job));
+   }
+   // The calling thread compresses its share of the baskets too.
+   R__CompressBasketsWorker(&job);
+   group.Wait();
+}
+
 //______________________________________________________________________________
 Int_t TTree::FlushBaskets() const
 {
@@ -4551,8 +4684,27 @@ Int_t TTree::FlushBaskets() const
    // Return the number of bytes written or -1 in case of write error.
 
    if (!fDirectory) return 0;
+   if (fNCompressThreads > 1) CompressBasketsParallel();
    Int_t nbytes = 0;
    Int_t nerror = 0;
+   if (fHotBranches) {
+      // Write the baskets of the hot branches first, so that they are
+      // contiguous in the cluster (see SetTuningProfile).
+      Int_t nhot = fHotBranches->GetEntriesFast();
+      for (Int_t j = 0; j < nhot; j++) {
+         TBranch* branch = (TBranch*) fHotBranches->UncheckedAt(j);
+         Int_t maxbasket = branch->GetWriteBasket() + 1;
+         for (Int_t i = 0; i < maxbasket; ++i) {
+            if (!branch->GetListOfBaskets()->UncheckedAt(i)) continue;
+            Int_t nwrite = branch->FlushOneBasket(i);
+            if (nwrite<0) {
+               ++nerror;
+            } else {
+               nbytes += nwrite;
+            }
+         }
+      }
+   }
    TObjArray *lb = const_cast<TTree*>(this)->GetListOfBranches();
    Int_t nb = lb->GetEntriesFast();
    for (Int_t j = 0; j < nb; j++) {
@@ -5492,6 +5644,53 @@ Int_t TTree::LoadBaskets(Long64_t maxmemory)
    return nimported;
 }
 
+//______________________________________________________________________________
+Int_t TTree::LoadColumns(const char *bname)
+{
+   // Keep the data of the branches in memory as columns: contiguous arrays
+   // holding the values of each leaf for all the entries, in the native
+   // format of the machine (like a TNtuple, but with the leaf types).
+   // Reading an entry then copies the values from the columns, without
+   // unzipping, unstreaming or byte swapping. This is meant for trees
+   // read many times in the same job, e.g. for iterative fits or for the
+   // training of a multivariate method, with GetEntry, TTree::Draw or
+   // TTreeReader.
+   //
+   // bname is the name of a branch; if bname="*", apply to all branches,
+   // if bname="xxx*", to all branches with name starting with xxx (see
+   // TRegexp for wildcarding options).
+   // Only the branches with leaves of basic types and a fixed number of
+   // values per entry are loaded (see TBranch::IsColumnReadable), the other
+   // ones are read as usual. Filling the tree drops the columns.
+   // The columns are not kept when a TChain moves to its next tree.
+   //
+   // Returns the number of branches loaded, -1 in case of error.
+   // See also TBranch::LoadColumns and DropColumns.
+
+   Int_t nleaves = fLeaves.GetEntriesFast();
+   TRegexp re(bname, kTRUE);
+   TBranch *previous = 0;
+   Int_t nloaded = 0;
+   for (Int_t i = 0; i < nleaves; i++)  {
+      TLeaf* leaf = (TLeaf*) fLeaves.UncheckedAt(i);
+      TBranch* branch = (TBranch*) leaf->GetBranch();
+      if (branch == previous) continue;
+      previous = branch;
+      TString s = branch->GetName();
+      if (strcmp(bname, branch->GetName()) && (s.Index(re) == kNPOS)) {
+         continue;
+      }
+      if (!branch->IsColumnReadable()) {
+         continue;
+      }
+      if (!branch->LoadColumns()) {
+         return -1;
+      }
+      nloaded++;
+   }
+   return nloaded;
+}
+
 //______________________________________________________________________________
 Long64_t TTree::LoadTree(Long64_t entry)
 {
@@ -7136,6 +7335,42 @@ void TTree::SetBasketSize(const char* bname, Int_t buffsize)
    }
 }
 
+//_______________________________________________________________________
+Int_t TTree::SetBasketStats(const char* bname, Bool_t on)
+{
+   // Record (on=kTRUE) or stop recording the range of values of the
+   // leaf in each basket of the branches matching bname, as in
+   // SetBasketSize. Only the branches of class TBranch with a single
+   // numerical leaf can record them, the others are ignored.
+   // Returns the number of branches recording the ranges.
+   //
+   // The ranges are used by TTree::Draw and TTreeStatsFilter to skip the
+   // baskets in which no entry can pass the selection, e.g.
+   //
+   //    tree->SetBasketStats("pt");
+   //    ... fill and write the tree
+   //    tree->Draw("eta", "pt>50");  // reads only the baskets with pt>50
+
+   Int_t nleaves = fLeaves.GetEntriesFast();
+   TRegexp re(bname, kTRUE);
+   Int_t nb = 0;
+   Int_t nstats = 0;
+   for (Int_t i = 0; i < nleaves; i++)  {
+      TLeaf* leaf = (TLeaf*) fLeaves.UncheckedAt(i);
+      TBranch* branch = (TBranch*) leaf->GetBranch();
+      TString s = branch->GetName();
+      if (strcmp(bname, branch->GetName()) && (s.Index(re) == kNPOS)) {
+         continue;
+      }
+      nb++;
+      if (branch->SetBasketStats(on) && on) nstats++;
+   }
+   if (!nb) {
+      Error("SetBasketStats", "unknown branch -> '%s'", bname);
+   }
+   return nstats;
+}
+
 //_______________________________________________________________________
 Int_t TTree::SetBranchAddress(const char* bname, void* addr, TBranch** ptr)
 {
@@ -7819,6 +8054,29 @@ void TTree::SetObject(const char* name, const char* title)
    }
 }
 
+//______________________________________________________________________________
+void TTree::SetParallelCompression(Bool_t opt, UInt_t nthreads)
+{
+   // Enable or disable the parallel compression of the baskets flushed
+   // by FlushBaskets, in particular at each AutoFlush boundary.
+   //
+   // When enabled, the baskets are compressed concurrently by up to
+   // nthreads threads of the shared TTaskScheduler (by default as many as
+   // the scheduler has) and then written in the same order as with the
+   // serial compression; the resulting file is thus identical. Each basket
+   // then keeps its own compression buffer instead of sharing the one of
+   // the tree, which increases the memory usage.
+   // The baskets using the old compression algorithm are always compressed
+   // serially.
+
+   if (!opt) {
+      fNCompressThreads = 0;
+      return;
+   }
+   if (nthreads == 0) nthreads = TTaskScheduler::GetDefaultNThreads();
+   fNCompressThreads = nthreads;
+}
+
 //______________________________________________________________________________
 void TTree::SetParallelUnzip(Bool_t opt, Float_t RelSize)
 {
@@ -7851,6 +8109,55 @@ void TTree::SetTreeIndex(TVirtualIndex* index)
    fTreeIndex = index;
 }
 
+//______________________________________________________________________________
+Int_t TTree::SetTuningProfile(const TTreeTuningProfile *profile)
+{
+   // Use the read pattern recorded in profile (from a previous version of
+   // this tree, see TTreeTuningProfile) to set up the layout of this tree
+   // on disk:
+   //  - the number of entries per cluster (see SetAutoFlush) is the one
+   //    returned by TTreeTuningProfile::GetClusterSize, so that the hot
+   //    branches of a cluster are read in one go by a TTreeCache of size
+   //    profile->GetCacheSize();
+   //  - the basket size of each branch known to the profile is set to hold
+   //    the entries of a cluster; these sizes are not changed by the
+   //    OptimizeBaskets done at the first flush;
+   //  - at each flush, the baskets of the hot branches are written before
+   //    the others, so that they are contiguous on disk.
+   //
+   // Call it once the branches are created, before filling the tree.
+   // Return the number of branches whose basket size was set. Calling it
+   // with profile=0 restores the default behaviour (but not the basket
+   // sizes and the cluster size).
+
+   delete fHotBranches;
+   fHotBranches = 0;
+   if (!profile) return 0;
+
+   Long64_t cluster = profile->GetClusterSize();
+   if (cluster > 0) SetAutoFlush(cluster);
+
+   fHotBranches = new TObjArray();
+   Int_t ntuned = 0;
+   TBranch *last = 0;
+   Int_t nleaves = fLeaves.GetEntriesFast();
+   for (Int_t i = 0; i < nleaves; ++i) {
+      TLeaf *leaf = (TLeaf*)fLeaves.UncheckedAt(i);
+      TBranch *branch = leaf->GetBranch();
+      if (branch == last) continue;
+      last = branch;
+      Int_t bsize = profile->GetBasketSize(branch);
+      if (bsize > 0) {
+         branch->SetBasketSize(bsize);
+         ++ntuned;
+      }
+      if (profile->IsHot(branch->GetName())) fHotBranches->Add(branch);
+   }
+   if (gDebug > 0) Info("SetTuningProfile","%d entries per cluster, %d basket sizes set, %d hot branches",
+                        (Int_t)cluster, ntuned, fHotBranches->GetEntriesFast());
+   return ntuned;
+}
+
 //______________________________________________________________________________
 void TTree::SetWeight(Double_t w, Option_t*)
 {
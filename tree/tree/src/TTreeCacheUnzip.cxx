@@ -23,10 +23,14 @@
 //////////////////////////////////////////////////////////////////////////
 // Parallel Unzipping                                                   //
 //                                                                      //
-// TTreeCache has been specialised in order to let additional threads   //
-//  free to unzip in advance its content. In this implementation we     //
-//  support up to 10 threads, but right now it makes more sense to      //
-//  limit their number to 1-2                                           //
+// TTreeCache has been specialised in order to let jobs run by the      //
+//  shared TTaskScheduler unzip in advance its content. Each basket of  //
+//  the cache is an independent task: once the cache has been read for  //
+//  a cluster, the jobs take the baskets one after the other (in file   //
+//  order) and unzip them into separate chunks, without holding any     //
+//  lock while unzipping. The number of jobs running at once is by      //
+//  default the number of cores and can be changed with                 //
+//  TTreeCacheUnzip::SetUnzipThreads.                                   //
 //                                                                      //
 // The application reading data is carefully synchronized, in order to: //
 //  - if the block it wants is not unzipped, it self-unzips it without  //
@@ -34,6 +38,9 @@
 //  - if the block is being unzipped in parallel, it waits only         //
 //    for that unzip to finish                                          //
 //  - if the block has already been unzipped, it takes it               //
+// Each block has an atomic claim counter so that exactly one of the    //
+//  jobs or the application unzips it: looking up a block that is       //
+//  ready does not take any lock.                                       //
 //                                                                      //
 // This is supposed to cancel a part of the unzipping latency, at the   //
 //  expenses of cpu time.                                               //
@@ -43,6 +50,11 @@
 // TTreeCache::SetUnzipBufferSize(Long64_t bufferSize)                  //
 // where bufferSize must be passed in bytes.                            //
 //                                                                      //
+// The parallel unzipping works from the cache buffer; it is not used   //
+//  when the cache is read asynchronously or prefetched (TFile.Async-   //
+//  Reading with a file supporting it, TFile.AsyncPrefetching) in which //
+//  case the baskets are unzipped by the application.                   //
+//                                                                      //
 //////////////////////////////////////////////////////////////////////////
 
 #include "TTreeCacheUnzip.h"
@@ -53,36 +65,70 @@
 #include "TVirtualMutex.h"
 #include "TThread.h"
 #include "TCondition.h"
+#include "TTaskScheduler.h"
+#include "TAtomicCount.h"
 #include "TMath.h"
 #include "Bytes.h"
 
 #include "TEnv.h"
 
-#define THREADCNT 2
 extern "C" void R__unzip(Int_t *nin, UChar_t *bufin, Int_t *lout, char *bufout, Int_t *nout);
 extern "C" int R__unzip_header(Int_t *nin, UChar_t *bufin, Int_t *lout);
 
 TTreeCacheUnzip::EParUnzipMode TTreeCacheUnzip::fgParallel = TTreeCacheUnzip::kDisable;
+Int_t TTreeCacheUnzip::fgNThreads = 0;
 
 // The unzip cache does not consume memory by itself, it just allocates in advance
 // mem blocks which are then picked as they are by the baskets.
 // Hence there is no good reason to limit it too much
 Double_t TTreeCacheUnzip::fgRelBuffSize = .5;
 
+// Blocks smaller than this are not worth a task, the application unzips them.
+static const Int_t kMinUnzipTaskSize = 256;
+
+//______________________________________________________________________________
+class TTreeCacheUnzipBlock {
+public:
+   // Unzipping state of one block of the cache.
+   // fClaim starts at 1: whoever (thread or application) decrements it to
+   // 0 unzips the block. fDone is incremented once the unzipped chunk has
+   // been stored.
+   TAtomicCount fClaim;
+   TAtomicCount fDone;
+
+   TTreeCacheUnzipBlock() : fClaim(1), fDone(0) {}
+   void Reset() { fClaim.Set(1); fDone.Set(0); }
+};
+
+//______________________________________________________________________________
+class TTreeCacheUnzipJob : public TTaskScheduler::TJob {
+public:
+   // Job unzipping blocks of the cache until none is left (see UnzipLoop).
+   TTreeCacheUnzip *fCache;
+
+   TTreeCacheUnzipJob(TTreeCacheUnzip *cache) : fCache(cache) {}
+   virtual void Execute() { TTreeCacheUnzip::UnzipLoop(fCache); }
+};
+
 ClassImp(TTreeCacheUnzip)
 
 //______________________________________________________________________________
 TTreeCacheUnzip::TTreeCacheUnzip() : TTreeCache(),
 
+   fUnzipGroup(0),
+   fNThreads(0),
+   fNJobs(0),
    fActiveThread(kFALSE),
    fAsyncReading(kFALSE),
    fCycle(0),
-   fLastReadPos(0),
-   fBlocksToGo(0),
+   fNTasks(0),
+   fNextTask(0),
+   fNRunning(0),
+   fUnzipBlocks(0),
    fUnzipLen(0),
    fUnzipChunks(0),
-   fUnzipStatus(0),
-   fTotalUnzipBytes(0),
+   fUnzipBytes(0),
+   fNWaiting(0),
    fNseekMax(0),
    fUnzipBufferSize(0),
    fNUnzip(0),
@@ -98,20 +144,25 @@ TTreeCacheUnzip::TTreeCacheUnzip() : TTreeCache(),
 
 //______________________________________________________________________________
 TTreeCacheUnzip::TTreeCacheUnzip(TTree *tree, Int_t buffersize) : TTreeCache(tree,buffersize),
+   fUnzipGroup(0),
+   fNThreads(0),
+   fNJobs(0),
    fActiveThread(kFALSE),
    fAsyncReading(kFALSE),
    fCycle(0),
-   fLastReadPos(0),
-   fBlocksToGo(0),
+   fNTasks(0),
+   fNextTask(0),
+   fNRunning(0),
+   fUnzipBlocks(0),
    fUnzipLen(0),
    fUnzipChunks(0),
-   fUnzipStatus(0),
-   fTotalUnzipBytes(0),
+   fUnzipBytes(0),
+   fNWaiting(0),
    fNseekMax(0),
    fUnzipBufferSize(0),
    fNUnzip(0),
    fNFound(0),
-   fNStalls(0),                                                                 
+   fNStalls(0),
    fNMissed(0)
 {
    // Constructor.
@@ -127,68 +178,72 @@ void TTreeCacheUnzip::Init()
    fMutexList        = new TMutex(kTRUE);
    fIOMutex          = new TMutex(kTRUE);
 
-   fUnzipStartCondition   = new TCondition(fMutexList);
    fUnzipDoneCondition   = new TCondition(fMutexList);
 
-   fTotalUnzipBytes = 0;
+   fUnzipBytes = new TAtomicCount(0);
+   fNWaiting   = new TAtomicCount(0);
 
    fCompBuffer = new char[16384];
    fCompBufferSize = 16384;
 
+   fParallel = kFALSE;
+
+   // Check if asynchronous reading is supported by this TFile specialization
+   if (gEnv->GetValue("TFile.AsyncReading", 1)) {
+      if (fFile && !(fFile->ReadBufferAsync(0, 0)))
+         fAsyncReading = kTRUE;
+   }
+
    if (fgParallel == kDisable) {
       fParallel = kFALSE;
    }
    else if(fgParallel == kEnable || fgParallel == kForce) {
-      SysInfo_t info;
-      gSystem->GetSysInfo(&info);
-
       fUnzipBufferSize = Long64_t(fgRelBuffSize * GetBufferSize());
 
-      if(gDebug > 0)
-         Info("TTreeCacheUnzip", "Enabling Parallel Unzipping");
-
-      fParallel = kTRUE;
-
-      for (Int_t i = 0; i < 10; i++) fUnzipThread[i] = 0;
+      Int_t nthreads = GetUnzipThreads();
+      if (nthreads < 2 && fgParallel == kEnable && fgNThreads == 0) {
+         // Only one core, the threads would just compete with the application.
+         nthreads = 0;
+      }
 
-      StartThreadUnzip(THREADCNT);
+      if (nthreads > 0) {
+         if(gDebug > 0)
+            Info("TTreeCacheUnzip", "Enabling Parallel Unzipping with %d threads", nthreads);
 
+         fParallel = kTRUE;
+         StartThreadUnzip(nthreads);
+      }
    }
    else {
       Warning("TTreeCacheUnzip", "Parallel Option unknown");
    }
-
-   // Check if asynchronous reading is supported by this TFile specialization
-   if (gEnv->GetValue("TFile.AsyncReading", 1)) {
-      if (fFile && !(fFile->ReadBufferAsync(0, 0)))
-         fAsyncReading = kTRUE;
-   }
-
 }
 
 //______________________________________________________________________________
 TTreeCacheUnzip::~TTreeCacheUnzip()
 {
-   // destructor. (in general called by the TFile destructor
    // destructor. (in general called by the TFile destructor)
 
-   ResetCache();
-
    if (IsActiveThread())
       StopThreadUnzip();
 
+   ResetCache();
 
+   for (Int_t i = 0; i < fNseekMax; i++) {
+      delete [] fUnzipChunks[i];
+   }
    delete [] fUnzipLen;
+   delete [] fUnzipChunks;
+   delete [] fUnzipBlocks;
+   delete [] fCompBuffer;
 
-   delete fUnzipStartCondition;
    delete fUnzipDoneCondition;
 
-
    delete fMutexList;
    delete fIOMutex;
 
-   delete [] fUnzipStatus;
-   delete [] fUnzipChunks;
+   delete fUnzipBytes;
+   delete fNWaiting;
 }
 
 //_____________________________________________________________________________
@@ -216,88 +271,87 @@ Bool_t TTreeCacheUnzip::FillBuffer()
 {
 
    if (fNbranches <= 0) return kFALSE;
-   {
-      // Fill the cache buffer with the branches in the cache.
-      R__LOCKGUARD(fMutexList);
-      fIsTransferred = kFALSE;
-
-      TTree *tree = ((TBranch*)fBranches->UncheckedAt(0))->GetTree();
-      Long64_t entry = tree->GetReadEntry();
-
-      // If the entry is in the range we previously prefetched, there is 
-      // no point in retrying.   Note that this will also return false
-      // during the training phase (fEntryNext is then set intentional to 
-      // the end of the training phase).
-      if (fEntryCurrent <= entry  && entry < fEntryNext) return kFALSE;
-
-      // Triggered by the user, not the learning phase
-      if (entry == -1)  entry=0;
-
-      TTree::TClusterIterator clusterIter = tree->GetClusterIterator(entry);
-      fEntryCurrent = clusterIter();
-      fEntryNext = clusterIter.GetNextEntry();
-
-      if (fEntryCurrent < fEntryMin) fEntryCurrent = fEntryMin;
-      if (fEntryMax <= 0) fEntryMax = tree->GetEntries();
-      if (fEntryNext > fEntryMax) fEntryNext = fEntryMax;
-
-      // Check if owner has a TEventList set. If yes we optimize for this
-      // Special case reading only the baskets containing entries in the
-      // list.
-      TEventList *elist = fTree->GetEventList();
-      Long64_t chainOffset = 0;
-      if (elist) {
-         if (fTree->IsA() ==TChain::Class()) {
-            TChain *chain = (TChain*)fTree;
-            Int_t t = chain->GetTreeNumber();
-            chainOffset = chain->GetTreeOffset()[t];
-         }
-      }
 
-      //clear cache buffer
-      TFileCacheRead::Prefetch(0,0);
-
-      //store baskets
-      for (Int_t i=0;i<fNbranches;i++) {
-         TBranch *b = (TBranch*)fBranches->UncheckedAt(i);
-         if (b->GetDirectory()==0) continue;
-         if (b->GetDirectory()->GetFile() != fFile) continue;
-         Int_t nb = b->GetMaxBaskets();
-         Int_t *lbaskets   = b->GetBasketBytes();
-         Long64_t *entries = b->GetBasketEntry();
-         if (!lbaskets || !entries) continue;
-         //we have found the branch. We now register all its baskets
-         //from the requested offset to the basket below fEntrymax
-         Int_t blistsize = b->GetListOfBaskets()->GetSize();
-         for (Int_t j=0;j<nb;j++) {
-            // This basket has already been read, skip it
-            if (j<blistsize && b->GetListOfBaskets()->UncheckedAt(j)) continue;
-
-            Long64_t pos = b->GetBasketSeek(j);
-            Int_t len = lbaskets[j];
-            if (pos <= 0 || len <= 0) continue;
-            //important: do not try to read fEntryNext, otherwise you jump to the next autoflush
-            if (entries[j] >= fEntryNext) continue;
-            if (entries[j] < entry && (j<nb-1 && entries[j+1] <= entry)) continue;
-            if (elist) {
-               Long64_t emax = fEntryMax;
-               if (j<nb-1) emax = entries[j+1]-1;
-               if (!elist->ContainsRange(entries[j]+chainOffset,emax+chainOffset)) continue;
-            }
-            fNReadPref++;
-
-            TFileCacheRead::Prefetch(pos,len);
-         }
-         if (gDebug > 0) printf("Entry: %lld, registering baskets branch %s, fEntryNext=%lld, fNseek=%d, fNtot=%d\n",entry,((TBranch*)fBranches->UncheckedAt(i))->GetName(),fEntryNext,fNseek,fNtot);
+   // Fill the cache buffer with the branches in the cache.
+   TTree *tree = ((TBranch*)fBranches->UncheckedAt(0))->GetTree();
+   Long64_t entry = tree->GetReadEntry();
+
+   // If the entry is in the range we previously prefetched, there is 
+   // no point in retrying.   Note that this will also return false
+   // during the training phase (fEntryNext is then set intentional to 
+   // the end of the training phase).
+   if (fEntryCurrent <= entry  && entry < fEntryNext) return kFALSE;
+
+   // The threads must not use the list of blocks while we rebuild it.
+   WaitUnzipIdle();
+
+   fIsTransferred = kFALSE;
+
+   // Triggered by the user, not the learning phase
+   if (entry == -1)  entry=0;
+
+   TTree::TClusterIterator clusterIter = tree->GetClusterIterator(entry);
+   fEntryCurrent = clusterIter();
+   fEntryNext = clusterIter.GetNextEntry();
+
+   if (fEntryCurrent < fEntryMin) fEntryCurrent = fEntryMin;
+   if (fEntryMax <= 0) fEntryMax = tree->GetEntries();
+   if (fEntryNext > fEntryMax) fEntryNext = fEntryMax;
+
+   // Check if owner has a TEventList set. If yes we optimize for this
+   // Special case reading only the baskets containing entries in the
+   // list.
+   TEventList *elist = fTree->GetEventList();
+   Long64_t chainOffset = 0;
+   if (elist) {
+      if (fTree->IsA() ==TChain::Class()) {
+         TChain *chain = (TChain*)fTree;
+         Int_t t = chain->GetTreeNumber();
+         chainOffset = chain->GetTreeOffset()[t];
       }
+   }
 
+   //clear cache buffer
+   TFileCacheRead::Prefetch(0,0);
+
+   //store baskets
+   for (Int_t i=0;i<fNbranches;i++) {
+      TBranch *b = (TBranch*)fBranches->UncheckedAt(i);
+      if (b->GetDirectory()==0) continue;
+      if (b->GetDirectory()->GetFile() != fFile) continue;
+      Int_t nb = b->GetMaxBaskets();
+      Int_t *lbaskets   = b->GetBasketBytes();
+      Long64_t *entries = b->GetBasketEntry();
+      if (!lbaskets || !entries) continue;
+      //we have found the branch. We now register all its baskets
+      //from the requested offset to the basket below fEntrymax
+      Int_t blistsize = b->GetListOfBaskets()->GetSize();
+      for (Int_t j=0;j<nb;j++) {
+         // This basket has already been read, skip it
+         if (j<blistsize && b->GetListOfBaskets()->UncheckedAt(j)) continue;
+
+         Long64_t pos = b->GetBasketSeek(j);
+         Int_t len = lbaskets[j];
+         if (pos <= 0 || len <= 0) continue;
+         //important: do not try to read fEntryNext, otherwise you jump to the next autoflush
+         if (entries[j] >= fEntryNext) continue;
+         if (entries[j] < entry && (j<nb-1 && entries[j+1] <= entry)) continue;
+         if (elist) {
+            Long64_t emax = fEntryMax;
+            if (j<nb-1) emax = entries[j+1]-1;
+            if (!elist->ContainsRange(entries[j]+chainOffset,emax+chainOffset)) continue;
+         }
+         fNReadPref++;
 
-      // Now fix the size of the status arrays
-      ResetCache();
+         TFileCacheRead::Prefetch(pos,len);
+      }
+      if (gDebug > 0) printf("Entry: %lld, registering baskets branch %s, fEntryNext=%lld, fNseek=%d, fNtot=%d\n",entry,((TBranch*)fBranches->UncheckedAt(i))->GetName(),fEntryNext,fNseek,fNtot);
+   }
 
-      fIsLearning = kFALSE;
+   // Now fix the size of the status arrays
+   ResetCache();
 
-   }
+   fIsLearning = kFALSE;
 
    return kTRUE;
 }
@@ -313,13 +367,27 @@ void TTreeCacheUnzip::SetEntryRange(Long64_t emin, Long64_t emax)
    TTreeCache::SetEntryRange(emin, emax);
 }
 
+//_____________________________________________________________________________
+void TTreeCacheUnzip::SetFile(TFile *file, TFile::ECacheAction action)
+{
+   // Change the underlying TFile. The list of blocks is reset, so the
+   // threads must be done with it first.
+
+   WaitUnzipIdle();
+
+   TTreeCache::SetFile(file, action);
+}
+
 //_____________________________________________________________________________
 void TTreeCacheUnzip::StopLearningPhase()
 {
    // It's the same as TTreeCache::StopLearningPhase but we guarantee that
-   // we start the unzipping just after getting the buffers
-   R__LOCKGUARD(fMutexList);
+   // we start the unzipping just after getting the buffers.
+   // With prefetching, TTreeCache::StopLearningPhase calls FillBuffer,
+   // which waits for the unzipping jobs: fMutexList is not held here, the
+   // jobs could not take it to report their blocks done.
 
+   WaitUnzipIdle();
 
    TTreeCache::StopLearningPhase();
 
@@ -329,6 +397,8 @@ void TTreeCacheUnzip::StopLearningPhase()
 void TTreeCacheUnzip::UpdateBranches(TTree *tree)
 {
    //update pointer to current Tree and recompute pointers to the branches in the cache
+   WaitUnzipIdle();
+
    R__LOCKGUARD(fMutexList);
 
    TTreeCache::UpdateBranches(tree);
@@ -361,6 +431,26 @@ Bool_t TTreeCacheUnzip::IsParallelUnzip()
    return kFALSE;
 }
 
+//_____________________________________________________________________________
+Int_t TTreeCacheUnzip::GetUnzipThreads()
+{
+   // Static function returning the number of threads unzipping the
+   // baskets of each cache: the value given to SetUnzipThreads or, by
+   // default, TTaskScheduler::GetDefaultNThreads().
+
+   if (fgNThreads > 0) return fgNThreads;
+   return TTaskScheduler::GetDefaultNThreads();
+}
+
+//_____________________________________________________________________________
+void TTreeCacheUnzip::SetUnzipThreads(Int_t nthreads)
+{
+   // Static function setting the number of threads used by each
+   // TTreeCacheUnzip created from now on (0: one per core).
+
+   fgNThreads = nthreads > 0 ? nthreads : 0;
+}
+
 //_____________________________________________________________________________
 Bool_t TTreeCacheUnzip::IsActiveThread()
 {
@@ -375,35 +465,30 @@ Bool_t TTreeCacheUnzip::IsActiveThread()
 //_____________________________________________________________________________
 Bool_t TTreeCacheUnzip::IsQueueEmpty()
 {
-   // It says if the queue is empty... useful to see if we have to process
-   // it.
+   // It says if there are no more blocks for the threads to unzip.
    R__LOCKGUARD(fMutexList);
 
    if ( fIsLearning )
       return kTRUE;
 
-   return kFALSE;
+   return fNextTask >= fNTasks;
 }
 
-void TTreeCacheUnzip::WaitUnzipStartSignal()
-{
-   // Here the threads sleep waiting for some blocks to unzip
-
-   fUnzipStartCondition->TimedWaitRelative(2000);
-
-}
 //_____________________________________________________________________________
 void TTreeCacheUnzip::SendUnzipStartSignal(Bool_t broadcast)
 {
-   // This will send the signal corresponfing to the queue... normally used
-   // when we want to start processing the list of buffers.
+   // Start again unzipping jobs for the blocks not yet taken: one, or as
+   // many as allowed if broadcast is true. Normally used when the
+   // application consumed unzipped blocks, so that the jobs stopped by the
+   // memory limit can go on.
 
-   if (gDebug > 0) Info("SendSignal", " fUnzipCondition->Signal()");
+   if (gDebug > 0) Info("SendSignal", " restarting the unzipping jobs");
 
-   if (broadcast)
-      fUnzipStartCondition->Broadcast();
-   else 
-      fUnzipStartCondition->Signal();
+   R__LOCKGUARD(fMutexList);
+   Int_t njobs = broadcast ? fNThreads : 1;
+   Long_t waiting = fNWaiting->Get();
+   fNWaiting->Set(waiting > njobs ? waiting - njobs : 0);
+   StartUnzipJobs(njobs);
 }
 
 //_____________________________________________________________________________
@@ -426,132 +511,134 @@ Int_t TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::EParUnzipMode option)
 }
 
 
-class TTreeCacheUnzipData {
-public:
-   TTreeCacheUnzip *fInstance;
-   Int_t            fCount;
-};
-
 //_____________________________________________________________________________
 Int_t TTreeCacheUnzip::StartThreadUnzip(Int_t nthreads)
 {
-   // The Thread is only a part of the TTreeCache but it is the part that
-   // waits for info in the queue and process it... unfortunatly, a Thread is
-   // not an object an we have to deal with it in the old C-Style way
-   // Returns 0 if the thread was initialized or 1 if it was already running
-   Int_t nt = nthreads;
-   if (nt > 10) nt = 10;
+   // Enable the unzipping by up to nthreads jobs of the shared
+   // TTaskScheduler at once. The jobs are started by ScheduleUnzip.
+   // Returns 1 if the unzipping is enabled.
 
    if (gDebug > 0)
-      Info("StartThreadUnzip", "Going to start %d threads.", nt);
-
-   for (Int_t i = 0; i < nt; i++) {
-      if (!fUnzipThread[i]) {
-         TString nm("UnzipLoop");
-         nm += i;
+      Info("StartThreadUnzip", "Going to unzip with up to %d jobs.", nthreads);
 
-         if (gDebug > 0)
-            Info("StartThreadUnzip", "Going to start thread '%s'", nm.Data());
-
-         TTreeCacheUnzipData *d = new TTreeCacheUnzipData;
-         d->fInstance = this;
-         d->fCount = i;
+   R__LOCKGUARD(fMutexList);
+   if (!fUnzipGroup) fUnzipGroup = new TTaskGroup();
+   fNThreads = nthreads;
+   fActiveThread = kTRUE;
 
-         fUnzipThread[i] = new TThread(nm.Data(), UnzipLoop, (void*)d);
-         if (!fUnzipThread[i])
-            Error("TTreeCacheUnzip::StartThreadUnzip", " Unable to create new thread.");
+   return (fActiveThread == kTRUE);
+}
 
-         fUnzipThread[i]->Run();
+//_____________________________________________________________________________
+Int_t TTreeCacheUnzip::StopThreadUnzip()
+{
+   // Tell the jobs to terminate and wait for them. A job unzipping a block
+   // finishes it first.
 
-         // There is at least one active thread
-         fActiveThread=kTRUE;
+   {
+      R__LOCKGUARD(fMutexList);
+      fActiveThread = kFALSE;
+   }
 
-      }
+   if (fUnzipGroup) {
+      fUnzipGroup->Wait();
+      delete fUnzipGroup;
+      fUnzipGroup = 0;
    }
 
-   return (fActiveThread == kTRUE);
+   return 1;
 }
 
 //_____________________________________________________________________________
-Int_t TTreeCacheUnzip::StopThreadUnzip()
+void TTreeCacheUnzip::ScheduleUnzip()
 {
-   // To stop the thread we only need to change the value of the variable
-   // fActiveThread to false and the loop will stop (of course, we will have)
-   // to do the cleaning after that.
-   // Note: The syncronization part is important here or we will try to delete
-   //       teh object while it's still processing the queue
-   fActiveThread = kFALSE;
+   // Hand out all the blocks of the cache to the unzipping jobs. Called once
+   // the cache has been read; the blocks are taken in file order.
 
-   for (Int_t i = 0; i < 1; i++) {
-      if(fUnzipThread[i]){
+   R__LOCKGUARD(fMutexList);
 
-         SendUnzipStartSignal(kTRUE);
+   fNTasks = fNseek;
+   fNextTask = 0;
+   fNWaiting->Set(0);
+   StartUnzipJobs(fNThreads);
+}
 
-         if (fUnzipThread[i]->Exists()) {
-            fUnzipThread[i]->Join();
-            delete fUnzipThread[i];
-         }
-      }
+//_____________________________________________________________________________
+void TTreeCacheUnzip::StartUnzipJobs(Int_t njobs)
+{
+   // Queue up to njobs unzipping jobs, without exceeding fNThreads jobs at
+   // once, if there are blocks left to unzip. fMutexList must be locked.
 
+   if (!fActiveThread || !fUnzipGroup) return;
+   for (Int_t i = 0; i < njobs && fNJobs < fNThreads && fNextTask < fNTasks; i++) {
+      fNJobs++;
+      fUnzipGroup->Run(new TTreeCacheUnzipJob(this));
    }
-
-   return 1;
 }
 
+//_____________________________________________________________________________
+void TTreeCacheUnzip::WaitUnzipIdle()
+{
+   // Withdraw the blocks not yet taken by the jobs and wait for the
+   // blocks being unzipped. After this the list of blocks and the cache
+   // buffer can be modified.
+   // fMutexList must not be held by the caller: the wait releases only
+   // one level of the recursive lock.
+
+   if (!fParallel) return;
 
+   R__LOCKGUARD(fMutexList);
+
+   fNTasks = 0;
+   fNextTask = 0;
+   fNWaiting->Set(0);
+   while (fNRunning > 0)
+      fUnzipDoneCondition->Wait();
+}
 
 //_____________________________________________________________________________
 void* TTreeCacheUnzip::UnzipLoop(void *arg)
 {
    // This is a static function.
-   // This is the call that will be executed in the Thread generated by
-   // StartThreadTreeCacheUnzip... what we want to do is to inflate the next
-   // series of buffers leaving them in the second cache.
+   // This is the call executed by each unzipping job: it takes the next
+   // block to unzip and unzips it without holding any lock, until no block
+   // is left or the unzipped blocks waiting to be used exceed the allowed
+   // memory (fUnzipBufferSize). In the latter case the job ends and a new
+   // one is started when the application consumes a block (TakeUnzipped).
    // Returns 0 when it finishes
-   TTreeCacheUnzipData *d = (TTreeCacheUnzipData *)arg;
-   TTreeCacheUnzip *unzipMng = d->fInstance;
 
-   TThread::SetCancelOn();
-   TThread::SetCancelDeferred();
-
-   Int_t thrnum = d->fCount;
-   Int_t startindex = thrnum;
-   Int_t locbuffsz = 16384;
-   char *locbuff = new char[16384];
-   Int_t res = 0;
-   Int_t myCycle = 0;
-
-   while( unzipMng->IsActiveThread() ) {
-      res = 1;
+   TTreeCacheUnzip *unzipMng = (TTreeCacheUnzip *)arg;
 
+   while (1) {
+      Int_t loc = -1;
       {
          R__LOCKGUARD(unzipMng->fMutexList);
-         if (myCycle != unzipMng->fCycle) startindex = thrnum;
-         myCycle = unzipMng->fCycle;
-         if (unzipMng->fNseek) startindex = startindex % unzipMng->fNseek;
-         else startindex = -1;
-      }
 
+         if (!unzipMng->fActiveThread || unzipMng->fNextTask >= unzipMng->fNTasks) {
+            unzipMng->fNJobs--;
+            break;
+         }
+         if (unzipMng->fUnzipBytes->Get() >= unzipMng->fUnzipBufferSize) {
+            // Wait for the application to use some of the unzipped blocks.
+            ++(*unzipMng->fNWaiting);
+            unzipMng->fNJobs--;
+            break;
+         }
+
+         loc = unzipMng->fNextTask++;
+         unzipMng->fNRunning++;
+      }
 
-      if (startindex >= 0)
-         res = unzipMng->UnzipCache(startindex, locbuffsz, locbuff);
+      Int_t len = unzipMng->UnzipCache(loc);
 
       {
          R__LOCKGUARD(unzipMng->fMutexList);
-
-         if(!unzipMng->IsActiveThread()) break;
-
-         if ((res == 1) || (!unzipMng->fIsTransferred)) {
-            unzipMng->WaitUnzipStartSignal();
-            startindex = unzipMng->fLastReadPos+3+thrnum;
-         }
+         unzipMng->fNRunning--;
+         if (len > 0) unzipMng->fNUnzip++;
+         unzipMng->fUnzipDoneCondition->Broadcast();
       }
-
-
    }
 
-   delete d;
-   delete [] locbuff;
    return (void *)0;
 }
 
@@ -610,61 +697,42 @@ void TTreeCacheUnzip::ResetCache()
    // in that method we were cleaning the prefetching buffer while here we
    // delete the information about the unzipped buffers
 
-   {
-   R__LOCKGUARD(fMutexList);
+   WaitUnzipIdle();
 
    if (gDebug > 0)
-      Info("ResetCache", "Thread: %ld -- Resetting the cache. fNseek:%d fNSeekMax:%d fTotalUnzipBytes:%lld", TThread::SelfId(), fNseek, fNseekMax, fTotalUnzipBytes);
+      Info("ResetCache", "Thread: %ld -- Resetting the cache. fNseek:%d fNSeekMax:%d fUnzipBytes:%ld", TThread::SelfId(), fNseek, fNseekMax, fUnzipBytes->Get());
 
    // Reset all the lists and wipe all the chunks
    fCycle++;
    for (Int_t i = 0; i < fNseekMax; i++) {
-      if (fUnzipLen) fUnzipLen[i] = 0;
-      if (fUnzipChunks) {
-         if (fUnzipChunks[i]) delete [] fUnzipChunks[i];
-         fUnzipChunks[i] = 0;
-      }
-      if (fUnzipStatus) fUnzipStatus[i] = 0;
-
+      fUnzipLen[i] = 0;
+      delete [] fUnzipChunks[i];
+      fUnzipChunks[i] = 0;
+      fUnzipBlocks[i].Reset();
    }
 
-   while (fActiveBlks.size()) fActiveBlks.pop();
-
    if(fNseekMax < fNseek){
       if (gDebug > 0)
          Info("ResetCache", "Changing fNseekMax from:%d to:%d", fNseekMax, fNseek);
 
-      Byte_t *aUnzipStatus = new Byte_t[fNseek];
-      memset(aUnzipStatus, 0, fNseek*sizeof(Byte_t));
-
       Int_t *aUnzipLen = new Int_t[fNseek];
       memset(aUnzipLen, 0, fNseek*sizeof(Int_t));
 
       char **aUnzipChunks = new char *[fNseek];
       memset(aUnzipChunks, 0, fNseek*sizeof(char *));
 
-      if (fUnzipStatus) delete [] fUnzipStatus;
-      if (fUnzipLen) delete [] fUnzipLen;
-      if (fUnzipChunks) delete [] fUnzipChunks;
+      delete [] fUnzipBlocks;
+      delete [] fUnzipLen;
+      delete [] fUnzipChunks;
 
-      fUnzipStatus  = aUnzipStatus;
+      fUnzipBlocks = new TTreeCacheUnzipBlock[fNseek];
       fUnzipLen  = aUnzipLen;
       fUnzipChunks = aUnzipChunks;
 
       fNseekMax  = fNseek;
    }
 
-
-
-   fLastReadPos = 0;
-   fTotalUnzipBytes = 0;
-   fBlocksToGo = fNseek;
-   }
-
-
-   SendUnzipStartSignal(kTRUE);
-
-
+   fUnzipBytes->Set(0);
 }
 
 //_____________________________________________________________________________
@@ -681,185 +749,42 @@ Int_t TTreeCacheUnzip::GetUnzipBuffer(char **buf, Long64_t pos, Int_t len, Bool_
    Int_t res = 0;
    Int_t loc = -1;
 
-   {
-      R__LOCKGUARD(fMutexList);
-
-
-      // We go straight to TTreeCache/TfileCacheRead, in order to get the info we need
-      //  pointer to the original zipped chunk
-      //  its index in the original unsorted offsets lists
-      //  
-      // Actually there are situations in which copying the buffer is not
-      // useful. But the choice is among doing once more a small memcpy or a binary search in a large array. I prefer the former.
-      // Also, here we prefer not to trigger the (re)population of the chunks in the TFileCacheRead. That is
-      // better to be done in the main thread.
-
-      // And now loc is the position of the chunk in the array of the sorted chunks
-      Int_t myCycle = fCycle;
-
-
-      if (fParallel && !fIsLearning) {
-
-
-         if(fNseekMax < fNseek){
-            if (gDebug > 0)
-               Info("GetUnzipBuffer", "Changing fNseekMax from:%d to:%d", fNseekMax, fNseek);
-
-            Byte_t *aUnzipStatus = new Byte_t[fNseek];
-            memset(aUnzipStatus, 0, fNseek*sizeof(Byte_t));
-
-            Int_t *aUnzipLen = new Int_t[fNseek];
-            memset(aUnzipLen, 0, fNseek*sizeof(Int_t));
-
-            char **aUnzipChunks = new char *[fNseek];
-            memset(aUnzipChunks, 0, fNseek*sizeof(char *));
-
-            for (Int_t i = 0; i < fNseekMax; i++) {
-               aUnzipStatus[i] = fUnzipStatus[i];
-               aUnzipLen[i] = fUnzipLen[i];
-               aUnzipChunks[i] = fUnzipChunks[i];
-            }
-
-            if (fUnzipStatus) delete [] fUnzipStatus;
-            if (fUnzipLen) delete [] fUnzipLen;
-            if (fUnzipChunks) delete [] fUnzipChunks;
-
-            fUnzipStatus  = aUnzipStatus;
-            fUnzipLen  = aUnzipLen;
-            fUnzipChunks = aUnzipChunks;
-
-            fNseekMax  = fNseek;
-         }
-
-
-
-
-
-
-
-         loc = (Int_t)TMath::BinarySearch(fNseek,fSeekSort,pos);
-         if ( (fCycle == myCycle) && (loc >= 0) && (loc < fNseek) && (pos == fSeekSort[loc]) ) {
-
-            // The buffer is, at minimum, in the file cache. We must know its index in the requests list
-            // In order to get its info
-            Int_t seekidx = fSeekIndex[loc];
-
-            fLastReadPos = seekidx;
-
-            do {
-
-
-
-
-               // If the block is ready we get it immediately.
-               // And also we don't have to alloc the blks. This is supposed to be
-               // the main thread of the app.
-               if ((fUnzipStatus[seekidx] == 2) && (fUnzipChunks[seekidx]) && (fUnzipLen[seekidx] > 0)) {
-
-                  //if (gDebug > 0)
-                  //   Info("GetUnzipBuffer", "++++++++++++++++++++ CacheHIT Block wanted: %d  len:%d req_len:%d fNseek:%d", seekidx, fUnzipLen[seekidx], len,  fNseek);
-
-                  if(!(*buf)) {
-                     *buf = fUnzipChunks[seekidx];
-                     fUnzipChunks[seekidx] = 0;
-                     fTotalUnzipBytes -= fUnzipLen[seekidx];
-                     SendUnzipStartSignal(kFALSE);
-                     *free = kTRUE;
-                  }
-                  else {
-                     memcpy(*buf, fUnzipChunks[seekidx], fUnzipLen[seekidx]);
-	             delete fUnzipChunks[seekidx];
-                     fTotalUnzipBytes -= fUnzipLen[seekidx];
-                     fUnzipChunks[seekidx] = 0;
-                     SendUnzipStartSignal(kFALSE);
-                     *free = kFALSE;
-                  }
-
-                  fNFound++;
-
-                  return fUnzipLen[seekidx];
-               }
-
-               // If the status of the unzipped chunk is pending
-               // we wait on the condvar, hoping that the next signal is the good one
-               if ( fUnzipStatus[seekidx] == 1 ) {
-                  //fMutexList->UnLock();
-                  fUnzipDoneCondition->TimedWaitRelative(200);
-                  //fMutexList->Lock();
-
-                  if ( myCycle != fCycle ) {
-                     if (gDebug > 0)
-                        Info("GetUnzipBuffer", "Sudden paging Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-                             IsActiveThread(), fNseek, fIsLearning);
-
-                     fLastReadPos = 0;
-
-                     seekidx = -1;
-                     break;
-                  }
-
-               }
-
-            } while ( fUnzipStatus[seekidx] == 1 );
-
-            //if (gDebug > 0)
-            //   Info("GetUnzipBuffer", "------- Block wanted: %d  status: %d len: %d chunk: %llx ", seekidx, fUnzipStatus[seekidx], fUnzipLen[seekidx], fUnzipChunks[seekidx]);
-
-            // Here the block is not pending. It could be done or aborted or not yet being processed.
-            if ( (seekidx >= 0) && (fUnzipStatus[seekidx] == 2) && (fUnzipChunks[seekidx]) && (fUnzipLen[seekidx] > 0) ) {
-
-               //if (gDebug > 0)
-               //   Info("GetUnzipBuffer", "++++++++++++++++++++ CacheLateHIT Block wanted: %d  len:%d fNseek:%d", seekidx, fUnzipLen[seekidx], fNseek);
-
-               if(!(*buf)) {
-                  *buf = fUnzipChunks[seekidx];
-                  fUnzipChunks[seekidx] = 0;
-                  fTotalUnzipBytes -= fUnzipLen[seekidx];
-                  SendUnzipStartSignal(kFALSE);
-                  *free = kTRUE;
-               }
-               else {
-                  memcpy(*buf, fUnzipChunks[seekidx], fUnzipLen[seekidx]);
-                  delete fUnzipChunks[seekidx];
-                  fTotalUnzipBytes -= fUnzipLen[seekidx];
-                  fUnzipChunks[seekidx] = 0;
-                  SendUnzipStartSignal(kFALSE);
-                  *free = kFALSE;
-               }
-
+   if (fParallel && !fIsLearning && !fEnablePrefetching && !fAsyncReading) {
 
+      // Look the block up in the cache. The first lookup after FillBuffer
+      // sorts and reads the cache; the blocks are then handed to the threads.
+      Int_t found = ReadBufferExt(0, pos, len, loc);
+      if (found == 0 && FillBuffer()) {
+         loc = -1;
+         found = ReadBufferExt(0, pos, len, loc);
+      }
+      if (found == 1 && fIsTransferred && loc >= 0 && loc < fNseek && fBuffer) {
+         if (fNTasks == 0) ScheduleUnzip();
+
+         TTreeCacheUnzipBlock &block = fUnzipBlocks[loc];
+         if (--block.fClaim != 0) {
+            // A thread took the block, wait for it if it is not done yet.
+            if (!block.fDone.Get()) {
+               R__LOCKGUARD(fMutexList);
+               while (!block.fDone.Get())
+                  fUnzipDoneCondition->Wait();
                fNStalls++;
-
-               return fUnzipLen[seekidx];
-            }
-            else {
-               // This is a complete miss. We want to avoid the threads
-               // to try unzipping this block in the future.
-               fUnzipStatus[seekidx] = 2;
-               fUnzipChunks[seekidx] = 0;
-
-               if ((fTotalUnzipBytes < fUnzipBufferSize) && fBlocksToGo)
-                  SendUnzipStartSignal(kFALSE);
-
-               //if (gDebug > 0)
-               //   Info("GetUnzipBuffer", "++++++++++++++++++++ CacheMISS Block wanted: %d  len:%d fNseek:%d", seekidx, len, fNseek);
+            } else {
+               fNFound++;
             }
-
-
-
-         } else {
-            loc = -1;
-            //fLastReadPos = 0;
-            fIsTransferred = kFALSE;
+            res = TakeUnzipped(loc, buf, free);
+            if (res > 0) return res;
          }
 
-      } else {
-         // We need to reset it for new transferences...
-         //ResetCache();
-         //TFileCacheRead::Prefetch(0,0);
+         // The block was not unzipped by a thread (too small, not yet
+         // taken, or already used once): unzip it directly from the cache.
+         res = UnzipBuffer(buf, &fBuffer[fSeekPos[loc]]);
+         *free = kTRUE;
+         fNMissed++;
+         return res;
       }
-
-   } // scope of the lock!
+      loc = -1;
+   }
 
    if (len > fCompBufferSize) {
       delete [] fCompBuffer;
@@ -881,7 +806,6 @@ Int_t TTreeCacheUnzip::GetUnzipBuffer(char **buf, Long64_t pos, Int_t len, Bool_
 
       res = 0;
       if (!ReadBufferExt(fCompBuffer, pos, len, loc)) {
-         //Info("GetUnzipBuffer", "++++++++++++++++++++ CacheMISS %d %d", loc, fNseek);
          fFile->Seek(pos);
          res = fFile->ReadBuffer(fCompBuffer, len);
       }
@@ -905,6 +829,33 @@ Int_t TTreeCacheUnzip::GetUnzipBuffer(char **buf, Long64_t pos, Int_t len, Bool_
 
 }
 
+//_____________________________________________________________________________
+Int_t TTreeCacheUnzip::TakeUnzipped(Int_t loc, char **buf, Bool_t *free)
+{
+   // Give the chunk unzipped by a thread for the block loc to the caller
+   // (see GetUnzipBuffer). Returns its length or 0 if there is none.
+
+   char *chunk = fUnzipChunks[loc];
+   Int_t len = fUnzipLen[loc];
+   if (!chunk || len <= 0) return 0;
+
+   if (!(*buf)) {
+      *buf = chunk;
+      *free = kTRUE;
+   } else {
+      memcpy(*buf, chunk, len);
+      delete [] chunk;
+      *free = kFALSE;
+   }
+   fUnzipChunks[loc] = 0;
+   fUnzipLen[loc] = 0;
+
+   (*fUnzipBytes) -= len;
+   if (fNWaiting->Get() > 0)
+      SendUnzipStartSignal(kFALSE);
+
+   return len;
+}
 
 //_____________________________________________________________________________
 void TTreeCacheUnzip::SetUnzipRelBufferSize(Float_t relbufferSize)
@@ -1029,220 +980,55 @@ Int_t TTreeCacheUnzip::UnzipBuffer(char **dest, char *src)
 }
 
 //_____________________________________________________________________________
-Int_t TTreeCacheUnzip::UnzipCache(Int_t &startindex, Int_t &locbuffsz, char *&locbuff)
+Int_t TTreeCacheUnzip::UnzipCache(Int_t loc)
 {
-   // This inflates all the buffers in the cache.. passing the data to a new
-   // buffer that will only wait there to be read...
-   // We can not inflate all the buffers in the cache so we will try to do
-   // it until the cache gets full... there is a member called fUnzipBufferSize which will
-   // tell us the max size we can allocate for this cache.
-   //
-   // note that we will  unzip in the order they were put into the cache not
-   // the order of the transference so it has to be read in that order or the
-   // pre-unzipping will be useless.
-   //
-   // startindex is used as start index to check for blks to be unzipped
-   //
-   // returns 0 in normal conditions or -1 if error, 1 if it would like to sleep
-   //
-   // This func is supposed to compete among an indefinite number of threads to get a chunk to inflate
-   // in order to accommodate multiple unzippers
-   // Since everything is so async, we cannot use a fixed buffer, we are forced to keep
-   // the individual chunks as separate blocks, whose summed size does not exceed the maximum
-   // allowed. The pointers are kept globally in the array fUnzipChunks
-   Int_t myCycle;
+   // Unzip the block at position loc (in fSeekSort) of the cache into a new
+   // chunk that will wait there to be used by GetUnzipBuffer.
+   // This is called by the threads of the pool, without holding any lock:
+   // the cache buffer is not modified while the threads are busy (see
+   // WaitUnzipIdle) and each block is unzipped by only one thread, the one
+   // that claims it first.
+   // Returns the length of the unzipped chunk, 0 if the block was left to
+   // the application.
+
+   // Small blocks are not worth it, and the application may have taken
+   // this block already.
+   if (fSeekSortLen[loc] <= kMinUnzipTaskSize) return 0;
+   TTreeCacheUnzipBlock &block = fUnzipBlocks[loc];
+   if (--block.fClaim != 0) return 0;
+
+   char *src = &fBuffer[fSeekPos[loc]];
    const Int_t hlen=128;
-   Int_t objlen=0, keylen=0;
-   Int_t nbytes=0;
-   Int_t readbuf = 0;
-
-   Int_t idxtounzip = -1;
-   Long64_t rdoffs = 0;
-   Int_t rdlen = 0;
-   {
-      R__LOCKGUARD(fMutexList);
-
-      if (!IsActiveThread() || !fNseek || fIsLearning || !fIsTransferred) {
-         if (gDebug > 0)
-            Info("UnzipCache", "Sudden Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-                 IsActiveThread(), fNseek, fIsLearning);
-         return 1;
-      }
-
-      // To synchronize with the 'paging'
-      myCycle = fCycle;
-
-      // Try to look for a blk to unzip
-      idxtounzip = -1;
-      rdoffs = 0;
-      rdlen = 0;
-      if (fTotalUnzipBytes < fUnzipBufferSize) {
-
-
-         if (fBlocksToGo > 0) {
-            for (Int_t ii=0; ii < fNseek; ii++) {
-               Int_t reqi = (startindex+ii) % fNseek;
-               if (!fUnzipStatus[reqi] && (fSeekLen[reqi] > 256)   ) {
-                  // We found a chunk which is not unzipped nor pending
-                  fUnzipStatus[reqi] = 1; // Set it as pending
-                  idxtounzip = reqi;
-
-                  rdoffs = fSeek[idxtounzip];
-                  rdlen = fSeekLen[idxtounzip];
-                  break;
-               }
-            }
-	    if (idxtounzip < 0) fBlocksToGo = 0;
-         }
-
-
-      }
-
-   } // lock scope
-
-
-
-   if (idxtounzip < 0) {
-      if (gDebug > 0)
-         Info("UnzipCache", "Nothing to do... startindex:%d fTotalUnzipBytes:%lld fUnzipBufferSize:%lld fNseek:%d",
-              startindex, fTotalUnzipBytes, fUnzipBufferSize, fNseek );
-      return 1;
-   }
-
-
-   // And here we have a new blk to unzip
-   startindex = idxtounzip+THREADCNT;
-
-
-   if (!IsActiveThread() || !fNseek || fIsLearning ) {
-      if (gDebug > 0)
-         Info("UnzipCache", "Sudden Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-              IsActiveThread(), fNseek, fIsLearning);
-      return 1;
-   }
-
-   Int_t loc = -1;
-
-   // Prepare a static tmp buf of adequate size
-   if(locbuffsz < rdlen) {
-      if (locbuff) delete [] locbuff;
-      locbuffsz = rdlen;
-      locbuff = new char[locbuffsz];
-      //memset(locbuff, 0, locbuffsz);
-   } else
-      if(locbuffsz > rdlen*3) {
-         if (locbuff) delete [] locbuff;
-         locbuffsz = rdlen*2;
-         locbuff = new char[locbuffsz];
-         //memset(locbuff, 0, locbuffsz);
-      }
-
-
-      if (gDebug > 0) 
-      Info("UnzipCache", "Going to unzip block %d", idxtounzip);
-
-      readbuf = ReadBufferExt(locbuff, rdoffs, rdlen, loc);
-
-   {
-      R__LOCKGUARD(fMutexList);
-
-      if ( (myCycle != fCycle) || !fIsTransferred )  {
-         if (gDebug > 0)
-            Info("UnzipCache", "Sudden paging Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-                 IsActiveThread(), fNseek, fIsLearning);
-
-         fUnzipStatus[idxtounzip] = 2; // Set it as not done
-         fUnzipChunks[idxtounzip] = 0;
-         fUnzipLen[idxtounzip] = 0;
-         fUnzipDoneCondition->Signal();
-         
-         startindex = 0;
-         return 1;
-      }
-
-
-      if (readbuf <= 0) {
-         fUnzipStatus[idxtounzip] = 2; // Set it as not done
-         fUnzipChunks[idxtounzip] = 0;
-         fUnzipLen[idxtounzip] = 0;
-         if (gDebug > 0)
-            Info("UnzipCache", "Block %d not done. rdoffs=%lld rdlen=%d readbuf=%d", idxtounzip, rdoffs, rdlen, readbuf);
-         return -1;
-      }
-
-
-      GetRecordHeader(locbuff, hlen, nbytes, objlen, keylen);
-
-      Int_t len = (objlen > nbytes-keylen)? keylen+objlen : nbytes;
-
-      // If the single unzipped chunk is really too big, reset it to not processable
-      // I.e. mark it as done but set the pointer to 0
-      // This block will be unzipped synchronously in the main thread
-      if (len > 4*fUnzipBufferSize) {
-
-         //if (gDebug > 0)
-            Info("UnzipCache", "Block %d is too big, skipping.", idxtounzip);
-
-         fUnzipStatus[idxtounzip] = 2; // Set it as done
-         fUnzipChunks[idxtounzip] = 0;
-         fUnzipLen[idxtounzip] = 0;
-
-         fUnzipDoneCondition->Signal();
-         return 0;
-      }
-
-   } // Scope of the lock
+   Int_t nbytes=0, objlen=0, keylen=0;
+   GetRecordHeader(src, hlen, nbytes, objlen, keylen);
+   Int_t len = (objlen > nbytes-keylen)? keylen+objlen : nbytes;
 
-   // Unzip it into a new blk
    char *ptr = 0;
    Int_t loclen = 0;
 
-   loclen = UnzipBuffer(&ptr, locbuff);
-
-   if ((loclen > 0) && (loclen == objlen+keylen)) {
-      R__LOCKGUARD(fMutexList);
-
-      if ( (myCycle != fCycle)  || !fIsTransferred) {
+   // If the single unzipped chunk is really too big, leave it to the
+   // application, which will unzip it synchronously.
+   if (len <= 4*fUnzipBufferSize) {
+      loclen = UnzipBuffer(&ptr, src);
+      if (loclen != objlen+keylen) {
          if (gDebug > 0)
-            Info("UnzipCache", "Sudden paging Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-                 IsActiveThread(), fNseek, fIsLearning);
+            Info("UnzipCache", "Block %d not done. loclen:%d objlen:%d keylen:%d", loc, loclen, objlen, keylen);
          delete [] ptr;
-
-         fUnzipStatus[idxtounzip] = 2; // Set it as not done
-         fUnzipChunks[idxtounzip] = 0;
-         fUnzipLen[idxtounzip] = 0;
-
-         startindex = 0;
-         fUnzipDoneCondition->Signal();
-         return 1;
+         ptr = 0;
+         loclen = 0;
       }
-
-      fUnzipStatus[idxtounzip] = 2; // Set it as done
-      fUnzipChunks[idxtounzip] = ptr;
-      fUnzipLen[idxtounzip] = loclen;
-      fTotalUnzipBytes += loclen;
-
-      fActiveBlks.push(idxtounzip);
-
-      if (gDebug > 0)
-         Info("UnzipCache", "reqi:%d, rdoffs:%lld, rdlen: %d, loclen:%d",
-              idxtounzip, rdoffs, rdlen, loclen);
-
-      fNUnzip++;
-   }
-   else {
-      R__LOCKGUARD(fMutexList);
-      Info("argh", "loclen:%d objlen:%d loc:%d readbuf:%d", loclen, objlen, loc, readbuf);
-      fUnzipStatus[idxtounzip] = 2; // Set it as done
-      fUnzipChunks[idxtounzip] = 0;
-      fUnzipLen[idxtounzip] = 0;
+   } else if (gDebug > 0) {
+      Info("UnzipCache", "Block %d is too big, skipping.", loc);
    }
 
+   fUnzipChunks[loc] = ptr;
+   fUnzipLen[loc] = loclen;
+   if (loclen > 0) (*fUnzipBytes) += loclen;
 
-   fUnzipDoneCondition->Signal();
+   // Publish the chunk (atomic increment, after the stores above).
+   ++block.fDone;
 
-   delete [] ptr;
-   return 0;
+   return loclen;
 }
 
 void  TTreeCacheUnzip::Print(Option_t* option) const {
@@ -35,9 +35,29 @@
 #include "TLeafS.h"
 #include "TLeafO.h"
 #include "TLeafC.h"
+#include "TTaskScheduler.h"
+#include "Compression.h"
 
 #include <algorithm>
 
+namespace {
+   // Maximum number of bytes of uncompressed baskets held at once while
+   // recompressing.
+   const Long64_t kMaxRecompressBytes = 64*1024*1024;
+
+   class TBasketRecompressJob : public TTaskScheduler::TJob {
+   public:
+      // Recompress one basket read by TTreeCloner::WriteBasketsRecompressed.
+      TBasket *fBasket;
+      Int_t    fSettings;
+      Int_t   *fResult;
+
+      TBasketRecompressJob(TBasket *basket, Int_t settings, Int_t *result) :
+         fBasket(basket), fSettings(settings), fResult(result) {}
+      virtual void Execute() { *fResult = fBasket->Recompress(fSettings); }
+   };
+}
+
 //______________________________________________________________________________
 Bool_t TTreeCloner::CompareSeek::operator()(UInt_t i1, UInt_t i2)
 {
@@ -78,7 +98,8 @@ TTreeCloner::TTreeCloner(TTree *from, TTree *to, Option_t *method, UInt_t option
    fBasketIndex(new UInt_t[fMaxBaskets]),
    fPidOffset(0),
    fCloneMethod(TTreeCloner::kDefault),
-   fToStartEntries(0)
+   fToStartEntries(0),
+   fRecompress(kFALSE)
 {
    // Constructor.  This object would transfer the data from
    // 'from' to 'to' using the method indicated in method.
@@ -118,9 +139,17 @@ TTreeCloner::TTreeCloner(TTree *from, TTree *to, Option_t *method, UInt_t option
    // in which they will be needed when reading the whole tree
    // sequentially.
    //
+   // If 'method' contains "recompress", the baskets of the branches whose
+   // compression settings differ from the ones of the output branch are
+   // unzipped and zipped again with the settings of the output branch,
+   // without unstreaming their content. The baskets are recompressed in
+   // parallel by the jobs of the shared TTaskScheduler and written in the
+   // same order as without recompression.
+   //
 
    TString opt(method);
    opt.ToLower();
+   fRecompress = opt.Contains("recompress");
    if (opt.Contains("sortbasketsbybranch")) {
       //::Info("TTreeCloner::TTreeCloner","use: kSortBasketsByBranch");
       fCloneMethod = TTreeCloner::kSortBasketsByBranch;
@@ -621,6 +650,11 @@ void TTreeCloner::WriteBaskets()
 {
    // Transfer the basket from the input file to the output file
 
+   if (fRecompress) {
+      WriteBasketsRecompressed();
+      return;
+   }
+
    TBasket *basket = new TBasket();
    for(UInt_t j=0; j<fMaxBaskets; ++j) {
       TBranch *from = (TBranch*)fFromBranches.UncheckedAt( fBasketBranchNum[ fBasketIndex[j] ] );
@@ -654,3 +688,104 @@ void TTreeCloner::WriteBaskets()
    }
    delete basket;
 }
+
+//______________________________________________________________________________
+void TTreeCloner::WriteBasketsRecompressed()
+{
+   // Transfer the basket from the input file to the output file, recompressing
+   // the baskets whose branch has compression settings different from the
+   // output branch. The baskets are handled in batches: a batch is read,
+   // recompressed in parallel, then written in order.
+
+   TFile *fromfile0 = fFromTree->GetCurrentFile();
+   if (fromfile0 && fromfile0->GetVersion() <= 30401) {
+      // The uncompressed baskets of these files are not recognizable.
+      Warning("WriteBaskets", "the baskets of %s are copied without recompression (old file format)",
+              fromfile0->GetName());
+      fRecompress = kFALSE;
+      WriteBaskets();
+      return;
+   }
+
+   TTaskScheduler *scheduler = TTaskScheduler::Instance();
+   UInt_t maxbatch = 16 * scheduler->GetNThreads();
+
+   std::vector<TBasket*> batch;
+   std::vector<UInt_t>   indices;
+   std::vector<Int_t>    results;
+   UInt_t j = 0;
+   while (j < fMaxBaskets) {
+      // Read a batch of baskets.
+      batch.clear();
+      indices.clear();
+      Long64_t nbytes = 0;
+      while (j < fMaxBaskets && batch.size() < maxbatch && nbytes < kMaxRecompressBytes) {
+         TBranch *from = (TBranch*)fFromBranches.UncheckedAt( fBasketBranchNum[ fBasketIndex[j] ] );
+         Int_t index = fBasketNum[ fBasketIndex[j] ];
+         TBasket *basket = 0;
+         Long64_t pos = from->GetBasketSeek(index);
+         if (pos != 0) {
+            TFile *fromfile = from->GetFile(0);
+            basket = new TBasket();
+            if (from->GetBasketBytes()[index] == 0) {
+               from->GetBasketBytes()[index] = basket->ReadBasketBytes(pos, fromfile);
+            }
+            Int_t len = from->GetBasketBytes()[index];
+            basket->LoadBasketBuffers(pos,len,fromfile,fFromTree);
+            basket->IncrementPidOffset(fPidOffset);
+            nbytes += basket->GetObjlen();
+         }
+         batch.push_back(basket);
+         indices.push_back(j);
+         ++j;
+      }
+
+      // Recompress them.
+      results.assign(batch.size(), 0);
+      {
+         TTaskGroup group(scheduler);
+         for (UInt_t k = 0; k < batch.size(); ++k) {
+            if (!batch[k]) continue;
+            TBranch *from = (TBranch*)fFromBranches.UncheckedAt( fBasketBranchNum[ fBasketIndex[indices[k]] ] );
+            TBranch *to   = (TBranch*)fToBranches.UncheckedAt( fBasketBranchNum[ fBasketIndex[indices[k]] ] );
+            Int_t settings = to->GetCompressionSettings();
+            if (settings == from->GetCompressionSettings()) continue;
+            Int_t algorithm = to->GetCompressionAlgorithm();
+            if (to->GetCompressionLevel() > 0 &&
+                (algorithm == ROOT::kUseGlobalSetting || algorithm == ROOT::kOldCompressionAlgo)) {
+               // The old compression algorithm uses global state: compress
+               // these baskets serially.
+               results[k] = batch[k]->Recompress(settings);
+            } else {
+               group.Run(new TBasketRecompressJob(batch[k], settings, &results[k]));
+            }
+         }
+         group.Wait();
+      }
+
+      // Write them in order.
+      for (UInt_t k = 0; k < batch.size(); ++k) {
+         TBranch *from = (TBranch*)fFromBranches.UncheckedAt( fBasketBranchNum[ fBasketIndex[indices[k]] ] );
+         TBranch *to   = (TBranch*)fToBranches.UncheckedAt( fBasketBranchNum[ fBasketIndex[indices[k]] ] );
+         Int_t index = fBasketNum[ fBasketIndex[indices[k]] ];
+         TBasket *basket = batch[k];
+         if (basket) {
+            if (results[k] < 0) {
+               Warning("WriteBaskets", "basket %d of branch %s is copied without recompression",
+                       index, from->GetName());
+            }
+            basket->CopyTo(to->GetFile(0));
+            to->AddBasket(*basket,kTRUE,fToStartEntries + from->GetBasketEntry()[index]);
+            delete basket;
+         } else {
+            TBasket *frombasket = from->GetBasket( index );
+            if (frombasket && frombasket->GetNevBuf()>0) {
+               TBasket *tobasket = (TBasket*)frombasket->Clone();
+               tobasket->SetBranch(to);
+               to->AddBasket(*tobasket, kFALSE, fToStartEntries+from->GetBasketEntry()[index]);
+               to->FlushOneBasket(to->GetWriteBasket());
+            }
+         }
+      }
+   }
+}
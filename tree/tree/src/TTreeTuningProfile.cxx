@@ -0,0 +1,295 @@
+// @(#)root/tree:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TTreeTuningProfile                                                   //
+//                                                                      //
+// A tuning profile records, for each branch of a tree, how many        //
+// entries an analysis read and the average size of an entry. It is    //
+// filled while reading the tree, from the branches kept by the         //
+// TTreeCache once its learning phase is over (AddCachedBranches) or    //
+// from the counters of TTreePerfStats (TTreePerfStats::                //
+// MakeTuningProfile), saved in a file, and given to                    //
+// TTree::SetTuningProfile when the next version of the tree is         //
+// written:                                                             //
+//                                                                      //
+//  - the branches read for at least half as many entries as the most   //
+//    read branch are 'hot';                                            //
+//  - the cluster size (see TTree::SetAutoFlush) is chosen so that the  //
+//    hot branches of a cluster take about GetCacheSize() bytes on file //
+//    (the TTreeCache reads them in one vectored read), while all the   //
+//    baskets of a cluster take less than GetMaxMemory() bytes in       //
+//    memory;                                                           //
+//  - the basket size of each branch is chosen to hold the entries of   //
+//    a cluster, so that a branch has one basket per cluster;           //
+//  - the baskets of the hot branches are written first when a cluster  //
+//    is flushed, so that they are contiguous on disk.                  //
+//                                                                      //
+// Recording (after the event loop):                                    //
+//                                                                      //
+//    TTreeTuningProfile profile("T_profile", T);                       //
+//    ... // event loop, with a TTreeCache                              //
+//    profile.AddCachedBranches();                                      //
+//    TFile out("profile.root", "RECREATE");                            //
+//    profile.Write();                                                  //
+//                                                                      //
+// Writing the next version of the tree:                                //
+//                                                                      //
+//    TTreeTuningProfile *profile = 0;                                  //
+//    pfile->GetObject("T_profile", profile);                           //
+//    ... // create T and its branches                                  //
+//    T->SetTuningProfile(profile);                                     //
+//    ... // fill T                                                     //
+//                                                                      //
+// The profiles of several jobs can be merged (e.g. by hadd).           //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#include "TTreeTuningProfile.h"
+#include "TBranch.h"
+#include "TCollection.h"
+#include "TFile.h"
+#include "TLeaf.h"
+#include "TTree.h"
+#include "TTreeCache.h"
+
+ClassImp(TTreeTuningProfile)
+
+//______________________________________________________________________________
+TTreeTuningProfile::TTreeTuningProfile() : TNamed(),
+   fCacheSize(30000000), fMaxMemory(100000000), fTree(0)
+{
+   // Default constructor.
+}
+
+//______________________________________________________________________________
+TTreeTuningProfile::TTreeTuningProfile(const char *name, TTree *tree) :
+   TNamed(name, "Tree tuning profile"),
+   fCacheSize(30000000), fMaxMemory(100000000), fTree(tree)
+{
+   // Create a profile for tree, with the size of the entries of each of
+   // its branches holding data and no entry read yet. For a TChain, the
+   // sizes are taken from its current tree.
+
+   if (!fTree) return;
+   fTreeName = fTree->GetName();
+   TTree *current = fTree->GetTree();
+   if (!current) current = fTree;
+   TObjArray *leaves = current->GetListOfLeaves();
+   Int_t nleaves = leaves->GetEntriesFast();
+   for (Int_t i = 0; i < nleaves; ++i) {
+      TLeaf *leaf = (TLeaf*)leaves->UncheckedAt(i);
+      TBranch *branch = leaf ? leaf->GetBranch() : 0;
+      if (!branch || FindBranch(branch->GetName())) continue;
+      TBranchProfile profile;
+      profile.fName = branch->GetName();
+      Long64_t nentries = branch->GetEntries();
+      if (nentries > 0) {
+         profile.fBytesPerEntry = Double_t(branch->GetTotBytes()) / nentries;
+         profile.fZipBytesPerEntry = Double_t(branch->GetZipBytes()) / nentries;
+      }
+      fBranches.push_back(profile);
+   }
+}
+
+//______________________________________________________________________________
+TTreeTuningProfile::~TTreeTuningProfile()
+{
+   // Destructor.
+}
+
+//______________________________________________________________________________
+Int_t TTreeTuningProfile::AddCachedBranches()
+{
+   // Count as read, for all the entries of the current tree, the branches
+   // of the TTreeCache of the tree. Call it once the learning phase of the
+   // cache is over, e.g. after the event loop; for a TChain, call it after
+   // each of its trees has been processed.
+   //
+   // Return the number of branches added, or -1 if the tree has no cache.
+
+   if (!fTree) return -1;
+   TFile *file = fTree->GetCurrentFile();
+   if (!file) return -1;
+   TTreeCache *tc = dynamic_cast<TTreeCache*>(file->GetCacheRead(fTree));
+   if (!tc && fTree->GetTree()) tc = dynamic_cast<TTreeCache*>(file->GetCacheRead(fTree->GetTree()));
+   if (!tc) {
+      Error("AddCachedBranches", "the tree %s has no TTreeCache", fTreeName.Data());
+      return -1;
+   }
+   if (tc->IsLearning()) {
+      Warning("AddCachedBranches", "the TTreeCache of %s is still learning: some branches read may be missing",
+              fTreeName.Data());
+   }
+   const TObjArray *branches = tc->GetCachedBranches();
+   if (!branches) return 0;
+   TTree *current = fTree->GetTree() ? fTree->GetTree() : fTree;
+   Long64_t nentries = current->GetEntries();
+   Int_t nb = branches->GetEntriesFast();
+   for (Int_t i = 0; i < nb; ++i) {
+      TBranch *branch = (TBranch*)branches->UncheckedAt(i);
+      if (branch) AddRead(branch->GetName(), nentries);
+   }
+   return nb;
+}
+
+//______________________________________________________________________________
+void TTreeTuningProfile::AddRead(const char *branchname, Long64_t nentries)
+{
+   // Add nentries to the number of entries of the branch read.
+
+   TBranchProfile *profile = FindBranch(branchname);
+   if (!profile) {
+      // Not a branch of the tree given to the constructor: its size is not known.
+      fBranches.push_back(TBranchProfile());
+      profile = &fBranches.back();
+      profile->fName = branchname;
+   }
+   profile->fEntriesRead += nentries;
+}
+
+//______________________________________________________________________________
+TTreeTuningProfile::TBranchProfile *TTreeTuningProfile::FindBranch(const char *name)
+{
+   // Return the profile of the branch, 0 if there is none.
+
+   for (UInt_t i = 0; i < fBranches.size(); ++i) {
+      if (fBranches[i].fName == name) return &fBranches[i];
+   }
+   return 0;
+}
+
+//______________________________________________________________________________
+const TTreeTuningProfile::TBranchProfile *TTreeTuningProfile::FindBranch(const char *name) const
+{
+   // Return the profile of the branch, 0 if there is none.
+
+   for (UInt_t i = 0; i < fBranches.size(); ++i) {
+      if (fBranches[i].fName == name) return &fBranches[i];
+   }
+   return 0;
+}
+
+//______________________________________________________________________________
+Int_t TTreeTuningProfile::GetBasketSize(const TBranch *branch) const
+{
+   // Return the basket size holding the entries of a cluster of the branch,
+   // or 0 if the profile has nothing to say about it.
+
+   const TBranchProfile *profile = FindBranch(branch->GetName());
+   if (!profile || profile->fBytesPerEntry <= 0) return 0;
+   Long64_t cluster = GetClusterSize();
+   if (cluster <= 0) return 0;
+
+   // The entries, their offsets and the key, with some room for the
+   // clusters whose entries are larger than the average.
+   Double_t entrysize = profile->fBytesPerEntry;
+   if (branch->GetEntryOffsetLen()) entrysize += 2 * sizeof(Int_t);
+   Double_t size = 1.1 * cluster * entrysize + 100 + strlen(branch->GetName());
+
+   static const Double_t hardmax = 1*1024*1024*1024; // As in TTree::OptimizeBaskets.
+   if (size > fMaxMemory) size = fMaxMemory;
+   if (size > hardmax) size = hardmax;
+   Int_t bsize = (Int_t)size;
+   bsize += 512 - bsize%512;
+   return bsize;
+}
+
+//______________________________________________________________________________
+Long64_t TTreeTuningProfile::GetClusterSize() const
+{
+   // Return the number of entries per cluster: the hot branches of a
+   // cluster take about GetCacheSize() bytes on file, and all the baskets
+   // of a cluster less than GetMaxMemory() bytes in memory. Return 0 if no
+   // entry was read or the sizes of the branches are not known.
+
+   if (GetMaxEntriesRead() == 0) return 0;
+   Double_t hotzip = 0;
+   Double_t all = 0;
+   for (UInt_t i = 0; i < fBranches.size(); ++i) {
+      all += fBranches[i].fBytesPerEntry;
+      if (IsHot(fBranches[i].fName)) hotzip += fBranches[i].fZipBytesPerEntry;
+   }
+   Double_t cluster = -1;
+   if (hotzip > 0) cluster = fCacheSize / hotzip;
+   if (all > 0 && (cluster < 0 || fMaxMemory / all < cluster)) cluster = fMaxMemory / all;
+   if (cluster < 0) return 0;
+   return cluster < 1 ? 1 : (Long64_t)cluster;
+}
+
+//______________________________________________________________________________
+Long64_t TTreeTuningProfile::GetMaxEntriesRead() const
+{
+   // Return the largest number of entries read of a branch.
+
+   Long64_t maxread = 0;
+   for (UInt_t i = 0; i < fBranches.size(); ++i) {
+      if (fBranches[i].fEntriesRead > maxread) maxread = fBranches[i].fEntriesRead;
+   }
+   return maxread;
+}
+
+//______________________________________________________________________________
+Bool_t TTreeTuningProfile::IsHot(const char *branchname) const
+{
+   // Return kTRUE if the branch was read for at least half as many entries
+   // as the most read branch.
+
+   const TBranchProfile *profile = FindBranch(branchname);
+   if (!profile || profile->fEntriesRead == 0) return kFALSE;
+   return 2 * profile->fEntriesRead >= GetMaxEntriesRead();
+}
+
+//______________________________________________________________________________
+Long64_t TTreeTuningProfile::Merge(TCollection *list)
+{
+   // Add the entries read of the profiles in list to this one. The sizes
+   // of the branches unknown to this profile are taken from the others.
+   // Return the number of branches, or -1 in case of error.
+
+   if (!list) return -1;
+   TIter next(list);
+   TObject *obj;
+   while ((obj = next())) {
+      TTreeTuningProfile *other = dynamic_cast<TTreeTuningProfile*>(obj);
+      if (!other) {
+         Error("Merge", "cannot merge a %s with a TTreeTuningProfile", obj->ClassName());
+         return -1;
+      }
+      if (fTreeName.IsNull()) fTreeName = other->fTreeName;
+      for (UInt_t i = 0; i < other->fBranches.size(); ++i) {
+         const TBranchProfile &src = other->fBranches[i];
+         AddRead(src.fName, src.fEntriesRead);
+         TBranchProfile *dest = FindBranch(src.fName);
+         if (dest->fBytesPerEntry <= 0) {
+            dest->fBytesPerEntry = src.fBytesPerEntry;
+            dest->fZipBytesPerEntry = src.fZipBytesPerEntry;
+         }
+      }
+   }
+   return GetNBranches();
+}
+
+//______________________________________________________________________________
+void TTreeTuningProfile::Print(Option_t *) const
+{
+   // Print the cluster size and the profile of each branch.
+
+   Printf("TTreeTuningProfile %s for tree %s: %lld entries per cluster", GetName(),
+          fTreeName.Data(), GetClusterSize());
+   Printf("   (%lld bytes on file of hot branches, %lld bytes in memory at most per cluster)",
+          fCacheSize, fMaxMemory);
+   for (UInt_t i = 0; i < fBranches.size(); ++i) {
+      const TBranchProfile &p = fBranches[i];
+      Printf("   %-40s %12lld entries read %10.1f bytes/entry %10.1f on file%s", p.fName.Data(),
+             p.fEntriesRead, p.fBytesPerEntry, p.fZipBytesPerEntry, IsHot(p.fName) ? "  hot" : "");
+   }
+}
@@ -19,12 +19,17 @@
 #pragma link C++ class TSelectorEntries;
 #pragma link C++ class TFileDrawMap+;
 #pragma link C++ class TTreeIndex-;
+#pragma link C++ class TTreeBlockIndex-;
+#pragma link C++ class TTreeBlockIndex::TBlock+;
 #pragma link C++ class TChainIndex+;
 #pragma link C++ class TChainIndex::TChainIndexEntry+;
 #pragma link C++ class TTreeFormulaManager;
 #pragma link C++ class TTreeDrawArgsParser+;
 #pragma link C++ class TTreePerfStats+;
+#pragma link C++ class TTreePerfStats::TBranchStats+;
 #pragma link C++ class TTreeReader+;
+#pragma link C++ class TTreeProcessor+;
+#pragma link C++ class TTreeStatsFilter+;
 #pragma link C++ class TTreeTableInterface;
 
 #pragma link C++ namespace ROOT;
@@ -0,0 +1,116 @@
+// @(#)root/treeplayer:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#ifndef ROOT_TTreeBlockIndex
+#define ROOT_TTreeBlockIndex
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TTreeBlockIndex                                                      //
+//                                                                      //
+// A Tree Index with majorname and minorname whose sorted table is      //
+// stored in the file in compressed blocks, read only when needed.      //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef ROOT_TVirtualIndex
+#include "TVirtualIndex.h"
+#endif
+
+#include <vector>
+
+class TTreeFormula;
+
+class TTreeBlockIndex : public TVirtualIndex {
+
+public:
+   // A block of the sorted index table: fValues[i] (major<<31 + minor)
+   // is at entry fEntries[i]. On file the values are delta encoded.
+   class TBlock : public TObject {
+   public:
+      Int_t     fN;         // Number of entries in the block
+      Long64_t *fValues;    //[fN] Sorted index values
+      Long64_t *fEntries;   //[fN] Entry numbers of the sorted values
+
+      TBlock() : fN(0), fValues(0), fEntries(0) {}
+      TBlock(Int_t n, const Long64_t *values, const Long64_t *entries);
+      virtual ~TBlock();
+      void Decode();
+      void Encode();
+
+   private:
+      TBlock(const TBlock&);            // Not implemented.
+      TBlock &operator=(const TBlock&); // Not implemented.
+
+      ClassDef(TBlock,1); // A block of a TTreeBlockIndex
+   };
+
+protected:
+   TString        fMajorName;           // Index major name
+   TString        fMinorName;           // Index minor name
+   Long64_t       fN;                   // Number of entries
+   Int_t          fBlockSize;           // Maximum number of entries per block
+   Int_t          fNBlocks;             // Number of blocks
+   Long64_t      *fBlockMin;            //[fNBlocks] Smallest index value of each block
+   Long64_t      *fBlockMax;            //[fNBlocks] Largest index value of each block
+   Long64_t      *fBlockSeek;           //[fNBlocks] Position of the key of each block in the file (0 if in memory)
+   Int_t         *fBlockNbytes;         //[fNBlocks] Size of the key of each block
+   mutable TBlock **fBlocks;            //! Blocks currently in memory
+   mutable std::vector<Int_t> fCached;  //! Blocks read from the file, in the order they were read
+   Int_t          fMaxCached;           //! Maximum number of blocks read from the file kept in memory
+   mutable Long64_t fNBlocksRead;       //! Number of blocks read from the file
+   TTreeFormula  *fMajorFormula;        //! Pointer to major TreeFormula
+   TTreeFormula  *fMinorFormula;        //! Pointer to minor TreeFormula
+   TTreeFormula  *fMajorFormulaParent;  //! Pointer to major TreeFormula in Parent tree (if any)
+   TTreeFormula  *fMinorFormulaParent;  //! Pointer to minor TreeFormula in Parent tree (if any)
+
+   void           AllocateBlocks(Int_t nblocks);
+   void           DeleteBlocks();
+   Int_t          FindBlock(Long64_t value) const;
+   TBlock        *GetBlock(Int_t i) const;
+   void           SetBlocks(Long64_t n, const Long64_t *values, const Long64_t *entries);
+   Bool_t         WriteBlocks();
+
+private:
+   TTreeBlockIndex(const TTreeBlockIndex&);            // Not implemented.
+   TTreeBlockIndex &operator=(const TTreeBlockIndex&); // Not implemented.
+
+public:
+   TTreeBlockIndex();
+   TTreeBlockIndex(const TTree *T, const char *majorname, const char *minorname, Int_t blocksize = 16384);
+   virtual               ~TTreeBlockIndex();
+   virtual void           Append(const TVirtualIndex *,Bool_t delaySort = kFALSE);
+   Int_t                  GetBlockSize()    const {return fBlockSize;}
+   virtual Long64_t       GetEntryNumberFriend(const TTree *parent);
+   virtual Long64_t       GetEntryNumberWithIndex(Int_t major, Int_t minor) const;
+   virtual Long64_t       GetEntryNumberWithBestIndex(Int_t major, Int_t minor) const;
+   Long64_t               GetMaxIndexValue() const {return fNBlocks ? fBlockMax[fNBlocks-1] : 0;}
+   Int_t                  GetMaxCached()    const {return fMaxCached;}
+   Long64_t               GetMinIndexValue() const {return fNBlocks ? fBlockMin[0] : 0;}
+   const char            *GetMajorName()    const {return fMajorName.Data();}
+   const char            *GetMinorName()    const {return fMinorName.Data();}
+   virtual Long64_t       GetN()            const {return fN;}
+   Int_t                  GetNBlocks()      const {return fNBlocks;}
+   Long64_t               GetNBlocksRead()  const {return fNBlocksRead;}
+   virtual TTreeFormula  *GetMajorFormula();
+   virtual TTreeFormula  *GetMinorFormula();
+   virtual TTreeFormula  *GetMajorFormulaParent(const TTree *parent);
+   virtual TTreeFormula  *GetMinorFormulaParent(const TTree *parent);
+   Bool_t                 LoadBlocks();
+   virtual void           Print(Option_t *option="") const;
+   void                   SetMaxCached(Int_t n);
+   virtual void           UpdateFormulaLeaves(const TTree *parent);
+   virtual void           SetTree(const TTree *T);
+
+   ClassDef(TTreeBlockIndex,1);  //A Tree Index stored in compressed blocks read on demand
+};
+
+#endif
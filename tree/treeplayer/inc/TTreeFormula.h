@@ -120,6 +120,10 @@ protected:
    Bool_t                    fDidBooleanOptimization;  //! True if we executed one boolean optimization since the last time instance number 0 was evaluated
    TTreeFormulaManager      *fManager;        //! The dimension coordinator.
 
+   typedef Bool_t   (*TJitOperand_t)(TTreeFormula*, Int_t, Int_t, Bool_t, Double_t*);
+   typedef Double_t (*TJitKernel_t)(TTreeFormula*, Int_t, Bool_t, Bool_t*, const Double_t*, TJitOperand_t);
+   TJitKernel_t              fJitKernel;      //! Function compiled by Jit()
+
    // Helper members and function used during the construction and parsing
    TList                    *fDimensionSetup; //! list of dimension setups, for delayed creation of the dimension information.
    std::vector<std::string>  fAliasesUsed;    //! List of aliases used during the parsing of the expression.
@@ -128,6 +132,7 @@ protected:
    void Init(const char *name, const char *formula);
    Bool_t      BranchHasMethod(TLeaf* leaf, TBranch* branch, const char* method,const char* params, Long64_t readentry) const;
    Int_t       DefineAlternate(const char* expression);
+   Bool_t      EvalOperand(Int_t i, Int_t instance, Bool_t willLoad, Double_t &value);
    void        DefineDimensions(Int_t code, Int_t size, TFormLeafInfoMultiVarDim * info, Int_t& virt_dim);
    Int_t       FindLeafForExpression(const char* expression, TLeaf *&leaf, TString &leftover, Bool_t &final, UInt_t &paran_level, TObjArray &castqueue, std::vector<std::string>& aliasUsed, Bool_t &useLeafCollectionObject, const char *fullExpression);
    TLeaf*      GetLeafWithDatamember(const char* topchoice, const char* nextchice, Long64_t readentry) const;
@@ -150,11 +155,14 @@ protected:
    virtual Bool_t    IsLeafInteger(Int_t code) const;
    virtual Bool_t    IsString(Int_t oper) const;
    virtual Bool_t    IsLeafString(Int_t code) const;
+   virtual Int_t     MakeJitOperator(Int_t i, TString &statement, Int_t &need, Int_t &delta, Int_t &jump) const;
    virtual Bool_t    SwitchToFormLeafInfo(Int_t code);
    virtual Bool_t    StringToNumber(Int_t code);
 
    void              Convert(UInt_t fromVersion);
 
+   static Bool_t     JitOperand(TTreeFormula *form, Int_t i, Int_t instance, Bool_t willLoad, Double_t *value);
+
 private:
    // Not implemented yet
    TTreeFormula(const TTreeFormula&);
@@ -184,8 +192,10 @@ public:
    //the mutable keyword.
    //NOTE: Also modify the code in PrintValue which current goes around this limitation :(
    virtual Bool_t      IsInteger(Bool_t fast=kTRUE) const;
+   virtual Bool_t      IsJitted() const { return fJitKernel != 0; }
            Bool_t      IsQuickLoad() const { return fQuickLoad; }
    virtual Bool_t      IsString() const;
+   virtual Bool_t      Jit();
    virtual Bool_t      Notify() { UpdateFormulaLeaves(); return kTRUE; }
    virtual char       *PrintValue(Int_t mode=0) const;
    virtual char       *PrintValue(Int_t mode, Int_t instance, const char *decform = "9.9") const;
@@ -28,6 +28,8 @@
 #include "TString.h"
 #endif
 
+#include <map>
+#include <vector>
 
 class TBrowser;
 class TFile;
@@ -37,8 +39,30 @@ class TPaveText;
 class TGraphErrors;
 class TGaxis;
 class TText;
+class TTreeTuningProfile;
 class TTreePerfStats : public TVirtualPerfStats {
 
+public:
+   class TBranchStats {
+      // I/O counters of one branch of the tree.
+   public:
+      TBranchStats() : fEntries(0), fBytesRead(0), fBytesUnzipped(0), fBytesStreamed(0),
+                       fBasketsRead(0), fBasketsUnzipped(0), fCacheHits(0), fCacheMisses(0),
+                       fUnzipTime(0), fStreamerTime(0) {}
+
+      TString  fName;            // Name of the branch
+      Long64_t fEntries;         // Number of entries read
+      Long64_t fBytesRead;       // Number of (compressed) bytes of the baskets read
+      Long64_t fBytesUnzipped;   // Number of bytes of the baskets after unzipping
+      Long64_t fBytesStreamed;   // Number of bytes deserialized by GetEntry
+      Int_t    fBasketsRead;     // Number of baskets read
+      Int_t    fBasketsUnzipped; // Number of baskets unzipped when read
+      Int_t    fCacheHits;       // Number of baskets found in the TTreeCache
+      Int_t    fCacheMisses;     // Number of baskets read directly from the file
+      Double_t fUnzipTime;       // Real time spent unzipping the baskets
+      Double_t fStreamerTime;    // Real time spent deserializing the entries
+   };
+
 protected:
    Int_t         fTreeCacheSize; //TTreeCache buffer size
    Int_t         fNleaves;       //Number of leaves in the tree
@@ -62,6 +86,12 @@ protected:
    TStopwatch   *fWatch;         //TStopwatch pointer
    TGaxis       *fRealTimeAxis;  //pointer to TGaxis object showing real-time
    TText        *fHostInfoText;  //Graphics Text object with the fHostInfo data
+   std::vector<TBranchStats> fBranchStats; //I/O counters of each branch read
+   std::map<const TObject*,Int_t> fBranchIndex; //!index in fBranchStats of the branches of fBranchTree
+   const TObject *fBranchTree;   //!tree of the branches in fBranchIndex
+
+   TBranchStats    *FindBranchStats(TObject *branch);
+   void             PrintBranches() const;
       
 public:
    TTreePerfStats();
@@ -71,11 +101,15 @@ public:
    virtual Int_t    DistancetoPrimitive(Int_t px, Int_t py);
    virtual void     Draw(Option_t *option="");
    virtual void     ExecuteEvent(Int_t event, Int_t px, Int_t py);
+   virtual void     Export(const char *filename, Option_t *option="") const;
    virtual void     Finish();
    virtual Long64_t GetBytesRead() const {return fBytesRead;}
    virtual Long64_t GetBytesReadExtra() const {return fBytesReadExtra;}
    virtual Double_t GetCpuTime()   const {return fCpuTime;}
    virtual Double_t GetDiskTime()  const {return fDiskTime;}
+   Int_t            GetNBranchStats() const {return (Int_t)fBranchStats.size();}
+   const TBranchStats *GetBranchStats(Int_t i) const {return (i >= 0 && i < GetNBranchStats()) ? &fBranchStats[i] : 0;}
+   const TBranchStats *GetBranchStats(const char *branchname) const;
    TGraphErrors    *GetGraphIO()     {return fGraphIO;}
    TGraphErrors    *GetGraphTime()   {return fGraphTime;}
    const char      *GetHostInfo() const{return fHostInfo.Data();}
@@ -89,6 +123,7 @@ public:
    TStopwatch      *GetStopwatch() const {return fWatch;}
    virtual Int_t    GetTreeCacheSize() const {return fTreeCacheSize;}
    virtual Double_t GetUnzipTime() const {return fUnzipTime; }
+   TTreeTuningProfile *MakeTuningProfile(const char *name = "") const;
    virtual void     Paint(Option_t *chopt="");
    virtual void     Print(Option_t *option="") const;
 
@@ -99,6 +134,9 @@ public:
    virtual void     FileOpenEvent(TFile *, const char *, Double_t) {}
    virtual void     FileReadEvent(TFile *file, Int_t len, Double_t start);
    virtual void     FileUnzipEvent(TFile *file, Long64_t pos, Double_t start, Int_t complen, Int_t objlen);
+   virtual void     UnzipEvent(TObject *branch, Long64_t pos, Double_t start, Int_t complen, Int_t objlen);
+   virtual void     BasketReadEvent(TObject *branch, Int_t nbytes, Bool_t incache);
+   virtual void     BranchReadEvent(TObject *branch, Int_t nbytes, Double_t start);
    virtual void     RateEvent(Double_t , Double_t , Long64_t , Long64_t) {}
 
    virtual void     SaveAs(const char *filename="",Option_t *option="") const;
@@ -121,7 +159,7 @@ public:
    virtual void     SetTreeCacheSize(Int_t nbytes) {fTreeCacheSize = nbytes;}
    virtual void     SetUnzipTime(Double_t uztime) {fUnzipTime = uztime;}
 
-   ClassDef(TTreePerfStats,1)  // TTree I/O performance measurement
+   ClassDef(TTreePerfStats,2)  // TTree I/O performance measurement
 };
 
 #endif
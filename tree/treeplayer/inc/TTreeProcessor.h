@@ -0,0 +1,96 @@
+// @(#)root/treeplayer:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#ifndef ROOT_TTreeProcessor
+#define ROOT_TTreeProcessor
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TTreeProcessor                                                       //
+//                                                                      //
+// Multi-threaded event loop over a TTree or TChain. The entries are    //
+// split on cluster boundaries and the clusters are processed by a set  //
+// of worker threads, each with its own TFile handle and its own copy   //
+// of the user's TSelector. The output lists are merged at the end.     //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef ROOT_TNamed
+#include "TNamed.h"
+#endif
+#ifndef ROOT_TString
+#include "TString.h"
+#endif
+
+#include <deque>
+#include <vector>
+
+class TMutex;
+class TSelector;
+class TTree;
+
+class TTreeProcessor : public TNamed {
+
+public:
+   // A range of entries [fStart,fEnd) of the tree in file fFileIndex.
+   // The entry numbers are local to that file's tree.
+   struct TClusterTask {
+      Int_t    fFileIndex;
+      Long64_t fStart;
+      Long64_t fEnd;
+   };
+
+protected:
+   typedef std::deque<TClusterTask> TaskQueue_t;
+
+   std::vector<TString>     fFileNames;   // Name of the files to process
+   std::vector<TString>     fTreeNames;   // Name (with path) of the tree in each file
+   UInt_t                   fNThreads;    // Number of worker threads
+   Long64_t                 fCacheSize;   // TTreeCache size for each worker's tree (-1: tree default)
+   std::vector<TaskQueue_t> fQueues;      //! Per-worker queue of clusters
+   TMutex                  *fQueueMutex;  //! Protects fQueues
+   Long64_t                 fNClusters;   //! Number of clusters of the last Process
+   Long64_t                 fNStolen;     //! Number of clusters stolen by idle workers
+   Long64_t                 fNFailed;     //! Number of entries not processed because their file could not be read
+   Bool_t                   fAborted;     //! Set by a worker when its selector aborts the processing
+
+   Long64_t BuildTasks(Long64_t firstentry, Long64_t nentries, UInt_t nworkers);
+   Bool_t   NextTask(UInt_t worker, TClusterTask &task);
+   void     MergeOutputs(TSelector *selector, std::vector<TSelector*> &workers);
+
+   static void *WorkerLoop(void *arg);
+
+private:
+   TTreeProcessor(const TTreeProcessor&);            // Not implemented
+   TTreeProcessor &operator=(const TTreeProcessor&); // Not implemented
+
+public:
+   TTreeProcessor();
+   TTreeProcessor(TTree *tree, UInt_t nthreads = 0);
+   TTreeProcessor(const char *treename, const char *filename, UInt_t nthreads = 0);
+   virtual ~TTreeProcessor();
+
+   void             AddFile(const char *filename, const char *treename = 0);
+   Long64_t         GetCacheSize() const { return fCacheSize; }
+   Int_t            GetNFiles() const { return (Int_t)fFileNames.size(); }
+   Long64_t         GetNClusters() const { return fNClusters; }
+   Long64_t         GetNFailed() const { return fNFailed; }
+   Long64_t         GetNStolen() const { return fNStolen; }
+   UInt_t           GetNThreads() const { return fNThreads; }
+   virtual Long64_t Process(TSelector *selector, Option_t *option = "", Long64_t nentries = 1000000000, Long64_t firstentry = 0);
+   void             SetCacheSize(Long64_t cachesize) { fCacheSize = cachesize; }
+   void             SetNThreads(UInt_t nthreads);
+
+   static UInt_t    GetDefaultNThreads();
+
+   ClassDef(TTreeProcessor,0); // Multi-threaded, cluster based event loop on a TTree or TChain
+};
+
+#endif
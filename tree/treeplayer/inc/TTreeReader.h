@@ -37,6 +37,7 @@
 class TDictionary;
 class TDirectory;
 class TFileCollection;
+class TTreeStatsFilter;
 
 namespace ROOT {
    class TBranchProxyDirector;
@@ -58,7 +59,8 @@ public:
    TTreeReader():
       fDirectory(0),
       fEntryStatus(kEntryNoTree),
-      fDirector(0)
+      fDirector(0),
+      fStatsFilter(0)
    {}
 
    TTreeReader(TTree* tree);
@@ -73,7 +75,11 @@ public:
 
    Bool_t IsChain() const { return TestBit(kBitIsChain); }
 
-   Bool_t Next() { return SetEntry(GetCurrentEntry() + 1) == kEntryValid; }
+   Bool_t Next() {
+      Long64_t entry = GetCurrentEntry() + 1;
+      if (fStatsFilter) entry = NextFilteredEntry(entry);
+      return SetEntry(entry) == kEntryValid;
+   }
    EEntryStatus SetEntry(Long64_t entry) { return SetEntryBase(entry, kFALSE); }
    EEntryStatus SetLocalEntry(Long64_t entry) { return SetEntryBase(entry, kTRUE); }
 
@@ -82,6 +88,8 @@ public:
    TTree* GetTree() const { return fTree; }
    Long64_t GetEntries(Bool_t force) const { return fTree ? (force ? fTree->GetEntries() : fTree->GetEntriesFast() ) : -1; }
    Long64_t GetCurrentEntry() const;
+   TTreeStatsFilter* GetStatsFilter() const { return fStatsFilter; }
+   Bool_t SetStatsFilter(const char* selection);
 
 protected:
    void Initialize();
@@ -93,6 +101,7 @@ protected:
    void DeregisterValueReader(ROOT::TTreeReaderValueBase* reader);
 
    EEntryStatus SetEntryBase(Long64_t entry, Bool_t local);
+   Long64_t NextFilteredEntry(Long64_t entry);
 
 private:
 
@@ -106,6 +115,7 @@ private:
    ROOT::TBranchProxyDirector* fDirector; // proxying director, owned
    std::deque<ROOT::TTreeReaderValueBase*> fValues; // readers that use our director
    THashTable   fProxies; //attached ROOT::TNamedBranchProxies; owned
+   TTreeStatsFilter* fStatsFilter; // entries skipped by Next(); owned
 
    friend class ROOT::TTreeReaderValueBase;
    friend class ROOT::TTreeReaderArrayBase;
@@ -0,0 +1,78 @@
+// @(#)root/treeplayer:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#ifndef ROOT_TTreeStatsFilter
+#define ROOT_TTreeStatsFilter
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TTreeStatsFilter                                                     //
+//                                                                      //
+// Skip the entries of a TTree or TChain that cannot pass a selection,  //
+// using the range of values recorded for each basket of the branches   //
+// (see TBranch::SetBasketStats).                                       //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef ROOT_TObject
+#include "TObject.h"
+#endif
+#ifndef ROOT_TString
+#include "TString.h"
+#endif
+
+#include <vector>
+
+class TBranch;
+class TTree;
+
+class TTreeStatsFilter : public TObject {
+
+public:
+   enum EOperator { kLess, kLessEqual, kGreater, kGreaterEqual, kEqual };
+
+protected:
+   TTree                  *fTree;        //! Tree or chain being filtered
+   TString                 fSelection;   //  Selection
+   std::vector<TString>    fNames;       //! Variable of each term "variable op value" of the selection
+   std::vector<Int_t>      fOperators;   //! Comparison of each term (EOperator)
+   std::vector<Double_t>   fValues;      //! Constant of each term
+   std::vector<TBranch*>   fBranches;    //! Branch of each variable in the current tree, 0 if it has no basket statistics
+   TTree                  *fCurrentTree; //! Tree in which fBranches were looked up
+   Int_t                   fTreeNumber;  //! Number of fCurrentTree in the chain
+   Long64_t                fNSkipped;    //! Number of entries skipped
+
+   static Bool_t CanPass(Int_t op, Double_t value, Double_t min, Double_t max);
+   Long64_t      NextLocalEntry(Long64_t entry, Long64_t nentries) const;
+   Bool_t        ParseTerm(TString term);
+   void          Parse();
+   void          UpdateBranches();
+
+private:
+   TTreeStatsFilter(const TTreeStatsFilter&);            // Not implemented.
+   TTreeStatsFilter &operator=(const TTreeStatsFilter&); // Not implemented.
+
+public:
+   TTreeStatsFilter();
+   TTreeStatsFilter(TTree *tree, const char *selection);
+   virtual ~TTreeStatsFilter();
+
+   Long64_t          GetNSkipped() const { return fNSkipped; }
+   Int_t             GetNTerms() const { return (Int_t)fNames.size(); }
+   const char       *GetSelection() const { return fSelection.Data(); }
+   TTree            *GetTree() const { return fTree; }
+   Bool_t            IsActive() const { return !fNames.empty(); }
+   Long64_t          NextEntry(Long64_t entry);
+   virtual void      Print(Option_t *option="") const;
+
+   ClassDef(TTreeStatsFilter,0); //Skip the entries of a tree that cannot pass a selection, using the basket statistics
+};
+
+#endif
@@ -19,11 +19,33 @@
 #include "TChain.h"
 #include "TTreeFormula.h"
 #include "TTreeIndex.h"
+#include "TTreeBlockIndex.h"
 #include "TFile.h"
 #include "TError.h"
 
 ClassImp(TChainIndex)
 
+//______________________________________________________________________________
+static Bool_t R__GetIndexRange(const TVirtualIndex *index, Long64_t &minvalue, Long64_t &maxvalue)
+{
+   // Get the smallest and largest values of a TTreeIndex or of a
+   // TTreeBlockIndex (without reading its blocks).
+
+   const TTreeIndex *ti_index = dynamic_cast<const TTreeIndex*>(index);
+   if (ti_index) {
+      minvalue = ti_index->GetIndexValues()[0];
+      maxvalue = ti_index->GetIndexValues()[index->GetN() - 1];
+      return kTRUE;
+   }
+   const TTreeBlockIndex *tbi_index = dynamic_cast<const TTreeBlockIndex*>(index);
+   if (tbi_index) {
+      minvalue = tbi_index->GetMinIndexValue();
+      maxvalue = tbi_index->GetMaxIndexValue();
+      return kTRUE;
+   }
+   return kFALSE;
+}
+
 //______________________________________________________________________________
 TChainIndex::TChainIndex(): TVirtualIndex()
 {
@@ -92,15 +114,11 @@ TChainIndex::TChainIndex(const TTree *T, const char *majorname, const char *mino
          return;
       }
 
-      TTreeIndex *ti_index = dynamic_cast<TTreeIndex*>(index);
-      if (ti_index == 0) {
-         Error("TChainIndex", "The underlying TTree must have a TTreeIndex but has a %s.",
+      if (!R__GetIndexRange(index, entry.fMinIndexValue, entry.fMaxIndexValue)) {
+         Error("TChainIndex", "The underlying TTree must have a TTreeIndex or a TTreeBlockIndex but has a %s.",
                index->IsA()->GetName());
          return;
       }
-
-      entry.fMinIndexValue = ti_index->GetIndexValues()[0];
-      entry.fMaxIndexValue = ti_index->GetIndexValues()[index->GetN() - 1];
       fEntries.push_back(entry);
    }
 
@@ -121,16 +139,13 @@ void TChainIndex::Append(const TVirtualIndex *index, Bool_t delaySort )
    // add an index to this chain
    // if delaySort is kFALSE (default) check if the indices of different trees are in order.
    if (index) {
-      const TTreeIndex *ti_index = dynamic_cast<const TTreeIndex*>(index);
-      if (ti_index == 0) {
-         Error("Append", "The given index is not a TTreeIndex but a %s",
-               index->IsA()->GetName());
-      }
-      
       TChainIndexEntry entry;
       entry.fTreeIndex = 0;
-      entry.fMinIndexValue = ti_index->GetIndexValues()[0];
-      entry.fMaxIndexValue = ti_index->GetIndexValues()[index->GetN() - 1];
+      if (!R__GetIndexRange(index, entry.fMinIndexValue, entry.fMaxIndexValue)) {
+         Error("Append", "The given index is not a TTreeIndex or a TTreeBlockIndex but a %s",
+               index->IsA()->GetName());
+         return;
+      }
       fEntries.push_back(entry);
    }
    
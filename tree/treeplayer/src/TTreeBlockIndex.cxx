@@ -0,0 +1,701 @@
+// @(#)root/treeplayer:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TTreeBlockIndex                                                      //
+//                                                                      //
+// A Tree Index with majorname and minorname, like TTreeIndex, for      //
+// trees too large to keep their whole index in memory.                 //
+//                                                                      //
+// The sorted table of index values (major<<31 + minor) and entry       //
+// numbers is split in blocks of fBlockSize entries. When the index is  //
+// built, each block is written, delta encoded and compressed, in its   //
+// own key of the sub-directory "<treename>_index" of the tree's        //
+// directory. The index object itself, saved with the TTree header,     //
+// only holds the smallest and largest value of each block and the      //
+// position of its key in the file.                                     //
+//                                                                      //
+// GetEntryNumberWithIndex finds the block by a binary search on the    //
+// block boundaries and reads only this block from the file. Values     //
+// that fall between two blocks are rejected without any read. The      //
+// last blocks read are kept in memory (see SetMaxCached).              //
+//                                                                      //
+//    TTree *T = ...; // in a file opened in "RECREATE" or "UPDATE"     //
+//    T->SetTreeIndex(new TTreeBlockIndex(T, "Run", "Event"));          //
+//    T->Write();                                                       //
+//    ...                                                               //
+//    T->GetEntryWithIndex(1234, 56789);                                //
+//                                                                      //
+// A TChainIndex uses the TTreeBlockIndex of the trees of the chain     //
+// without building anything. If the tree is not attached to a          //
+// writable file, the blocks are kept in memory and saved within the    //
+// index object, like a TTreeIndex.                                     //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#include "TTreeBlockIndex.h"
+#include "TTreeIndex.h"
+#include "TTreeFormula.h"
+#include "TChain.h"
+#include "TTree.h"
+#include "TFile.h"
+#include "TKey.h"
+#include "TMath.h"
+
+#include <algorithm>
+#include <string.h>
+
+ClassImp(TTreeBlockIndex)
+ClassImp(TTreeBlockIndex::TBlock)
+
+//______________________________________________________________________________
+TTreeBlockIndex::TBlock::TBlock(Int_t n, const Long64_t *values, const Long64_t *entries)
+   : TObject(), fN(n), fValues(0), fEntries(0)
+{
+   // Create a block holding a copy of the n values and entries.
+
+   if (fN > 0) {
+      fValues  = new Long64_t[fN];
+      fEntries = new Long64_t[fN];
+      memcpy(fValues,  values,  fN*sizeof(Long64_t));
+      memcpy(fEntries, entries, fN*sizeof(Long64_t));
+   }
+}
+
+//______________________________________________________________________________
+TTreeBlockIndex::TBlock::~TBlock()
+{
+   // Destructor.
+
+   delete [] fValues;
+   delete [] fEntries;
+}
+
+//______________________________________________________________________________
+void TTreeBlockIndex::TBlock::Decode()
+{
+   // Turn the delta encoded values back into the sorted values.
+
+   for (Int_t i = 1; i < fN; ++i) fValues[i] += fValues[i-1];
+}
+
+//______________________________________________________________________________
+void TTreeBlockIndex::TBlock::Encode()
+{
+   // Replace each value, but the first one, by its difference with the
+   // previous one. The values being sorted the differences are small
+   // and compress much better.
+
+   for (Int_t i = fN - 1; i > 0; --i) fValues[i] -= fValues[i-1];
+}
+
+//______________________________________________________________________________
+TTreeBlockIndex::TTreeBlockIndex(): TVirtualIndex()
+{
+   // Default constructor for TTreeBlockIndex
+
+   fTree               = 0;
+   fN                  = 0;
+   fBlockSize          = 0;
+   fNBlocks            = 0;
+   fBlockMin           = 0;
+   fBlockMax           = 0;
+   fBlockSeek          = 0;
+   fBlockNbytes        = 0;
+   fBlocks             = 0;
+   fMaxCached          = 8;
+   fNBlocksRead        = 0;
+   fMajorFormula       = 0;
+   fMinorFormula       = 0;
+   fMajorFormulaParent = 0;
+   fMinorFormulaParent = 0;
+}
+
+//______________________________________________________________________________
+TTreeBlockIndex::TTreeBlockIndex(const TTree *T, const char *majorname, const char *minorname, Int_t blocksize)
+           : TVirtualIndex()
+{
+   // Normal constructor for TTreeBlockIndex
+   //
+   // Build the index of Tree T with the expressions majorname and minorname,
+   // see TTreeIndex::TTreeIndex for their description, and split it in
+   // blocks of 'blocksize' entries.
+   // If the tree is attached to a writable file, the blocks are written
+   // right away in the sub-directory "<treename>_index" of the tree's
+   // directory (as new cycles of the keys of a previous TTreeBlockIndex,
+   // which stay readable by the cycles of the TTree already written) and
+   // released from memory; the TTree must then be written to the same file
+   // for the index to be usable.
+   // T cannot be a TChain, build the index of each of its trees instead.
+
+   fTree               = (TTree*)T;
+   fN                  = 0;
+   fBlockSize          = blocksize > 0 ? blocksize : 16384;
+   fNBlocks            = 0;
+   fBlockMin           = 0;
+   fBlockMax           = 0;
+   fBlockSeek          = 0;
+   fBlockNbytes        = 0;
+   fBlocks             = 0;
+   fMaxCached          = 8;
+   fNBlocksRead        = 0;
+   fMajorFormula       = 0;
+   fMinorFormula       = 0;
+   fMajorFormulaParent = 0;
+   fMinorFormulaParent = 0;
+   fMajorName          = majorname;
+   fMinorName          = minorname;
+   if (!T) return;
+   if (dynamic_cast<const TChain*>(T)) {
+      MakeZombie();
+      Error("TTreeBlockIndex","Cannot build a TTreeBlockIndex on a TChain, build it for each of its trees");
+      return;
+   }
+
+   // The sorting is the one of TTreeIndex, its arrays are released as soon
+   // as they are split in blocks.
+   TTreeIndex *index = new TTreeIndex(T, majorname, minorname);
+   if (index->IsZombie() || index->GetN() <= 0) {
+      delete index;
+      MakeZombie();
+      Error("TTreeBlockIndex","Cannot build the index with major=%s, minor=%s",fMajorName.Data(), fMinorName.Data());
+      return;
+   }
+   SetBlocks(index->GetN(), index->GetIndexValues(), index->GetIndex());
+   delete index;
+
+   WriteBlocks();
+}
+
+//______________________________________________________________________________
+TTreeBlockIndex::~TTreeBlockIndex()
+{
+   // Destructor.
+
+   if (fTree && fTree->GetTreeIndex() == this) fTree->SetTreeIndex(0);
+   DeleteBlocks();
+   delete fMajorFormula;        fMajorFormula  = 0;
+   delete fMinorFormula;        fMinorFormula  = 0;
+   delete fMajorFormulaParent;  fMajorFormulaParent = 0;
+   delete fMinorFormulaParent;  fMinorFormulaParent = 0;
+}
+
+//______________________________________________________________________________
+void TTreeBlockIndex::AllocateBlocks(Int_t nblocks)
+{
+   // Delete the current blocks and allocate the tables for nblocks blocks.
+
+   DeleteBlocks();
+   fNBlocks = nblocks;
+   if (fNBlocks <= 0) {
+      fNBlocks = 0;
+      return;
+   }
+   fBlockMin    = new Long64_t[fNBlocks];
+   fBlockMax    = new Long64_t[fNBlocks];
+   fBlockSeek   = new Long64_t[fNBlocks];
+   fBlockNbytes = new Int_t[fNBlocks];
+   fBlocks      = new TBlock*[fNBlocks];
+   for (Int_t i = 0; i < fNBlocks; ++i) {
+      fBlockMin[i] = fBlockMax[i] = fBlockSeek[i] = 0;
+      fBlockNbytes[i] = 0;
+      fBlocks[i] = 0;
+   }
+}
+
+//______________________________________________________________________________
+void TTreeBlockIndex::DeleteBlocks()
+{
+   // Delete the blocks in memory and the block tables.
+
+   if (fBlocks) {
+      for (Int_t i = 0; i < fNBlocks; ++i) delete fBlocks[i];
+   }
+   delete [] fBlocks;      fBlocks = 0;
+   delete [] fBlockMin;    fBlockMin = 0;
+   delete [] fBlockMax;    fBlockMax = 0;
+   delete [] fBlockSeek;   fBlockSeek = 0;
+   delete [] fBlockNbytes; fBlockNbytes = 0;
+   fCached.clear();
+   fNBlocks = 0;
+}
+
+//______________________________________________________________________________
+void TTreeBlockIndex::Append(const TVirtualIndex *add, Bool_t delaySort)
+{
+   // Append 'add' to this index.  Entry 0 in add will become entry n+1 in this.
+   // All the blocks of both indices are loaded in memory and the result is
+   // kept in memory (it is saved within the index object).
+   // The table is always sorted, delaySort is ignored.
+
+   if (delaySort) { }
+   if (!add || !add->GetN()) return;
+
+   const TTreeBlockIndex *ti_add = dynamic_cast<const TTreeBlockIndex*>(add);
+   if (ti_add == 0) {
+      Error("Append","Can only Append a TTreeBlockIndex to a TTreeBlockIndex but got a %s",
+            add->IsA()->GetName());
+      return;
+   }
+   if (!LoadBlocks() || !const_cast<TTreeBlockIndex*>(ti_add)->LoadBlocks()) {
+      Error("Append","Cannot read the blocks of the indices");
+      return;
+   }
+
+   Long64_t n = fN + ti_add->GetN();
+   Long64_t *values  = new Long64_t[n];
+   Long64_t *entries = new Long64_t[n];
+   Long64_t k = 0;
+   Int_t b;
+   for (b = 0; b < fNBlocks; ++b) {
+      const TBlock *blk = fBlocks[b];
+      for (Int_t i = 0; i < blk->fN; ++i, ++k) {
+         values[k]  = blk->fValues[i];
+         entries[k] = blk->fEntries[i];
+      }
+   }
+   for (b = 0; b < ti_add->fNBlocks; ++b) {
+      const TBlock *blk = ti_add->fBlocks[b];
+      for (Int_t i = 0; i < blk->fN; ++i, ++k) {
+         values[k]  = blk->fValues[i];
+         entries[k] = blk->fEntries[i] + fN;
+      }
+   }
+
+   Long64_t *conv = new Long64_t[n];
+   TMath::Sort(n, values, conv, kFALSE);
+   Long64_t *svalues  = new Long64_t[n];
+   Long64_t *sentries = new Long64_t[n];
+   for (Long64_t i = 0; i < n; ++i) {
+      svalues[i]  = values[conv[i]];
+      sentries[i] = entries[conv[i]];
+   }
+   delete [] conv;
+   delete [] values;
+   delete [] entries;
+
+   SetBlocks(n, svalues, sentries);
+   delete [] svalues;
+   delete [] sentries;
+}
+
+//______________________________________________________________________________
+Int_t TTreeBlockIndex::FindBlock(Long64_t value) const
+{
+   // Return the last block whose smallest value is less or equal to value,
+   // or -1 if value is less than all the values of the index.
+
+   if (fNBlocks == 0) return -1;
+   return (Int_t)TMath::BinarySearch((Long64_t)fNBlocks, fBlockMin, value);
+}
+
+//______________________________________________________________________________
+TTreeBlockIndex::TBlock *TTreeBlockIndex::GetBlock(Int_t i) const
+{
+   // Return block i, reading it from the file if it is not in memory.
+   // The last fMaxCached blocks read are kept in memory.
+
+   if (i < 0 || i >= fNBlocks) return 0;
+   if (fBlocks[i]) {
+      if (fBlockSeek[i] && fCached.size() > 1 && fCached.back() != i) {
+         // Keep the most recently used block at the end.
+         std::vector<Int_t>::iterator it = std::find(fCached.begin(), fCached.end(), i);
+         if (it != fCached.end()) {
+            fCached.erase(it);
+            fCached.push_back(i);
+         }
+      }
+      return fBlocks[i];
+   }
+
+   TFile *file = fTree ? fTree->GetCurrentFile() : 0;
+   if (!file || !fBlockSeek[i]) {
+      Error("GetBlock","Block %d of the index is not available (the tree is not attached to the file holding it)",i);
+      return 0;
+   }
+   TDirectory::TContext ctxt(gDirectory, file); // gFile and gDirectory used in ReadObj
+   TKey *key = new TKey(file);
+   char *buffer = new char[fBlockNbytes[i]+1];
+   char *buf = buffer;
+   TBlock *block = 0;
+   if (file->ReadBuffer(buffer, fBlockSeek[i], fBlockNbytes[i])) {
+      // ReadBuffer returns kTRUE in case of failure.
+      Error("GetBlock","Cannot read block %d of the index from file %s",i,file->GetName());
+   } else {
+      key->ReadKeyBuffer(buf);
+      block = dynamic_cast<TBlock*>(key->ReadObjWithBuffer(buffer));
+      if (!block) {
+         Error("GetBlock","Block %d of the index in file %s is corrupted",i,file->GetName());
+      }
+   }
+   delete [] buffer;
+   delete key;
+   if (!block) return 0;
+   block->Decode();
+   ++fNBlocksRead;
+
+   fBlocks[i] = block;
+   fCached.push_back(i);
+   while ((Int_t)fCached.size() > fMaxCached) {
+      Int_t old = fCached.front();
+      fCached.erase(fCached.begin());
+      delete fBlocks[old];
+      fBlocks[old] = 0;
+   }
+   return block;
+}
+
+//______________________________________________________________________________
+Long64_t TTreeBlockIndex::GetEntryNumberFriend(const TTree *parent)
+{
+   // Returns the entry number in this (friend) Tree corresponding to entry in
+   // the master Tree 'parent'.
+   // See TTreeIndex::GetEntryNumberFriend
+
+   if (!parent) return -3;
+   GetMajorFormulaParent(parent);
+   GetMinorFormulaParent(parent);
+   if (!fMajorFormulaParent || !fMinorFormulaParent) return -1;
+   if (!fMajorFormulaParent->GetNdim() || !fMinorFormulaParent->GetNdim()) {
+      // The Tree Index in the friend has a pair majorname,minorname
+      // not available in the parent Tree T.
+      // if the friend Tree has less entries than the parent, this is an error
+      Long64_t pentry = parent->GetReadEntry();
+      if (pentry >= fTree->GetEntries()) return -2;
+      // otherwise we ignore the Tree Index and return the entry number
+      // in the parent Tree.
+      return pentry;
+   }
+
+   Double_t majord = fMajorFormulaParent->EvalInstance();
+   Double_t minord = fMinorFormulaParent->EvalInstance();
+   Long64_t majorv = (Long64_t)majord;
+   Long64_t minorv = (Long64_t)minord;
+   return fTree->GetEntryNumberWithIndex(majorv,minorv);
+}
+
+//______________________________________________________________________________
+Long64_t TTreeBlockIndex::GetEntryNumberWithBestIndex(Int_t major, Int_t minor) const
+{
+   // Return entry number corresponding to major and minor number or, if
+   // there is no such pair, to the pair immediately lower (-1 if the pair
+   // is lower than the first entry in the index).
+   // Only the block containing the pair is read.
+   //
+   // See also GetEntryNumberWithIndex
+
+   if (fN == 0) return -1;
+   Long64_t value = Long64_t(major)<<31;
+   value += minor;
+   Int_t b = FindBlock(value);
+   if (b < 0) return -1;
+   const TBlock *block = GetBlock(b);
+   if (!block) return -1;
+   Long64_t i = TMath::BinarySearch((Long64_t)block->fN, block->fValues, value);
+   if (i < 0) return -1;
+   return block->fEntries[i];
+}
+
+//______________________________________________________________________________
+Long64_t TTreeBlockIndex::GetEntryNumberWithIndex(Int_t major, Int_t minor) const
+{
+   // Return entry number corresponding to major and minor number, -1 if
+   // there is no such pair.
+   // The block that may contain the pair is found from the block boundaries
+   // kept in memory and only this block is read; if the pair falls between
+   // two blocks nothing is read.
+   //
+   // See also GetEntryNumberWithBestIndex
+
+   if (fN == 0) return -1;
+   Long64_t value = Long64_t(major)<<31;
+   value += minor;
+   Int_t b = FindBlock(value);
+   if (b < 0 || value > fBlockMax[b]) return -1;
+   const TBlock *block = GetBlock(b);
+   if (!block) return -1;
+   Long64_t i = TMath::BinarySearch((Long64_t)block->fN, block->fValues, value);
+   if (i < 0 || block->fValues[i] != value) return -1;
+   return block->fEntries[i];
+}
+
+//______________________________________________________________________________
+TTreeFormula *TTreeBlockIndex::GetMajorFormula()
+{
+   // Return a pointer to the TreeFormula corresponding to the majorname.
+
+   if (!fMajorFormula) {
+      fMajorFormula = new TTreeFormula("Major",fMajorName.Data(),fTree);
+      fMajorFormula->SetQuickLoad(kTRUE);
+   }
+   return fMajorFormula;
+}
+
+//______________________________________________________________________________
+TTreeFormula *TTreeBlockIndex::GetMinorFormula()
+{
+   // Return a pointer to the TreeFormula corresponding to the minorname.
+
+   if (!fMinorFormula) {
+      fMinorFormula = new TTreeFormula("Minor",fMinorName.Data(),fTree);
+      fMinorFormula->SetQuickLoad(kTRUE);
+   }
+   return fMinorFormula;
+}
+
+//______________________________________________________________________________
+TTreeFormula *TTreeBlockIndex::GetMajorFormulaParent(const TTree *parent)
+{
+   // Return a pointer to the TreeFormula corresponding to the majorname in parent tree.
+
+   if (!fMajorFormulaParent) {
+      // Prevent TTreeFormula from finding any of the branches in our TTree even if it
+      // is a friend of the parent TTree.
+      TTree::TFriendLock friendlock(fTree, TTree::kFindLeaf | TTree::kFindBranch | TTree::kGetBranch | TTree::kGetLeaf);
+      fMajorFormulaParent = new TTreeFormula("MajorP",fMajorName.Data(),const_cast<TTree*>(parent));
+      fMajorFormulaParent->SetQuickLoad(kTRUE);
+   }
+   if (fMajorFormulaParent->GetTree() != parent) {
+      fMajorFormulaParent->SetTree(const_cast<TTree*>(parent));
+      fMajorFormulaParent->UpdateFormulaLeaves();
+   }
+   return fMajorFormulaParent;
+}
+
+//______________________________________________________________________________
+TTreeFormula *TTreeBlockIndex::GetMinorFormulaParent(const TTree *parent)
+{
+   // Return a pointer to the TreeFormula corresponding to the minorname in parent tree.
+
+   if (!fMinorFormulaParent) {
+      // Prevent TTreeFormula from finding any of the branches in our TTree even if it
+      // is a friend of the parent TTree.
+      TTree::TFriendLock friendlock(fTree, TTree::kFindLeaf | TTree::kFindBranch | TTree::kGetBranch | TTree::kGetLeaf);
+      fMinorFormulaParent = new TTreeFormula("MinorP",fMinorName.Data(),const_cast<TTree*>(parent));
+      fMinorFormulaParent->SetQuickLoad(kTRUE);
+   }
+   if (fMinorFormulaParent->GetTree() != parent) {
+      fMinorFormulaParent->SetTree(const_cast<TTree*>(parent));
+      fMinorFormulaParent->UpdateFormulaLeaves();
+   }
+   return fMinorFormulaParent;
+}
+
+//______________________________________________________________________________
+Bool_t TTreeBlockIndex::LoadBlocks()
+{
+   // Read all the blocks that are not in memory and keep them there.
+   // Returns kFALSE if a block could not be read.
+
+   for (Int_t i = 0; i < fNBlocks; ++i) {
+      if (!GetBlock(i)) return kFALSE;
+      // Detach the block from the list of blocks that may be released.
+      std::vector<Int_t>::iterator it = std::find(fCached.begin(), fCached.end(), i);
+      if (it != fCached.end()) fCached.erase(it);
+   }
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+void TTreeBlockIndex::Print(Option_t * option) const
+{
+   // Print a summary of the index.
+   // If option contains "blocks", print also the range of values and the
+   // size on file of each block.
+
+   TString opt = option;
+   opt.ToLower();
+
+   Printf("\n*****************************************************************");
+   Printf("*    Block index of Tree: %s/%s",fTree ? fTree->GetName() : "",fTree ? fTree->GetTitle() : "");
+   Printf("*****************************************************************");
+   Printf("*  major: %s  minor: %s",fMajorName.Data(),fMinorName.Data());
+   Printf("*  %lld entries in %d blocks of at most %d entries",fN,fNBlocks,fBlockSize);
+   Printf("*  %lld blocks read from file, at most %d kept in memory",fNBlocksRead,fMaxCached);
+   if (opt.Contains("blocks")) {
+      Printf("*****************************************************************");
+      Printf("%8s : %16s : %16s : %10s","block","first major","last major","bytes");
+      for (Int_t i = 0; i < fNBlocks; ++i) {
+         Printf("%8d :         %8lld :         %8lld : %10d",i,fBlockMin[i]>>31,fBlockMax[i]>>31,fBlockNbytes[i]);
+      }
+   }
+   Printf("*****************************************************************");
+}
+
+//______________________________________________________________________________
+void TTreeBlockIndex::SetBlocks(Long64_t n, const Long64_t *values, const Long64_t *entries)
+{
+   // Split the n sorted values and their entries in blocks kept in memory.
+
+   fN = n;
+   AllocateBlocks((Int_t)((n + fBlockSize - 1) / fBlockSize));
+   for (Int_t b = 0; b < fNBlocks; ++b) {
+      Long64_t first = (Long64_t)b * fBlockSize;
+      Int_t nb = (Int_t)TMath::Min((Long64_t)fBlockSize, n - first);
+      fBlocks[b]   = new TBlock(nb, values + first, entries + first);
+      fBlockMin[b] = values[first];
+      fBlockMax[b] = values[first + nb - 1];
+   }
+}
+
+//______________________________________________________________________________
+void TTreeBlockIndex::SetMaxCached(Int_t n)
+{
+   // Set the maximum number of blocks read from the file kept in memory
+   // (default 8). Blocks loaded with LoadBlocks are not counted.
+
+   fMaxCached = n > 0 ? n : 1;
+   while ((Int_t)fCached.size() > fMaxCached) {
+      Int_t old = fCached.front();
+      fCached.erase(fCached.begin());
+      delete fBlocks[old];
+      fBlocks[old] = 0;
+   }
+}
+
+//______________________________________________________________________________
+void TTreeBlockIndex::Streamer(TBuffer &R__b)
+{
+   // Stream an object of class TTreeBlockIndex.
+   // When the index is written to the file holding its blocks only the
+   // block table is written. Otherwise (e.g. when the index is cloned, or
+   // its tree was not attached to a writable file) the blocks themselves
+   // are written in the buffer.
+
+   UInt_t R__s, R__c;
+   if (R__b.IsReading()) {
+      Version_t R__v = R__b.ReadVersion(&R__s, &R__c); if (R__v) { }
+      TVirtualIndex::Streamer(R__b);
+      fMajorName.Streamer(R__b);
+      fMinorName.Streamer(R__b);
+      R__b >> fN;
+      R__b >> fBlockSize;
+      Int_t nblocks;
+      R__b >> nblocks;
+      AllocateBlocks(nblocks);
+      R__b.ReadFastArray(fBlockMin, fNBlocks);
+      R__b.ReadFastArray(fBlockMax, fNBlocks);
+      R__b.ReadFastArray(fBlockSeek, fNBlocks);
+      R__b.ReadFastArray(fBlockNbytes, fNBlocks);
+      for (Int_t i = 0; i < fNBlocks; ++i) {
+         if (fBlockSeek[i]) continue;
+         fBlocks[i] = new TBlock();
+         fBlocks[i]->Streamer(R__b);
+         fBlocks[i]->Decode();
+      }
+      fNBlocksRead = 0;
+      R__b.CheckByteCount(R__s, R__c, TTreeBlockIndex::IsA());
+   } else {
+      Bool_t inFile = fTree && R__b.GetParent() && R__b.GetParent() == fTree->GetCurrentFile();
+      R__c = R__b.WriteVersion(TTreeBlockIndex::IsA(), kTRUE);
+      TVirtualIndex::Streamer(R__b);
+      fMajorName.Streamer(R__b);
+      fMinorName.Streamer(R__b);
+      R__b << fN;
+      R__b << fBlockSize;
+      R__b << fNBlocks;
+      R__b.WriteFastArray(fBlockMin, fNBlocks);
+      R__b.WriteFastArray(fBlockMax, fNBlocks);
+      Int_t i;
+      for (i = 0; i < fNBlocks; ++i) {
+         Long64_t seek = inFile ? fBlockSeek[i] : 0;
+         R__b << seek;
+      }
+      R__b.WriteFastArray(fBlockNbytes, fNBlocks);
+      for (i = 0; i < fNBlocks; ++i) {
+         if (inFile && fBlockSeek[i]) continue;
+         TBlock *block = GetBlock(i);
+         if (!block) {
+            // Keep the buffer consistent, the error was already reported.
+            TBlock empty;
+            empty.Streamer(R__b);
+            continue;
+         }
+         block->Encode();
+         block->Streamer(R__b);
+         block->Decode();
+      }
+      R__b.SetByteCount(R__c, kTRUE);
+   }
+}
+
+//______________________________________________________________________________
+void TTreeBlockIndex::UpdateFormulaLeaves(const TTree *parent)
+{
+   // Called by TChain::LoadTree when the parent chain changes it's tree.
+
+   if (fMajorFormula)       { fMajorFormula->UpdateFormulaLeaves();}
+   if (fMinorFormula)       { fMinorFormula->UpdateFormulaLeaves();}
+   if (fMajorFormulaParent) {
+      if (parent) fMajorFormulaParent->SetTree(const_cast<TTree*>(parent));
+      fMajorFormulaParent->UpdateFormulaLeaves();
+   }
+   if (fMinorFormulaParent) {
+      if (parent) fMinorFormulaParent->SetTree(const_cast<TTree*>(parent));
+      fMinorFormulaParent->UpdateFormulaLeaves();
+   }
+}
+
+//______________________________________________________________________________
+void TTreeBlockIndex::SetTree(const TTree *T)
+{
+   // This function is called by TChain::LoadTree and TTreePlayer::UpdateFormulaLeaves
+   // when a new Tree is loaded.
+
+   fTree = (TTree*)T;
+}
+
+//______________________________________________________________________________
+Bool_t TTreeBlockIndex::WriteBlocks()
+{
+   // Write the blocks in memory to the sub-directory "<treename>_index" of
+   // the tree's directory and release them. The blocks of a previous index
+   // are not deleted: they are still used by the cycles of the tree written
+   // with it, the new blocks are written as new cycles of the keys.
+   // Returns kFALSE, keeping the blocks in memory, if the tree is not
+   // attached to a writable file.
+
+   TDirectory *dir = fTree ? fTree->GetDirectory() : 0;
+   TFile *file = dir ? dir->GetFile() : 0;
+   if (!file || !file->IsWritable()) return kFALSE;
+
+   TString subname = TString::Format("%s_index", fTree->GetName());
+   TDirectory *subdir = dir->GetDirectory(subname);
+   if (!subdir) {
+      if (dir->GetKey(subname)) {
+         Warning("WriteBlocks","%s is not a directory, the index is kept in memory",subname.Data());
+         return kFALSE;
+      }
+      subdir = dir->mkdir(subname, "TTreeBlockIndex blocks");
+      if (!subdir) return kFALSE;
+   }
+
+   for (Int_t i = 0; i < fNBlocks; ++i) {
+      TBlock *block = fBlocks[i];
+      if (!block || fBlockSeek[i]) continue;
+      block->Encode();
+      TString name = TString::Format("block%d", i);
+      Int_t bufsize = 2 * block->fN * (Int_t)sizeof(Long64_t) + 64;
+      TKey *key = file->CreateKey(subdir, block, name, bufsize);
+      block->Decode();
+      if (!key->GetSeekKey()) {
+         Error("WriteBlocks","Cannot write block %d of the index to %s",i,file->GetName());
+         return kFALSE;
+      }
+      file->SumBuffer(key->GetObjlen());
+      key->WriteFile(0);
+      fBlockSeek[i]   = key->GetSeekKey();
+      fBlockNbytes[i] = key->GetNbytes();
+      delete block;
+      fBlocks[i] = 0;
+   }
+   return kTRUE;
+}
@@ -128,7 +128,7 @@ public:
 
 //______________________________________________________________________________
 TTreeFormula::TTreeFormula(): TFormula(), fQuickLoad(kFALSE), fNeedLoading(kTRUE),
-   fDidBooleanOptimization(kFALSE), fDimensionSetup(0)
+   fDidBooleanOptimization(kFALSE), fJitKernel(0), fDimensionSetup(0)
 
 {
    // Tree Formula default constructor
@@ -159,7 +159,7 @@ TTreeFormula::TTreeFormula(): TFormula(), fQuickLoad(kFALSE), fNeedLoading(kTRUE
 //______________________________________________________________________________
 TTreeFormula::TTreeFormula(const char *name,const char *expression, TTree *tree)
    :TFormula(), fTree(tree), fQuickLoad(kFALSE), fNeedLoading(kTRUE),
-    fDidBooleanOptimization(kFALSE), fDimensionSetup(0)
+    fDidBooleanOptimization(kFALSE), fJitKernel(0), fDimensionSetup(0)
 {
    // Normal TTree Formula Constuctor
 
@@ -170,7 +170,7 @@ TTreeFormula::TTreeFormula(const char *name,const char *expression, TTree *tree)
 TTreeFormula::TTreeFormula(const char *name,const char *expression, TTree *tree,
                            const std::vector<std::string>& aliases)
    :TFormula(), fTree(tree), fQuickLoad(kFALSE), fNeedLoading(kTRUE),
-    fDidBooleanOptimization(kFALSE), fDimensionSetup(0), fAliasesUsed(aliases)
+    fDidBooleanOptimization(kFALSE), fJitKernel(0), fDimensionSetup(0), fAliasesUsed(aliases)
 {
    // Constructor used during the expansion of an alias
    Init(name,expression);
@@ -318,6 +318,8 @@ void TTreeFormula::Init(const char*name, const char* expression)
 
    }
 
+   if (GetDefaultJit()) Jit();
+
    if(savedir) savedir->cd();
 }
 
@@ -3935,6 +3937,12 @@ Double_t TTreeFormula::EvalInstance(Int_t instance, const char *stringStackArg[]
    const Bool_t willLoad = (instance==0 || fNeedLoading); fNeedLoading = kFALSE;
    if (willLoad) fDidBooleanOptimization = kFALSE;
 
+   if (fJitKernel) {
+      // The operators were compiled by Jit(); the operands are still
+      // evaluated by EvalOperand.
+      return fJitKernel(this, instance, willLoad, &fDidBooleanOptimization, fConst, &TTreeFormula::JitOperand);
+   }
+
    Int_t pos  = 0;
    Int_t pos2 = 0;
    for (Int_t i=0; i<fNoper ; ++i) {
@@ -4311,6 +4319,191 @@ Double_t TTreeFormula::EvalInstance(Int_t instance, const char *stringStackArg[]
    return result;
 }
 
+//______________________________________________________________________________
+Bool_t TTreeFormula::EvalOperand(Int_t i, Int_t instance, Bool_t willLoad, Double_t &value)
+{
+   // Set value to the operand i (a tree variable, an alias, MinIf$, MaxIf$
+   // or Alt$) of the formula for instance, loading the branches like
+   // EvalInstance. Return kFALSE if EvalInstance would return 0 at this
+   // operand (instance out of range).
+   // This is used by the function compiled by Jit().
+
+   const Int_t oper = GetOper()[i];
+   const Int_t action = oper >> kTFOperShift;
+
+   if (action == kDefinedVariable) {
+      const Int_t code = (oper & kTFOperMask);
+      switch (fLookupType[code]) {
+         case kIndexOfEntry: value = (Double_t)fTree->GetReadEntry(); return kTRUE;
+         case kIndexOfLocalEntry: value = (Double_t)fTree->GetTree()->GetReadEntry(); return kTRUE;
+         case kEntries:      value = (Double_t)fTree->GetEntries(); return kTRUE;
+         case kLength:       value = fManager->fNdata; return kTRUE;
+         case kLengthFunc:   value = ((TTreeFormula*)fAliases.UncheckedAt(i))->GetNdata(); return kTRUE;
+         case kIteration:    value = instance; return kTRUE;
+         case kSum:          value = Summing((TTreeFormula*)fAliases.UncheckedAt(i)); return kTRUE;
+         case kMin:          value = FindMin((TTreeFormula*)fAliases.UncheckedAt(i)); return kTRUE;
+         case kMax:          value = FindMax((TTreeFormula*)fAliases.UncheckedAt(i)); return kTRUE;
+
+         case kDirect:     { TT_EVAL_INIT_LOOP; value = leaf->GetValue(real_instance); return kTRUE; }
+         case kMethod:     { TT_EVAL_INIT_LOOP; value = GetValueFromMethod(code,leaf); return kTRUE; }
+         case kDataMember: { TT_EVAL_INIT_LOOP; value = ((TFormLeafInfo*)fDataMembers.UncheckedAt(code))->
+                                    GetValue(leaf,real_instance); return kTRUE; }
+         case kTreeMember: { TREE_EVAL_INIT_LOOP; value = ((TFormLeafInfo*)fDataMembers.UncheckedAt(code))->
+                                    GetValue((TLeaf*)0x0,real_instance); return kTRUE; }
+         case kEntryList: { TEntryList *elist = (TEntryList*)fExternalCuts.At(code);
+            value = elist->Contains(fTree->GetReadEntry());
+            return kTRUE; }
+         case -1: break;
+         default: value = 0; return kTRUE;
+      }
+      switch (fCodes[code]) {
+         case -2: {
+            TCutG *gcut = (TCutG*)fExternalCuts.At(code);
+            TTreeFormula *fx = (TTreeFormula *)gcut->GetObjectX();
+            TTreeFormula *fy = (TTreeFormula *)gcut->GetObjectY();
+            Double_t xcut = fx->EvalInstance(instance);
+            Double_t ycut = fy->EvalInstance(instance);
+            value = gcut->IsInside(xcut,ycut);
+            return kTRUE;
+         }
+         case -1: {
+            TCutG *gcut = (TCutG*)fExternalCuts.At(code);
+            TTreeFormula *fx = (TTreeFormula *)gcut->GetObjectX();
+            value = fx->EvalInstance(instance);
+            return kTRUE;
+         }
+         default: value = 0; return kTRUE;
+      }
+   }
+
+   switch (action) {
+      case kAlias: {
+         TTreeFormula *subform = static_cast<TTreeFormula*>(fAliases.UncheckedAt(i));
+         R__ASSERT(subform);
+         value = subform->EvalInstance(instance);
+         return kTRUE;
+      }
+      case kMinIf: {
+         TTreeFormula *primary = static_cast<TTreeFormula*>(fAliases.UncheckedAt(i));
+         TTreeFormula *condition = static_cast<TTreeFormula*>(fAliases.UncheckedAt(i+1));
+         value = FindMin(primary,condition);
+         return kTRUE;
+      }
+      case kMaxIf: {
+         TTreeFormula *primary = static_cast<TTreeFormula*>(fAliases.UncheckedAt(i));
+         TTreeFormula *condition = static_cast<TTreeFormula*>(fAliases.UncheckedAt(i+1));
+         value = FindMax(primary,condition);
+         return kTRUE;
+      }
+      case kAlternate: {
+         // The alternate value is the alias following the operator.
+         TTreeFormula *primary = static_cast<TTreeFormula*>(fAliases.UncheckedAt(i));
+         if (instance < primary->GetNdata()) {
+            value = primary->EvalInstance(instance);
+         } else {
+            TTreeFormula *alternate = static_cast<TTreeFormula*>(fAliases.UncheckedAt(i+1));
+            R__ASSERT(alternate);
+            value = alternate->EvalInstance(instance);
+         }
+         return kTRUE;
+      }
+   }
+   value = 0;
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+Bool_t TTreeFormula::JitOperand(TTreeFormula *form, Int_t i, Int_t instance, Bool_t willLoad, Double_t *value)
+{
+   // Called by the function compiled by Jit() to evaluate an operand.
+
+   return form->EvalOperand(i, instance, willLoad, *value);
+}
+
+//______________________________________________________________________________
+Int_t TTreeFormula::MakeJitOperator(Int_t i, TString &statement, Int_t &need, Int_t &delta, Int_t &jump) const
+{
+   // Translate the operator i for TFormula::MakeJitBody (see
+   // TFormula::MakeJitOperator). The operands are evaluated by calling
+   // EvalOperand; the integer operations are done on Long64_t and the
+   // jumps skipping some operands record it in fDidBooleanOptimization,
+   // like in EvalInstance.
+
+   const Int_t oper = GetOper()[i];
+   const Int_t action = oper >> kTFOperShift;
+   const Int_t param = oper & kTFOperMask;
+
+   switch (action) {
+      case kDefinedVariable:
+      case kMinIf:
+      case kMaxIf:
+      case kAlternate:
+         statement.Form("if (!v(f, %d, instance, w, &@0)) return 0;", i);
+         delta = 1;
+         return 1;
+      case kAlias:
+         if (i > 0) {
+            const Int_t previous = GetAction(i-1);
+            if (previous == kMinIf || previous == kMaxIf || previous == kAlternate) {
+               // Evaluated with the previous operator.
+               return 1;
+            }
+         }
+         statement.Form("if (!v(f, %d, instance, w, &@0)) return 0;", i);
+         delta = 1;
+         return 1;
+
+      case kBitAnd    : statement = "@2 = ((Long64_t) @2) & ((Long64_t) @1);"; need = 2; delta = -1; return 1;
+      case kBitOr     : statement = "@2 = ((Long64_t) @2) | ((Long64_t) @1);"; need = 2; delta = -1; return 1;
+      case kLeftShift : statement = "@2 = ((Long64_t) @2) << ((Long64_t) @1);"; need = 2; delta = -1; return 1;
+      case kRightShift: statement = "@2 = ((Long64_t) @2) >> ((Long64_t) @1);"; need = 2; delta = -1; return 1;
+
+      case kJumpIf:
+         jump = param + 1;
+         statement.Form("if (!@1) { if (w) *b = true; goto L%d; }", jump);
+         need = 1; delta = -1;
+         return 1;
+      case kBoolOptimize:
+         jump = i + param / 10 + 1;
+         if (param % 10 == 1)      statement.Form("if (!@1) { @1 = 0; if (w) *b = true; goto L%d; }", jump);
+         else if (param % 10 == 2) statement.Form("if (@1) { @1 = 1; if (w) *b = true; goto L%d; }", jump);
+         else jump = -1;
+         need = 1;
+         return 1;
+   }
+   if (action >= kDefinedVariable || action == kParameter || action == kVariable
+       || (action >= kxexpo && action <= kzpol)) {
+      // Strings, parameters and variables x, y, z are not translated.
+      return -1;
+   }
+   return 0;
+}
+
+//______________________________________________________________________________
+Bool_t TTreeFormula::Jit()
+{
+   // Translate the operators of the formula into C++ and compile them with
+   // the interpreter (see TFormula::Jit); EvalInstance then calls the
+   // compiled function, which still reads the tree variables, aliases and
+   // special functions (Length$, Sum$, Alt$...) through EvalOperand for the
+   // instance requested. The formulas using strings or calling functions
+   // are not compiled. Return kTRUE if the formula is compiled.
+   // All the formulas are compiled when they are created if
+   // TFormula::SetDefaultJit() was called, e.g. before TTree::Draw. The
+   // compilation takes gClingMutex, not gROOTMutex (see
+   // TFormula::JitCompile).
+
+   if (fNoper <= 1 || TestBit(kIsCharacter) || fAxis) return kFALSE;
+
+   const char *declarations = "class TTreeFormula;";
+   const char *signature = "TTreeFormula *f, int instance, bool w, bool *b, const double *c, "
+                           "bool (*v)(TTreeFormula*, int, int, bool, double*)";
+   TJitKernel_t kernel = (TJitKernel_t) JitCompile(declarations, signature, MakeJitBody());
+   if (!kernel) return kFALSE;
+   fJitKernel = kernel;
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 TFormLeafInfo *TTreeFormula::GetLeafInfo(Int_t code) const
 {
@@ -76,6 +76,21 @@
 //           number of bytes returned to the application per second.
 //           The Physical disk speed is DiskIO + DiskIO*ReadExtra/100.
 //
+// Per branch counters
+// ===================
+// The I/O of each branch of the tree is also recorded (see TBranchStats):
+// number of entries, baskets and bytes read, baskets found in the TTreeCache
+// or read directly from the file, baskets unzipped with the number of bytes
+// and the time spent unzipping, and the time spent deserializing the entries
+// in TBranch::GetEntry. These counters are only collected while gPerfStats
+// is set. They are printed, the most expensive branches first, with
+//    root > ioperf->Print("branches");
+// and can be exported in a machine readable format with
+//    root > ioperf->Export("ioperf.json");   // or SaveAs("ioperf.json")
+//    root > ioperf->Export("ioperf.csv");    // or SaveAs("ioperf.csv")
+// The JSON file contains the global values above and the list of branches,
+// the CSV file has one line per branch.
+//
 //////////////////////////////////////////////////////////////////////////
 
 
@@ -85,6 +100,7 @@
 #include "Riostream.h"
 #include "TFile.h"
 #include "TTree.h"
+#include "TBranch.h"
 #include "TAxis.h"
 #include "TBrowser.h"
 #include "TVirtualPad.h"
@@ -95,6 +111,9 @@
 #include "TTimeStamp.h"
 #include "TDatime.h"
 #include "TMath.h"
+#include "TTreeTuningProfile.h"
+
+#include <stdio.h>
 
 ClassImp(TTreePerfStats)
 
@@ -125,6 +144,7 @@ TTreePerfStats::TTreePerfStats() : TVirtualPerfStats()
    fCompress      = 0;
    fRealTimeAxis  = 0;
    fHostInfoText  = 0;
+   fBranchTree    = 0;
 }
 
 //______________________________________________________________________________
@@ -170,6 +190,7 @@ TTreePerfStats::TTreePerfStats(const char *name, TTree *T) : TVirtualPerfStats()
    TDatime dt;
    fHostInfo += TString::Format(" %s",dt.AsString());
    fHostInfoText   = 0;
+   fBranchTree     = 0;
 
    gPerfStats = this;
 }
@@ -306,6 +327,200 @@ void TTreePerfStats::FileUnzipEvent(TFile * /* file */, Long64_t /* pos */, Doub
    fUnzipTime += dtime;
 }
 
+//______________________________________________________________________________
+TTreePerfStats::TBranchStats *TTreePerfStats::FindBranchStats(TObject *branch)
+{
+   // Return the counters of branch, creating them the first time the branch
+   // is seen. Return 0 if the branch does not belong to the monitored tree
+   // (or to the current tree of the monitored chain).
+
+   if (!fTree || !branch) return 0;
+   TTree *tree = ((TBranch*)branch)->GetTree();
+   if (tree != fTree->GetTree()) return 0;
+
+   // The branch objects change with the tree of a chain, the names stay.
+   if (tree != fBranchTree) {
+      fBranchIndex.clear();
+      fBranchTree = tree;
+   }
+   std::map<const TObject*,Int_t>::const_iterator it = fBranchIndex.find(branch);
+   if (it != fBranchIndex.end()) return &fBranchStats[it->second];
+
+   const char *name = branch->GetName();
+   Int_t index = -1;
+   for (UInt_t i = 0; i < fBranchStats.size(); ++i) {
+      if (fBranchStats[i].fName == name) {
+         index = i;
+         break;
+      }
+   }
+   if (index < 0) {
+      index = fBranchStats.size();
+      fBranchStats.push_back(TBranchStats());
+      fBranchStats.back().fName = name;
+   }
+   fBranchIndex[branch] = index;
+   return &fBranchStats[index];
+}
+
+//______________________________________________________________________________
+void TTreePerfStats::UnzipEvent(TObject *branch, Long64_t /* pos */, Double_t start, Int_t /* complen */, Int_t objlen)
+{
+   // Record the unzipping of a basket of branch.
+   // start is the TimeStamp before unzip
+   // objlen is the length of the de-compressed buffer
+
+   TBranchStats *stats = FindBranchStats(branch);
+   if (!stats) return;
+   Double_t tnow = TTimeStamp();
+   stats->fUnzipTime += tnow-start;
+   stats->fBytesUnzipped += objlen;
+   stats->fBasketsUnzipped++;
+}
+
+//______________________________________________________________________________
+void TTreePerfStats::BasketReadEvent(TObject *branch, Int_t nbytes, Bool_t incache)
+{
+   // Record the reading of a basket of branch.
+   // nbytes is the size of the basket in the file
+   // incache is true if the basket was found in the TTreeCache
+
+   TBranchStats *stats = FindBranchStats(branch);
+   if (!stats) return;
+   stats->fBasketsRead++;
+   stats->fBytesRead += nbytes;
+   if (incache) stats->fCacheHits++;
+   else         stats->fCacheMisses++;
+}
+
+//______________________________________________________________________________
+void TTreePerfStats::BranchReadEvent(TObject *branch, Int_t nbytes, Double_t start)
+{
+   // Record the deserialization of an entry of branch.
+   // start is the TimeStamp before reading the leaves
+   // nbytes is the number of bytes read from the basket
+
+   TBranchStats *stats = FindBranchStats(branch);
+   if (!stats) return;
+   Double_t tnow = TTimeStamp();
+   stats->fStreamerTime += tnow-start;
+   stats->fBytesStreamed += nbytes;
+   stats->fEntries++;
+}
+
+//______________________________________________________________________________
+const TTreePerfStats::TBranchStats *TTreePerfStats::GetBranchStats(const char *branchname) const
+{
+   // Return the counters of the branch named branchname, 0 if it was not read.
+
+   for (UInt_t i = 0; i < fBranchStats.size(); ++i) {
+      if (fBranchStats[i].fName == branchname) return &fBranchStats[i];
+   }
+   return 0;
+}
+
+//______________________________________________________________________________
+TTreeTuningProfile *TTreePerfStats::MakeTuningProfile(const char *name) const
+{
+   // Return a new tuning profile (to be deleted by the caller) with the
+   // number of entries read of each branch, to be saved and given to
+   // TTree::SetTuningProfile when writing the next version of the tree.
+   // The default name is the name of the tree followed by "_profile".
+
+   TString pname(name);
+   if (pname.IsNull()) pname.Form("%s_profile", fTree ? fTree->GetName() : "tree");
+   TTreeTuningProfile *profile = new TTreeTuningProfile(pname, fTree);
+   for (UInt_t i = 0; i < fBranchStats.size(); ++i) {
+      profile->AddRead(fBranchStats[i].fName, fBranchStats[i].fEntries);
+   }
+   return profile;
+}
+
+//______________________________________________________________________________
+static void R__WriteJSONString(FILE *fp, const char *str)
+{
+   // Write str as a JSON string.
+
+   fputc('"', fp);
+   for (const char *c = str; c && *c; ++c) {
+      if (*c == '"' || *c == '\\') fputc('\\', fp);
+      if ((unsigned char)*c < 0x20) fprintf(fp, "\\u%04x", (unsigned char)*c);
+      else fputc(*c, fp);
+   }
+   fputc('"', fp);
+}
+
+//______________________________________________________________________________
+void TTreePerfStats::Export(const char *filename, Option_t *option) const
+{
+   // Write the I/O perf stats, including the counters of each branch, in a
+   // machine readable format. The format is given by option ("json" or
+   // "csv") or, if option is empty, by the extension of filename
+   // (.json or .csv).
+   // The JSON file contains the global values (see Print) and the array
+   // "branches" with the counters of each branch. The CSV file contains
+   // one line per branch, after a header line with the column names.
+
+   TString opt(option);
+   opt.ToLower();
+   if (opt.IsNull()) {
+      TString fname(filename);
+      fname.ToLower();
+      if (fname.EndsWith(".json"))     opt = "json";
+      else if (fname.EndsWith(".csv")) opt = "csv";
+   }
+   if (opt != "json" && opt != "csv") {
+      Error("Export", "unknown format for %s, use option \"json\" or \"csv\"", filename);
+      return;
+   }
+
+   TTreePerfStats *ps = (TTreePerfStats*)this;
+   ps->Finish();
+
+   FILE *fp = fopen(filename, "w");
+   if (!fp) {
+      SysError("Export", "cannot open file %s", filename);
+      return;
+   }
+
+   if (opt == "csv") {
+      fprintf(fp, "branch,entries,basketsread,bytesread,cachehits,cachemisses,"
+                  "basketsunzipped,bytesunzipped,unziptime,bytesstreamed,streamertime\n");
+      for (UInt_t i = 0; i < fBranchStats.size(); ++i) {
+         const TBranchStats &b = fBranchStats[i];
+         fprintf(fp, "%s,%lld,%d,%lld,%d,%d,%d,%lld,%g,%lld,%g\n", b.fName.Data(), b.fEntries,
+                 b.fBasketsRead, b.fBytesRead, b.fCacheHits, b.fCacheMisses,
+                 b.fBasketsUnzipped, b.fBytesUnzipped, b.fUnzipTime, b.fBytesStreamed, b.fStreamerTime);
+      }
+   } else {
+      fprintf(fp, "{\n  \"name\": ");
+      R__WriteJSONString(fp, GetName());
+      fprintf(fp, ",\n  \"title\": ");
+      R__WriteJSONString(fp, fGraphIO ? fGraphIO->GetTitle() : "");
+      fprintf(fp, ",\n  \"hostinfo\": ");
+      R__WriteJSONString(fp, GetHostInfo());
+      fprintf(fp, ",\n  \"treecachesize\": %d,\n  \"nleaves\": %d,\n  \"readcalls\": %d,\n"
+                  "  \"readaheadsize\": %d,\n  \"bytesread\": %lld,\n  \"bytesreadextra\": %lld,\n"
+                  "  \"compress\": %g,\n  \"realtime\": %g,\n  \"cputime\": %g,\n"
+                  "  \"disktime\": %g,\n  \"unziptime\": %g,\n  \"branches\": [",
+              fTreeCacheSize, fNleaves, fReadCalls, fReadaheadSize, fBytesRead, fBytesReadExtra,
+              fCompress, fRealTime, fCpuTime, fDiskTime, fUnzipTime);
+      for (UInt_t i = 0; i < fBranchStats.size(); ++i) {
+         const TBranchStats &b = fBranchStats[i];
+         fprintf(fp, "%s\n    {\"name\": ", i ? "," : "");
+         R__WriteJSONString(fp, b.fName.Data());
+         fprintf(fp, ", \"entries\": %lld, \"basketsread\": %d, \"bytesread\": %lld, "
+                     "\"cachehits\": %d, \"cachemisses\": %d, \"basketsunzipped\": %d, "
+                     "\"bytesunzipped\": %lld, \"unziptime\": %g, \"bytesstreamed\": %lld, "
+                     "\"streamertime\": %g}",
+                 b.fEntries, b.fBasketsRead, b.fBytesRead, b.fCacheHits, b.fCacheMisses,
+                 b.fBasketsUnzipped, b.fBytesUnzipped, b.fUnzipTime, b.fBytesStreamed, b.fStreamerTime);
+      }
+      fprintf(fp, "\n  ]\n}\n");
+   }
+   fclose(fp);
+}
+
 //______________________________________________________________________________
 void TTreePerfStats::Finish()
 {
@@ -454,13 +669,51 @@ void TTreePerfStats::Print(Option_t * option) const
       printf("ReadStrCP = %7.3f MBytes/s\n",1e-6*fCompress*fBytesRead/(fCpuTime-fUnzipTime));
       printf("ReadZipCP = %7.3f MBytes/s\n",1e-6*fCompress*fBytesRead/fUnzipTime);
    }      
+   if (opts.Contains("branches")) {
+      PrintBranches();
+   }
+}
+
+//______________________________________________________________________________
+void TTreePerfStats::PrintBranches() const
+{
+   // Print the counters of each branch, sorted by decreasing time spent
+   // unzipping and deserializing.
+
+   Int_t n = fBranchStats.size();
+   if (!n) {
+      printf("No branch I/O recorded\n");
+      return;
+   }
+   std::vector<Double_t> times(n);
+   std::vector<Int_t> index(n);
+   for (Int_t i = 0; i < n; ++i) {
+      times[i] = fBranchStats[i].fUnzipTime + fBranchStats[i].fStreamerTime;
+   }
+   TMath::Sort(n, &times[0], &index[0], kTRUE);
+
+   printf("%-40s %10s %8s %12s %8s %8s %12s %10s %10s\n", "Branch", "Entries", "Baskets",
+          "ZipBytes", "CacheHit", "CacheMis", "UnzipBytes", "UnzipTime", "StrmTime");
+   for (Int_t i = 0; i < n; ++i) {
+      const TBranchStats &b = fBranchStats[index[i]];
+      printf("%-40s %10lld %8d %12lld %8d %8d %12lld %10.4f %10.4f\n", b.fName.Data(), b.fEntries,
+             b.fBasketsRead, b.fBytesRead, b.fCacheHits, b.fCacheMisses, b.fBytesUnzipped,
+             b.fUnzipTime, b.fStreamerTime);
+   }
 }
 
 //______________________________________________________________________________
 void TTreePerfStats::SaveAs(const char *filename, Option_t * /*option*/) const
 {
-   // Save this object to filename
+   // Save this object to filename. If the extension of filename is .json
+   // or .csv, the perf stats are exported in this format (see Export).
    
+   TString fname(filename);
+   fname.ToLower();
+   if (fname.EndsWith(".json") || fname.EndsWith(".csv")) {
+      Export(filename);
+      return;
+   }
    TTreePerfStats *ps = (TTreePerfStats*)this;
    ps->Finish();
    ps->TObject::SaveAs(filename);
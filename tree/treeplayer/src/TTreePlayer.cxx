@@ -71,6 +71,7 @@
 #include "TObjString.h"
 #include "TTreeProxyGenerator.h"
 #include "TTreeIndex.h"
+#include "TTreeStatsFilter.h"
 #include "TChainIndex.h"
 #include "TRefProxy.h"
 #include "TRefArrayProxy.h"
@@ -2184,7 +2185,21 @@ Long64_t TTreePlayer::Process(TSelector *selector,Option_t *option, Long64_t nen
       fSelectorUpdate = selector;
       UpdateFormulaLeaves();
 
+      // Skip the baskets in which no entry can pass the selection of Draw.
+      TTreeStatsFilter *filter = 0;
+      if (selector == fSelector && fSelector->GetSelect() && !fTree->GetEntryList()) {
+         filter = new TTreeStatsFilter(fTree, fSelector->GetSelect()->GetTitle());
+         if (!filter->IsActive()) {
+            delete filter;
+            filter = 0;
+         }
+      }
+
       for (entry=firstentry;entry<firstentry+nentries;entry++) {
+         if (filter) {
+            entry = filter->NextEntry(entry);
+            if (entry >= firstentry+nentries) break;
+         }
          entryNumber = fTree->GetEntryNumber(entry);
          if (entryNumber < 0) break;
          if (timer && timer->ProcessEvents()) break;
@@ -2208,6 +2223,7 @@ Long64_t TTreePlayer::Process(TSelector *selector,Option_t *option, Long64_t nen
          }
       }
       delete timer;
+      delete filter;
       //we must reset the cache
       {
          TFile *curfile2 = fTree->GetCurrentFile();
@@ -0,0 +1,466 @@
+// @(#)root/treeplayer:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+//
+// TTreeProcessor
+//
+// Implicitly multi-threaded event loop over a TTree or a TChain.
+//
+// The entries to process are split on the cluster boundaries recorded
+// in the tree (see TTree::GetClusterIterator). The clusters are dealt
+// out in contiguous blocks to a set of workers; a worker that runs out
+// of clusters steals the last cluster of the most loaded worker, so
+// that all threads stay busy until the very end. The workers run as
+// jobs of the shared TTaskScheduler: at most as many run at once as
+// the scheduler has threads (plus the calling thread).
+//
+// Each worker opens its own TFile for the files it processes and runs
+// its own instance of the user's selector, created via the selector's
+// dictionary (TClass::New). The selector must therefore be compiled
+// (ACLiC or a library) and have a default constructor. Selectors using
+// a TTreeReader should connect it to the tree in Init, e.g.:
+//
+//    void MySelector::Init(TTree *tree) { fReader.SetTree(tree); }
+//    Bool_t MySelector::Process(Long64_t entry) {
+//       fReader.SetLocalEntry(entry);
+//       fHist->Fill(*fPt);
+//       return kTRUE;
+//    }
+//
+// The calling thread runs worker 0 with the selector passed to Process;
+// Begin and Terminate are only called for that selector. At the end of
+// the loop the output lists of the other workers are merged into its
+// output list: objects with the same name are merged via their Merge
+// function (e.g. TH1::Merge), other objects are simply moved.
+//
+//    TChain chain("T");
+//    chain.Add("data_*.root");
+//    TTreeProcessor proc(&chain, 8);
+//    proc.Process(new MySelector);
+//
+// Friend trees and entry lists are not supported.
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "TTreeProcessor.h"
+
+#include "TChain.h"
+#include "TChainElement.h"
+#include "TClass.h"
+#include "TDirectory.h"
+#include "TFile.h"
+#include "TMutex.h"
+#include "TROOT.h"
+#include "TSelector.h"
+#include "TSystem.h"
+#include "TTaskScheduler.h"
+#include "TTree.h"
+#include "TVirtualMutex.h"
+
+#include <algorithm>
+
+ClassImp(TTreeProcessor)
+
+namespace {
+   struct TWorkerSlot {
+      TTreeProcessor *fProcessor;
+      TSelector      *fSelector;
+      UInt_t          fId;
+      Long64_t        fProcessed;
+   };
+
+   // The loop of a worker, as a job of the task scheduler.
+   class TWorkerJob : public TTaskScheduler::TJob {
+   public:
+      typedef void *(*LoopFunc_t)(void *);
+   private:
+      LoopFunc_t     fLoop;
+      TWorkerSlot   *fSlot;
+   public:
+      TWorkerJob(LoopFunc_t loop, TWorkerSlot *slot) : fLoop(loop), fSlot(slot) { }
+      virtual void Execute() { fLoop(fSlot); }
+   };
+}
+
+//______________________________________________________________________________
+TTreeProcessor::TTreeProcessor() : TNamed(), fNThreads(1), fCacheSize(-1), fQueueMutex(0),
+   fNClusters(0), fNStolen(0), fNFailed(0), fAborted(kFALSE)
+{
+   // Default constructor.
+}
+
+//______________________________________________________________________________
+TTreeProcessor::TTreeProcessor(TTree *tree, UInt_t nthreads) : TNamed(), fNThreads(1), fCacheSize(-1),
+   fQueueMutex(0), fNClusters(0), fNStolen(0), fNFailed(0), fAborted(kFALSE)
+{
+   // Create a processor for the entries of tree, which can be a TChain.
+   // The tree itself is not used for the processing; the workers reopen
+   // the files it comes from. If nthreads is 0, one thread per cpu is used.
+
+   SetNThreads(nthreads);
+   if (!tree) return;
+   SetName(tree->GetName());
+   SetTitle(tree->GetTitle());
+
+   if (tree->InheritsFrom(TChain::Class())) {
+      TIter next(((TChain*)tree)->GetListOfFiles());
+      TChainElement *element;
+      while ((element = (TChainElement*)next())) {
+         AddFile(element->GetTitle(), element->GetName());
+      }
+   } else {
+      TDirectory *dir = tree->GetDirectory();
+      TFile *file = tree->GetCurrentFile();
+      if (!dir || !file) {
+         Error("TTreeProcessor", "the tree %s is not attached to a file, it cannot be processed in parallel", tree->GetName());
+         return;
+      }
+      // Path of the tree inside the file, i.e. strip "file.root:/".
+      TString path = dir->GetPath();
+      Ssiz_t colon = path.Index(":/");
+      path = colon == kNPOS ? TString() : TString(path(colon+2, path.Length()));
+      if (path.Length()) path += "/";
+      path += tree->GetName();
+      AddFile(file->GetName(), path);
+   }
+}
+
+//______________________________________________________________________________
+TTreeProcessor::TTreeProcessor(const char *treename, const char *filename, UInt_t nthreads) :
+   TNamed(treename, treename), fNThreads(1), fCacheSize(-1), fQueueMutex(0),
+   fNClusters(0), fNStolen(0), fNFailed(0), fAborted(kFALSE)
+{
+   // Create a processor for the tree treename stored in filename.
+   // More files can be added via AddFile.
+
+   SetNThreads(nthreads);
+   AddFile(filename, treename);
+}
+
+//______________________________________________________________________________
+TTreeProcessor::~TTreeProcessor()
+{
+   // Destructor.
+
+   delete fQueueMutex;
+}
+
+//______________________________________________________________________________
+void TTreeProcessor::AddFile(const char *filename, const char *treename)
+{
+   // Add a file to the list of files to process. If treename is not given,
+   // the name of this processor is used.
+
+   if (!filename || !filename[0]) return;
+   fFileNames.push_back(filename);
+   fTreeNames.push_back((treename && treename[0]) ? treename : GetName());
+}
+
+//______________________________________________________________________________
+Long64_t TTreeProcessor::BuildTasks(Long64_t firstentry, Long64_t nentries, UInt_t nworkers)
+{
+   // Fill the nworkers queues with the clusters overlapping the (global)
+   // entry range [firstentry, firstentry+nentries). Each worker gets a
+   // contiguous block of clusters to keep the accesses to a file local
+   // to as few threads as possible. Return the number of entries to be
+   // processed or -1 in case of error.
+
+   fQueues.clear();
+   fQueues.resize(nworkers);
+   fNClusters = 0;
+   fNStolen = 0;
+   fNFailed = 0;
+
+   std::vector<TClusterTask> tasks;
+   Long64_t lastentry = firstentry + nentries;
+   Long64_t offset = 0;
+   Long64_t total = 0;
+   for (UInt_t i = 0; i < fFileNames.size() && offset < lastentry; ++i) {
+      TDirectory::TContext ctxt(0);
+      TFile *file = TFile::Open(fFileNames[i]);
+      if (!file || file->IsZombie()) {
+         Error("BuildTasks", "cannot open file %s", fFileNames[i].Data());
+         delete file;
+         return -1;
+      }
+      TTree *tree = dynamic_cast<TTree*>(file->Get(fTreeNames[i]));
+      if (!tree) {
+         Error("BuildTasks", "cannot find tree %s in file %s", fTreeNames[i].Data(), fFileNames[i].Data());
+         delete file;
+         return -1;
+      }
+      Long64_t entries = tree->GetEntries();
+      Long64_t start = std::max(firstentry - offset, (Long64_t)0);
+      Long64_t end = std::min(lastentry - offset, entries);
+      if (start < end) {
+         TTree::TClusterIterator clusters = tree->GetClusterIterator(start);
+         Long64_t clusterstart;
+         while ((clusterstart = clusters()) < end) {
+            TClusterTask task;
+            task.fFileIndex = i;
+            task.fStart = std::max(clusterstart, start);
+            task.fEnd = std::min(clusters.GetNextEntry(), end);
+            tasks.push_back(task);
+            total += task.fEnd - task.fStart;
+         }
+      }
+      offset += entries;
+      delete file;
+   }
+
+   fNClusters = tasks.size();
+   for (UInt_t w = 0; w < nworkers; ++w) {
+      Long64_t begin = fNClusters * w / nworkers;
+      Long64_t end = fNClusters * (w+1) / nworkers;
+      fQueues[w].assign(tasks.begin() + begin, tasks.begin() + end);
+   }
+   return total;
+}
+
+//______________________________________________________________________________
+Bool_t TTreeProcessor::NextTask(UInt_t worker, TClusterTask &task)
+{
+   // Get the next cluster to be processed by worker. The worker first takes
+   // the clusters at the front of its own queue; when it is empty, it
+   // steals from the back of the longest queue. Return false when there
+   // is nothing left to do.
+
+   TLockGuard lock(fQueueMutex);
+   if (fAborted) return kFALSE;
+   if (!fQueues[worker].empty()) {
+      task = fQueues[worker].front();
+      fQueues[worker].pop_front();
+      return kTRUE;
+   }
+   UInt_t victim = worker;
+   for (UInt_t w = 0; w < fQueues.size(); ++w) {
+      if (fQueues[w].size() > fQueues[victim].size()) victim = w;
+   }
+   if (fQueues[victim].empty()) return kFALSE;
+   task = fQueues[victim].back();
+   fQueues[victim].pop_back();
+   ++fNStolen;
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+void *TTreeProcessor::WorkerLoop(void *arg)
+{
+   // Loop of a worker thread: process clusters until none is left.
+
+   TWorkerSlot *slot = (TWorkerSlot*)arg;
+   TTreeProcessor *proc = slot->fProcessor;
+   TSelector *selector = slot->fSelector;
+
+   // Objects created by the selector must not be attached to a directory
+   // shared with other threads.
+   TDirectory::TContext ctxt(0);
+
+   if (slot->fId != 0) selector->SlaveBegin(0);
+
+   Bool_t useCutFill = selector->Version() == 0;
+   Int_t curfile = -1;
+   TFile *file = 0;
+   TTree *tree = 0;
+   TClusterTask task;
+   while (proc->NextTask(slot->fId, task)) {
+      if (task.fFileIndex != curfile) {
+         delete file;
+         tree = 0;
+         curfile = task.fFileIndex;
+         file = TFile::Open(proc->fFileNames[curfile]);
+         gDirectory = 0;
+         if (file && !file->IsZombie()) {
+            tree = dynamic_cast<TTree*>(file->Get(proc->fTreeNames[curfile]));
+         }
+         if (!tree) {
+            proc->Error("WorkerLoop", "cannot read tree %s from file %s",
+                        proc->fTreeNames[curfile].Data(), proc->fFileNames[curfile].Data());
+         } else {
+            if (proc->fCacheSize >= 0) tree->SetCacheSize(proc->fCacheSize);
+            if (selector->Version() >= 2) selector->Init(tree);
+            selector->Notify();
+         }
+      }
+      if (!tree) {
+         // The entries are lost: record it so that Process reports an error.
+         TLockGuard lock(proc->fQueueMutex);
+         proc->fNFailed += task.fEnd - task.fStart;
+         continue;
+      }
+      tree->SetCacheEntryRange(task.fStart, task.fEnd);
+      for (Long64_t entry = task.fStart; entry < task.fEnd; ++entry) {
+         if (useCutFill) {
+            if (selector->ProcessCut(entry))
+               selector->ProcessFill(entry);
+         } else {
+            selector->Process(entry);
+         }
+         ++slot->fProcessed;
+         if (selector->GetAbort() != TSelector::kContinue) break;
+      }
+      if (selector->GetAbort() == TSelector::kAbortProcess) {
+         TLockGuard lock(proc->fQueueMutex);
+         proc->fAborted = kTRUE;
+         break;
+      }
+      // kAbortFile only skips the rest of the current cluster: the other
+      // clusters of the file may already be processed by other workers.
+      selector->ResetAbort();
+   }
+   if (selector->Version() != 0 || selector->GetStatus() != -1) {
+      selector->SlaveTerminate();
+   }
+   delete file;
+   return 0;
+}
+
+//______________________________________________________________________________
+void TTreeProcessor::MergeOutputs(TSelector *selector, std::vector<TSelector*> &workers)
+{
+   // Merge the output lists of the workers into the one of selector.
+
+   TList *output = selector->GetOutputList();
+   for (UInt_t w = 0; w < workers.size(); ++w) {
+      TList *wout = workers[w]->GetOutputList();
+      TObject *obj;
+      while ((obj = wout->First())) {
+         wout->Remove(obj);
+         TObject *target = output->FindObject(obj->GetName());
+         if (!target) {
+            output->Add(obj);
+            continue;
+         }
+         TList inputs;
+         inputs.SetOwner();
+         inputs.Add(obj);
+         // Pick up the same object from the remaining workers to merge them in one go.
+         for (UInt_t o = w+1; o < workers.size(); ++o) {
+            TObject *other = workers[o]->GetOutputList()->FindObject(obj->GetName());
+            if (other) {
+               workers[o]->GetOutputList()->Remove(other);
+               inputs.Add(other);
+            }
+         }
+         ROOT::MergeFunc_t func = target->IsA()->GetMerge();
+         if (func) {
+            if (func(target, &inputs, 0) < 0)
+               Error("MergeOutputs", "calling Merge() on '%s' failed", target->GetName());
+         } else if (target->IsA()->GetMethodWithPrototype("Merge", "TCollection*")) {
+            Int_t error = 0;
+            TString args;
+            args.Form("((TCollection*)0x%lx)", (ULong_t)&inputs);
+            target->Execute("Merge", args.Data(), &error);
+            if (error)
+               Error("MergeOutputs", "calling Merge() on '%s' failed", target->GetName());
+         } else {
+            Warning("MergeOutputs", "object '%s' of class %s cannot be merged; keeping the one of the first worker",
+                    target->GetName(), target->ClassName());
+         }
+      }
+   }
+}
+
+//______________________________________________________________________________
+Long64_t TTreeProcessor::Process(TSelector *selector, Option_t *option, Long64_t nentries, Long64_t firstentry)
+{
+   // Process the entries [firstentry, firstentry+nentries) of the tree with
+   // the given selector, using GetNThreads() threads. The entry numbers are
+   // global to the chain. Return -1 in case of error, in particular if some
+   // of the entries could not be read (see GetNFailed), and the status of
+   // the selector otherwise.
+
+   if (!selector) return -1;
+   if (fFileNames.empty()) {
+      Error("Process", "no file to process");
+      return -1;
+   }
+   if (!fQueueMutex) fQueueMutex = new TMutex();
+   fAborted = kFALSE;
+
+   // Workers other than 0 get their own instance of the selector.
+   std::vector<TSelector*> workers;
+   for (UInt_t w = 1; w < fNThreads; ++w) {
+      TSelector *wsel = (TSelector*)selector->IsA()->New();
+      if (!wsel) {
+         Warning("Process", "cannot create an instance of %s, processing with one thread", selector->ClassName());
+         for (UInt_t i = 0; i < workers.size(); ++i) delete workers[i];
+         workers.clear();
+         break;
+      }
+      wsel->SetOption(option);
+      wsel->SetInputList(selector->GetInputList());
+      workers.push_back(wsel);
+   }
+   Long64_t toprocess = BuildTasks(firstentry, nentries, workers.size() + 1);
+   if (toprocess < 0) {
+      for (UInt_t i = 0; i < workers.size(); ++i) delete workers[i];
+      return -1;
+   }
+
+   TDirectory::TContext ctxt(0);
+   selector->SetOption(option);
+   selector->Begin(0);
+   selector->SlaveBegin(0);
+
+   if (selector->GetAbort() != TSelector::kAbortProcess
+       && (selector->Version() != 0 || selector->GetStatus() != -1)) {
+      std::vector<TWorkerSlot> slots(workers.size() + 1);
+      TTaskGroup group;
+      for (UInt_t w = 0; w < slots.size(); ++w) {
+         slots[w].fProcessor = this;
+         slots[w].fSelector = w ? workers[w-1] : selector;
+         slots[w].fId = w;
+         slots[w].fProcessed = 0;
+         if (w) group.Run(new TWorkerJob(&TTreeProcessor::WorkerLoop, &slots[w]));
+      }
+      // The calling thread does its share of the work.
+      WorkerLoop(&slots[0]);
+      group.Wait();
+      Long64_t processed = 0;
+      for (UInt_t w = 0; w < slots.size(); ++w) processed += slots[w].fProcessed;
+      if (gDebug > 0)
+         Info("Process", "processed %lld of %lld entries in %lld clusters with %u threads (%lld clusters stolen)",
+              processed, toprocess, fNClusters, (UInt_t)slots.size(), fNStolen);
+
+      if (fNFailed > 0)
+         Error("Process", "%lld of %lld entries were not processed: their file could not be read",
+               fNFailed, toprocess);
+
+      MergeOutputs(selector, workers);
+      if (selector->Version() != 0 || selector->GetStatus() != -1) {
+         selector->Terminate();
+      }
+   }
+   for (UInt_t i = 0; i < workers.size(); ++i) delete workers[i];
+   fQueues.clear();
+
+   if (fNFailed > 0) return -1;
+   return selector->GetStatus();
+}
+
+//______________________________________________________________________________
+void TTreeProcessor::SetNThreads(UInt_t nthreads)
+{
+   // Set the number of threads used by Process, including the calling
+   // thread. If nthreads is 0, use one thread per cpu.
+
+   fNThreads = nthreads ? nthreads : GetDefaultNThreads();
+}
+
+//______________________________________________________________________________
+UInt_t TTreeProcessor::GetDefaultNThreads()
+{
+   // Return the number of threads of the shared task scheduler, by
+   // default the number of cpus of this machine.
+
+   return TTaskScheduler::GetDefaultNThreads();
+}
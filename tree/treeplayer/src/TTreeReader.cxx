@@ -14,6 +14,7 @@
 #include "TChain.h"
 #include "TDirectory.h"
 #include "TTreeReaderValue.h"
+#include "TTreeStatsFilter.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
@@ -38,7 +39,8 @@ TTreeReader::TTreeReader(TTree* tree):
    fTree(tree),
    fDirectory(0),
    fEntryStatus(kEntryNotLoaded),
-   fDirector(0)
+   fDirector(0),
+   fStatsFilter(0)
 {
    // Access data from tree.
    Initialize();
@@ -49,7 +51,8 @@ TTreeReader::TTreeReader(const char* keyname, TDirectory* dir /*= NULL*/):
    fTree(0),
    fDirectory(dir),
    fEntryStatus(kEntryNotLoaded),
-   fDirector(0)
+   fDirector(0),
+   fStatsFilter(0)
 {
    // Access data from the tree called keyname in the directory (e.g. TFile)
    // dir, or the current directory if dir is NULL. If keyname cannot be
@@ -68,6 +71,7 @@ TTreeReader::~TTreeReader()
       (*i)->MarkTreeReaderUnavailable();
    }
    delete fDirector;
+   delete fStatsFilter;
    fProxies.SetOwner();
 }
 
@@ -95,6 +99,42 @@ Long64_t TTreeReader::GetCurrentEntry() const {
    return currentTreeEntry;
 }
 
+//______________________________________________________________________________
+Long64_t TTreeReader::NextFilteredEntry(Long64_t entry)
+{
+   // Return the first entry from entry on that Next() should read.
+
+   Int_t treeNumInChain = fTree->GetTreeNumber();
+   entry = fStatsFilter->NextEntry(entry);
+   if (fDirector && treeNumInChain != fTree->GetTreeNumber()) {
+      // The filter loaded another tree of the chain.
+      fDirector->SetTree(fTree->GetTree());
+   }
+   return entry;
+}
+
+//______________________________________________________________________________
+Bool_t TTreeReader::SetStatsFilter(const char* selection)
+{
+   // Let Next() skip the entries that certainly fail selection, according
+   // to the range of values of the baskets of the branches (see
+   // TTree::SetBasketStats and TTreeStatsFilter). The entries returned
+   // still have to be tested against the selection. A null or empty
+   // selection removes the filter. Returns kFALSE if no term of the
+   // selection can be used.
+
+   delete fStatsFilter;
+   fStatsFilter = 0;
+   if (!fTree || !selection || !selection[0]) return kFALSE;
+   fStatsFilter = new TTreeStatsFilter(fTree, selection);
+   if (!fStatsFilter->IsActive()) {
+      delete fStatsFilter;
+      fStatsFilter = 0;
+      return kFALSE;
+   }
+   return kTRUE;
+}
+
 //______________________________________________________________________________
 TTreeReader::EEntryStatus TTreeReader::SetEntryBase(Long64_t entry, Bool_t local)
 {
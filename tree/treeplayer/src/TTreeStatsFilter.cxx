@@ -0,0 +1,307 @@
+// @(#)root/treeplayer:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2013, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// TTreeStatsFilter                                                     //
+//                                                                      //
+// A branch can record the smallest and largest value of its leaf in    //
+// each basket (see TBranch::SetBasketStats and TTree::SetBasketStats). //
+// Given a selection, TTreeStatsFilter uses these ranges to find the    //
+// baskets in which no entry can pass it: NextEntry(entry) returns the  //
+// first entry from 'entry' on that may pass, so that the event loop    //
+// neither reads nor decompresses the baskets in between.               //
+//                                                                      //
+// Only the terms of the selection of the form "variable op constant"   //
+// or "constant op variable", with op one of <, <=, >, >= and ==, that  //
+// are combined with && at the top level are used; the other terms are  //
+// ignored. A selection with || or ?: at the top level is not used at   //
+// all. The variable must be a leaf (possibly with an index) of a       //
+// branch recording its basket ranges. Entries are only skipped when    //
+// they certainly fail the selection; the selection itself must still  //
+// be evaluated on the entries returned.                                //
+//                                                                      //
+// TTree::Draw uses it automatically for its selection. With a          //
+// TTreeReader, see TTreeReader::SetStatsFilter; in a hand-written      //
+// loop:                                                                //
+//                                                                      //
+//    TTreeStatsFilter filter(tree, "pt>50 && abs(eta)<2.5");           //
+//    for (Long64_t entry = filter.NextEntry(0); entry < nentries;      //
+//         entry = filter.NextEntry(entry + 1)) {                       //
+//       tree->GetEntry(entry);                                         //
+//       if (pt > 50 && TMath::Abs(eta) < 2.5) ...                      //
+//    }                                                                 //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#include "TTreeStatsFilter.h"
+#include "TBranch.h"
+#include "TLeaf.h"
+#include "TMath.h"
+#include "TTree.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+
+ClassImp(TTreeStatsFilter)
+
+//______________________________________________________________________________
+TTreeStatsFilter::TTreeStatsFilter() : TObject(),
+   fTree(0), fCurrentTree(0), fTreeNumber(-1), fNSkipped(0)
+{
+   // Default constructor.
+}
+
+//______________________________________________________________________________
+TTreeStatsFilter::TTreeStatsFilter(TTree *tree, const char *selection) : TObject(),
+   fTree(tree), fSelection(selection), fCurrentTree(0), fTreeNumber(-1), fNSkipped(0)
+{
+   // Create a filter for the selection on tree (a TTree or a TChain).
+   // IsActive() returns kFALSE if no term of the selection can be used.
+
+   if (fTree) Parse();
+}
+
+//______________________________________________________________________________
+TTreeStatsFilter::~TTreeStatsFilter()
+{
+   // Destructor.
+}
+
+//______________________________________________________________________________
+Bool_t TTreeStatsFilter::CanPass(Int_t op, Double_t value, Double_t min, Double_t max)
+{
+   // Return kFALSE if no value in [min,max] satisfies "x op value".
+   // An empty range (min > max) cannot satisfy anything.
+
+   if (min > max) return kFALSE;
+   switch (op) {
+      case kLess:         return min < value;
+      case kLessEqual:    return min <= value;
+      case kGreater:      return max > value;
+      case kGreaterEqual: return max >= value;
+      case kEqual:        return min <= value && value <= max;
+   }
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+Long64_t TTreeStatsFilter::NextEntry(Long64_t entry)
+{
+   // Return the first entry number from 'entry' on that may pass the
+   // selection. For a chain, entry numbers are global. The value
+   // returned may be past the last entry of the tree, if all the
+   // remaining entries fail the selection.
+   //
+   // Note that the tree (and for a chain its current file) is loaded
+   // for the entry returned.
+
+   if (!fTree || fNames.empty()) return entry;
+   while (1) {
+      Long64_t local = fTree->LoadTree(entry);
+      if (local < 0) return entry;
+      TTree *tree = fTree->GetTree();
+      if (tree != fCurrentTree || fTree->GetTreeNumber() != fTreeNumber) {
+         UpdateBranches();
+      }
+      Long64_t nentries = tree->GetEntries();
+      Long64_t next = NextLocalEntry(local, nentries);
+      if (next == local) return entry;
+      fNSkipped += next - local;
+      entry += next - local;
+      if (next < nentries || tree == fTree) return entry;
+      // The remaining entries of this tree of the chain fail the
+      // selection: continue with the next one.
+   }
+   return entry;
+}
+
+//______________________________________________________________________________
+Long64_t TTreeStatsFilter::NextLocalEntry(Long64_t entry, Long64_t nentries) const
+{
+   // Return the first entry of the current tree from 'entry' on that is
+   // not in a basket whose range fails a term of the selection.
+
+   Long64_t next = entry;
+   Bool_t moved = kTRUE;
+   while (moved && next < nentries) {
+      moved = kFALSE;
+      for (UInt_t t = 0; t < fBranches.size(); ++t) {
+         TBranch *branch = fBranches[t];
+         if (!branch) continue;
+         Int_t nbaskets = branch->GetWriteBasket() + 1;
+         Long64_t *basketEntry = branch->GetBasketEntry();
+         Int_t basket = TMath::BinarySearch(nbaskets, basketEntry, next);
+         if (basket < 0) continue;
+         Double_t min, max;
+         if (!branch->GetBasketRange(basket, min, max)) continue;
+         if (CanPass(fOperators[t], fValues[t], min, max)) continue;
+         Long64_t end = basket + 1 < nbaskets ? basketEntry[basket+1] : branch->GetEntries();
+         if (end <= next) continue;
+         next = end;
+         moved = kTRUE;
+      }
+   }
+   return next < nentries ? next : nentries;
+}
+
+//______________________________________________________________________________
+void TTreeStatsFilter::Parse()
+{
+   // Split the selection in the terms combined with && at the top level
+   // and keep those that can be checked against the basket ranges.
+
+   TString sel(fSelection);
+   sel.ReplaceAll(" ", "");
+   sel.ReplaceAll("\t", "");
+   if (sel.IsNull() || sel.Index("\"") != kNPOS || sel.Index("'") != kNPOS) return;
+
+   std::vector<TString> terms;
+   Int_t depth = 0;
+   Int_t start = 0;
+   Int_t len = sel.Length();
+   for (Int_t i = 0; i < len; ++i) {
+      char c = sel[i];
+      if (c == '(' || c == '[') {
+         ++depth;
+      } else if (c == ')' || c == ']') {
+         --depth;
+      } else if (depth == 0) {
+         if (c == '?' || (c == '|' && i+1 < len && sel[i+1] == '|')) {
+            // The result does not require each term to be true.
+            return;
+         }
+         if (c == '&' && i+1 < len && sel[i+1] == '&') {
+            terms.push_back(sel(start, i - start));
+            start = i + 2;
+            ++i;
+         }
+      }
+   }
+   if (depth != 0) return;
+   terms.push_back(sel(start, len - start));
+
+   for (UInt_t i = 0; i < terms.size(); ++i) {
+      ParseTerm(terms[i]);
+   }
+}
+
+//______________________________________________________________________________
+Bool_t TTreeStatsFilter::ParseTerm(TString term)
+{
+   // Add term to the list if it is of the form "variable op constant"
+   // or "constant op variable".
+
+   // Remove the parentheses around the whole term.
+   while (term.Length() > 1 && term[0] == '(' && term[term.Length()-1] == ')') {
+      Int_t depth = 0;
+      Int_t i = 0;
+      for (; i < term.Length(); ++i) {
+         if (term[i] == '(') ++depth;
+         else if (term[i] == ')' && --depth == 0) break;
+      }
+      if (i != term.Length()-1) break;
+      term = term(1, term.Length()-2);
+   }
+
+   Int_t pos = term.First("<>=");
+   if (pos <= 0 || pos+1 >= term.Length() || term[pos-1] == '!') return kFALSE;
+   Int_t oplen = term[pos+1] == '=' ? 2 : 1;
+   Int_t op;
+   if (term[pos] == '<')      op = oplen == 2 ? kLessEqual : kLess;
+   else if (term[pos] == '>') op = oplen == 2 ? kGreaterEqual : kGreater;
+   else if (oplen == 2)       op = kEqual;
+   else return kFALSE;
+
+   TString lhs = term(0, pos);
+   TString rhs = term(pos + oplen, term.Length() - pos - oplen);
+   if (rhs.IsNull() || rhs.First("<>=!") != kNPOS) return kFALSE;
+
+   TString name;
+   const char *number;
+   if (isalpha(lhs[0]) || lhs[0] == '_') {
+      name = lhs;
+      number = rhs.Data();
+   } else {
+      name = rhs;
+      number = lhs.Data();
+      // "value < x" is "x > value".
+      if (op == kLess)              op = kGreater;
+      else if (op == kLessEqual)    op = kGreaterEqual;
+      else if (op == kGreater)      op = kLess;
+      else if (op == kGreaterEqual) op = kLessEqual;
+   }
+
+   char *end = 0;
+   Double_t value = strtod(number, &end);
+   if (end == number || *end) return kFALSE;
+
+   // The variable is a name, possibly followed by indices; the range of
+   // the basket covers all the elements.
+   Int_t n = 0;
+   if (!isalpha(name[0]) && name[0] != '_') return kFALSE;
+   while (n < name.Length() && (isalnum(name[n]) || name[n] == '_' || name[n] == '.')) ++n;
+   Int_t i = n;
+   while (i < name.Length()) {
+      if (name[i] != '[') return kFALSE;
+      Int_t close = name.Index("]", i);
+      if (close == kNPOS || name.Index("[", i+1) < close) return kFALSE;
+      i = close + 1;
+   }
+   name.Remove(n);
+   if (name.EndsWith(".") || fTree->GetAlias(name)) return kFALSE;
+
+   fNames.push_back(name);
+   fOperators.push_back(op);
+   fValues.push_back(value);
+   fBranches.push_back((TBranch*)0);
+   return kTRUE;
+}
+
+//______________________________________________________________________________
+void TTreeStatsFilter::Print(Option_t *) const
+{
+   // Print the terms of the selection used and whether their branch
+   // has basket statistics in the current tree.
+
+   static const char *ops[] = { "<", "<=", ">", ">=", "==" };
+   Printf("TTreeStatsFilter on %s: \"%s\", %lld entries skipped",
+          fTree ? fTree->GetName() : "", fSelection.Data(), fNSkipped);
+   for (UInt_t t = 0; t < fNames.size(); ++t) {
+      Printf("   %s %s %g%s", fNames[t].Data(), ops[fOperators[t]], fValues[t],
+             fBranches[t] ? "" : " (no basket statistics)");
+   }
+}
+
+//______________________________________________________________________________
+void TTreeStatsFilter::UpdateBranches()
+{
+   // Find the branch of each variable in the current tree. Branches
+   // without basket statistics, and those of friend trees (whose
+   // baskets are numbered by their own entries), are not used.
+
+   fCurrentTree = fTree->GetTree();
+   fTreeNumber = fTree->GetTreeNumber();
+   for (UInt_t t = 0; t < fNames.size(); ++t) {
+      TBranch *branch = 0;
+      if (fCurrentTree) {
+         TLeaf *leaf = fCurrentTree->GetLeaf(fNames[t]);
+         if (leaf) {
+            branch = leaf->GetBranch();
+         } else {
+            branch = fCurrentTree->GetBranch(fNames[t]);
+         }
+      }
+      if (branch && (branch->GetTree() != fCurrentTree || !branch->HasBasketStats())) {
+         branch = 0;
+      }
+      fBranches[t] = branch;
+   }
+}